@@ -40,6 +40,7 @@ bool SaveXML(XMLElement&) const;
 void SendEvent(const String&, VariantMap& = VariantMap ( ));
 bool SetAttribute(const String&, const Variant&);
 void SetMorphWeight(uint, float);
+void SyncBoneNodes();
 
 // Properties:
 float animationLodBias;
@@ -65,6 +66,7 @@ bool enabledEffective;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 /* writeonly */
@@ -77,6 +79,7 @@ Array<String> morphNames;
 Array<float> morphWeights;
 /* readonly */
 Node node;
+bool nodeFreeAnimation;
 /* readonly */
 uint numAnimationStates;
 /* readonly */
@@ -156,6 +159,7 @@ bool flipY;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 Material material;
@@ -191,6 +195,7 @@ class Animation
 {
 // Methods:
 void AddTrigger(float, bool, const Variant&);
+void Compress();
 bool Load(File);
 void RemoveAllTriggers();
 void RemoveTrigger(uint);
@@ -205,6 +210,8 @@ ShortStringHash baseType;
 /* readonly */
 String category;
 /* readonly */
+bool compressed;
+/* readonly */
 float length;
 /* readonly */
 uint memoryUse;
@@ -517,6 +524,7 @@ bool faceCamera;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 Material material;
@@ -1723,6 +1731,7 @@ bool enabledEffective;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 /* writeonly */
@@ -1890,6 +1899,7 @@ bool enabledEffective;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 Material material;
@@ -2035,6 +2045,7 @@ bool enabledEffective;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 uint maxLights;
@@ -2102,6 +2113,7 @@ bool enabledEffective;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 Material material;
@@ -2333,6 +2345,7 @@ Console CreateConsole();
 DebugHud CreateDebugHud();
 void DumpMemory();
 void DumpProfiler();
+void DumpProfilerTrace(const String&, uint = 1);
 void DumpResources();
 void Exit();
 void RunFrame();
@@ -2353,6 +2366,7 @@ bool initialized;
 int maxFps;
 int maxInactiveFps;
 int minFps;
+float nextTimeStep;
 bool pauseMinimized;
 /* readonly */
 int refs;
@@ -2967,6 +2981,7 @@ Frustum frustum;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 LightType lightType;
 float lodBias;
@@ -3388,6 +3403,7 @@ void Warning(const String&);
 void Write(const String&, bool = false);
 
 // Properties:
+bool async;
 /* readonly */
 ShortStringHash baseType;
 /* readonly */
@@ -4355,6 +4371,7 @@ uint id;
 /* readonly */
 bool inView;
 float inactiveTime;
+bool isStatic;
 uint lightMask;
 float lodBias;
 Material material;
@@ -4460,6 +4477,7 @@ bool enabledEffective;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 Material material;
@@ -4906,8 +4924,13 @@ Array<uint> numShadowMaps;
 uint numViewports;
 /* readonly */
 uint numViews;
+/* readonly */
+Array<uint> numZoneLookups;
 float occluderSizeThreshold;
 int occlusionBufferSize;
+float occlusionReprojectionAngle;
+float occlusionReprojectionDistance;
+int occlusionReprojectionFrames;
 /* readonly */
 int refs;
 bool reuseShadowMaps;
@@ -5871,6 +5894,7 @@ bool enabledEffective;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 /* writeonly */
@@ -6656,6 +6680,7 @@ bool enabledEffective;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 /* writeonly */
@@ -6735,6 +6760,7 @@ uint id;
 bool inView;
 /* readonly */
 Array<Node> instanceNodes;
+bool isStatic;
 uint lightMask;
 float lodBias;
 /* writeonly */
@@ -6817,6 +6843,7 @@ bool flipY;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 Material material;
@@ -7067,6 +7094,7 @@ bool enabledEffective;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 uint maxLights;
@@ -7334,6 +7362,7 @@ HorizontalAlignment horizontalAlignment;
 uint id;
 /* readonly */
 bool inView;
+bool isStatic;
 uint lightMask;
 float lodBias;
 Material material;
@@ -8800,6 +8829,7 @@ uint id;
 bool inView;
 /* readonly */
 Matrix3x4 inverseWorldTransform;
+bool isStatic;
 uint lightMask;
 float lodBias;
 uint maxLights;
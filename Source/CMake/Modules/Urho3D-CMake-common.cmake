@@ -90,6 +90,12 @@ if (NOT MSVC)
         set (USE_OPENGL 1)
     endif ()
 endif ()
+# Alternatively use the null graphics backend, which records rendering calls without touching a GPU.
+# It is meant for benchmarking and regression testing the CPU side of rendering on machines without a GPU.
+if (USE_NULL_GRAPHICS)
+    set (USE_OPENGL 0)
+    add_definitions (-DUSE_NULL_GRAPHICS)
+endif ()
 if (USE_OPENGL)
     add_definitions (-DUSE_OPENGL)
 endif ()
@@ -622,7 +628,7 @@ macro (define_dependency_libs TARGET)
             elseif (NOT APPLE AND NOT RASPI)
                 list (APPEND LINK_LIBS_ONLY GL)
             endif ()
-        else ()
+        elseif (NOT USE_NULL_GRAPHICS)
             if (DIRECT3D_FOUND)
                 list (APPEND ABSOLUTE_PATH_LIBS ${DIRECT3D_LIBRARIES} ${DIRECT3D_COMPILER_LIBRARIES})
             else ()
@@ -22,25 +22,41 @@
 
 #include "Precompiled.h"
 #include "Allocator.h"
+#include "ArenaAllocator.h"
+#include "Atomic.h"
+#include "ConcurrentAllocator.h"
 
 #include "stdio.h"
+#include <cassert>
 
 #include "DebugNew.h"
 
 namespace Urho3D
 {
 
-AllocatorBlock* AllocatorReserveBlock(AllocatorBlock* allocator, unsigned nodeSize, unsigned capacity)
+static volatile int numHeapAllocations = 0;
+
+AllocatorBlock* AllocatorReserveBlock(AllocatorBlock* allocator, unsigned nodeSize, unsigned capacity, ArenaAllocator* arena)
 {
     if (!capacity)
         capacity = 1;
     
-    unsigned char* blockPtr = new unsigned char[sizeof(AllocatorBlock) + capacity * (sizeof(AllocatorNode) + nodeSize)];
+    unsigned blockSize = sizeof(AllocatorBlock) + capacity * (sizeof(AllocatorNode) + nodeSize);
+    unsigned char* blockPtr;
+    if (arena)
+        blockPtr = static_cast<unsigned char*>(arena->Allocate(blockSize));
+    else
+    {
+        CountHeapAllocation();
+        blockPtr = new unsigned char[blockSize];
+    }
     AllocatorBlock* newBlock = reinterpret_cast<AllocatorBlock*>(blockPtr);
     newBlock->nodeSize_ = nodeSize;
     newBlock->capacity_ = capacity;
     newBlock->free_ = 0;
     newBlock->next_ = 0;
+    newBlock->arena_ = arena;
+    newBlock->concurrent_ = 0;
     
     if (!allocator)
         allocator = newBlock;
@@ -71,14 +87,24 @@ AllocatorBlock* AllocatorReserveBlock(AllocatorBlock* allocator, unsigned nodeSi
     return newBlock;
 }
 
-AllocatorBlock* AllocatorInitialize(unsigned nodeSize, unsigned initialCapacity)
+AllocatorBlock* AllocatorInitialize(unsigned nodeSize, unsigned initialCapacity, ArenaAllocator* arena)
 {
-    AllocatorBlock* block = AllocatorReserveBlock(0, nodeSize, initialCapacity);
+    AllocatorBlock* block = AllocatorReserveBlock(0, nodeSize, initialCapacity, arena);
     return block;
 }
 
+AllocatorBlock* AllocatorInitialize(unsigned nodeSize, ConcurrentAllocator* allocator)
+{
+    assert(allocator && nodeSize <= allocator->GetNodeSize());
+    return allocator->GetAllocatorBlock();
+}
+
 void AllocatorUninitialize(AllocatorBlock* allocator)
 {
+    // Arena and thread-safe allocator memory is released by their owners
+    if (allocator && (allocator->arena_ || allocator->concurrent_))
+        return;
+    
     while (allocator)
     {
         AllocatorBlock* next = allocator->next_;
@@ -92,11 +118,14 @@ void* AllocatorReserve(AllocatorBlock* allocator)
     if (!allocator)
         return 0;
     
+    if (allocator->concurrent_)
+        return allocator->concurrent_->Reserve();
+    
     if (!allocator->free_)
     {
         // Free nodes have been exhausted. Allocate a new larger block
         unsigned newCapacity = (allocator->capacity_ + 1) >> 1;
-        AllocatorReserveBlock(allocator, allocator->nodeSize_, newCapacity);
+        AllocatorReserveBlock(allocator, allocator->nodeSize_, newCapacity, allocator->arena_);
         allocator->capacity_ += newCapacity;
     }
     
@@ -114,6 +143,12 @@ void AllocatorFree(AllocatorBlock* allocator, void* ptr)
     if (!allocator || !ptr)
         return;
     
+    if (allocator->concurrent_)
+    {
+        allocator->concurrent_->Free(ptr);
+        return;
+    }
+    
     unsigned char* dataPtr = static_cast<unsigned char*>(ptr);
     AllocatorNode* node = reinterpret_cast<AllocatorNode*>(dataPtr - sizeof(AllocatorNode));
     
@@ -122,4 +157,14 @@ void AllocatorFree(AllocatorBlock* allocator, void* ptr)
     allocator->free_ = node;
 }
 
+void CountHeapAllocation()
+{
+    AtomicIncrement(&numHeapAllocations);
+}
+
+unsigned GetNumHeapAllocations()
+{
+    return (unsigned)numHeapAllocations;
+}
+
 }
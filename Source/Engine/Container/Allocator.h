@@ -29,6 +29,8 @@
 namespace Urho3D
 {
 
+class ArenaAllocator;
+class ConcurrentAllocator;
 struct AllocatorBlock;
 struct AllocatorNode;
 
@@ -43,6 +45,10 @@ struct AllocatorBlock
     AllocatorNode* free_;
     /// Next allocator block.
     AllocatorBlock* next_;
+    /// Arena the block was allocated from, or null if from the heap.
+    ArenaAllocator* arena_;
+    /// Thread-safe allocator to forward to, or null if not used.
+    ConcurrentAllocator* concurrent_;
     /// Nodes follow.
 };
 
@@ -54,14 +60,20 @@ struct AllocatorNode
     /// Data follows.
 };
 
-/// Initialize a fixed-size allocator with the node size and initial capacity.
-URHO3D_API AllocatorBlock* AllocatorInitialize(unsigned nodeSize, unsigned initialCapacity = 1);
-/// Uninitialize a fixed-size allocator. Frees all blocks in the chain.
+/// Initialize a fixed-size allocator with the node size and initial capacity. Optionally allocate the blocks from an arena instead of the heap.
+URHO3D_API AllocatorBlock* AllocatorInitialize(unsigned nodeSize, unsigned initialCapacity = 1, ArenaAllocator* arena = 0);
+/// Initialize a fixed-size allocator that reserves the nodes from a thread-safe allocator, whose node size must be at least the specified node size.
+URHO3D_API AllocatorBlock* AllocatorInitialize(unsigned nodeSize, ConcurrentAllocator* allocator);
+/// Uninitialize a fixed-size allocator. Frees all blocks in the chain, unless they were allocated from an arena.
 URHO3D_API void AllocatorUninitialize(AllocatorBlock* allocator);
 /// Reserve a node. Creates a new block if necessary.
 URHO3D_API void* AllocatorReserve(AllocatorBlock* allocator);
 /// Free a node. Does not free any blocks.
 URHO3D_API void AllocatorFree(AllocatorBlock* allocator, void* ptr);
+/// Count a general heap allocation made by a container or allocator.
+URHO3D_API void CountHeapAllocation();
+/// Return the number of general heap allocations made by containers and allocators so far. Used for detecting allocation churn.
+URHO3D_API unsigned GetNumHeapAllocations();
 
 /// %Allocator template class. Allocates objects of a specific class.
 template <class T> class Allocator
@@ -75,6 +87,12 @@ public:
             allocator_ = AllocatorInitialize(sizeof(T), initialCapacity);
     }
     
+    /// Construct to reserve the objects from a thread-safe allocator.
+    explicit Allocator(ConcurrentAllocator* allocator) :
+        allocator_(AllocatorInitialize(sizeof(T), allocator))
+    {
+    }
+    
     /// Destruct.
     ~Allocator()
     {
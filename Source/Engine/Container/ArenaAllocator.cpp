@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Allocator.h"
+#include "ArenaAllocator.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned ARENA_ALIGNMENT = 16;
+
+/// %Arena memory block.
+struct ArenaBlock
+{
+    /// Previous block.
+    ArenaBlock* prev_;
+    /// Data follows, aligned.
+};
+
+ArenaAllocator::ArenaAllocator(unsigned blockSize) :
+    block_(0),
+    current_(0),
+    end_(0),
+    allocated_(0),
+    capacity_(0),
+    blockSize_(blockSize ? blockSize : ARENA_ALIGNMENT)
+{
+}
+
+ArenaAllocator::~ArenaAllocator()
+{
+    FreeBlocks();
+}
+
+void* ArenaAllocator::Allocate(unsigned size)
+{
+    size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    
+    if (!block_ || (unsigned)(end_ - current_) < size)
+    {
+        // Grow geometrically so that the amount of blocks stays low until the next reset
+        unsigned blockSize = capacity_ ? capacity_ : blockSize_;
+        AllocateBlock(blockSize > size ? blockSize : size);
+    }
+    
+    void* ptr = current_;
+    current_ += size;
+    allocated_ += size;
+    return ptr;
+}
+
+void ArenaAllocator::Reset()
+{
+    if (block_ && block_->prev_)
+    {
+        unsigned capacity = capacity_;
+        FreeBlocks();
+        AllocateBlock(capacity);
+    }
+    else if (block_)
+    {
+        unsigned char* blockPtr = reinterpret_cast<unsigned char*>(block_);
+        current_ = reinterpret_cast<unsigned char*>(((size_t)(blockPtr + sizeof(ArenaBlock)) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1));
+    }
+    
+    allocated_ = 0;
+}
+
+unsigned ArenaAllocator::GetNumBlocks() const
+{
+    unsigned numBlocks = 0;
+    for (ArenaBlock* block = block_; block; block = block->prev_)
+        ++numBlocks;
+    return numBlocks;
+}
+
+void ArenaAllocator::AllocateBlock(unsigned size)
+{
+    CountHeapAllocation();
+    unsigned char* blockPtr = new unsigned char[sizeof(ArenaBlock) + ARENA_ALIGNMENT + size];
+    ArenaBlock* newBlock = reinterpret_cast<ArenaBlock*>(blockPtr);
+    newBlock->prev_ = block_;
+    block_ = newBlock;
+    capacity_ += size;
+    
+    current_ = reinterpret_cast<unsigned char*>(((size_t)(blockPtr + sizeof(ArenaBlock)) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1));
+    end_ = current_ + size;
+}
+
+void ArenaAllocator::FreeBlocks()
+{
+    while (block_)
+    {
+        ArenaBlock* prev = block_->prev_;
+        delete[] reinterpret_cast<unsigned char*>(block_);
+        block_ = prev;
+    }
+    
+    current_ = 0;
+    end_ = 0;
+    capacity_ = 0;
+}
+
+}
@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Urho3D.h"
+
+namespace Urho3D
+{
+
+struct ArenaBlock;
+
+/// Linear memory arena. Allocation only advances a pointer and individual allocations are never freed; instead all memory is released at once by Reset(). Not thread-safe.
+class URHO3D_API ArenaAllocator
+{
+public:
+    /// Construct with the initial block size in bytes.
+    ArenaAllocator(unsigned blockSize = 65536);
+    /// Destruct. Free all blocks.
+    ~ArenaAllocator();
+    
+    /// Allocate memory. The memory is aligned to 16 bytes.
+    void* Allocate(unsigned size);
+    /// Release all allocations. If several blocks were used, replace them with one block large enough for all, so that a repeating allocation pattern needs no further blocks.
+    void Reset();
+    
+    /// Return bytes allocated since the last reset.
+    unsigned GetAllocated() const { return allocated_; }
+    /// Return total size of the blocks in bytes.
+    unsigned GetCapacity() const { return capacity_; }
+    /// Return number of blocks.
+    unsigned GetNumBlocks() const;
+    
+private:
+    /// Prevent copy construction.
+    ArenaAllocator(const ArenaAllocator& rhs);
+    /// Prevent assignment.
+    ArenaAllocator& operator = (const ArenaAllocator& rhs);
+    
+    /// Allocate a new block and make it current.
+    void AllocateBlock(unsigned size);
+    /// Free all blocks.
+    void FreeBlocks();
+    
+    /// Current block.
+    ArenaBlock* block_;
+    /// Next free byte in the current block.
+    unsigned char* current_;
+    /// End of the current block.
+    unsigned char* end_;
+    /// Bytes allocated since the last reset.
+    unsigned allocated_;
+    /// Total size of the blocks.
+    unsigned capacity_;
+    /// Initial block size.
+    unsigned blockSize_;
+};
+
+}
@@ -0,0 +1,269 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "ConcurrentAllocator.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Per-thread node cache of a concurrent allocator.
+struct ConcurrentAllocatorCache
+{
+    /// Owning allocator.
+    ConcurrentAllocator* owner_;
+    /// Free nodes.
+    AllocatorNode* free_;
+    /// Number of free nodes.
+    unsigned count_;
+};
+
+#ifdef WIN32
+/// Thread exit callback for fiber-local storage. Windows thread-local storage has no exit callback, but fiber-local storage calls it also when a thread exits.
+static void WINAPI ReleaseCacheFls(void* data)
+{
+    ConcurrentAllocator::ReleaseCacheStatic(data);
+}
+#endif
+
+ConcurrentAllocator::ConcurrentAllocator(unsigned nodeSize, unsigned batchSize) :
+    nodeSize_(nodeSize),
+    batchSize_(batchSize ? batchSize : 1),
+    capacity_(0),
+    free_(0),
+    cacheKey_(0)
+{
+    block_.nodeSize_ = nodeSize;
+    block_.capacity_ = 0;
+    block_.free_ = 0;
+    block_.next_ = 0;
+    block_.arena_ = 0;
+    block_.concurrent_ = this;
+    
+    // The amount of thread-local storage keys is limited. If none is left, use the shared pool directly
+    #ifdef WIN32
+    DWORD* key = new DWORD;
+    *key = FlsAlloc(ReleaseCacheFls);
+    if (*key != FLS_OUT_OF_INDEXES)
+        cacheKey_ = key;
+    #else
+    pthread_key_t* key = new pthread_key_t;
+    if (!pthread_key_create(key, ReleaseCacheStatic))
+        cacheKey_ = key;
+    #endif
+    else
+        delete key;
+}
+
+ConcurrentAllocator::~ConcurrentAllocator()
+{
+    // Deleting the key prevents the thread exit callbacks. On Windows it instead calls them now for all threads that have a
+    // cache, which releases the caches before the pool is freed below
+    if (cacheKey_)
+    {
+        #ifdef WIN32
+        DWORD* key = (DWORD*)cacheKey_;
+        FlsFree(*key);
+        #else
+        pthread_key_t* key = (pthread_key_t*)cacheKey_;
+        pthread_key_delete(*key);
+        #endif
+        delete key;
+    }
+    
+    for (unsigned i = 0; i < caches_.Size(); ++i)
+        delete caches_[i];
+    for (unsigned i = 0; i < blocks_.Size(); ++i)
+        delete[] blocks_[i];
+}
+
+void* ConcurrentAllocator::Reserve()
+{
+    AllocatorNode* node;
+    ConcurrentAllocatorCache* cache = GetCache();
+    if (cache)
+    {
+        if (!cache->free_)
+            Refill(cache);
+        
+        node = cache->free_;
+        cache->free_ = node->next_;
+        --cache->count_;
+    }
+    else
+    {
+        MutexLock lock(poolMutex_);
+        if (!free_)
+            AllocateBlock();
+        
+        node = free_;
+        free_ = node->next_;
+    }
+    node->next_ = 0;
+    
+    return reinterpret_cast<unsigned char*>(node) + sizeof(AllocatorNode);
+}
+
+void ConcurrentAllocator::Free(void* ptr)
+{
+    if (!ptr)
+        return;
+    
+    ConcurrentAllocatorCache* cache = GetCache();
+    AllocatorNode* node = reinterpret_cast<AllocatorNode*>(static_cast<unsigned char*>(ptr) - sizeof(AllocatorNode));
+    if (!cache)
+    {
+        MutexLock lock(poolMutex_);
+        node->next_ = free_;
+        free_ = node;
+        return;
+    }
+    
+    node->next_ = cache->free_;
+    cache->free_ = node;
+    ++cache->count_;
+    
+    // Keep one batch cached for reuse and return the rest
+    if (cache->count_ >= batchSize_ * 2)
+        Flush(cache, cache->count_ - batchSize_);
+}
+
+ConcurrentAllocatorCache* ConcurrentAllocator::GetCache()
+{
+    if (!cacheKey_)
+        return 0;
+    
+    #ifdef WIN32
+    ConcurrentAllocatorCache* cache = static_cast<ConcurrentAllocatorCache*>(FlsGetValue(*(DWORD*)cacheKey_));
+    #else
+    ConcurrentAllocatorCache* cache = static_cast<ConcurrentAllocatorCache*>(pthread_getspecific(*(pthread_key_t*)cacheKey_));
+    #endif
+    
+    if (!cache)
+    {
+        cache = new ConcurrentAllocatorCache();
+        cache->owner_ = this;
+        cache->free_ = 0;
+        cache->count_ = 0;
+        
+        {
+            MutexLock lock(poolMutex_);
+            caches_.Push(cache);
+        }
+        
+        #ifdef WIN32
+        FlsSetValue(*(DWORD*)cacheKey_, cache);
+        #else
+        pthread_setspecific(*(pthread_key_t*)cacheKey_, cache);
+        #endif
+    }
+    
+    return cache;
+}
+
+void ConcurrentAllocator::AllocateBlock()
+{
+    // Grow by half of the current capacity, but at least by one batch per thread
+    unsigned numCaches = caches_.Size() ? caches_.Size() : 1;
+    unsigned newCapacity = capacity_ >> 1;
+    if (newCapacity < batchSize_ * numCaches)
+        newCapacity = batchSize_ * numCaches;
+    
+    unsigned nodeStride = sizeof(AllocatorNode) + nodeSize_;
+    CountHeapAllocation();
+    unsigned char* blockPtr = new unsigned char[newCapacity * nodeStride];
+    blocks_.Push(blockPtr);
+    
+    for (unsigned i = 0; i < newCapacity; ++i)
+    {
+        AllocatorNode* node = reinterpret_cast<AllocatorNode*>(blockPtr + i * nodeStride);
+        node->next_ = i < newCapacity - 1 ? reinterpret_cast<AllocatorNode*>(blockPtr + (i + 1) * nodeStride) : 0;
+    }
+    
+    free_ = reinterpret_cast<AllocatorNode*>(blockPtr);
+    capacity_ += newCapacity;
+}
+
+void ConcurrentAllocator::Refill(ConcurrentAllocatorCache* cache)
+{
+    MutexLock lock(poolMutex_);
+    
+    if (!free_)
+        AllocateBlock();
+    
+    for (unsigned i = 0; i < batchSize_ && free_; ++i)
+    {
+        AllocatorNode* node = free_;
+        free_ = node->next_;
+        node->next_ = cache->free_;
+        cache->free_ = node;
+        ++cache->count_;
+    }
+}
+
+void ConcurrentAllocator::Flush(ConcurrentAllocatorCache* cache, unsigned count)
+{
+    if (!count || !cache->free_)
+        return;
+    
+    // Detach the nodes as a chain first to keep the locked section short
+    AllocatorNode* first = cache->free_;
+    AllocatorNode* last = first;
+    unsigned moved = 1;
+    while (moved < count && last->next_)
+    {
+        last = last->next_;
+        ++moved;
+    }
+    cache->free_ = last->next_;
+    cache->count_ -= moved;
+    
+    MutexLock lock(poolMutex_);
+    last->next_ = free_;
+    free_ = first;
+}
+
+void ConcurrentAllocator::ReleaseCache(ConcurrentAllocatorCache* cache)
+{
+    Flush(cache, cache->count_);
+    
+    MutexLock lock(poolMutex_);
+    caches_.Remove(cache);
+    delete cache;
+}
+
+void ConcurrentAllocator::ReleaseCacheStatic(void* data)
+{
+    ConcurrentAllocatorCache* cache = static_cast<ConcurrentAllocatorCache*>(data);
+    if (cache)
+        cache->owner_->ReleaseCache(cache);
+}
+
+}
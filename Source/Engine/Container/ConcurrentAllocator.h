@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Allocator.h"
+#include "Mutex.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+struct ConcurrentAllocatorCache;
+
+/// Thread-safe fixed-size node allocator. Each thread reserves and frees nodes through its own cache without locking, and moves them to and from a shared pool in batches. Can be shared by several containers, including ones used in different threads. Each allocator uses one thread-local storage key, of which the operating system has a limited amount; if none is left, all threads use the shared pool with locking.
+class URHO3D_API ConcurrentAllocator
+{
+public:
+    /// Construct with node size and the amount of nodes to move between a thread cache and the shared pool at once.
+    ConcurrentAllocator(unsigned nodeSize, unsigned batchSize = 32);
+    /// Destruct. Free all memory. The allocator must not be in use by any thread.
+    ~ConcurrentAllocator();
+    
+    /// Reserve a node.
+    void* Reserve();
+    /// Free a node. May be called from a different thread than the node was reserved in.
+    void Free(void* ptr);
+    
+    /// Return node size.
+    unsigned GetNodeSize() const { return nodeSize_; }
+    /// Return the total amount of nodes.
+    unsigned GetCapacity() const { return capacity_; }
+    /// Return the allocator block to use in containers. Reserving or freeing through it is forwarded to this allocator.
+    AllocatorBlock* GetAllocatorBlock() { return &block_; }
+    
+    /// Return a thread cache's nodes to the shared pool of its allocator and delete the cache. Used as the thread exit callback.
+    static void ReleaseCacheStatic(void* data);
+    
+private:
+    /// Prevent copy construction.
+    ConcurrentAllocator(const ConcurrentAllocator& rhs);
+    /// Prevent assignment.
+    ConcurrentAllocator& operator = (const ConcurrentAllocator& rhs);
+    
+    /// Return the calling thread's cache. Create if necessary. Return null if there is no thread-local storage key.
+    ConcurrentAllocatorCache* GetCache();
+    /// Allocate a new block of nodes to the empty shared pool. The pool mutex must be locked.
+    void AllocateBlock();
+    /// Move a batch of nodes from the shared pool to a cache. Allocate a new block if the pool is empty.
+    void Refill(ConcurrentAllocatorCache* cache);
+    /// Move nodes from a cache to the shared pool.
+    void Flush(ConcurrentAllocatorCache* cache, unsigned count);
+    /// Return all nodes of a cache to the shared pool and delete it. Called on thread exit.
+    void ReleaseCache(ConcurrentAllocatorCache* cache);
+    
+    /// Allocator block that forwards to this allocator.
+    AllocatorBlock block_;
+    /// Node size.
+    unsigned nodeSize_;
+    /// Batch size.
+    unsigned batchSize_;
+    /// Total amount of nodes.
+    unsigned capacity_;
+    /// Shared pool free nodes.
+    AllocatorNode* free_;
+    /// Allocated memory blocks.
+    PODVector<unsigned char*> blocks_;
+    /// Thread caches.
+    PODVector<ConcurrentAllocatorCache*> caches_;
+    /// Thread-local storage key for the caches, or null if none could be created.
+    void* cacheKey_;
+    /// Mutex for the shared pool and the cache list.
+    Mutex poolMutex_;
+};
+
+}
@@ -0,0 +1,482 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Hash.h"
+#include "Pair.h"
+#include "Sort.h"
+#include "Vector.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Open addressing hash table slot of FlatHashMap.
+struct FlatHashSlot
+{
+    /// Hash value of the key.
+    unsigned hash_;
+    /// Index of the key-value pair plus one, or zero if the slot is empty.
+    unsigned index_;
+};
+
+/// Hash map template class with open addressing and contiguous key-value storage. Faster to look up and iterate than HashMap, but erasing moves the last pair into the erased position, so the insertion order is not preserved and erasing invalidates iterators and pointers to the last pair.
+template <class T, class U> class FlatHashMap : public VectorBase
+{
+public:
+    /// Hash map key-value pair with const key.
+    class KeyValue
+    {
+    public:
+        /// Construct with default key.
+        KeyValue() :
+            first_(T())
+        {
+        }
+        
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            second_(second)
+        {
+        }
+        
+        /// Test for equality with another pair.
+        bool operator == (const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+        /// Test for inequality with another pair.
+        bool operator != (const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+        
+        /// Key.
+        const T first_;
+        /// Value.
+        U second_;
+    };
+    
+    typedef RandomAccessIterator<KeyValue> Iterator;
+    typedef RandomAccessConstIterator<KeyValue> ConstIterator;
+    
+    /// Construct empty.
+    FlatHashMap() :
+        slots_(0),
+        numSlots_(0),
+        slotBits_(0)
+    {
+    }
+    
+    /// Construct from another hash map.
+    FlatHashMap(const FlatHashMap<T, U>& map) :
+        slots_(0),
+        numSlots_(0),
+        slotBits_(0)
+    {
+        *this = map;
+    }
+    
+    /// Destruct.
+    ~FlatHashMap()
+    {
+        Clear();
+        delete[] buffer_;
+        delete[] reinterpret_cast<unsigned char*>(slots_);
+    }
+    
+    /// Assign a hash map.
+    FlatHashMap& operator = (const FlatHashMap<T, U>& rhs)
+    {
+        Clear();
+        Insert(rhs);
+        return *this;
+    }
+    
+    /// Add-assign a pair.
+    FlatHashMap& operator += (const Pair<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+    
+    /// Add-assign a hash map.
+    FlatHashMap& operator += (const FlatHashMap<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+    
+    /// Test for equality with another hash map.
+    bool operator == (const FlatHashMap<T, U>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+        
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+        
+        return true;
+    }
+    
+    /// Test for inequality with another hash map.
+    bool operator != (const FlatHashMap<T, U>& rhs) const { return !(*this == rhs); }
+    
+    /// Index the map. Create a new pair if key not found.
+    U& operator [] (const T& key)
+    {
+        unsigned hash = MakeHash(key);
+        unsigned slot = FindSlot(key, hash);
+        if (slot != NOT_FOUND)
+            return Buffer()[slots_[slot].index_ - 1].second_;
+        else
+            return InsertNew(key, U(), hash)->second_;
+    }
+    
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<T, U>& pair) { return Iterator(InsertPair(pair.first_, pair.second_)); }
+    
+    /// Insert a map.
+    void Insert(const FlatHashMap<T, U>& map)
+    {
+        for (ConstIterator i = map.Begin(); i != map.End(); ++i)
+            InsertPair(i->first_, i->second_);
+    }
+    
+    /// Insert a pair by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Iterator(InsertPair(it->first_, it->second_)); }
+    
+    /// Insert a range by iterators.
+    void Insert(const ConstIterator& start, const ConstIterator& end)
+    {
+        for (ConstIterator i = start; i != end; ++i)
+            InsertPair(i->first_, i->second_);
+    }
+    
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned slot = FindSlot(key, MakeHash(key));
+        if (slot == NOT_FOUND)
+            return false;
+        
+        EraseSlot(slot);
+        return true;
+    }
+    
+    /// Erase a pair by iterator. Return iterator to the next pair, which is at the same position as the erased pair was.
+    Iterator Erase(const Iterator& it)
+    {
+        unsigned index = it.ptr_ - Buffer();
+        if (index >= size_)
+            return End();
+        
+        EraseSlot(FindIndexSlot(index, MakeHash(it->first_)));
+        return Begin() + index;
+    }
+    
+    /// Clear the map.
+    void Clear()
+    {
+        DestructElements(Buffer(), size_);
+        size_ = 0;
+        if (numSlots_)
+            memset(slots_, 0, numSlots_ * sizeof(FlatHashSlot));
+    }
+    
+    /// Swap with another hash map.
+    void Swap(FlatHashMap<T, U>& map)
+    {
+        VectorBase::Swap(map);
+        Urho3D::Swap(slots_, map.slots_);
+        Urho3D::Swap(numSlots_, map.numSlots_);
+        Urho3D::Swap(slotBits_, map.slotBits_);
+    }
+    
+    /// Sort pairs. After sorting the map can be iterated in order until new elements are inserted or erased.
+    void Sort()
+    {
+        if (size_ < 2)
+            return;
+        
+        KeyValue** ptrs = new KeyValue*[size_];
+        for (unsigned i = 0; i < size_; ++i)
+            ptrs[i] = Buffer() + i;
+        
+        Urho3D::Sort(RandomAccessIterator<KeyValue*>(ptrs), RandomAccessIterator<KeyValue*>(ptrs + size_), ComparePairs);
+        
+        // The keys are const, so copy the pairs to a new buffer in sorted order
+        KeyValue* newBuffer = reinterpret_cast<KeyValue*>(AllocateBuffer(capacity_ * sizeof(KeyValue)));
+        for (unsigned i = 0; i < size_; ++i)
+            new(newBuffer + i) KeyValue(*ptrs[i]);
+        DestructElements(Buffer(), size_);
+        delete[] buffer_;
+        buffer_ = reinterpret_cast<unsigned char*>(newBuffer);
+        
+        delete[] ptrs;
+        Rehash();
+    }
+    
+    /// Rehash to a specific slot count, which must be a power of two and large enough for the current size. Return true if successful.
+    bool Rehash(unsigned numBuckets)
+    {
+        if (numBuckets == numSlots_)
+            return true;
+        if (!numBuckets || size_ * MAX_LOAD_FACTOR_DIVISOR > numBuckets * MAX_LOAD_FACTOR_MULTIPLIER)
+            return false;
+        
+        // Check for being power of two
+        if (numBuckets & (numBuckets - 1))
+            return false;
+        
+        AllocateSlots(numBuckets);
+        Rehash();
+        return true;
+    }
+    
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key)
+    {
+        unsigned slot = FindSlot(key, MakeHash(key));
+        return slot != NOT_FOUND ? Iterator(Buffer() + slots_[slot].index_ - 1) : End();
+    }
+    
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        unsigned slot = FindSlot(key, MakeHash(key));
+        return slot != NOT_FOUND ? ConstIterator(Buffer() + slots_[slot].index_ - 1) : End();
+    }
+    
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const { return FindSlot(key, MakeHash(key)) != NOT_FOUND; }
+    
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(size_);
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+    
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(Buffer()); }
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(Buffer()); }
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(Buffer() + size_); }
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(Buffer() + size_); }
+    /// Return first pair.
+    const KeyValue& Front() const { assert(size_); return Buffer()[0]; }
+    /// Return last pair.
+    const KeyValue& Back() const { assert(size_); return Buffer()[size_ - 1]; }
+    /// Return number of pairs.
+    unsigned Size() const { return size_; }
+    /// Return number of hash table slots.
+    unsigned NumBuckets() const { return numSlots_; }
+    /// Return whether the map is empty.
+    bool Empty() const { return size_ == 0; }
+    
+    /// Initial amount of hash table slots.
+    static const unsigned MIN_BUCKETS = 16;
+    /// Maximum load factor numerator. The table grows when more than three quarters of the slots are in use.
+    static const unsigned MAX_LOAD_FACTOR_MULTIPLIER = 3;
+    /// Maximum load factor denominator.
+    static const unsigned MAX_LOAD_FACTOR_DIVISOR = 4;
+    
+private:
+    /// Slot index for "not found."
+    static const unsigned NOT_FOUND = 0xffffffff;
+    
+    /// Return the key-value pair buffer.
+    KeyValue* Buffer() const { return reinterpret_cast<KeyValue*>(buffer_); }
+    
+    /// Return the home slot of a hash value. The hash is scrambled with a multiplicative hash, as pointer and integer hashes are not well distributed in the low bits.
+    unsigned HomeSlot(unsigned hash) const { return (hash * 2654435769u) >> (32 - slotBits_); }
+    
+    /// Find the slot of a key, or NOT_FOUND if not found.
+    unsigned FindSlot(const T& key, unsigned hash) const
+    {
+        if (!size_)
+            return NOT_FOUND;
+        
+        unsigned mask = numSlots_ - 1;
+        for (unsigned slot = HomeSlot(hash);; slot = (slot + 1) & mask)
+        {
+            const FlatHashSlot& current = slots_[slot];
+            if (!current.index_)
+                return NOT_FOUND;
+            if (current.hash_ == hash && Buffer()[current.index_ - 1].first_ == key)
+                return slot;
+        }
+    }
+    
+    /// Find the slot that points to a pair index. The pair must exist.
+    unsigned FindIndexSlot(unsigned index, unsigned hash) const
+    {
+        unsigned mask = numSlots_ - 1;
+        unsigned slot = HomeSlot(hash);
+        while (slots_[slot].index_ != index + 1)
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+    
+    /// Insert a pair, or change the value if the key exists. Return the pair.
+    KeyValue* InsertPair(const T& key, const U& value)
+    {
+        unsigned hash = MakeHash(key);
+        unsigned slot = FindSlot(key, hash);
+        if (slot != NOT_FOUND)
+        {
+            KeyValue* existing = Buffer() + slots_[slot].index_ - 1;
+            existing->second_ = value;
+            return existing;
+        }
+        else
+            return InsertNew(key, value, hash);
+    }
+    
+    /// Insert a pair whose key does not exist yet. Return the new pair.
+    KeyValue* InsertNew(const T& key, const U& value, unsigned hash)
+    {
+        // Grow the table if the maximum load factor would be exceeded
+        if ((size_ + 1) * MAX_LOAD_FACTOR_DIVISOR > numSlots_ * MAX_LOAD_FACTOR_MULTIPLIER)
+        {
+            AllocateSlots(numSlots_ ? numSlots_ << 1 : MIN_BUCKETS);
+            Rehash();
+        }
+        
+        if (size_ == capacity_)
+            Reserve(capacity_ ? capacity_ + (capacity_ + 1) / 2 : MIN_BUCKETS / 2);
+        
+        KeyValue* newPair = Buffer() + size_;
+        new(newPair) KeyValue(key, value);
+        ++size_;
+        InsertSlot(hash, size_);
+        return newPair;
+    }
+    
+    /// Reserve space for pairs, copying the existing pairs to a new buffer.
+    void Reserve(unsigned newCapacity)
+    {
+        KeyValue* newBuffer = reinterpret_cast<KeyValue*>(AllocateBuffer(newCapacity * sizeof(KeyValue)));
+        for (unsigned i = 0; i < size_; ++i)
+            new(newBuffer + i) KeyValue(Buffer()[i]);
+        DestructElements(Buffer(), size_);
+        delete[] buffer_;
+        
+        buffer_ = reinterpret_cast<unsigned char*>(newBuffer);
+        capacity_ = newCapacity;
+    }
+    
+    /// Insert a hash value and pair index plus one to the first free slot of the probe sequence.
+    void InsertSlot(unsigned hash, unsigned indexPlusOne)
+    {
+        unsigned mask = numSlots_ - 1;
+        unsigned slot = HomeSlot(hash);
+        while (slots_[slot].index_)
+            slot = (slot + 1) & mask;
+        slots_[slot].hash_ = hash;
+        slots_[slot].index_ = indexPlusOne;
+    }
+    
+    /// Erase a slot and its pair. Move the last pair into the erased position.
+    void EraseSlot(unsigned slot)
+    {
+        unsigned index = slots_[slot].index_ - 1;
+        
+        // Shift the following slots of the probe sequence back to fill the hole, so that no tombstones are needed
+        unsigned mask = numSlots_ - 1;
+        unsigned hole = slot;
+        for (unsigned next = (hole + 1) & mask; slots_[next].index_; next = (next + 1) & mask)
+        {
+            // A slot can move to the hole only if the hole is between its home slot and its current position
+            unsigned home = HomeSlot(slots_[next].hash_);
+            if (((next - home) & mask) >= ((next - hole) & mask))
+            {
+                slots_[hole] = slots_[next];
+                hole = next;
+            }
+        }
+        slots_[hole].index_ = 0;
+        
+        // Move the last pair to the erased position and redirect its slot
+        unsigned last = size_ - 1;
+        KeyValue* buffer = Buffer();
+        (buffer + index)->~KeyValue();
+        if (index != last)
+        {
+            slots_[FindIndexSlot(last, MakeHash(buffer[last].first_))].index_ = index + 1;
+            new(buffer + index) KeyValue(buffer[last]);
+            (buffer + last)->~KeyValue();
+        }
+        --size_;
+    }
+    
+    /// Allocate an empty slot table.
+    void AllocateSlots(unsigned numSlots)
+    {
+        delete[] reinterpret_cast<unsigned char*>(slots_);
+        slots_ = reinterpret_cast<FlatHashSlot*>(AllocateBuffer(numSlots * sizeof(FlatHashSlot)));
+        memset(slots_, 0, numSlots * sizeof(FlatHashSlot));
+        numSlots_ = numSlots;
+        slotBits_ = 0;
+        while ((1u << slotBits_) < numSlots)
+            ++slotBits_;
+    }
+    
+    /// Rebuild the slot table from the pairs.
+    void Rehash()
+    {
+        memset(slots_, 0, numSlots_ * sizeof(FlatHashSlot));
+        KeyValue* buffer = Buffer();
+        for (unsigned i = 0; i < size_; ++i)
+            InsertSlot(MakeHash(buffer[i].first_), i + 1);
+    }
+    
+    /// Call the destructor for pairs.
+    static void DestructElements(KeyValue* dest, unsigned count)
+    {
+        while (count--)
+        {
+            dest->~KeyValue();
+            ++dest;
+        }
+    }
+    
+    /// Compare two pairs by key.
+    static bool ComparePairs(KeyValue*& lhs, KeyValue*& rhs) { return lhs->first_ < rhs->first_; }
+    
+    /// Hash table slots.
+    FlatHashSlot* slots_;
+    /// Number of hash table slots, zero or a power of two.
+    unsigned numSlots_;
+    /// Base two logarithm of the slot count.
+    unsigned slotBits_;
+};
+
+}
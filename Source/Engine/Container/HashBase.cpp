@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "ArenaAllocator.h"
 #include "HashBase.h"
 
 #include "DebugNew.h"
@@ -30,10 +31,17 @@ namespace Urho3D
 
 void HashBase::AllocateBuckets(unsigned size, unsigned numBuckets)
 {
-    if (ptrs_)
-        delete[] ptrs_;
+    FreeBuckets();
     
-    HashNodeBase** ptrs = new HashNodeBase*[numBuckets + 2];
+    HashNodeBase** ptrs;
+    ArenaAllocator* arena = GetArena();
+    if (arena)
+        ptrs = static_cast<HashNodeBase**>(arena->Allocate((numBuckets + 2) * sizeof(HashNodeBase*)));
+    else
+    {
+        CountHeapAllocation();
+        ptrs = new HashNodeBase*[numBuckets + 2];
+    }
     unsigned* data = reinterpret_cast<unsigned*>(ptrs);
     data[0] = size;
     data[1] = numBuckets;
@@ -42,6 +50,13 @@ void HashBase::AllocateBuckets(unsigned size, unsigned numBuckets)
     ResetPtrs();
 }
 
+void HashBase::FreeBuckets()
+{
+    if (ptrs_ && !GetArena())
+        delete[] ptrs_;
+    ptrs_ = 0;
+}
+
 void HashBase::ResetPtrs()
 {
     // Reset bucket pointers
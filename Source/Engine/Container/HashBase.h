@@ -124,10 +124,14 @@ public:
     unsigned NumBuckets() const { return ptrs_ ? (reinterpret_cast<unsigned*>(ptrs_))[1] : 0; }
     /// Return whether has no elements.
     bool Empty() const { return Size() == 0; }
+    /// Return the arena the nodes and buckets are allocated from, or null if from the heap.
+    ArenaAllocator* GetArena() const { return allocator_ ? allocator_->arena_ : 0; }
     
 protected:
     /// Allocate bucket head pointers + room for size and bucket count variables.
     void AllocateBuckets(unsigned size, unsigned numBuckets);
+    /// Free bucket head pointers. Must be called before uninitializing the node allocator.
+    void FreeBuckets();
     /// Reset bucket head pointers.
     void ResetPtrs();
     /// Set new size.
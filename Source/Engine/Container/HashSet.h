@@ -133,6 +133,22 @@ public:
         head_ = tail_ = ReserveNode();
     }
     
+    /// Construct empty and allocate the nodes and buckets from an arena. The arena must not be reset while the set exists.
+    explicit HashSet(ArenaAllocator* arena)
+    {
+        // Reserve the tail node
+        allocator_ = AllocatorInitialize(sizeof(Node), 1, arena);
+        head_ = tail_ = ReserveNode();
+    }
+    
+    /// Construct empty and reserve the nodes from a thread-safe allocator shared with other containers.
+    explicit HashSet(ConcurrentAllocator* allocator)
+    {
+        // Reserve the tail node
+        allocator_ = AllocatorInitialize(sizeof(Node), allocator);
+        head_ = tail_ = ReserveNode();
+    }
+    
     /// Construct from another hash set.
     HashSet(const HashSet<T>& set)
     {
@@ -147,6 +163,7 @@ public:
     {
         Clear();
         FreeNode(Tail());
+        FreeBuckets();
         AllocatorUninitialize(allocator_);
     }
     
@@ -127,6 +127,13 @@ public:
         head_ = tail_ = ReserveNode();
     }
     
+    /// Construct empty and reserve the nodes from a thread-safe allocator shared with other containers.
+    explicit List(ConcurrentAllocator* allocator)
+    {
+        allocator_ = AllocatorInitialize(sizeof(Node), allocator);
+        head_ = tail_ = ReserveNode();
+    }
+    
     /// Construct from another list.
     List(const List<T>& list)
     {
@@ -47,6 +47,15 @@ public:
         AddRef();
     }
     
+    #ifdef URHO3D_CXX11
+    /// Move-construct from another shared pointer. The reference is taken over without changing the refcount.
+    SharedPtr(SharedPtr<T>&& rhs) :
+        ptr_(rhs.ptr_)
+    {
+        rhs.ptr_ = 0;
+    }
+    #endif
+    
     /// Construct from a raw pointer.
     explicit SharedPtr(T* ptr) :
         ptr_(ptr)
@@ -73,6 +82,21 @@ public:
         return *this;
     }
     
+    #ifdef URHO3D_CXX11
+    /// Move-assign from another shared pointer.
+    SharedPtr<T>& operator = (SharedPtr<T>&& rhs)
+    {
+        if (this == &rhs)
+            return *this;
+        
+        ReleaseRef();
+        ptr_ = rhs.ptr_;
+        rhs.ptr_ = 0;
+        
+        return *this;
+    }
+    #endif
+    
     /// Assign from a raw pointer.
     SharedPtr<T>& operator = (T* ptr)
     {
@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "Allocator.h"
 #include "Str.h"
 #include "Swap.h"
 
@@ -31,22 +32,20 @@
 namespace Urho3D
 {
 
-char String::endZero = 0;
-
 const String String::EMPTY;
 
 String::String(const WString& str) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     SetUTF8FromWChar(str.CString());
 }
 
 String::String(int value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%d", value);
@@ -54,9 +53,9 @@ String::String(int value) :
 }
 
 String::String(short value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%d", value);
@@ -64,9 +63,9 @@ String::String(short value) :
 }
 
 String::String(long value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%ld", value);
@@ -74,9 +73,9 @@ String::String(long value) :
 }
     
 String::String(long long value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%lld", value);
@@ -84,9 +83,9 @@ String::String(long long value) :
 }
 
 String::String(unsigned value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%u", value);
@@ -94,9 +93,9 @@ String::String(unsigned value) :
 }
 
 String::String(unsigned short value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%u", value);
@@ -104,9 +103,9 @@ String::String(unsigned short value) :
 }
 
 String::String(unsigned long value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%lu", value);
@@ -114,9 +113,9 @@ String::String(unsigned long value) :
 }
     
 String::String(unsigned long long value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%llu", value);
@@ -124,9 +123,9 @@ String::String(unsigned long long value) :
 }
 
 String::String(float value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%g", value);
@@ -134,9 +133,9 @@ String::String(float value) :
 }
 
 String::String(double value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%g", value);
@@ -144,9 +143,9 @@ String::String(double value) :
 }
 
 String::String(bool value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     if (value)
         *this = "true";
@@ -155,18 +154,18 @@ String::String(bool value) :
 }
 
 String::String(char value) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     Resize(1);
     buffer_[0] = value;
 }
 
 String::String(char value, unsigned length) :
+    buffer_(inline_),
     length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    capacity_(0)
 {
     Resize(length);
     for (unsigned i = 0; i < length; ++i)
@@ -393,18 +392,25 @@ String::Iterator String::Erase(const String::Iterator& start, const String::Iter
 
 void String::Resize(unsigned newLength)
 {
-    if (!capacity_)
+    if (buffer_ == inline_)
     {
-        // If zero length requested, do not allocate buffer yet
-        if (!newLength)
-            return;
-        
-        // Calculate initial capacity
-        capacity_ = newLength + 1;
-        if (capacity_ < MIN_CAPACITY)
-            capacity_ = MIN_CAPACITY;
-        
-        buffer_ = new char[capacity_];
+        // Short strings are stored in the inline buffer without allocating
+        if (newLength >= INLINE_CAPACITY)
+        {
+            // Calculate initial capacity
+            unsigned newCapacity = newLength + 1;
+            if (newCapacity < MIN_CAPACITY)
+                newCapacity = MIN_CAPACITY;
+            
+            CountHeapAllocation();
+            char* newBuffer = new char[newCapacity];
+            // Copy the inline data before the capacity overwrites it
+            if (length_)
+                CopyChars(newBuffer, inline_, length_);
+            
+            buffer_ = newBuffer;
+            capacity_ = newCapacity;
+        }
     }
     else
     {
@@ -414,6 +420,7 @@ void String::Resize(unsigned newLength)
             while (capacity_ < newLength + 1)
                 capacity_ += (capacity_ + 1) >> 1;
             
+            CountHeapAllocation();
             char* newBuffer = new char[capacity_];
             // Move the existing data to the new buffer, then delete the old buffer
             if (length_)
@@ -432,22 +439,36 @@ void String::Reserve(unsigned newCapacity)
 {
     if (newCapacity < length_ + 1)
         newCapacity = length_ + 1;
-    if (newCapacity == capacity_)
+    if (newCapacity == Capacity())
         return;
     
+    if (newCapacity <= INLINE_CAPACITY)
+    {
+        // Move the data back to the inline buffer if it fits
+        if (buffer_ != inline_)
+        {
+            char* oldBuffer = buffer_;
+            CopyChars(inline_, oldBuffer, length_ + 1);
+            buffer_ = inline_;
+            delete[] oldBuffer;
+        }
+        return;
+    }
+    
+    CountHeapAllocation();
     char* newBuffer = new char[newCapacity];
     // Move the existing data to the new buffer, then delete the old buffer
     CopyChars(newBuffer, buffer_, length_ + 1);
-    if (capacity_)
+    if (buffer_ != inline_)
         delete[] buffer_;
     
-    capacity_ = newCapacity;
     buffer_ = newBuffer;
+    capacity_ = newCapacity;
 }
 
 void String::Compact()
 {
-    if (capacity_)
+    if (buffer_ != inline_)
         Reserve(length_ + 1);
 }
 
@@ -458,9 +479,45 @@ void String::Clear()
 
 void String::Swap(String& str)
 {
-    Urho3D::Swap(length_, str.length_);
-    Urho3D::Swap(capacity_, str.capacity_);
-    Urho3D::Swap(buffer_, str.buffer_);
+    if (buffer_ != inline_ && str.buffer_ != str.inline_)
+    {
+        Urho3D::Swap(buffer_, str.buffer_);
+        Urho3D::Swap(length_, str.length_);
+        Urho3D::Swap(capacity_, str.capacity_);
+        return;
+    }
+    
+    // At least one of the strings is inline, so the inline data has to be copied
+    char tempInline[INLINE_CAPACITY];
+    char* tempBuffer = buffer_ != inline_ ? buffer_ : tempInline;
+    unsigned tempLength = length_;
+    unsigned tempCapacity = buffer_ != inline_ ? capacity_ : 0;
+    if (buffer_ == inline_)
+        CopyChars(tempInline, inline_, length_ + 1);
+    
+    if (str.buffer_ != str.inline_)
+    {
+        buffer_ = str.buffer_;
+        capacity_ = str.capacity_;
+    }
+    else
+    {
+        buffer_ = inline_;
+        CopyChars(inline_, str.inline_, str.length_ + 1);
+    }
+    length_ = str.length_;
+    
+    if (tempBuffer != tempInline)
+    {
+        str.buffer_ = tempBuffer;
+        str.capacity_ = tempCapacity;
+    }
+    else
+    {
+        str.buffer_ = str.inline_;
+        CopyChars(str.inline_, tempInline, tempLength + 1);
+    }
+    str.length_ = tempLength;
 }
 
 String String::Substring(unsigned pos) const
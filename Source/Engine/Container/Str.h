@@ -44,44 +44,44 @@ public:
     
     /// Construct empty.
     String() :
+        buffer_(inline_),
         length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        capacity_(0)
     {
     }
     
     /// Construct from another string.
     String(const String& str) :
+        buffer_(inline_),
         length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        capacity_(0)
     {
         *this = str;
     }
     
     /// Construct from a C string.
     String(const char* str) :
+        buffer_(inline_),
         length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        capacity_(0)
     {
         *this = str;
     }
     
     /// Construct from a C string.
     String(char* str) :
+        buffer_(inline_),
         length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        capacity_(0)
     {
         *this = (const char*)str;
     }
     
     /// Construct from a char array and length.
     String(const char* str, unsigned length) :
+        buffer_(inline_),
         length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        capacity_(0)
     {
         Resize(length);
         CopyChars(buffer_, str, length);
@@ -89,18 +89,18 @@ public:
     
     /// Construct from a null-terminated wide character array.
     String(const wchar_t* str) :
+        buffer_(inline_),
         length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        capacity_(0)
     {
         SetUTF8FromWChar(str);
     }
     
     /// Construct from a null-terminated wide character array.
     String(wchar_t* str) :
+        buffer_(inline_),
         length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        capacity_(0)
     {
         SetUTF8FromWChar(str);
     }
@@ -137,17 +137,28 @@ public:
     
     /// Construct from a convertable value.
     template <class T> explicit String(const T& value) :
+        buffer_(inline_),
         length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        capacity_(0)
     {
         *this = value.ToString();
     }
     
+    #ifdef URHO3D_CXX11
+    /// Move-construct from another string.
+    String(String&& str) :
+        buffer_(inline_),
+        length_(0),
+        capacity_(0)
+    {
+        Swap(str);
+    }
+    #endif
+    
     /// Destruct.
     ~String()
     {
-        if (capacity_)
+        if (buffer_ != inline_)
             delete[] buffer_;
     }
     
@@ -160,6 +171,15 @@ public:
         return *this;
     }
     
+    #ifdef URHO3D_CXX11
+    /// Move-assign a string.
+    String& operator = (String&& rhs)
+    {
+        Swap(rhs);
+        return *this;
+    }
+    #endif
+    
     /// Assign a C string.
     String& operator = (const char* rhs)
     {
@@ -365,7 +385,7 @@ public:
     /// Return length.
     unsigned Length() const { return length_; }
     /// Return buffer capacity.
-    unsigned Capacity() const { return capacity_; }
+    unsigned Capacity() const { return buffer_ != inline_ ? capacity_ : INLINE_CAPACITY; }
     /// Return whether the string is empty.
     bool Empty() const { return length_ == 0; }
     /// Return comparision result with a string.
@@ -454,6 +474,8 @@ public:
     static const unsigned NPOS = 0xffffffff;
     /// Initial dynamic allocation size.
     static const unsigned MIN_CAPACITY = 8;
+    /// Size of the inline buffer for short strings, including the terminating zero. Shares space with the capacity, so that the string stays small enough to be stored in a Variant.
+    static const unsigned INLINE_CAPACITY = 2 * sizeof(char*) - sizeof(unsigned);
     /// Empty string.
     static const String EMPTY;
     
@@ -485,15 +507,18 @@ private:
     /// Replace a substring with another substring.
     void Replace(unsigned pos, unsigned length, const char* srcStart, unsigned srcLength);
     
+    /// String buffer. Points to the inline buffer if not allocated.
+    char* buffer_;
     /// String length.
     unsigned length_;
-    /// Capacity, zero if buffer not allocated.
-    unsigned capacity_;
-    /// String buffer, null if not allocated.
-    char* buffer_;
     
-    /// End zero for empty strings.
-    static char endZero;
+    union
+    {
+        /// Capacity of the allocated buffer. Only valid when allocated. Initializing it to zero also terminates the inline buffer.
+        unsigned capacity_;
+        /// Inline buffer for short strings.
+        char inline_[INLINE_CAPACITY];
+    };
 };
 
 /// Add a string to a C string.
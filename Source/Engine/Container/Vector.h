@@ -61,6 +61,14 @@ public:
         *this = vector;
     }
     
+    #ifdef URHO3D_CXX11
+    /// Move-construct from another vector.
+    Vector(Vector<T>&& vector)
+    {
+        Swap(vector);
+    }
+    #endif
+    
     /// Destruct.
     ~Vector()
     {
@@ -76,6 +84,15 @@ public:
         return *this;
     }
     
+    #ifdef URHO3D_CXX11
+    /// Move-assign from another vector.
+    Vector<T>& operator = (Vector<T>&& rhs)
+    {
+        Swap(rhs);
+        return *this;
+    }
+    #endif
+    
     /// Add-assign an element.
     Vector<T>& operator += (const T& rhs)
     {
@@ -462,33 +479,52 @@ public:
     typedef RandomAccessConstIterator<T> ConstIterator;
     
     /// Construct empty.
-    PODVector()
+    PODVector() :
+        arena_(0)
     {
     }
     
     /// Construct with initial size.
-    explicit PODVector(unsigned size)
+    explicit PODVector(unsigned size) :
+        arena_(0)
     {
         Resize(size);
     }
     
     /// Construct with initial data.
-    PODVector(const T* data, unsigned size)
+    PODVector(const T* data, unsigned size) :
+        arena_(0)
     {
         Resize(size);
         CopyElements(Buffer(), data, size);
     }
     
-    /// Construct from another vector.
-    PODVector(const PODVector<T>& vector)
+    /// Construct empty and allocate the buffer from an arena. After the arena is reset the vector may only be destroyed.
+    explicit PODVector(ArenaAllocator* arena) :
+        arena_(arena)
+    {
+    }
+    
+    /// Construct from another vector. The buffer is allocated from the heap.
+    PODVector(const PODVector<T>& vector) :
+        arena_(0)
     {
         *this = vector;
     }
     
+    #ifdef URHO3D_CXX11
+    /// Move-construct from another vector. The buffer and the arena it was allocated from are taken over.
+    PODVector(PODVector<T>&& vector) :
+        arena_(0)
+    {
+        Swap(vector);
+    }
+    #endif
+    
     /// Destruct.
     ~PODVector()
     {
-        delete[] buffer_;
+        FreeBuffer(buffer_);
     }
     
     /// Assign from another vector.
@@ -499,6 +535,15 @@ public:
         return *this;
     }
     
+    #ifdef URHO3D_CXX11
+    /// Move-assign from another vector. The buffer and the arena it was allocated from are taken over.
+    PODVector<T>& operator = (PODVector<T>&& rhs)
+    {
+        Swap(rhs);
+        return *this;
+    }
+    #endif
+    
     /// Add-assign an element.
     PODVector<T>& operator += (const T& rhs)
     {
@@ -737,12 +782,12 @@ public:
                     capacity_ += (capacity_ + 1) >> 1;
             }
             
-            unsigned char* newBuffer = AllocateBuffer(capacity_ * sizeof(T));
+            unsigned char* newBuffer = AllocateBuffer(capacity_ * sizeof(T), arena_);
             // Move the data into the new buffer and delete the old
             if (buffer_)
             {
                 CopyElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
-                delete[] buffer_;
+                FreeBuffer(buffer_);
             }
             buffer_ = newBuffer;
         }
@@ -763,13 +808,13 @@ public:
             
             if (capacity_)
             {
-                newBuffer = AllocateBuffer(capacity_ * sizeof(T));
+                newBuffer = AllocateBuffer(capacity_ * sizeof(T), arena_);
                 // Move the data into the new buffer
                 CopyElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
             }
             
             // Delete the old buffer
-            delete[] buffer_;
+            FreeBuffer(buffer_);
             buffer_ = newBuffer;
         }
     }
@@ -777,6 +822,41 @@ public:
     /// Reallocate so that no extra memory is used.
     void Compact() { Reserve(size_); }
     
+    /// Set the arena to allocate the buffer from, or null to use the heap. Existing elements are moved to a new buffer. After the arena is reset the vector may only be destroyed.
+    void SetArena(ArenaAllocator* arena)
+    {
+        if (arena == arena_)
+            return;
+        
+        unsigned char* oldBuffer = buffer_;
+        ArenaAllocator* oldArena = arena_;
+        arena_ = arena;
+        buffer_ = capacity_ ? AllocateBuffer(capacity_ * sizeof(T), arena_) : 0;
+        CopyElements(Buffer(), reinterpret_cast<T*>(oldBuffer), size_);
+        if (!oldArena)
+            delete[] oldBuffer;
+    }
+    
+    /// Clear and set the arena to allocate the buffer from, or null to use the heap. An arena buffer is discarded without freeing, so this may be called after the arena has been reset. A heap buffer is kept if the heap remains in use.
+    void ResetArena(ArenaAllocator* arena)
+    {
+        if (arena_ || arena)
+        {
+            FreeBuffer(buffer_);
+            buffer_ = 0;
+            capacity_ = 0;
+        }
+        size_ = 0;
+        arena_ = arena;
+    }
+    
+    /// Swap with another vector.
+    void Swap(PODVector<T>& rhs)
+    {
+        VectorBase::Swap(rhs);
+        Urho3D::Swap(arena_, rhs.arena_);
+    }
+    
     /// Return iterator to value, or to the end if not found.
     Iterator Find(const T& value)
     {
@@ -819,6 +899,8 @@ public:
     unsigned Capacity() const { return capacity_; }
     /// Return whether vector is empty.
     bool Empty() const { return size_ == 0; }
+    /// Return the arena the buffer is allocated from, or null if from the heap.
+    ArenaAllocator* GetArena() const { return arena_; }
     
 private:
     /// Return the buffer with right type.
@@ -837,6 +919,16 @@ private:
         if (count)
             memcpy(dest, src, count * sizeof(T));
     }
+    
+    /// Free a buffer unless it was allocated from the arena.
+    void FreeBuffer(unsigned char* buffer)
+    {
+        if (!arena_)
+            delete[] buffer;
+    }
+    
+    /// Arena to allocate the buffer from, or null to use the heap.
+    ArenaAllocator* arena_;
 };
 
 }
@@ -21,6 +21,8 @@
 //
 
 #include "Precompiled.h"
+#include "Allocator.h"
+#include "ArenaAllocator.h"
 #include "VectorBase.h"
 
 #include "DebugNew.h"
@@ -30,7 +32,13 @@ namespace Urho3D
 
 unsigned char* VectorBase::AllocateBuffer(unsigned size)
 {
+    CountHeapAllocation();
     return new unsigned char[size];
 }
 
+unsigned char* VectorBase::AllocateBuffer(unsigned size, ArenaAllocator* arena)
+{
+    return arena ? static_cast<unsigned char*>(arena->Allocate(size)) : AllocateBuffer(size);
+}
+
 }
@@ -28,6 +28,8 @@
 namespace Urho3D
 {
 
+class ArenaAllocator;
+
 /// Random access iterator.
 template <class T> struct RandomAccessIterator
 {
@@ -165,7 +167,10 @@ public:
     }
     
 protected:
+    /// Allocate a buffer from the heap.
     static unsigned char* AllocateBuffer(unsigned size);
+    /// Allocate a buffer from an arena, or from the heap if null.
+    static unsigned char* AllocateBuffer(unsigned size, ArenaAllocator* arena);
     
     /// Size of vector.
     unsigned size_;
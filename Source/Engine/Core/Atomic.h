@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Urho3D.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Urho3D
+{
+
+/// Atomically increment an integer and return the new value.
+inline int AtomicIncrement(volatile int* value)
+{
+    #ifdef _MSC_VER
+    return (int)_InterlockedIncrement((volatile long*)value);
+    #else
+    return __sync_add_and_fetch(value, 1);
+    #endif
+}
+
+/// Atomically decrement an integer and return the new value.
+inline int AtomicDecrement(volatile int* value)
+{
+    #ifdef _MSC_VER
+    return (int)_InterlockedDecrement((volatile long*)value);
+    #else
+    return __sync_sub_and_fetch(value, 1);
+    #endif
+}
+
+/// Atomically add to an integer and return the new value.
+inline int AtomicAdd(volatile int* value, int delta)
+{
+    #ifdef _MSC_VER
+    return (int)_InterlockedExchangeAdd((volatile long*)value, delta) + delta;
+    #else
+    return __sync_add_and_fetch(value, delta);
+    #endif
+}
+
+/// Atomically replace an integer with a new value if it equals the comparand. Return true if replaced.
+inline bool AtomicCompareAndSwap(volatile int* value, int comparand, int newValue)
+{
+    #ifdef _MSC_VER
+    return _InterlockedCompareExchange((volatile long*)value, newValue, comparand) == comparand;
+    #else
+    return __sync_bool_compare_and_swap(value, comparand, newValue);
+    #endif
+}
+
+/// Atomically replace a pointer with a new value if it equals the comparand. Return true if replaced.
+inline bool AtomicCompareAndSwapPointer(void* volatile* value, void* comparand, void* newValue)
+{
+    #ifdef _MSC_VER
+    return _InterlockedCompareExchangePointer(value, newValue, comparand) == comparand;
+    #else
+    return __sync_bool_compare_and_swap(value, comparand, newValue);
+    #endif
+}
+
+/// Atomically replace a pointer with a new value and return the previous value.
+inline void* AtomicExchangePointer(void* volatile* value, void* newValue)
+{
+    #ifdef _MSC_VER
+    return _InterlockedExchangePointer(value, newValue);
+    #else
+    void* oldValue;
+    do
+    {
+        oldValue = *value;
+    }
+    while (!__sync_bool_compare_and_swap(value, oldValue, newValue));
+    return oldValue;
+    #endif
+}
+
+/// Issue a full memory barrier. Neither the compiler nor the CPU may reorder loads and stores across it.
+inline void MemoryFence()
+{
+    #ifdef _MSC_VER
+    long barrier = 0;
+    _InterlockedExchange(&barrier, 0);
+    #else
+    __sync_synchronize();
+    #endif
+}
+
+}
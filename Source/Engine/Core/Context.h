@@ -23,6 +23,7 @@
 #pragma once
 
 #include "Attribute.h"
+#include "FlatHashMap.h"
 #include "Object.h"
 #include "HashSet.h"
 
@@ -81,7 +82,7 @@ public:
     /// Return all subsystems.
     const HashMap<ShortStringHash, SharedPtr<Object> >& GetSubsystems() const { return subsystems_; }
     /// Return all object factories.
-    const HashMap<ShortStringHash, SharedPtr<ObjectFactory> >& GetObjectFactories() const { return factories_; }
+    const FlatHashMap<ShortStringHash, SharedPtr<ObjectFactory> >& GetObjectFactories() const { return factories_; }
     /// Return all object categories.
     const HashMap<String, Vector<ShortStringHash> >& GetObjectCategories() const { return objectCategories_; }
     /// Return active event sender. Null outside event handling.
@@ -150,7 +151,7 @@ private:
     void EndSendEvent() { eventSenders_.Pop(); }
 
     /// Object factories.
-    HashMap<ShortStringHash, SharedPtr<ObjectFactory> > factories_;
+    FlatHashMap<ShortStringHash, SharedPtr<ObjectFactory> > factories_;
     /// Subsystems.
     HashMap<ShortStringHash, SharedPtr<Object> > subsystems_;
     /// Attribute descriptions per object type.
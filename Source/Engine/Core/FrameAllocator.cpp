@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "CoreEvents.h"
+#include "FrameAllocator.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+FrameAllocator::FrameAllocator(Context* context) :
+    Object(context),
+    lastHeapAllocations_(GetNumHeapAllocations()),
+    frameHeapAllocations_(0),
+    frameMemory_(0)
+{
+    // Create the main thread's arena
+    arenas_.Push(new ArenaAllocator());
+    
+    SubscribeToEvent(E_ENDFRAME, HANDLER(FrameAllocator, HandleEndFrame));
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+        delete arenas_[i];
+    arenas_.Clear();
+}
+
+void FrameAllocator::SetNumThreads(unsigned numThreads)
+{
+    // The worker threads may already be using their arenas, so allow setting only once
+    if (arenas_.Size() > 1)
+        return;
+    
+    for (unsigned i = 1; i < numThreads; ++i)
+        arenas_.Push(new ArenaAllocator());
+}
+
+void* FrameAllocator::Allocate(unsigned size, unsigned threadIndex)
+{
+    ArenaAllocator* arena = GetArena(threadIndex);
+    return arena ? arena->Allocate(size) : 0;
+}
+
+void FrameAllocator::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    frameMemory_ = 0;
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+    {
+        frameMemory_ += arenas_[i]->GetAllocated();
+        arenas_[i]->Reset();
+    }
+    
+    unsigned heapAllocations = GetNumHeapAllocations();
+    frameHeapAllocations_ = heapAllocations - lastHeapAllocations_;
+    lastHeapAllocations_ = heapAllocations;
+}
+
+}
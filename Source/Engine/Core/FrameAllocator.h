@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "ArenaAllocator.h"
+#include "Object.h"
+
+namespace Urho3D
+{
+
+/// Per-frame memory arenas for transient data. There is one arena for the main thread and one for each WorkQueue worker thread, indexed by the work item thread index, and all of them are reset at the end of the frame.
+class URHO3D_API FrameAllocator : public Object
+{
+    OBJECT(FrameAllocator);
+    
+public:
+    /// Construct.
+    FrameAllocator(Context* context);
+    /// Destruct.
+    virtual ~FrameAllocator();
+    
+    /// Set number of threads including the main thread. Called by WorkQueue before starting the worker threads.
+    void SetNumThreads(unsigned numThreads);
+    /// Allocate memory from a thread's arena. Return null if the thread index is out of range.
+    void* Allocate(unsigned size, unsigned threadIndex = 0);
+    
+    /// Return the arena of a thread, or null if the thread index is out of range. 0 is the main thread.
+    ArenaAllocator* GetArena(unsigned threadIndex = 0) const { return threadIndex < arenas_.Size() ? arenas_[threadIndex] : 0; }
+    /// Return number of arenas.
+    unsigned GetNumArenas() const { return arenas_.Size(); }
+    /// Return bytes allocated from all arenas on the last frame.
+    unsigned GetFrameMemory() const { return frameMemory_; }
+    /// Return number of general heap allocations made by containers on the last frame.
+    unsigned GetFrameHeapAllocations() const { return frameHeapAllocations_; }
+    
+private:
+    /// Handle frame end event. Reset the arenas.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    
+    /// Arenas indexed by thread index.
+    PODVector<ArenaAllocator*> arenas_;
+    /// Heap allocation count at the previous frame end.
+    unsigned lastHeapAllocations_;
+    /// Heap allocations on the last frame.
+    unsigned frameHeapAllocations_;
+    /// Bytes allocated from the arenas on the last frame.
+    unsigned frameMemory_;
+};
+
+}
@@ -24,6 +24,7 @@
 
 #if defined(_MSC_VER) && defined(ENABLE_MINIDUMPS)
 
+#include "Log.h"
 #include "ProcessUtils.h"
 
 #include <cstdio>
@@ -48,6 +49,9 @@ URHO3D_API int WriteMiniDump(const char* applicationName, void* exceptionPointer
     
     miniDumpWritten = true;
     
+    // Write out log messages that are still waiting in the asynchronous log queue
+    Log::FlushOnCrash();
+    
     MINIDUMP_EXCEPTION_INFORMATION info;
     info.ThreadId = GetCurrentThreadId();
     info.ExceptionPointers = (EXCEPTION_POINTERS*)exceptionPointers;
@@ -21,8 +21,17 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
 #include "CoreEvents.h"
 #include "Profiler.h"
+#include "Serializer.h"
+#include "Thread.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 #include <cstdio>
 #include <cstring>
@@ -34,29 +43,194 @@ namespace Urho3D
 
 static const int LINE_MAX_LENGTH = 256;
 static const int NAME_MAX_LENGTH = 30;
+static const unsigned EVENT_BUFFER_SIZE = 8192;
+static const unsigned MAX_TRACE_EVENTS = 1000000;
+
+/// Profiling data of a worker thread. The worker thread writes block begin and end events to a fixed-size ring buffer, which the main thread reads at the end of each frame.
+class ProfilerThread
+{
+public:
+    /// Construct.
+    ProfilerThread(unsigned index) :
+        root_(new ProfilerBlock(0, "Root")),
+        current_(root_),
+        index_(index),
+        head_(0),
+        tail_(0),
+        openDepth_(0),
+        droppedDepth_(0)
+    {
+        events_.Resize(EVENT_BUFFER_SIZE);
+    }
+    
+    /// Destruct.
+    ~ProfilerThread()
+    {
+        delete root_;
+        root_ = 0;
+    }
+    
+    /// Add an event. Called only by the worker thread. If the buffer is full, the block is dropped, but space is always reserved for ending the already open blocks.
+    void Push(const char* name, long long time, bool begin)
+    {
+        unsigned head = head_;
+        
+        if (begin)
+        {
+            if (droppedDepth_ || head - tail_ + openDepth_ + 1 >= EVENT_BUFFER_SIZE)
+            {
+                ++droppedDepth_;
+                return;
+            }
+            ++openDepth_;
+        }
+        else
+        {
+            if (droppedDepth_)
+            {
+                --droppedDepth_;
+                return;
+            }
+            if (!openDepth_)
+                return;
+            --openDepth_;
+        }
+        
+        ProfilerEvent& event = events_[head & (EVENT_BUFFER_SIZE - 1)];
+        event.name_ = name;
+        event.time_ = time;
+        event.threadIndex_ = index_;
+        event.begin_ = begin;
+        
+        // Make sure the event is written before it becomes visible to the main thread
+        MemoryFence();
+        head_ = head + 1;
+    }
+    
+    /// Root profiling block.
+    ProfilerBlock* root_;
+    /// Current profiling block when reading events.
+    ProfilerBlock* current_;
+    /// Thread index.
+    unsigned index_;
+    /// Event ring buffer.
+    PODVector<ProfilerEvent> events_;
+    /// Write position, advanced by the worker thread.
+    volatile unsigned head_;
+    /// Read position, advanced by the main thread.
+    volatile unsigned tail_;
+    /// Number of open blocks that have been written.
+    unsigned openDepth_;
+    /// Number of open blocks that have been dropped.
+    unsigned droppedDepth_;
+};
+
+/// Append a string to JSON output with quotes and backslashes escaped.
+static void AppendEscaped(String& output, const char* str)
+{
+    while (*str)
+    {
+        char c = *str++;
+        if (c == '"' || c == '\\')
+            output += '\\';
+        output += c;
+    }
+}
 
 Profiler::Profiler(Context* context) :
     Object(context),
     current_(0),
     root_(0),
     intervalFrames_(0),
-    totalFrames_(0)
+    totalFrames_(0),
+    traceFrames_(M_MAX_UNSIGNED),
+    traceFramesLeft_(0),
+    threadKey_(0),
+    tracing_(false)
 {
     root_ = new ProfilerBlock(0, "Root");
     current_ = root_;
+    
+    // The worker threads find their profiling data through a thread-local slot. The data is owned by the profiler, so no
+    // thread exit callback is needed
+    #ifdef WIN32
+    threadKey_ = (void*)(size_t)TlsAlloc();
+    #else
+    pthread_key_t* key = new pthread_key_t;
+    pthread_key_create(key, 0);
+    threadKey_ = key;
+    #endif
 }
 
 Profiler::~Profiler()
 {
+    #ifdef WIN32
+    TlsFree((DWORD)(size_t)threadKey_);
+    #else
+    pthread_key_t* key = (pthread_key_t*)threadKey_;
+    pthread_key_delete(*key);
+    delete key;
+    #endif
+    
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        delete threads_[i];
+    threads_.Clear();
+    
     delete root_;
     root_ = 0;
 }
 
+void Profiler::BeginBlock(const char* name)
+{
+    if (Thread::IsMainThread())
+    {
+        current_ = current_->GetChild(name);
+        current_->Begin();
+        if (tracing_)
+            AddTraceEvent(current_->name_, true);
+    }
+    else
+    {
+        ProfilerThread* thread = GetCurrentThread();
+        if (thread)
+            thread->Push(name, eventTimer_.GetUSec(false), true);
+    }
+}
+
+void Profiler::EndBlock()
+{
+    if (Thread::IsMainThread())
+    {
+        if (current_ != root_)
+        {
+            current_->End();
+            if (tracing_)
+                AddTraceEvent(current_->name_, false);
+            current_ = current_->parent_;
+        }
+    }
+    else
+    {
+        ProfilerThread* thread = GetCurrentThread();
+        if (thread)
+            thread->Push(0, eventTimer_.GetUSec(false), false);
+    }
+}
+
 void Profiler::BeginFrame()
 {
     // End the previous frame if any
     EndFrame();
     
+    // Start a pending trace capture
+    if (traceFrames_ != M_MAX_UNSIGNED)
+    {
+        traceEvents_.Clear();
+        traceFramesLeft_ = traceFrames_;
+        traceFrames_ = M_MAX_UNSIGNED;
+        tracing_ = true;
+    }
+    
     BeginBlock("RunFrame");
 }
 
@@ -71,15 +245,93 @@ void Profiler::EndFrame()
             ++totalFrames_;
         root_->EndFrame();
         current_ = root_;
+        
+        ProcessThreadEvents();
+        
+        if (tracing_ && ((traceFramesLeft_ && !--traceFramesLeft_) || traceEvents_.Size() >= MAX_TRACE_EVENTS))
+            tracing_ = false;
     }
 }
 
 void Profiler::BeginInterval()
 {
     root_->BeginInterval();
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        threads_[i]->root_->BeginInterval();
     intervalFrames_ = 0;
 }
 
+void Profiler::SetNumThreads(unsigned numThreads)
+{
+    // The worker threads may already be using the buffers, so allow setting only once
+    if (!threads_.Empty())
+        return;
+    
+    for (unsigned i = 1; i < numThreads; ++i)
+        threads_.Push(new ProfilerThread(i));
+}
+
+void Profiler::RegisterThread(unsigned index)
+{
+    if (!index || index > threads_.Size())
+        return;
+    
+    #ifdef WIN32
+    TlsSetValue((DWORD)(size_t)threadKey_, threads_[index - 1]);
+    #else
+    pthread_setspecific(*(pthread_key_t*)threadKey_, threads_[index - 1]);
+    #endif
+}
+
+void Profiler::BeginTrace(unsigned numFrames)
+{
+    traceFrames_ = numFrames;
+}
+
+void Profiler::EndTrace()
+{
+    traceFrames_ = M_MAX_UNSIGNED;
+    tracing_ = false;
+}
+
+bool Profiler::SaveTrace(Serializer& dest) const
+{
+    char line[LINE_MAX_LENGTH];
+    String output("{\"traceEvents\":[\n");
+    
+    for (unsigned i = 0; i < GetNumThreads(); ++i)
+    {
+        if (!i)
+            sprintf(line, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Main thread\"}}");
+        else
+            sprintf(line, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"Worker thread %u\"}}", i, i);
+        output += String(line);
+        output += i + 1 < GetNumThreads() || traceEvents_.Size() ? ",\n" : "\n";
+    }
+    
+    for (unsigned i = 0; i < traceEvents_.Size(); ++i)
+    {
+        const ProfilerEvent& event = traceEvents_[i];
+        output += "{\"name\":\"";
+        AppendEscaped(output, event.name_);
+        sprintf(line, "\",\"ph\":\"%c\",\"pid\":0,\"tid\":%u,\"ts\":%lld}", event.begin_ ? 'B' : 'E', event.threadIndex_, event.time_);
+        output += String(line);
+        output += i + 1 < traceEvents_.Size() ? ",\n" : "\n";
+    }
+    
+    output += "]}\n";
+    
+    return dest.Write(output.CString(), output.Length()) == output.Length();
+}
+
+const ProfilerBlock* Profiler::GetThreadRootBlock(unsigned index) const
+{
+    if (!index)
+        return root_;
+    else
+        return index <= threads_.Size() ? threads_[index - 1]->root_ : 0;
+}
+
 String Profiler::GetData(bool showUnused, bool showTotal, unsigned maxDepth) const
 {
     String output;
@@ -97,6 +349,16 @@ String Profiler::GetData(bool showUnused, bool showTotal, unsigned maxDepth) con
     
     GetData(root_, output, 0, maxDepth, showUnused, showTotal);
     
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+    {
+        ProfilerBlock* threadRoot = threads_[i]->root_;
+        if (showUnused || !threadRoot->children_.Empty())
+        {
+            output += "\nWorker thread " + String(i + 1) + "\n\n";
+            GetData(threadRoot, output, 0, maxDepth, showUnused, showTotal);
+        }
+    }
+    
     return output;
 }
 
@@ -110,8 +372,8 @@ void Profiler::GetData(ProfilerBlock* block, String& output, unsigned depth, uns
     if (depth >= maxDepth)
         return;
     
-    // Do not print the root block as it does not collect any actual data
-    if (block != root_)
+    // Do not print the root blocks as they do not collect any actual data
+    if (block->parent_)
     {
         if (showUnused || block->intervalCount_ || (showTotal && block->totalCount_))
         {
@@ -155,4 +417,68 @@ void Profiler::GetData(ProfilerBlock* block, String& output, unsigned depth, uns
         GetData(*i, output, depth, maxDepth, showUnused, showTotal);
 }
 
+ProfilerThread* Profiler::GetCurrentThread() const
+{
+    #ifdef WIN32
+    return static_cast<ProfilerThread*>(TlsGetValue((DWORD)(size_t)threadKey_));
+    #else
+    return static_cast<ProfilerThread*>(pthread_getspecific(*(pthread_key_t*)threadKey_));
+    #endif
+}
+
+void Profiler::ProcessThreadEvents()
+{
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+    {
+        ProfilerThread* thread = threads_[i];
+        unsigned head = thread->head_;
+        // Make sure the events are read only after reading the write position
+        MemoryFence();
+        
+        for (unsigned j = thread->tail_; j != head; ++j)
+        {
+            const ProfilerEvent& event = thread->events_[j & (EVENT_BUFFER_SIZE - 1)];
+            if (event.begin_)
+            {
+                thread->current_ = thread->current_->GetChild(event.name_);
+                thread->current_->Begin(event.time_);
+                if (tracing_ && traceEvents_.Size() < MAX_TRACE_EVENTS)
+                {
+                    traceEvents_.Push(event);
+                    traceEvents_.Back().name_ = thread->current_->name_;
+                }
+            }
+            else if (thread->current_ != thread->root_)
+            {
+                thread->current_->End(event.time_);
+                if (tracing_ && traceEvents_.Size() < MAX_TRACE_EVENTS)
+                {
+                    traceEvents_.Push(event);
+                    traceEvents_.Back().name_ = thread->current_->name_;
+                }
+                thread->current_ = thread->current_->parent_;
+            }
+        }
+        
+        // Release the read events for the worker thread
+        MemoryFence();
+        thread->tail_ = head;
+        
+        thread->root_->EndFrame();
+    }
+}
+
+void Profiler::AddTraceEvent(const char* name, bool begin)
+{
+    if (traceEvents_.Size() >= MAX_TRACE_EVENTS)
+        return;
+    
+    ProfilerEvent event;
+    event.name_ = name;
+    event.time_ = eventTimer_.GetUSec(false);
+    event.threadIndex_ = 0;
+    event.begin_ = begin;
+    traceEvents_.Push(event);
+}
+
 }
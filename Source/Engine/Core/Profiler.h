@@ -28,6 +28,8 @@
 namespace Urho3D
 {
 
+class Serializer;
+
 /// Profiling data for one block in the profiling tree.
 class URHO3D_API ProfilerBlock
 {
@@ -35,6 +37,7 @@ public:
     /// Construct with the specified parent block and name.
     ProfilerBlock(ProfilerBlock* parent, const char* name) :
         name_(name),
+        eventStartTime_(0),
         time_(0),
         maxTime_(0),
         count_(0),
@@ -71,7 +74,25 @@ public:
     /// End timing.
     void End()
     {
-        long long time = timer_.GetUSec(false);
+        AddTime(timer_.GetUSec(false));
+    }
+    
+    /// Begin timing from a recorded event time.
+    void Begin(long long startTime)
+    {
+        eventStartTime_ = startTime;
+        ++count_;
+    }
+    
+    /// End timing from a recorded event time.
+    void End(long long endTime)
+    {
+        AddTime(endTime - eventStartTime_);
+    }
+    
+    /// Add time of one call.
+    void AddTime(long long time)
+    {
         if (time > maxTime_)
             maxTime_ = time;
         time_ += time;
@@ -136,6 +157,8 @@ public:
     const char* name_;
     /// High-resolution timer for measuring the block duration.
     HiresTimer timer_;
+    /// Start time of the current call when timing from recorded events.
+    long long eventStartTime_;
     /// Time on current frame.
     long long time_;
     /// Maximum time on current frame.
@@ -166,7 +189,22 @@ public:
     unsigned totalCount_;
 };
 
-/// Hierarchical performance profiler subsystem.
+/// Profiling block begin or end event.
+struct ProfilerEvent
+{
+    /// Block name.
+    const char* name_;
+    /// Time in microseconds since the profiler was created.
+    long long time_;
+    /// Thread index. 0 is the main thread.
+    unsigned threadIndex_;
+    /// Begin flag. False for block end.
+    bool begin_;
+};
+
+class ProfilerThread;
+
+/// Hierarchical performance profiler subsystem. Profiling blocks may be used both in the main thread and in WorkQueue worker threads.
 class URHO3D_API Profiler : public Object
 {
     OBJECT(Profiler);
@@ -177,29 +215,26 @@ public:
     /// Destruct.
     virtual ~Profiler();
     
-    /// Begin timing a profiling block.
-    void BeginBlock(const char* name)
-    {
-        current_ = current_->GetChild(name);
-        current_->Begin();
-    }
-    
-    /// End timing the current profiling block.
-    void EndBlock()
-    {
-        if (current_ != root_)
-        {
-            current_->End();
-            current_ = current_->parent_;
-        }
-    }
-    
+    /// Begin timing a profiling block in the calling thread.
+    void BeginBlock(const char* name);
+    /// End timing the current profiling block of the calling thread.
+    void EndBlock();
     /// Begin the profiling frame. Called by HandleBeginFrame().
     void BeginFrame();
-    /// End the profiling frame. Called by HandleEndFrame().
+    /// End the profiling frame and collect the worker threads' events. Called by HandleEndFrame().
     void EndFrame();
     /// Begin a new interval.
     void BeginInterval();
+    /// Set number of threads including the main thread, and allocate event buffers for the worker threads. Called by WorkQueue before starting the worker threads.
+    void SetNumThreads(unsigned numThreads);
+    /// Register the calling thread as the worker thread with the specified index. Called by the worker thread itself when it starts.
+    void RegisterThread(unsigned index);
+    /// Begin capturing events of all threads for a trace, starting from the next frame. With zero frames capture until EndTrace() is called. Previously captured events are discarded.
+    void BeginTrace(unsigned numFrames = 0);
+    /// End capturing events for a trace.
+    void EndTrace();
+    /// Write the captured trace in Chrome trace event JSON format. Return true if successful.
+    bool SaveTrace(Serializer& dest) const;
     
     /// Return profiling data as text output.
     String GetData(bool showUnused = false, bool showTotal = false, unsigned maxDepth = M_MAX_UNSIGNED) const;
@@ -207,10 +242,24 @@ public:
     const ProfilerBlock* GetCurrentBlock() { return current_; }
     /// Return the root profiling block.
     const ProfilerBlock* GetRootBlock() { return root_; }
+    /// Return number of threads including the main thread.
+    unsigned GetNumThreads() const { return threads_.Size() + 1; }
+    /// Return the root profiling block of a thread. 0 is the main thread.
+    const ProfilerBlock* GetThreadRootBlock(unsigned index) const;
+    /// Return whether a trace capture is in progress or pending.
+    bool IsTracing() const { return tracing_ || traceFrames_ != M_MAX_UNSIGNED; }
+    /// Return captured trace events.
+    const PODVector<ProfilerEvent>& GetTraceEvents() const { return traceEvents_; }
     
 private:
     /// Return profiling data as text output for a specified profiling block.
     void GetData(ProfilerBlock* block, String& output, unsigned depth, unsigned maxDepth, bool showUnused, bool showTotal) const;
+    /// Return the profiling data of the calling worker thread, or null if it has not been registered.
+    ProfilerThread* GetCurrentThread() const;
+    /// Read the worker threads' events into their profiling trees, and into the trace if capturing.
+    void ProcessThreadEvents();
+    /// Record a trace event from the main thread.
+    void AddTraceEvent(const char* name, bool begin);
     
     /// Current profiling block.
     ProfilerBlock* current_;
@@ -220,6 +269,20 @@ private:
     unsigned intervalFrames_;
     /// Total frames.
     unsigned totalFrames_;
+    /// Worker thread profiling data, indexed by thread index minus one.
+    PODVector<ProfilerThread*> threads_;
+    /// Timer for event times.
+    HiresTimer eventTimer_;
+    /// Captured trace events.
+    PODVector<ProfilerEvent> traceEvents_;
+    /// Frames to capture for a pending trace, or M_MAX_UNSIGNED if no trace requested.
+    unsigned traceFrames_;
+    /// Frames left in the current trace capture. 0 if unlimited.
+    unsigned traceFramesLeft_;
+    /// Thread-local storage key for the calling worker thread's profiling data.
+    void* threadKey_;
+    /// Trace capture in progress flag.
+    bool tracing_;
 };
 
 /// Helper class for automatically beginning and ending a profiling block
@@ -248,8 +311,10 @@ private:
 
 #ifdef ENABLE_PROFILING
 #define PROFILE(name) AutoProfileBlock profile_ ## name (GetSubsystem<Profiler>(), #name)
+#define PROFILE_OBJECT(object, name) AutoProfileBlock profile_ ## name ((object)->GetSubsystem<Profiler>(), #name)
 #else
 #define PROFILE(name)
+#define PROFILE_OBJECT(object, name)
 #endif
 
 }
@@ -24,9 +24,19 @@
 
 #include "Urho3D.h"
 
+#ifndef WIN32
+#include <pthread.h>
+#endif
+
 namespace Urho3D
 {
 
+#ifdef WIN32
+typedef unsigned ThreadID;
+#else
+typedef pthread_t ThreadID;
+#endif
+
 /// Operating system thread.
 class URHO3D_API Thread
 {
@@ -49,11 +59,21 @@ public:
     /// Return whether thread exists.
     bool IsStarted() const { return handle_ != 0; }
     
+    /// Set the current thread as the main thread.
+    static void SetMainThread();
+    /// Return the current thread's ID.
+    static ThreadID GetCurrentThreadID();
+    /// Return whether is executing in the main thread.
+    static bool IsMainThread();
+    
 protected:
     /// Thread handle.
     void* handle_;
     /// Running flag.
     volatile bool shouldRun_;
+    
+    /// Main thread's thread ID.
+    static ThreadID mainThreadID;
 };
 
 }
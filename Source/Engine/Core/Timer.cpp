@@ -141,7 +141,13 @@ String Time::GetTimeStamp()
 {
     time_t sysTime;
     time(&sysTime);
+    // The Windows CRT uses a per-thread buffer for ctime(), elsewhere use the reentrant version so that worker threads may log
+    #ifdef WIN32
     const char* dateTime = ctime(&sysTime);
+    #else
+    char dateTime[32];
+    ctime_r(&sysTime, dateTime);
+    #endif
     return String(dateTime).Replaced("\n", "");
 }
 
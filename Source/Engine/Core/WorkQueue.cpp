@@ -21,7 +21,9 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
 #include "CoreEvents.h"
+#include "FrameAllocator.h"
 #include "Log.h"
 #include "ProcessUtils.h"
 #include "Profiler.h"
@@ -33,15 +35,37 @@ namespace Urho3D
 {
 
 const unsigned MAX_NONTHREADED_WORK_USEC = 1000;
+const unsigned INITIAL_QUEUE_CAPACITY = 256;
+
+/// Acquire a spinlock.
+static void AcquireSpinLock(volatile int* lock)
+{
+    while (!AtomicCompareAndSwap(lock, 0, 1))
+    {
+    }
+}
+
+/// Release a spinlock.
+static void ReleaseSpinLock(volatile int* lock)
+{
+    MemoryFence();
+    *lock = 0;
+}
+
+/// Work function for items that only join other items through dependencies.
+static void JoinWork(const WorkItem* item, unsigned threadIndex)
+{
+}
 
 /// Worker thread managed by the work queue.
 class WorkerThread : public Thread, public RefCounted
 {
 public:
     /// Construct.
-    WorkerThread(WorkQueue* owner, unsigned index) :
+    WorkerThread(WorkQueue* owner, unsigned index, Profiler* profiler) :
         owner_(owner),
-        index_(index)
+        index_(index),
+        profiler_(profiler)
     {
     }
     
@@ -50,6 +74,8 @@ public:
     {
         // Init FPU state first
         InitFPU();
+        if (profiler_)
+            profiler_->RegisterThread(index_);
         owner_->ProcessItems(index_);
     }
     
@@ -61,16 +87,157 @@ private:
     WorkQueue* owner_;
     /// Thread index.
     unsigned index_;
+    /// Profiler to register the thread to.
+    Profiler* profiler_;
+};
+
+/// Lock-free work-stealing deque of work items (Chase-Lev.) Only the owning thread may push and pop at the bottom, while any thread may steal from the top.
+class WorkStealingQueue : public RefCounted
+{
+public:
+    /// Construct.
+    WorkStealingQueue() :
+        top_(0),
+        bottom_(0),
+        array_(new ItemArray(INITIAL_QUEUE_CAPACITY))
+    {
+    }
+    
+    /// Destruct.
+    ~WorkStealingQueue()
+    {
+        delete array_;
+        for (unsigned i = 0; i < retiredArrays_.Size(); ++i)
+            delete retiredArrays_[i];
+    }
+    
+    /// Push an item to the bottom. Only called by the owning thread.
+    void Push(WorkItem* item)
+    {
+        unsigned bottom = (unsigned)bottom_;
+        unsigned top = (unsigned)top_;
+        ItemArray* array = array_;
+        if (bottom - top >= array->capacity_ - 1)
+            array = Grow(top, bottom);
+        
+        array->items_[bottom & (array->capacity_ - 1)] = item;
+        MemoryFence();
+        bottom_ = (int)(bottom + 1);
+    }
+    
+    /// Pop the most recently pushed item from the bottom. Only called by the owning thread. Return null if empty.
+    WorkItem* Pop()
+    {
+        unsigned bottom = (unsigned)bottom_ - 1;
+        bottom_ = (int)bottom;
+        MemoryFence();
+        unsigned top = (unsigned)top_;
+        
+        int size = (int)(bottom - top);
+        if (size < 0)
+        {
+            // Was empty, restore
+            bottom_ = (int)(bottom + 1);
+            return 0;
+        }
+        
+        ItemArray* array = array_;
+        WorkItem* item = array->items_[bottom & (array->capacity_ - 1)];
+        if (size == 0)
+        {
+            // Last item: race against stealers for it
+            if (!AtomicCompareAndSwap(&top_, (int)top, (int)(top + 1)))
+                item = 0;
+            bottom_ = (int)(bottom + 1);
+        }
+        
+        return item;
+    }
+    
+    /// Steal the least recently pushed item from the top. May be called by any thread. Return null if empty or if lost a race to another thread.
+    WorkItem* Steal()
+    {
+        unsigned top = (unsigned)top_;
+        MemoryFence();
+        unsigned bottom = (unsigned)bottom_;
+        
+        if ((int)(bottom - top) <= 0)
+            return 0;
+        
+        MemoryFence();
+        ItemArray* array = array_;
+        WorkItem* item = array->items_[top & (array->capacity_ - 1)];
+        if (!AtomicCompareAndSwap(&top_, (int)top, (int)(top + 1)))
+            return 0;
+        
+        return item;
+    }
+    
+    /// Return approximate number of queued items.
+    unsigned Size() const
+    {
+        int size = (int)((unsigned)bottom_ - (unsigned)top_);
+        return size > 0 ? (unsigned)size : 0;
+    }
+    
+private:
+    /// Circular item storage.
+    struct ItemArray
+    {
+        /// Construct with capacity, which must be a power of two.
+        ItemArray(unsigned capacity) :
+            capacity_(capacity),
+            items_(new WorkItem*[capacity])
+        {
+        }
+        
+        /// Destruct.
+        ~ItemArray()
+        {
+            delete[] items_;
+        }
+        
+        /// Capacity.
+        unsigned capacity_;
+        /// Items.
+        WorkItem** items_;
+    };
+    
+    /// Double the storage capacity and return the new storage. Only called by the owning thread. The old storage is kept alive, as stealers may still be reading from it.
+    ItemArray* Grow(unsigned top, unsigned bottom)
+    {
+        ItemArray* oldArray = array_;
+        ItemArray* newArray = new ItemArray(oldArray->capacity_ * 2);
+        for (unsigned i = top; i != bottom; ++i)
+            newArray->items_[i & (newArray->capacity_ - 1)] = oldArray->items_[i & (oldArray->capacity_ - 1)];
+        
+        retiredArrays_.Push(oldArray);
+        MemoryFence();
+        array_ = newArray;
+        return newArray;
+    }
+    
+    /// Index of the topmost (oldest) item.
+    volatile int top_;
+    /// Index one past the bottommost (newest) item.
+    volatile int bottom_;
+    /// Current item storage.
+    ItemArray* volatile array_;
+    /// Storages replaced by growing.
+    PODVector<ItemArray*> retiredArrays_;
 };
 
 WorkQueue::WorkQueue(Context* context) :
     Object(context),
+    numLowPriorityItems_(0),
     shutDown_(false),
-    pausing_(false),
     paused_(false),
     tolerance_(10),
     lastSize_(0)
 {
+    // Create the main thread's queue
+    queues_.Push(SharedPtr<WorkStealingQueue>(new WorkStealingQueue()));
+    
     SubscribeToEvent(E_BEGINFRAME, HANDLER(WorkQueue, HandleBeginFrame));
 }
 
@@ -94,9 +261,21 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     // Start threads in paused mode
     Pause();
     
+    // Create all queues before starting any threads, as the threads steal from each other
+    for (unsigned i = 0; i < numThreads; ++i)
+        queues_.Push(SharedPtr<WorkStealingQueue>(new WorkStealingQueue()));
+    
+    // Allocate the worker threads' frame arenas and profiling data before starting them
+    FrameAllocator* frameAllocator = GetSubsystem<FrameAllocator>();
+    if (frameAllocator)
+        frameAllocator->SetNumThreads(numThreads + 1);
+    Profiler* profiler = GetSubsystem<Profiler>();
+    if (profiler)
+        profiler->SetNumThreads(numThreads + 1);
+    
     for (unsigned i = 0; i < numThreads; ++i)
     {
-        SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
+        SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1, profiler));
         thread->Run();
         threads_.Push(thread);
     }
@@ -134,43 +313,90 @@ void WorkQueue::AddWorkItem(SharedPtr<WorkItem> item)
     // Clear completed flag in case item is reused
     workItems_.Push(item);
     item->completed_ = false;
-
-    // Make sure worker threads' list is safe to modify
-    if (threads_.Size() && !paused_)
-        queueMutex_.Acquire();
     
-    // Find position for new item
-    if (queue_.Empty())
-        queue_.Push(item);
-    else
+    item->finished_ = false;
+    
+    // Register as a dependent of unfinished dependencies. Hold one extra count while doing so, so that the item is not
+    // started prematurely by a dependency finishing in a worker thread
+    item->pendingDependencies_ = 1;
+    for (unsigned i = 0; i < item->dependencies_.Size(); ++i)
     {
-        for (List<WorkItem*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
+        WorkItem* dependency = item->dependencies_[i];
+        if (!dependency)
+            continue;
+        
+        assert(dependency->priority_ >= item->priority_);
+        
+        AcquireSpinLock(&dependency->dependentsLock_);
+        if (!dependency->finished_)
         {
-            if ((*i)->priority_ <= item->priority_)
-            {
-                queue_.Insert(i, item);
-                break;
-            }
+            dependency->dependents_.Push(item);
+            AtomicIncrement(&item->pendingDependencies_);
         }
+        ReleaseSpinLock(&dependency->dependentsLock_);
     }
     
+    // Queue if ready to start. Worker threads will steal from the main thread's queue
+    if (AtomicDecrement(&item->pendingDependencies_) == 0)
+        QueueItem(item, 0);
+    
     if (threads_.Size())
+        Resume();
+}
+
+SharedPtr<WorkItem> WorkQueue::ParallelFor(void* start, unsigned count, unsigned elementSize, unsigned grainSize,
+    void (*workFunction)(const WorkItem*, unsigned), void* aux, WorkItem* dependency, unsigned priority)
+{
+    if (!count)
+        return SharedPtr<WorkItem>();
+    
+    // By default split into a few items per thread, so that work stealing can balance unevenly costed elements
+    if (!grainSize)
+        grainSize = Max((int)(count / ((threads_.Size() + 1) * 4)), 1);
+    
+    unsigned numItems = (count + grainSize - 1) / grainSize;
+    SharedPtr<WorkItem> join;
+    if (numItems > 1)
     {
-        queueMutex_.Release();
-        paused_ = false;
+        join = GetFreeItem();
+        join->priority_ = priority;
+        join->workFunction_ = JoinWork;
+        join->start_ = 0;
+        join->end_ = 0;
+        join->aux_ = aux;
+    }
+    
+    unsigned char* data = reinterpret_cast<unsigned char*>(start);
+    for (unsigned i = 0; i < numItems; ++i)
+    {
+        unsigned first = i * grainSize;
+        unsigned last = Min((int)(first + grainSize), (int)count);
+        
+        SharedPtr<WorkItem> item = GetFreeItem();
+        item->priority_ = priority;
+        item->workFunction_ = workFunction;
+        item->start_ = data + first * elementSize;
+        item->end_ = data + last * elementSize;
+        item->aux_ = aux;
+        if (dependency)
+            item->dependencies_.Push(dependency);
+        AddWorkItem(item);
+        
+        if (!join)
+            return item;
+        join->dependencies_.Push(item);
     }
+    
+    AddWorkItem(join);
+    return join;
 }
 
 void WorkQueue::Pause()
 {
     if (!paused_)
     {
-        pausing_ = true;
-        
-        queueMutex_.Acquire();
+        pauseMutex_.Acquire();
         paused_ = true;
-        
-        pausing_ = false;
     }
 }
 
@@ -178,8 +404,8 @@ void WorkQueue::Resume()
 {
     if (paused_)
     {
-        queueMutex_.Release();
         paused_ = false;
+        pauseMutex_.Release();
     }
 }
 
@@ -190,49 +416,51 @@ void WorkQueue::Complete(unsigned priority)
     {
         Resume();
         
-        // Take work items also in the main thread until queue empty or no high-priority items anymore
-        while (!queue_.Empty())
+        // Take work items also in the main thread until no high-priority items remain, then wait for threaded work to complete
+        for (;;)
         {
-            queueMutex_.Acquire();
-            if (!queue_.Empty() && queue_.Front()->priority_ >= priority)
-            {
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
-            }
-            else
-            {
-                queueMutex_.Release();
+            WorkItem* item = TakeItem(0, priority);
+            if (item)
+                ExecuteItem(item, 0);
+            else if (IsCompleted(priority))
                 break;
-            }
-        }
-        
-        // Wait for threaded work to complete
-        while (!IsCompleted(priority))
-        {
         }
-        
-        // If no work at all remaining, pause worker threads by leaving the mutex locked
-        if (queue_.Empty())
-            Pause();
     }
     else
     {
         // No worker threads: ensure all high-priority items are completed in the main thread
-        while (!queue_.Empty() && queue_.Front()->priority_ >= priority)
-        {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
-        }
+        while (WorkItem* item = TakeItem(0, priority))
+            ExecuteItem(item, 0);
     }
     
+    // If no work at all remaining, pause worker threads by leaving the mutex locked
+    if (threads_.Size() && !HasQueuedItems())
+        Pause();
+    
     PurgeCompleted(priority);
 }
 
+void WorkQueue::CompleteItem(WorkItem* item)
+{
+    if (!item)
+        return;
+    
+    if (threads_.Size())
+        Resume();
+    
+    while (!item->completed_)
+    {
+        WorkItem* next = TakeItem(0, item->priority_);
+        if (next)
+            ExecuteItem(next, 0);
+        else if (threads_.Empty())
+        {
+            LOGERROR("Work item to complete has not been added to the work queue");
+            return;
+        }
+    }
+}
+
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
     for (List<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
@@ -246,37 +474,106 @@ bool WorkQueue::IsCompleted(unsigned priority) const
 
 void WorkQueue::ProcessItems(unsigned threadIndex)
 {
-    bool wasActive = false;
-    
     for (;;)
     {
         if (shutDown_)
             return;
         
-        if (pausing_ && !wasActive)
-            Time::Sleep(0);
-        else
+        WorkItem* item = TakeItem(threadIndex, 0);
+        if (item)
+            ExecuteItem(item, threadIndex);
+        else if (paused_)
         {
-            queueMutex_.Acquire();
-            if (!queue_.Empty())
-            {
-                wasActive = true;
-                
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
-            }
-            else
-            {
-                wasActive = false;
-                
-                queueMutex_.Release();
-                Time::Sleep(0);
-            }
+            // Block until the main thread resumes work
+            pauseMutex_.Acquire();
+            pauseMutex_.Release();
         }
+        else
+            Time::Sleep(0);
+    }
+}
+
+WorkItem* WorkQueue::TakeItem(unsigned threadIndex, unsigned minPriority)
+{
+    WorkItem* item = queues_[threadIndex]->Pop();
+    if (item)
+        return item;
+    
+    // Own queue empty, try to steal from the other threads, starting from the next one
+    unsigned numQueues = queues_.Size();
+    for (unsigned i = 1; i < numQueues; ++i)
+    {
+        item = queues_[(threadIndex + i) % numQueues]->Steal();
+        if (item)
+            return item;
     }
+    
+    // No frame-critical work left to take, so start lower priority work
+    return TakeLowPriorityItem(minPriority);
+}
+
+WorkItem* WorkQueue::TakeLowPriorityItem(unsigned minPriority)
+{
+    if (!numLowPriorityItems_)
+        return 0;
+    
+    MutexLock lock(lowPriorityMutex_);
+    if (lowPriorityItems_.Empty() || lowPriorityItems_.Front()->priority_ < minPriority)
+        return 0;
+    
+    WorkItem* item = lowPriorityItems_.Front();
+    lowPriorityItems_.PopFront();
+    --numLowPriorityItems_;
+    return item;
+}
+
+void WorkQueue::QueueItem(WorkItem* item, unsigned threadIndex)
+{
+    if (item->priority_ == M_MAX_UNSIGNED)
+    {
+        queues_[threadIndex]->Push(item);
+        return;
+    }
+    
+    // Insert after the items of the same or higher priority, so that equal priority items start in the order they were queued
+    MutexLock lock(lowPriorityMutex_);
+    List<WorkItem*>::Iterator i = lowPriorityItems_.Begin();
+    while (i != lowPriorityItems_.End() && (*i)->priority_ >= item->priority_)
+        ++i;
+    lowPriorityItems_.Insert(i, item);
+    ++numLowPriorityItems_;
+}
+
+void WorkQueue::ExecuteItem(WorkItem* item, unsigned threadIndex)
+{
+    item->workFunction_(item, threadIndex);
+    
+    // Start the dependents that have no other unfinished dependencies. Once the finished flag is set, no new dependents
+    // can be added
+    AcquireSpinLock(&item->dependentsLock_);
+    item->finished_ = true;
+    for (unsigned i = 0; i < item->dependents_.Size(); ++i)
+    {
+        WorkItem* dependent = item->dependents_[i];
+        if (AtomicDecrement(&dependent->pendingDependencies_) == 0)
+            QueueItem(dependent, threadIndex);
+    }
+    item->dependents_.Clear();
+    ReleaseSpinLock(&item->dependentsLock_);
+    
+    // Signal completion last, as the main thread may reset the item once it sees it completed
+    item->completed_ = true;
+}
+
+bool WorkQueue::HasQueuedItems() const
+{
+    for (unsigned i = 0; i < queues_.Size(); ++i)
+    {
+        if (queues_[i]->Size())
+            return true;
+    }
+    
+    return numLowPriorityItems_ != 0;
 }
 
 void WorkQueue::PurgeCompleted(unsigned priority)
@@ -311,6 +608,7 @@ void WorkQueue::PurgeCompleted(unsigned priority)
                 (*i)->priority_ = M_MAX_UNSIGNED;
                 (*i)->sendEvent_ = false;
                 (*i)->completed_ = false;
+                (*i)->dependencies_.Clear();
 
                 poolItems_.Push(*i);
             }
@@ -337,18 +635,21 @@ void WorkQueue::PurgePool()
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     // If no worker threads, complete low-priority work here
-    if (threads_.Empty() && !queue_.Empty())
+    if (threads_.Empty() && HasQueuedItems())
     {
         PROFILE(CompleteWorkNonthreaded);
         
         HiresTimer timer;
         
-        while (!queue_.Empty() && timer.GetUSec(false) < MAX_NONTHREADED_WORK_USEC)
+        // Steal from the own queue to execute oldest items first, then continue with the lower priority items
+        while (timer.GetUSec(false) < MAX_NONTHREADED_WORK_USEC)
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkItem* item = queues_[0]->Steal();
+            if (!item)
+                item = TakeLowPriorityItem(0);
+            if (!item)
+                break;
+            ExecuteItem(item, 0);
         }
     }
     
@@ -36,6 +36,7 @@ EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
 }
 
 class WorkerThread;
+class WorkStealingQueue;
 
 /// Work queue item.
 struct WorkItem : public RefCounted
@@ -48,7 +49,10 @@ public:
         priority_(0),
         sendEvent_(false),
         completed_(false),
-        pooled_(false)
+        pooled_(false),
+        finished_(false),
+        pendingDependencies_(0),
+        dependentsLock_(0)
     {
     }
     
@@ -60,15 +64,26 @@ public:
     void* end_;
     /// Auxiliary data pointer.
     void* aux_;
-    /// Priority. Higher value = will be completed first.
+    /// Priority. Higher value = will be completed first. Items with the maximum priority are frame-critical and always taken before any lower priority items.
     unsigned priority_;
     /// Whether to send event on completion.
     bool sendEvent_;
     /// Completed flag.
     volatile bool completed_;
+    /// Work items that must complete before this item can start. They must have already been added to the queue, and must have at least the same priority.
+    PODVector<WorkItem*> dependencies_;
 
 private:
+    /// Pooled flag.
     bool pooled_;
+    /// Finished flag. Set when the work function has returned and dependents have been released.
+    volatile bool finished_;
+    /// Number of dependencies not yet finished.
+    volatile int pendingDependencies_;
+    /// Spinlock for the dependents and the finished flag.
+    volatile int dependentsLock_;
+    /// Work items waiting for this item to finish.
+    PODVector<WorkItem*> dependents_;
 };
 
 /// Work queue subsystem for multithreading.
@@ -88,17 +103,32 @@ public:
     void CreateThreads(unsigned numThreads);
     /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
     SharedPtr<WorkItem> GetFreeItem();
-    /// Add a work item and resume worker threads.
+    /// Add a work item and resume worker threads. If the item has unfinished dependencies, it will be started once they finish.
     void AddWorkItem(SharedPtr<WorkItem> item);
+    /// Split an array into work items of at most grainSize elements each (0 = automatic) and add them, optionally to start after a dependency finishes. The work function receives the element range in the start and end pointers. Return an item that completes once all of the range has been processed, or null if the range was empty.
+    template <class T> SharedPtr<WorkItem> ParallelFor(T* start, T* end, unsigned grainSize, void (*workFunction)(const WorkItem*, unsigned), void* aux = 0, WorkItem* dependency = 0, unsigned priority = M_MAX_UNSIGNED)
+    {
+        return ParallelFor(start, end - start, sizeof(T), grainSize, workFunction, aux, dependency, priority);
+    }
+    /// Split a vector into work items of at most grainSize elements each (0 = automatic) and add them, optionally to start after a dependency finishes. The work function receives the element range in the start and end pointers. Return an item that completes once all of the range has been processed, or null if the vector was empty.
+    template <class T> SharedPtr<WorkItem> ParallelFor(PODVector<T>& vector, unsigned grainSize, void (*workFunction)(const WorkItem*, unsigned), void* aux = 0, WorkItem* dependency = 0, unsigned priority = M_MAX_UNSIGNED)
+    {
+        return ParallelFor(vector.Begin().ptr_, vector.Size(), sizeof(T), grainSize, workFunction, aux, dependency, priority);
+    }
     /// Pause worker threads.
     void Pause();
     /// Resume worker threads.
     void Resume();
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(unsigned priority);
+    /// Finish a work item that has been added to the queue, including its dependencies. Main thread will also execute other work of at least the item's priority while waiting, but unlike Complete() does not wait for unrelated work to finish.
+    void CompleteItem(WorkItem* item);
     /// Set the pool telerance before it starts deleting pool items.
     void SetTolerance(int tolerance) { tolerance_ = tolerance; }
     
+    /// Split an array of count elements of the specified size into work items. Called by the typed ParallelFor functions.
+    SharedPtr<WorkItem> ParallelFor(void* start, unsigned count, unsigned elementSize, unsigned grainSize, void (*workFunction)(const WorkItem*, unsigned), void* aux, WorkItem* dependency, unsigned priority);
+    
     /// Return number of worker threads.
     unsigned GetNumThreads() const { return threads_.Size(); }
     /// Return whether all work with at least the specified priority is finished.
@@ -109,6 +139,16 @@ public:
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
+    /// Take a work item of at least the specified priority. Frame-critical items are taken from the thread's own queue or stolen from the other threads' queues before lower priority items. Return null if none available.
+    WorkItem* TakeItem(unsigned threadIndex, unsigned minPriority);
+    /// Take the highest priority item from the lower priority list if it has at least the specified priority. Return null if none available.
+    WorkItem* TakeLowPriorityItem(unsigned minPriority);
+    /// Queue an item that is ready to start. Frame-critical items go to the thread's own queue, lower priority items to the priority-ordered list.
+    void QueueItem(WorkItem* item, unsigned threadIndex);
+    /// Execute a work item, start its dependents if they have no other unfinished dependencies, and mark it completed.
+    void ExecuteItem(WorkItem* item, unsigned threadIndex);
+    /// Return whether any of the queues still hold unstarted work items.
+    bool HasQueuedItems() const;
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
     /// Purge the pool to reduce allocation where its unneeded.
@@ -122,16 +162,20 @@ private:
     List<SharedPtr<WorkItem> > poolItems_;
     /// Work item collection. Accessed only by the main thread.
     List<SharedPtr<WorkItem> > workItems_;
-    /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems.)
-    List<WorkItem*> queue_;
-    /// Worker queue mutex.
-    Mutex queueMutex_;
+    /// Per-thread work-stealing queues for frame-critical items, indexed by thread index (0 = main thread.) Pointers in the queues are guaranteed to be valid (point to workItems.)
+    Vector<SharedPtr<WorkStealingQueue> > queues_;
+    /// Items below the maximum priority, sorted from highest to lowest priority.
+    List<WorkItem*> lowPriorityItems_;
+    /// Number of items in the lower priority list. Can be read without the mutex to check for work.
+    volatile int numLowPriorityItems_;
+    /// Lower priority list mutex.
+    Mutex lowPriorityMutex_;
+    /// Worker pause mutex.
+    Mutex pauseMutex_;
     /// Shutting down flag.
     volatile bool shutDown_;
-    /// Pausing flag. Indicates the worker threads should not contend for the queue mutex.
-    volatile bool pausing_;
-    /// Paused flag. Indicates the queue mutex being locked to prevent worker threads using up CPU time.
-    bool paused_;
+    /// Paused flag. Indicates the pause mutex being locked to prevent worker threads using up CPU time.
+    volatile bool paused_;
     /// Tolerance for the shared pool before it begins to deallocate.
     int tolerance_;
     /// Last size of the shared pool.
@@ -25,6 +25,7 @@
 #include "DebugHud.h"
 #include "Engine.h"
 #include "Font.h"
+#include "FrameAllocator.h"
 #include "Graphics.h"
 #include "Log.h"
 #include "Profiler.h"
@@ -112,13 +113,19 @@ void DebugHud::Update()
         }
 
         String stats;
-        stats.AppendWithFormat("Triangles %u\nBatches %u\nViews %u\nLights %u\nShadowmaps %u\nOccluders %u",
+        stats.AppendWithFormat("Triangles %u\nBatches %u\nViews %u\nLights %u\nShadowmaps %u\nOccluders %u\nZone lookups %u",
             primitives,
             batches,
             renderer->GetNumViews(),
             renderer->GetNumLights(true),
             renderer->GetNumShadowMaps(true),
-            renderer->GetNumOccluders(true));
+            renderer->GetNumOccluders(true),
+            renderer->GetNumZoneLookups(true));
+
+        FrameAllocator* frameAllocator = GetSubsystem<FrameAllocator>();
+        if (frameAllocator)
+            stats.AppendWithFormat("\nHeap allocations %u\nFrame memory %u", frameAllocator->GetFrameHeapAllocations(),
+                frameAllocator->GetFrameMemory());
 
         if (!appStats_.Empty())
         {
@@ -27,7 +27,9 @@
 #include "CoreEvents.h"
 #include "DebugHud.h"
 #include "Engine.h"
+#include "File.h"
 #include "FileSystem.h"
+#include "FrameAllocator.h"
 #include "Graphics.h"
 #include "Input.h"
 #include "InputEvents.h"
@@ -110,6 +112,7 @@ Engine::Engine(Context* context) :
     // Create subsystems which do not depend on engine initialization or startup parameters
     context_->RegisterSubsystem(new Time(context_));
     context_->RegisterSubsystem(new WorkQueue(context_));
+    context_->RegisterSubsystem(new FrameAllocator(context_));
     #ifdef ENABLE_PROFILING
     context_->RegisterSubsystem(new Profiler(context_));
     #endif
@@ -146,7 +149,12 @@ bool Engine::Initialize(const VariantMap& parameters)
     headless_ = GetParameter(parameters, "Headless", false).GetBool();
 
     // Register the rest of the subsystems
-    if (!headless_)
+    bool createGraphics = !headless_;
+    #ifdef USE_NULL_GRAPHICS
+    // The null graphics backend does not need a GPU, so the CPU side of rendering can be run also in headless mode
+    createGraphics = true;
+    #endif
+    if (createGraphics)
     {
         context_->RegisterSubsystem(new Graphics(context_));
         context_->RegisterSubsystem(new Renderer(context_));
@@ -166,6 +174,7 @@ bool Engine::Initialize(const VariantMap& parameters)
         if (HasParameter(parameters, "LogLevel"))
             log->SetLevel(GetParameter(parameters, "LogLevel").GetInt());
         log->SetQuiet(GetParameter(parameters, "LogQuiet", false).GetBool());
+        log->SetAsync(GetParameter(parameters, "LogAsync", false).GetBool());
         log->Open(GetParameter(parameters, "LogName", "Urho3D.log").GetString());
     }
 
@@ -257,9 +266,9 @@ bool Engine::Initialize(const VariantMap& parameters)
     }
 
     // Initialize graphics & audio output
-    if (!headless_)
+    Graphics* graphics = GetSubsystem<Graphics>();
+    if (graphics)
     {
-        Graphics* graphics = GetSubsystem<Graphics>();
         Renderer* renderer = GetSubsystem<Renderer>();
 
         if (HasParameter(parameters, "ExternalWindow"))
@@ -286,16 +295,16 @@ bool Engine::Initialize(const VariantMap& parameters)
         renderer->SetDrawShadows(GetParameter(parameters, "Shadows", true).GetBool());
         if (renderer->GetDrawShadows() && GetParameter(parameters, "LowQualityShadows", false).GetBool())
             renderer->SetShadowQuality(SHADOWQUALITY_LOW_16BIT);
+    }
 
-        if (GetParameter(parameters, "Sound", true).GetBool())
-        {
-            GetSubsystem<Audio>()->SetMode(
-                GetParameter(parameters, "SoundBuffer", 100).GetInt(),
-                GetParameter(parameters, "SoundMixRate", 44100).GetInt(),
-                GetParameter(parameters, "SoundStereo", true).GetBool(),
-                GetParameter(parameters, "SoundInterpolation", true).GetBool()
-            );
-        }
+    if (!headless_ && GetParameter(parameters, "Sound", true).GetBool())
+    {
+        GetSubsystem<Audio>()->SetMode(
+            GetParameter(parameters, "SoundBuffer", 100).GetInt(),
+            GetParameter(parameters, "SoundMixRate", 44100).GetInt(),
+            GetParameter(parameters, "SoundStereo", true).GetBool(),
+            GetParameter(parameters, "SoundInterpolation", true).GetBool()
+        );
     }
 
     // Init FPU state of main thread
@@ -308,8 +317,8 @@ bool Engine::Initialize(const VariantMap& parameters)
 
     // In debug mode, check now that all factory created objects can be created without crashing
     #ifdef _DEBUG
-    const HashMap<ShortStringHash, SharedPtr<ObjectFactory> >& factories = context_->GetObjectFactories();
-    for (HashMap<ShortStringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories.Begin(); i != factories.End(); ++i)
+    const FlatHashMap<ShortStringHash, SharedPtr<ObjectFactory> >& factories = context_->GetObjectFactories();
+    for (FlatHashMap<ShortStringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories.Begin(); i != factories.End(); ++i)
         SharedPtr<Object> object = i->second_->CreateObject();
     #endif
 
@@ -323,8 +332,9 @@ void Engine::RunFrame()
 {
     assert(initialized_);
 
-    // If not headless, and the graphics subsystem no longer has a window open, assume we should exit
-    if (!headless_ && !GetSubsystem<Graphics>()->IsInitialized())
+    // If the graphics subsystem exists, but no longer has a window open, assume we should exit
+    Graphics* graphics = GetSubsystem<Graphics>();
+    if (graphics && !graphics->IsInitialized())
         exiting_ = true;
 
     if (exiting_)
@@ -363,6 +373,9 @@ void Engine::RunFrame()
     ApplyFrameLimit();
 
     time->EndFrame();
+
+    if (!profilerTraceFileName_.Empty())
+        SaveProfilerTrace();
 }
 
 Console* Engine::CreateConsole()
@@ -431,6 +444,11 @@ void Engine::SetAutoExit(bool enable)
     autoExit_ = enable;
 }
 
+void Engine::SetNextTimeStep(float seconds)
+{
+    timeStep_ = Max(seconds, 0.0f);
+}
+
 void Engine::Exit()
 {
 #if defined(IOS)
@@ -454,6 +472,35 @@ void Engine::DumpProfiler()
         LOGRAW(profiler->GetData(true, true) + "\n");
 }
 
+void Engine::DumpProfilerTrace(const String& fileName, unsigned numFrames)
+{
+    Profiler* profiler = GetSubsystem<Profiler>();
+    if (!profiler)
+        return;
+
+    // Always capture a limited amount of frames so that the trace gets saved
+    profiler->BeginTrace(numFrames ? numFrames : 1);
+    profilerTraceFileName_ = fileName;
+}
+
+void Engine::SaveProfilerTrace()
+{
+    Profiler* profiler = GetSubsystem<Profiler>();
+    if (profiler && profiler->IsTracing())
+        return;
+
+    if (profiler)
+    {
+        File file(context_, profilerTraceFileName_, FILE_WRITE);
+        if (file.IsOpen() && profiler->SaveTrace(file))
+            LOGINFO("Saved profiler trace to " + profilerTraceFileName_);
+        else
+            LOGERROR("Could not save profiler trace to " + profilerTraceFileName_);
+    }
+
+    profilerTraceFileName_.Clear();
+}
+
 void Engine::DumpResources()
 {
     #ifdef ENABLE_LOGGING
@@ -541,13 +588,14 @@ void Engine::Update()
 
 void Engine::Render()
 {
-    if (headless_)
+    // Graphics does not exist in headless mode, unless using the null graphics backend
+    Graphics* graphics = GetSubsystem<Graphics>();
+    if (!graphics)
         return;
 
     PROFILE(Render);
 
     // If device is lost, BeginFrame will fail and we skip rendering
-    Graphics* graphics = GetSubsystem<Graphics>();
     if (!graphics->BeginFrame())
         return;
 
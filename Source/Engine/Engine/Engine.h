@@ -62,10 +62,14 @@ public:
     void SetPauseMinimized(bool enable);
     /// Set whether to exit automatically on exit request (window close button.)
     void SetAutoExit(bool enable);
+    /// Override timestep of the next frame. Should be called in between RunFrame() calls.
+    void SetNextTimeStep(float seconds);
     /// Close the graphics window and set the exit flag. No-op on iOS, as an iOS application can not legally exit.
     void Exit();
     /// Dump profiling information to the log.
     void DumpProfiler();
+    /// Capture profiling events of the following frames from all threads and save them to a file in Chrome trace event format.
+    void DumpProfilerTrace(const String& fileName, unsigned numFrames = 1);
     /// Dump information of all resources to the log.
     void DumpResources();
     /// Dump information of all memory allocations to the log. Supported in MSVC debug mode only.
@@ -83,6 +87,8 @@ public:
     bool GetPauseMinimized() const { return pauseMinimized_; }
     /// Return whether to exit automatically on exit request.
     bool GetAutoExit() const { return autoExit_; }
+    /// Return timestep of the next frame.
+    float GetNextTimeStep() const { return timeStep_; }
     /// Return whether engine has been initialized.
     bool IsInitialized() const { return initialized_; }
     /// Return whether exit has been requested.
@@ -109,6 +115,8 @@ private:
     void HandleExitRequested(StringHash eventType, VariantMap& eventData);
     /// Actually perform the exit actions.
     void DoExit();
+    /// Save the profiler trace once the capture has finished.
+    void SaveProfilerTrace();
     
     /// Frame update timer.
     HiresTimer frameTimer_;
@@ -144,6 +152,8 @@ private:
     bool headless_;
     /// Audio paused flag.
     bool audioPaused_;
+    /// File name to save the profiler trace to when capture finishes.
+    String profilerTraceFileName_;
 };
 
 }
@@ -59,11 +59,13 @@ static const unsigned MAX_ANIMATION_STATES = 256;
 AnimatedModel::AnimatedModel(Context* context) :
     StaticModel(context),
     animationLodFrameNumber_(0),
+    animationUpdateFrameNumber_(M_MAX_UNSIGNED),
     morphElementMask_(0),
     animationLodBias_(1.0f),
     animationLodTimer_(-1.0f),
     animationLodDistance_(0.0f),
     updateInvisible_(false),
+    nodeFreeAnimation_(false),
     animationDirty_(false),
     animationOrderDirty_(false),
     morphsDirty_(false),
@@ -98,6 +100,7 @@ void AnimatedModel::RegisterObject(Context* context)
     ACCESSOR_ATTRIBUTE(AnimatedModel, VAR_VARIANTVECTOR, "Bone Animation Enabled", GetBonesEnabledAttr, SetBonesEnabledAttr, VariantVector, Variant::emptyVariantVector, AM_FILE | AM_NOEDIT);
     ACCESSOR_ATTRIBUTE(AnimatedModel, VAR_VARIANTVECTOR, "Animation States", GetAnimationStatesAttr, SetAnimationStatesAttr, VariantVector, Variant::emptyVariantVector, AM_FILE);
     REF_ACCESSOR_ATTRIBUTE(AnimatedModel, VAR_BUFFER, "Morphs", GetMorphsAttr, SetMorphsAttr, PODVector<unsigned char>, Variant::emptyBuffer, AM_DEFAULT | AM_NOEDIT);
+    ACCESSOR_ATTRIBUTE(AnimatedModel, VAR_BOOL, "Node-Free Animation", GetNodeFreeAnimation, SetNodeFreeAnimation, bool, false, AM_DEFAULT);
 }
 
 bool AnimatedModel::Load(Deserializer& source, bool setInstanceDefault)
@@ -140,6 +143,8 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
 
     const Vector<Bone>& bones = skeleton_.GetBones();
     Sphere boneSphere;
+    // In node-free animation mode the bone nodes are not up to date, so use the evaluated pose instead
+    bool nodeFree = nodeFreeAnimation_ && isMaster_ && boneModelTransforms_.Size() == bones.Size();
 
     for (unsigned i = 0; i < bones.Size(); ++i)
     {
@@ -154,7 +159,8 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         {
             // Do an initial crude test using the bone's AABB
             const BoundingBox& box = bone.boundingBox_;
-            const Matrix3x4& transform = bone.node_->GetWorldTransform();
+            Matrix3x4 transform = nodeFree ? node_->GetWorldTransform() * boneModelTransforms_[i] :
+                bone.node_->GetWorldTransform();
             distance = query.ray_.HitDistance(box.Transformed(transform));
             if (distance >= query.maxDistance_)
                 continue;
@@ -170,7 +176,8 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         }
         else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
         {
-            boneSphere.center_ = bone.node_->GetWorldPosition();
+            boneSphere.center_ = nodeFree ? node_->GetWorldTransform() * boneModelTransforms_[i].Translation() :
+                bone.node_->GetWorldPosition();
             boneSphere.radius_ = bone.radius_;
             distance = query.ray_.HitDistance(boneSphere);
             if (distance >= query.maxDistance_)
@@ -193,6 +200,10 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
 
 void AnimatedModel::Update(const FrameInfo& frame)
 {
+    // Skip if the octree's animation update already handled this frame
+    if (frame.frameNumber_ == animationUpdateFrameNumber_)
+        return;
+    
     // If node was invisible last frame, need to decide animation LOD distance here
     // If headless, retain the current animation distance (should be 0)
     if (frame.camera_ && abs((int)frame.frameNumber_ - (int)viewFrameNumber_) > 1)
@@ -214,6 +225,17 @@ void AnimatedModel::Update(const FrameInfo& frame)
         UpdateBoneBoundingBox();
 }
 
+void AnimatedModel::UpdateAnimationAndSkinning(const FrameInfo& frame)
+{
+    Update(frame);
+    animationUpdateFrameNumber_ = frame.frameNumber_;
+    
+    // The skinning matrices only depend on the evaluated pose and the node's world transform, so calculate them already here
+    // instead of in UpdateGeometry(). If the node moves later in the frame, they are recalculated
+    if (nodeFreeAnimation_ && isMaster_ && skinningDirty_ && abs((int)frame.frameNumber_ - (int)viewFrameNumber_) <= 1)
+        UpdateSkinning();
+}
+
 void AnimatedModel::UpdateBatches(const FrameInfo& frame)
 {
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
@@ -276,6 +298,8 @@ void AnimatedModel::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     if (debug && IsEnabledEffective())
     {
         debug->AddBoundingBox(GetWorldBoundingBox(), Color::GREEN, depthTest);
+        if (nodeFreeAnimation_)
+            SyncBoneNodes();
         debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
     }
 }
@@ -485,6 +509,48 @@ void AnimatedModel::SetUpdateInvisible(bool enable)
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::SetNodeFreeAnimation(bool enable)
+{
+    if (enable == nodeFreeAnimation_)
+        return;
+    
+    if (enable)
+    {
+        // Start from the current bone node transforms so that the pose is valid before the next animation update
+        nodeFreeAnimation_ = true;
+        if (isMaster_)
+        {
+            ResetBonePose(false);
+            UpdateBoneModelTransforms();
+        }
+    }
+    else
+    {
+        // Leave the bone nodes in the last evaluated pose
+        SyncBoneNodes();
+        nodeFreeAnimation_ = false;
+    }
+    
+    MarkAnimationDirty();
+    MarkNetworkUpdate();
+}
+
+void AnimatedModel::SyncBoneNodes()
+{
+    if (!nodeFreeAnimation_ || !isMaster_)
+        return;
+    
+    Vector<Bone>& bones = skeleton_.GetModifiableBones();
+    unsigned numBones = Min((int)bones.Size(), (int)bonePositions_.Size());
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        const Bone& bone = bones[i];
+        // Bones with animation disabled are controlled through their nodes, so the pose was read from them
+        if (bone.animated_ && bone.node_)
+            bone.node_->SetTransform(bonePositions_[i], boneRotations_[i], boneScales_[i]);
+    }
+}
+
 
 void AnimatedModel::SetMorphWeight(unsigned index, float weight)
 {
@@ -676,6 +742,7 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
             RemoveRootBone();
 
         skeleton_.Define(skeleton);
+        SetBonePose();
 
         // Remove collision information from dummy bones that do not affect skinning, to prevent them from being merged
         // to the bounding box
@@ -868,6 +935,10 @@ void AnimatedModel::OnMarkedDirty(Node* node)
     // If the scene node or any of the bone nodes move, mark skinning and the bone bounding box dirty
     skinningDirty_ = true;
     boneBoundingBoxDirty_ = true;
+    
+    // In node-free animation mode the pose reads bones with animation disabled from their nodes, so re-evaluate it
+    if (nodeFreeAnimation_ && isMaster_ && node != node_)
+        animationDirty_ = true;
 }
 
 void AnimatedModel::OnWorldBoundingBoxUpdate()
@@ -1102,6 +1173,155 @@ void AnimatedModel::SetGeometryBoneMappings()
     }
 }
 
+void AnimatedModel::SetBonePose()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    unsigned numBones = bones.Size();
+    
+    bonePositions_.Resize(numBones);
+    boneRotations_.Resize(numBones);
+    boneScales_.Resize(numBones);
+    boneModelTransforms_.Resize(numBones);
+    boneEvaluationOrder_.Clear();
+    boneNumChildBones_.Resize(numBones);
+    boneSyncFlags_.Resize(numBones);
+    
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        bonePositions_[i] = bones[i].initialPosition_;
+        boneRotations_[i] = bones[i].initialRotation_;
+        boneScales_[i] = bones[i].initialScale_;
+        boneNumChildBones_[i] = 0;
+    }
+    
+    // Order the bones by hierarchy depth so that parents are always evaluated before their children
+    PODVector<unsigned> depths(numBones);
+    unsigned maxDepth = 0;
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        unsigned depth = 0;
+        unsigned index = i;
+        while (depth < numBones && bones[index].parentIndex_ != index && bones[index].parentIndex_ < numBones)
+        {
+            index = bones[index].parentIndex_;
+            ++depth;
+        }
+        depths[i] = depth;
+        maxDepth = Max((int)maxDepth, (int)depth);
+        
+        unsigned parentIndex = bones[i].parentIndex_;
+        if (parentIndex != i && parentIndex < numBones)
+            ++boneNumChildBones_[parentIndex];
+    }
+    
+    boneEvaluationOrder_.Reserve(numBones);
+    for (unsigned depth = 0; depth <= maxDepth && numBones; ++depth)
+    {
+        for (unsigned i = 0; i < numBones; ++i)
+        {
+            if (depths[i] == depth)
+                boneEvaluationOrder_.Push(i);
+        }
+    }
+    
+    UpdateBoneModelTransforms();
+}
+
+void AnimatedModel::ResetBonePose(bool animatedBonesOnly)
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    unsigned numBones = Min((int)bones.Size(), (int)bonePositions_.Size());
+    
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        const Bone& bone = bones[i];
+        Node* boneNode = bone.node_;
+        if (boneNode && (!animatedBonesOnly || !bone.animated_))
+        {
+            bonePositions_[i] = boneNode->GetPosition();
+            boneRotations_[i] = boneNode->GetRotation();
+            boneScales_[i] = boneNode->GetScale();
+            // Clear the node's dirty flag, as otherwise further transform changes would not be notified to OnMarkedDirty()
+            boneNode->GetWorldTransform();
+        }
+        else
+        {
+            bonePositions_[i] = bone.initialPosition_;
+            boneRotations_[i] = bone.initialRotation_;
+            boneScales_[i] = bone.initialScale_;
+        }
+    }
+}
+
+void AnimatedModel::UpdateBoneModelTransforms()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    unsigned numBones = boneEvaluationOrder_.Size();
+    if (numBones != bones.Size())
+        return;
+    
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        unsigned index = boneEvaluationOrder_[i];
+        unsigned parentIndex = bones[index].parentIndex_;
+        Matrix3x4 localTransform(bonePositions_[index], boneRotations_[index], boneScales_[index]);
+        
+        if (parentIndex != index && parentIndex < numBones)
+            boneModelTransforms_[index] = boneModelTransforms_[parentIndex] * localTransform;
+        else
+            boneModelTransforms_[index] = localTransform;
+    }
+}
+
+void AnimatedModel::SyncAttachedBoneNodes()
+{
+    Vector<Bone>& bones = skeleton_.GetModifiableBones();
+    unsigned numBones = boneEvaluationOrder_.Size();
+    if (numBones != bones.Size())
+        return;
+    
+    // If there are other animated models in the node, they skin from the bone nodes, so all of them need to be up to date
+    const Vector<SharedPtr<Component> >& components = node_->GetComponents();
+    for (Vector<SharedPtr<Component> >::ConstIterator i = components.Begin(); i != components.End(); ++i)
+    {
+        if (*i != this && (*i)->GetType() == GetTypeStatic())
+        {
+            SyncBoneNodes();
+            return;
+        }
+    }
+    
+    // Visit children before parents, so that a bone needing synchronization also flags its parent
+    bool syncNeeded = false;
+    for (unsigned i = 0; i < numBones; ++i)
+        boneSyncFlags_[i] = 0;
+    for (unsigned i = numBones - 1; i < numBones; --i)
+    {
+        unsigned index = boneEvaluationOrder_[i];
+        Node* boneNode = bones[index].node_;
+        if (boneNode && (boneNode->GetNumComponents() || boneNode->GetNumChildren() > boneNumChildBones_[index]))
+            boneSyncFlags_[index] = 1;
+        
+        if (boneSyncFlags_[index])
+        {
+            syncNeeded = true;
+            unsigned parentIndex = bones[index].parentIndex_;
+            if (parentIndex != index && parentIndex < numBones)
+                boneSyncFlags_[parentIndex] = 1;
+        }
+    }
+    
+    if (!syncNeeded)
+        return;
+    
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        const Bone& bone = bones[i];
+        if (boneSyncFlags_[i] && bone.animated_ && bone.node_)
+            bone.node_->SetTransform(bonePositions_[i], boneRotations_[i], boneScales_[i]);
+    }
+}
+
 void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
 {
     // If using animation LOD, accumulate time and see if it is time to update
@@ -1131,9 +1351,22 @@ void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
     // (first AnimatedModel in a node)
     if (isMaster_)
     {
-        skeleton_.Reset();
-        for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
-            (*i)->Apply();
+        if (!nodeFreeAnimation_)
+        {
+            skeleton_.Reset();
+            for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+                (*i)->Apply();
+        }
+        else
+        {
+            // Evaluate into the pose arrays without touching the bone nodes, except those that have attachments
+            ResetBonePose(true);
+            for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+                (*i)->Apply();
+            UpdateBoneModelTransforms();
+            SyncAttachedBoneNodes();
+            skinningDirty_ = true;
+        }
         
         // Calculate new bone bounding box
         UpdateBoneBoundingBox();
@@ -1151,6 +1384,24 @@ void AnimatedModel::UpdateBoneBoundingBox()
         Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
         
         const Vector<Bone>& bones = skeleton_.GetBones();
+        
+        // In node-free animation mode the model space transforms are already available
+        if (nodeFreeAnimation_ && isMaster_ && boneModelTransforms_.Size() == bones.Size())
+        {
+            for (unsigned i = 0; i < bones.Size(); ++i)
+            {
+                const Bone& bone = bones[i];
+                if (bone.collisionMask_ & BONECOLLISION_BOX)
+                    boneBoundingBox_.Merge(bone.boundingBox_.Transformed(boneModelTransforms_[i]));
+                else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
+                    boneBoundingBox_.Merge(Sphere(boneModelTransforms_[i].Translation(), bone.radius_ * 0.5f));
+            }
+            
+            boneBoundingBoxDirty_ = false;
+            worldBoundingBoxDirty_ = true;
+            return;
+        }
+        
         for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
         {
             Node* boneNode = i->node_;
@@ -1177,8 +1428,20 @@ void AnimatedModel::UpdateSkinning()
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
 
+    // Skinning from the evaluated pose in node-free animation mode
+    if (nodeFreeAnimation_ && isMaster_ && boneModelTransforms_.Size() == bones.Size())
+    {
+        for (unsigned i = 0; i < bones.Size(); ++i)
+            skinMatrices_[i] = worldTransform * boneModelTransforms_[i] * bones[i].offsetMatrix_;
+        
+        for (unsigned i = 0; i < geometrySkinMatrixPtrs_.Size(); ++i)
+        {
+            for (unsigned j = 0; j < geometrySkinMatrixPtrs_[i].Size(); ++j)
+                *geometrySkinMatrixPtrs_[i][j] = skinMatrices_[i];
+        }
+    }
     // Skinning with global matrices only
-    if (!geometrySkinMatrices_.Size())
+    else if (!geometrySkinMatrices_.Size())
     {
         for (unsigned i = 0; i < bones.Size(); ++i)
         {
@@ -66,6 +66,8 @@ public:
     /// Visualize the component as debug geometry.
     virtual void DrawDebugGeometry(DebugRenderer* debug, bool depthTest);
 
+    /// Update animation, and in node-free animation mode also the skinning matrices if the model was in view on the last frame. Called from a worker thread by the octree's animation update, after which Update() does nothing on the same frame.
+    void UpdateAnimationAndSkinning(const FrameInfo& frame);
     /// Set model.
     void SetModel(Model* model, bool createBones = true);
     /// Add an animation.
@@ -86,6 +88,10 @@ public:
     void SetAnimationLodBias(float bias);
     /// Set whether to update animation and the bounding box when not visible. Recommended to enable for physically controlled models like ragdolls.
     void SetUpdateInvisible(bool enable);
+    /// Set node-free animation mode. When enabled, animations are evaluated into the model's own bone transform arrays instead of the bone scene nodes, which are only synchronized when they have attachments, or on demand.
+    void SetNodeFreeAnimation(bool enable);
+    /// Copy the last evaluated pose to the bone scene nodes. Only needed in node-free animation mode, for example before reading bone node transforms.
+    void SyncBoneNodes();
     /// Set vertex morph weight by index.
     void SetMorphWeight(unsigned index, float weight);
     /// Set vertex morph weight by name.
@@ -113,6 +119,10 @@ public:
     float GetAnimationLodBias() const { return animationLodBias_; }
     /// Return whether to update animation when not visible.
     bool GetUpdateInvisible() const { return updateInvisible_; }
+    /// Return whether node-free animation mode is enabled.
+    bool GetNodeFreeAnimation() const { return nodeFreeAnimation_; }
+    /// Return model space bone transforms evaluated in node-free animation mode.
+    const PODVector<Matrix3x4>& GetBoneModelTransforms() const { return boneModelTransforms_; }
     /// Return all vertex morphs.
     const Vector<ModelMorph>& GetMorphs() const { return morphs_; }
     /// Return all morph vertex buffers.
@@ -127,6 +137,8 @@ public:
     float GetMorphWeight(StringHash nameHash) const;
     /// Return whether is the master (first) animated model.
     bool IsMaster() const { return isMaster_; }
+    /// Return whether the animation needs to be evaluated on the next update.
+    bool IsAnimationDirty() const { return animationDirty_ || animationOrderDirty_; }
 
     /// Set model attribute.
     void SetModelAttr(ResourceRef value);
@@ -172,6 +184,14 @@ private:
     void SetSkeleton(const Skeleton& skeleton, bool createBones);
     /// Set mapping of subgeometry bone indices.
     void SetGeometryBoneMappings();
+    /// Size the node-free animation pose arrays and calculate the bone evaluation order.
+    void SetBonePose();
+    /// Copy bone scene node transforms to the local pose. If animated bones only is false, copies all bones, otherwise resets animated bones to the initial pose.
+    void ResetBonePose(bool animatedBonesOnly);
+    /// Recalculate model space bone transforms from the local pose.
+    void UpdateBoneModelTransforms();
+    /// Copy the pose to bone scene nodes that have attachments, and to their parent bones.
+    void SyncAttachedBoneNodes();
     /// Clone geometries for vertex morphing.
     void CloneGeometries();
     /// Copy morph vertices.
@@ -207,10 +227,26 @@ private:
     Vector<PODVector<Matrix3x4*> > geometrySkinMatrixPtrs_;
     /// Bounding box calculated from bones.
     BoundingBox boneBoundingBox_;
+    /// Local bone positions in node-free animation mode.
+    PODVector<Vector3> bonePositions_;
+    /// Local bone rotations in node-free animation mode.
+    PODVector<Quaternion> boneRotations_;
+    /// Local bone scales in node-free animation mode.
+    PODVector<Vector3> boneScales_;
+    /// Model space bone transforms in node-free animation mode.
+    PODVector<Matrix3x4> boneModelTransforms_;
+    /// Bone indices ordered so that parents come before their children.
+    PODVector<unsigned> boneEvaluationOrder_;
+    /// Number of child bones per bone, used to detect attachments in the bone nodes.
+    PODVector<unsigned> boneNumChildBones_;
+    /// Per-bone node synchronization flags.
+    PODVector<unsigned char> boneSyncFlags_;
     /// Attribute buffer.
     mutable VectorBuffer attrBuffer_;
     /// The frame number animation LOD distance was last calculated on.
     unsigned animationLodFrameNumber_;
+    /// The frame number animation was last updated on by the octree's animation update.
+    unsigned animationUpdateFrameNumber_;
     /// Morph vertex element mask.
     unsigned morphElementMask_;
     /// Animation LOD bias.
@@ -221,6 +257,8 @@ private:
     float animationLodDistance_;
     /// Update animation when invisible flag.
     bool updateInvisible_;
+    /// Node-free animation mode flag.
+    bool nodeFreeAnimation_;
     /// Animation dirty flag.
     bool animationDirty_;
     /// Animation order dirty flag.
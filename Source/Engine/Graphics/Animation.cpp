@@ -36,26 +36,426 @@
 namespace Urho3D
 {
 
+/// Maximum value of 16-bit quantized keyframe data.
+static const float QUANTIZE_16BIT = 65535.0f;
+/// Maximum value of 15-bit quantized rotation components.
+static const float QUANTIZE_15BIT = 32767.0f;
+/// Range of the three smallest quaternion components when the largest is omitted.
+static const float ROTATION_COMPONENT_RANGE = 0.70710678f;
+/// Maximum deviation of keyframe times from even spacing, relative to the keyframe interval.
+static const float KEYFRAME_INTERVAL_TOLERANCE = 0.01f;
+
 inline bool CompareTriggers(AnimationTriggerPoint& lhs, AnimationTriggerPoint& rhs)
 {
     return lhs.time_ < rhs.time_;
 }
 
+/// Quantize a vector channel of keyframes to 16 bits per component within its range. Return true if the channel is constant, in which case only the minimum is filled.
+static bool CompressVectors(const PODVector<Vector3>& values, Vector3& min, Vector3& scale, PODVector<unsigned short>& dest)
+{
+    Vector3 max = min = values[0];
+    for (unsigned i = 1; i < values.Size(); ++i)
+    {
+        const Vector3& value = values[i];
+        min = Vector3(Min(min.x_, value.x_), Min(min.y_, value.y_), Min(min.z_, value.z_));
+        max = Vector3(Max(max.x_, value.x_), Max(max.y_, value.y_), Max(max.z_, value.z_));
+    }
+    
+    Vector3 range = max - min;
+    if (range.x_ < M_EPSILON && range.y_ < M_EPSILON && range.z_ < M_EPSILON)
+    {
+        scale = Vector3::ZERO;
+        dest.Clear();
+        return true;
+    }
+    
+    scale = range / QUANTIZE_16BIT;
+    dest.Resize(values.Size() * 3);
+    for (unsigned i = 0; i < values.Size(); ++i)
+    {
+        const float* value = values[i].Data();
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            float componentRange = range.Data()[j];
+            float normalized = componentRange > 0.0f ? (value[j] - min.Data()[j]) / componentRange : 0.0f;
+            dest[i * 3 + j] = (unsigned short)(Clamp(normalized, 0.0f, 1.0f) * QUANTIZE_16BIT + 0.5f);
+        }
+    }
+    
+    return false;
+}
+
+/// Return a vector decompressed from 16-bit components.
+static inline Vector3 DecompressVector(const unsigned short* src, const Vector3& min, const Vector3& scale)
+{
+    return Vector3(min.x_ + src[0] * scale.x_, min.y_ + src[1] * scale.y_, min.z_ + src[2] * scale.z_);
+}
+
+/// Compress a rotation to 48 bits: the index of the largest component and the three smallest components at 15 bits each.
+static void CompressRotation(Quaternion rotation, unsigned short* dest)
+{
+    rotation.Normalize();
+    float components[4] = { rotation.w_, rotation.x_, rotation.y_, rotation.z_ };
+    
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largest]))
+            largest = i;
+    }
+    
+    // The quaternion and its negation are the same rotation, so make the omitted component positive
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    unsigned long long packed = largest;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float normalized = (Clamp(components[i] * sign, -ROTATION_COMPONENT_RANGE, ROTATION_COMPONENT_RANGE) +
+            ROTATION_COMPONENT_RANGE) / (2.0f * ROTATION_COMPONENT_RANGE);
+        packed = (packed << 15) | (unsigned)(normalized * QUANTIZE_15BIT + 0.5f);
+    }
+    
+    dest[0] = (unsigned short)(packed & 0xffff);
+    dest[1] = (unsigned short)((packed >> 16) & 0xffff);
+    dest[2] = (unsigned short)(packed >> 32);
+}
+
+/// Return a rotation decompressed from 48 bits.
+static inline Quaternion DecompressRotation(const unsigned short* src)
+{
+    unsigned long long packed = (unsigned long long)src[0] | ((unsigned long long)src[1] << 16) | ((unsigned long long)src[2] << 32);
+    unsigned largest = (unsigned)(packed >> 45) & 3;
+    
+    // The components were packed in ascending order, so the last one is in the lowest bits
+    float components[4];
+    float sumSquares = 0.0f;
+    for (int i = 3; i >= 0; --i)
+    {
+        if (i == (int)largest)
+            continue;
+        float value = (packed & 0x7fff) * (2.0f * ROTATION_COMPONENT_RANGE / QUANTIZE_15BIT) - ROTATION_COMPONENT_RANGE;
+        components[i] = value;
+        sumSquares += value * value;
+        packed >>= 15;
+    }
+    components[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+    
+    return Quaternion(components[0], components[1], components[2], components[3]);
+}
+
+AnimationTrack::AnimationTrack() :
+    channelMask_(0),
+    invKeyFrameInterval_(0.0f),
+    constantMask_(0),
+    timeScale_(0.0f),
+    positionMin_(Vector3::ZERO),
+    positionScale_(Vector3::ZERO),
+    constantRotation_(Quaternion::IDENTITY),
+    scaleMin_(Vector3::ONE),
+    scaleScale_(Vector3::ZERO)
+{
+}
+
+void AnimationTrack::SetKeyFrames(const Vector<AnimationKeyFrame>& keyFrames)
+{
+    unsigned numKeyFrames = keyFrames.Size();
+    keyFrameTimes_.Resize(numKeyFrames);
+    keyFramePositions_.Resize((channelMask_ & CHANNEL_POSITION) ? numKeyFrames : 0);
+    keyFrameRotations_.Resize((channelMask_ & CHANNEL_ROTATION) ? numKeyFrames : 0);
+    keyFrameScales_.Resize((channelMask_ & CHANNEL_SCALE) ? numKeyFrames : 0);
+    
+    for (unsigned i = 0; i < numKeyFrames; ++i)
+    {
+        const AnimationKeyFrame& keyFrame = keyFrames[i];
+        keyFrameTimes_[i] = keyFrame.time_;
+        if (channelMask_ & CHANNEL_POSITION)
+            keyFramePositions_[i] = keyFrame.position_;
+        if (channelMask_ & CHANNEL_ROTATION)
+            keyFrameRotations_[i] = keyFrame.rotation_;
+        if (channelMask_ & CHANNEL_SCALE)
+            keyFrameScales_[i] = keyFrame.scale_;
+    }
+    
+    constantMask_ = 0;
+    compressedTimes_.Clear();
+    compressedPositions_.Clear();
+    compressedRotations_.Clear();
+    compressedScales_.Clear();
+    UpdateKeyFrameInterval();
+}
+
+void AnimationTrack::Compress()
+{
+    if (IsCompressed() || keyFrameTimes_.Empty())
+        return;
+    
+    unsigned numKeyFrames = keyFrameTimes_.Size();
+    constantMask_ = 0;
+    
+    // Quantize times relative to the last keyframe
+    float lastTime = Max(keyFrameTimes_.Back(), 0.0f);
+    timeScale_ = lastTime / QUANTIZE_16BIT;
+    compressedTimes_.Resize(numKeyFrames);
+    for (unsigned i = 0; i < numKeyFrames; ++i)
+    {
+        float normalized = lastTime > 0.0f ? Clamp(keyFrameTimes_[i] / lastTime, 0.0f, 1.0f) : 0.0f;
+        compressedTimes_[i] = (unsigned short)(normalized * QUANTIZE_16BIT + 0.5f);
+    }
+    
+    if (channelMask_ & CHANNEL_POSITION)
+    {
+        if (CompressVectors(keyFramePositions_, positionMin_, positionScale_, compressedPositions_))
+            constantMask_ |= CHANNEL_POSITION;
+    }
+    
+    if (channelMask_ & CHANNEL_ROTATION)
+    {
+        bool constant = true;
+        constantRotation_ = keyFrameRotations_[0];
+        for (unsigned i = 1; i < numKeyFrames && constant; ++i)
+        {
+            if (Abs(constantRotation_.DotProduct(keyFrameRotations_[i])) < 1.0f - M_EPSILON)
+                constant = false;
+        }
+        
+        if (constant)
+            constantMask_ |= CHANNEL_ROTATION;
+        else
+        {
+            compressedRotations_.Resize(numKeyFrames * 3);
+            for (unsigned i = 0; i < numKeyFrames; ++i)
+                CompressRotation(keyFrameRotations_[i], &compressedRotations_[i * 3]);
+        }
+    }
+    
+    if (channelMask_ & CHANNEL_SCALE)
+    {
+        if (CompressVectors(keyFrameScales_, scaleMin_, scaleScale_, compressedScales_))
+            constantMask_ |= CHANNEL_SCALE;
+    }
+    
+    keyFrameTimes_.Clear();
+    keyFrameTimes_.Compact();
+    keyFramePositions_.Clear();
+    keyFramePositions_.Compact();
+    keyFrameRotations_.Clear();
+    keyFrameRotations_.Compact();
+    keyFrameScales_.Clear();
+    keyFrameScales_.Compact();
+    
+    // Quantization may have shifted the times slightly, so check the spacing again
+    UpdateKeyFrameInterval();
+}
+
+void AnimationTrack::UpdateKeyFrameInterval()
+{
+    invKeyFrameInterval_ = 0.0f;
+    
+    unsigned numKeyFrames = GetNumKeyFrames();
+    if (numKeyFrames < 2)
+        return;
+    
+    float startTime = GetKeyFrameTime(0);
+    float interval = (GetKeyFrameTime(numKeyFrames - 1) - startTime) / (float)(numKeyFrames - 1);
+    if (interval <= 0.0f)
+        return;
+    
+    float tolerance = interval * KEYFRAME_INTERVAL_TOLERANCE;
+    for (unsigned i = 1; i < numKeyFrames - 1; ++i)
+    {
+        if (Abs(GetKeyFrameTime(i) - (startTime + i * interval)) > tolerance)
+            return;
+    }
+    
+    invKeyFrameInterval_ = 1.0f / interval;
+}
+
 void AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
 {
+    unsigned numKeyFrames = GetNumKeyFrames();
+    if (!numKeyFrames)
+    {
+        index = 0;
+        return;
+    }
+    
     if (time < 0.0f)
         time = 0.0f;
     
-    if (index >= keyFrames_.Size())
-        index = keyFrames_.Size() - 1;
+    // During playback the time usually stays within the previous keyframe or advances to the next
+    if (index < numKeyFrames && (!index || time >= GetKeyFrameTime(index)))
+    {
+        if (index == numKeyFrames - 1 || time < GetKeyFrameTime(index + 1))
+            return;
+        if (index + 2 >= numKeyFrames || time < GetKeyFrameTime(index + 2))
+        {
+            ++index;
+            return;
+        }
+    }
+    
+    if (invKeyFrameInterval_ > 0.0f)
+    {
+        // Evenly spaced keyframes: calculate the index, then correct for the times not being exactly even
+        float position = (time - GetKeyFrameTime(0)) * invKeyFrameInterval_;
+        index = position > 0.0f ? (unsigned)position : 0;
+        if (index >= numKeyFrames)
+            index = numKeyFrames - 1;
+        
+        while (index && time < GetKeyFrameTime(index))
+            --index;
+        while (index < numKeyFrames - 1 && time >= GetKeyFrameTime(index + 1))
+            ++index;
+    }
+    else
+    {
+        // Binary search for the first keyframe after the time
+        unsigned low = 0;
+        unsigned high = numKeyFrames;
+        while (low < high)
+        {
+            unsigned middle = (low + high) >> 1;
+            if (GetKeyFrameTime(middle) <= time)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        
+        index = low ? low - 1 : 0;
+    }
+}
+
+unsigned char AnimationTrack::Sample(float time, float length, bool looped, unsigned& index, Vector3& position,
+    Quaternion& rotation, Vector3& scale) const
+{
+    unsigned numKeyFrames = GetNumKeyFrames();
+    if (!numKeyFrames)
+        return 0;
+    
+    GetKeyFrameIndex(time, index);
     
-    // Check for being too far ahead
-    while (index && time < keyFrames_[index].time_)
-        --index;
+    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
+    unsigned nextIndex = index + 1;
+    bool interpolate = true;
+    if (nextIndex >= numKeyFrames)
+    {
+        if (!looped)
+        {
+            nextIndex = index;
+            interpolate = false;
+        }
+        else
+            nextIndex = 0;
+    }
     
-    // Check for being too far behind
-    while (index < keyFrames_.Size() - 1 && time >= keyFrames_[index + 1].time_)
-        ++index;
+    // Constant channels of a compressed track need no interpolation
+    unsigned char interpolateMask = interpolate ? channelMask_ & ~constantMask_ : 0;
+    float t = 0.0f;
+    if (interpolateMask)
+    {
+        float keyFrameTime = GetKeyFrameTime(index);
+        float timeInterval = GetKeyFrameTime(nextIndex) - keyFrameTime;
+        if (timeInterval < 0.0f)
+            timeInterval += length;
+        t = timeInterval > 0.0f ? (time - keyFrameTime) / timeInterval : 1.0f;
+    }
+    
+    if (!IsCompressed())
+    {
+        if (channelMask_ & CHANNEL_POSITION)
+        {
+            position = (interpolateMask & CHANNEL_POSITION) ? keyFramePositions_[index].Lerp(keyFramePositions_[nextIndex], t) :
+                keyFramePositions_[index];
+        }
+        if (channelMask_ & CHANNEL_ROTATION)
+        {
+            rotation = (interpolateMask & CHANNEL_ROTATION) ? keyFrameRotations_[index].Slerp(keyFrameRotations_[nextIndex], t) :
+                keyFrameRotations_[index];
+        }
+        if (channelMask_ & CHANNEL_SCALE)
+        {
+            scale = (interpolateMask & CHANNEL_SCALE) ? keyFrameScales_[index].Lerp(keyFrameScales_[nextIndex], t) :
+                keyFrameScales_[index];
+        }
+    }
+    else
+    {
+        if (channelMask_ & CHANNEL_POSITION)
+        {
+            if (constantMask_ & CHANNEL_POSITION)
+                position = positionMin_;
+            else
+            {
+                position = DecompressVector(&compressedPositions_[index * 3], positionMin_, positionScale_);
+                if (interpolateMask & CHANNEL_POSITION)
+                    position = position.Lerp(DecompressVector(&compressedPositions_[nextIndex * 3], positionMin_, positionScale_), t);
+            }
+        }
+        if (channelMask_ & CHANNEL_ROTATION)
+        {
+            if (constantMask_ & CHANNEL_ROTATION)
+                rotation = constantRotation_;
+            else
+            {
+                rotation = DecompressRotation(&compressedRotations_[index * 3]);
+                if (interpolateMask & CHANNEL_ROTATION)
+                    rotation = rotation.Slerp(DecompressRotation(&compressedRotations_[nextIndex * 3]), t);
+            }
+        }
+        if (channelMask_ & CHANNEL_SCALE)
+        {
+            if (constantMask_ & CHANNEL_SCALE)
+                scale = scaleMin_;
+            else
+            {
+                scale = DecompressVector(&compressedScales_[index * 3], scaleMin_, scaleScale_);
+                if (interpolateMask & CHANNEL_SCALE)
+                    scale = scale.Lerp(DecompressVector(&compressedScales_[nextIndex * 3], scaleMin_, scaleScale_), t);
+            }
+        }
+    }
+    
+    return channelMask_;
+}
+
+void AnimationTrack::GetKeyFrame(unsigned index, AnimationKeyFrame& dest) const
+{
+    if (!IsCompressed())
+    {
+        dest.time_ = keyFrameTimes_[index];
+        if (channelMask_ & CHANNEL_POSITION)
+            dest.position_ = keyFramePositions_[index];
+        if (channelMask_ & CHANNEL_ROTATION)
+            dest.rotation_ = keyFrameRotations_[index];
+        if (channelMask_ & CHANNEL_SCALE)
+            dest.scale_ = keyFrameScales_[index];
+        return;
+    }
+    
+    dest.time_ = compressedTimes_[index] * timeScale_;
+    if (channelMask_ & CHANNEL_POSITION)
+    {
+        dest.position_ = (constantMask_ & CHANNEL_POSITION) ? positionMin_ : DecompressVector(&compressedPositions_[index * 3],
+            positionMin_, positionScale_);
+    }
+    if (channelMask_ & CHANNEL_ROTATION)
+    {
+        dest.rotation_ = (constantMask_ & CHANNEL_ROTATION) ? constantRotation_ :
+            DecompressRotation(&compressedRotations_[index * 3]);
+    }
+    if (channelMask_ & CHANNEL_SCALE)
+    {
+        dest.scale_ = (constantMask_ & CHANNEL_SCALE) ? scaleMin_ : DecompressVector(&compressedScales_[index * 3], scaleMin_,
+            scaleScale_);
+    }
+}
+
+unsigned AnimationTrack::GetKeyFrameMemoryUse() const
+{
+    return keyFrameTimes_.Size() * sizeof(float) + (keyFramePositions_.Size() + keyFrameScales_.Size()) * sizeof(Vector3) +
+        keyFrameRotations_.Size() * sizeof(Quaternion) + (compressedTimes_.Size() + compressedPositions_.Size() +
+        compressedRotations_.Size() + compressedScales_.Size()) * sizeof(unsigned short);
 }
 
 Animation::Animation(Context* context) :
@@ -80,7 +480,9 @@ bool Animation::Load(Deserializer& source)
     unsigned memoryUse = sizeof(Animation);
     
     // Check ID
-    if (source.ReadFileID() != "UANI")
+    String fileID = source.ReadFileID();
+    bool compressed = fileID == "UANC";
+    if (fileID != "UANI" && !compressed)
     {
         LOGERROR(source.GetName() + " is not a valid animation file");
         return false;
@@ -104,22 +506,34 @@ bool Animation::Load(Deserializer& source)
         newTrack.nameHash_ = newTrack.name_;
         newTrack.channelMask_ = source.ReadUByte();
         
+        if (compressed)
+        {
+            ReadCompressedTrack(newTrack, source);
+            memoryUse += newTrack.GetKeyFrameMemoryUse();
+            continue;
+        }
+        
         unsigned keyFrames = source.ReadUInt();
-        newTrack.keyFrames_.Resize(keyFrames);
-        memoryUse += keyFrames * sizeof(AnimationKeyFrame);
+        unsigned char channelMask = newTrack.channelMask_;
+        newTrack.keyFrameTimes_.Resize(keyFrames);
+        newTrack.keyFramePositions_.Resize((channelMask & CHANNEL_POSITION) ? keyFrames : 0);
+        newTrack.keyFrameRotations_.Resize((channelMask & CHANNEL_ROTATION) ? keyFrames : 0);
+        newTrack.keyFrameScales_.Resize((channelMask & CHANNEL_SCALE) ? keyFrames : 0);
         
-        // Read keyframes of the track
+        // Read keyframes of the track into the channel arrays
         for (unsigned j = 0; j < keyFrames; ++j)
         {
-            AnimationKeyFrame& newKeyFrame = newTrack.keyFrames_[j];
-            newKeyFrame.time_ = source.ReadFloat();
-            if (newTrack.channelMask_ & CHANNEL_POSITION)
-                newKeyFrame.position_ = source.ReadVector3();
-            if (newTrack.channelMask_ & CHANNEL_ROTATION)
-                newKeyFrame.rotation_ = source.ReadQuaternion();
-            if (newTrack.channelMask_ & CHANNEL_SCALE)
-                newKeyFrame.scale_ = source.ReadVector3();
+            newTrack.keyFrameTimes_[j] = source.ReadFloat();
+            if (channelMask & CHANNEL_POSITION)
+                newTrack.keyFramePositions_[j] = source.ReadVector3();
+            if (channelMask & CHANNEL_ROTATION)
+                newTrack.keyFrameRotations_[j] = source.ReadQuaternion();
+            if (channelMask & CHANNEL_SCALE)
+                newTrack.keyFrameScales_[j] = source.ReadVector3();
         }
+        
+        newTrack.UpdateKeyFrameInterval();
+        memoryUse += newTrack.GetKeyFrameMemoryUse();
     }
     
     // Optionally read triggers from an XML file
@@ -150,8 +564,9 @@ bool Animation::Load(Deserializer& source)
 
 bool Animation::Save(Serializer& dest) const
 {
-    // Write ID, name and length
-    dest.WriteFileID("UANI");
+    // Write ID, name and length. If any of the tracks are compressed, use the compressed format for all
+    bool compressed = IsCompressed();
+    dest.WriteFileID(compressed ? "UANC" : "UANI");
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
     
@@ -162,19 +577,32 @@ bool Animation::Save(Serializer& dest) const
         const AnimationTrack& track = tracks_[i];
         dest.WriteString(track.name_);
         dest.WriteUByte(track.channelMask_);
-        dest.WriteUInt(track.keyFrames_.Size());
+        
+        if (compressed)
+        {
+            if (track.IsCompressed())
+                WriteCompressedTrack(track, dest);
+            else
+            {
+                AnimationTrack compressedTrack = track;
+                compressedTrack.Compress();
+                WriteCompressedTrack(compressedTrack, dest);
+            }
+            continue;
+        }
+        
+        dest.WriteUInt(track.keyFrameTimes_.Size());
         
         // Write keyframes of the track
-        for (unsigned j = 0; j < track.keyFrames_.Size(); ++j)
+        for (unsigned j = 0; j < track.keyFrameTimes_.Size(); ++j)
         {
-            const AnimationKeyFrame& keyFrame = track.keyFrames_[j];
-            dest.WriteFloat(keyFrame.time_);
+            dest.WriteFloat(track.keyFrameTimes_[j]);
             if (track.channelMask_ & CHANNEL_POSITION)
-                dest.WriteVector3(keyFrame.position_);
+                dest.WriteVector3(track.keyFramePositions_[j]);
             if (track.channelMask_ & CHANNEL_ROTATION)
-                dest.WriteQuaternion(keyFrame.rotation_);
+                dest.WriteQuaternion(track.keyFrameRotations_[j]);
             if (track.channelMask_ & CHANNEL_SCALE)
-                dest.WriteVector3(keyFrame.scale_);
+                dest.WriteVector3(track.keyFrameScales_[j]);
         }
     }
     
@@ -222,6 +650,20 @@ void Animation::SetTracks(const Vector<AnimationTrack>& tracks)
     tracks_ = tracks;
 }
 
+void Animation::Compress()
+{
+    unsigned memoryUse = sizeof(Animation) + tracks_.Size() * sizeof(AnimationTrack) + triggers_.Size() *
+        sizeof(AnimationTriggerPoint);
+    
+    for (Vector<AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+    {
+        i->Compress();
+        memoryUse += i->GetKeyFrameMemoryUse();
+    }
+    
+    SetMemoryUse(memoryUse);
+}
+
 void Animation::AddTrigger(float time, bool timeIsNormalized, const Variant& data)
 {
     AnimationTriggerPoint newTrigger;
@@ -248,6 +690,138 @@ void Animation::SetNumTriggers(unsigned num)
     triggers_.Resize(num);
 }
 
+bool Animation::IsCompressed() const
+{
+    for (Vector<AnimationTrack>::ConstIterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+    {
+        if (i->IsCompressed())
+            return true;
+    }
+    
+    return false;
+}
+
+void Animation::Sample(float time, bool looped, AnimationPose& pose) const
+{
+    unsigned numTracks = tracks_.Size();
+    if (pose.keyFrames_.Size() != numTracks)
+    {
+        pose.positions_.Resize(numTracks);
+        pose.rotations_.Resize(numTracks);
+        pose.scales_.Resize(numTracks);
+        pose.channelMasks_.Resize(numTracks);
+        pose.keyFrames_.Resize(numTracks);
+        for (unsigned i = 0; i < numTracks; ++i)
+            pose.keyFrames_[i] = 0;
+    }
+    
+    if (looped && length_ > 0.0f)
+    {
+        time = fmodf(time, length_);
+        if (time < 0.0f)
+            time += length_;
+    }
+    else
+        time = Clamp(time, 0.0f, length_);
+    
+    for (unsigned i = 0; i < numTracks; ++i)
+    {
+        pose.channelMasks_[i] = tracks_[i].Sample(time, length_, looped, pose.keyFrames_[i], pose.positions_[i],
+            pose.rotations_[i], pose.scales_[i]);
+    }
+}
+
+void Animation::ReadCompressedTrack(AnimationTrack& track, Deserializer& source)
+{
+    track.constantMask_ = source.ReadUByte();
+    unsigned keyFrames = source.ReadUInt();
+    track.timeScale_ = source.ReadFloat();
+    track.compressedTimes_.Resize(keyFrames);
+    if (keyFrames)
+        source.Read(&track.compressedTimes_[0], keyFrames * sizeof(unsigned short));
+    
+    unsigned char animatedMask = track.channelMask_ & ~track.constantMask_;
+    
+    if (track.channelMask_ & CHANNEL_POSITION)
+    {
+        track.positionMin_ = source.ReadVector3();
+        if (animatedMask & CHANNEL_POSITION)
+        {
+            track.positionScale_ = source.ReadVector3();
+            track.compressedPositions_.Resize(keyFrames * 3);
+            if (keyFrames)
+                source.Read(&track.compressedPositions_[0], keyFrames * 3 * sizeof(unsigned short));
+        }
+    }
+    if (track.channelMask_ & CHANNEL_ROTATION)
+    {
+        if (animatedMask & CHANNEL_ROTATION)
+        {
+            track.compressedRotations_.Resize(keyFrames * 3);
+            if (keyFrames)
+                source.Read(&track.compressedRotations_[0], keyFrames * 3 * sizeof(unsigned short));
+        }
+        else
+            track.constantRotation_ = source.ReadQuaternion();
+    }
+    if (track.channelMask_ & CHANNEL_SCALE)
+    {
+        track.scaleMin_ = source.ReadVector3();
+        if (animatedMask & CHANNEL_SCALE)
+        {
+            track.scaleScale_ = source.ReadVector3();
+            track.compressedScales_.Resize(keyFrames * 3);
+            if (keyFrames)
+                source.Read(&track.compressedScales_[0], keyFrames * 3 * sizeof(unsigned short));
+        }
+    }
+    
+    track.UpdateKeyFrameInterval();
+}
+
+void Animation::WriteCompressedTrack(const AnimationTrack& track, Serializer& dest) const
+{
+    unsigned keyFrames = track.compressedTimes_.Size();
+    dest.WriteUByte(track.constantMask_);
+    dest.WriteUInt(keyFrames);
+    dest.WriteFloat(track.timeScale_);
+    if (keyFrames)
+        dest.Write(&track.compressedTimes_[0], keyFrames * sizeof(unsigned short));
+    
+    unsigned char animatedMask = track.channelMask_ & ~track.constantMask_;
+    
+    if (track.channelMask_ & CHANNEL_POSITION)
+    {
+        dest.WriteVector3(track.positionMin_);
+        if (animatedMask & CHANNEL_POSITION)
+        {
+            dest.WriteVector3(track.positionScale_);
+            if (keyFrames)
+                dest.Write(&track.compressedPositions_[0], keyFrames * 3 * sizeof(unsigned short));
+        }
+    }
+    if (track.channelMask_ & CHANNEL_ROTATION)
+    {
+        if (animatedMask & CHANNEL_ROTATION)
+        {
+            if (keyFrames)
+                dest.Write(&track.compressedRotations_[0], keyFrames * 3 * sizeof(unsigned short));
+        }
+        else
+            dest.WriteQuaternion(track.constantRotation_);
+    }
+    if (track.channelMask_ & CHANNEL_SCALE)
+    {
+        dest.WriteVector3(track.scaleMin_);
+        if (animatedMask & CHANNEL_SCALE)
+        {
+            dest.WriteVector3(track.scaleScale_);
+            if (keyFrames)
+                dest.Write(&track.compressedScales_[0], keyFrames * 3 * sizeof(unsigned short));
+        }
+    }
+}
+
 const AnimationTrack* Animation::GetTrack(unsigned index) const
 {
     return index < tracks_.Size() ? &tracks_[index] : 0;
@@ -43,11 +43,35 @@ struct AnimationKeyFrame
     Vector3 scale_;
 };
 
-/// Skeletal animation track, stores keyframes of a single bone.
-struct AnimationTrack
+/// Skeletal animation track, stores keyframes of a single bone. Each channel is stored in its own array so that sampling only touches the channels that are animated.
+struct URHO3D_API AnimationTrack
 {
-    /// Return keyframe index based on time and previous index.
+    /// Construct.
+    AnimationTrack();
+    
+    /// Set keyframes, which should be sorted by time. Only the channels included in the channel mask are stored, so set it first.
+    void SetKeyFrames(const Vector<AnimationKeyFrame>& keyFrames);
+    /// Compress the keyframes. Channels that do not change are stored once, rotations are quantized to 48 bits and positions, scales and times to 16 bits per component within their range. The uncompressed keyframes are cleared.
+    void Compress();
+    /// Check whether the keyframes are evenly spaced in time, which allows finding keyframes without a search. Called automatically when the keyframes are set, loaded or compressed.
+    void UpdateKeyFrameInterval();
+    /// Return keyframe index based on time and previous index. Stepping forward from the previous index is checked first, then the index is calculated directly for evenly spaced keyframes or found with a binary search.
     void GetKeyFrameIndex(float time, unsigned& index) const;
+    /// Sample the channels at time using and updating the previous keyframe index. Wrap to the first keyframe if looped. Return the channels that were sampled, or 0 if there are no keyframes.
+    unsigned char Sample(float time, float length, bool looped, unsigned& index, Vector3& position, Quaternion& rotation,
+        Vector3& scale) const;
+    /// Return keyframe by index, decompressed if necessary. Only the channels in the channel mask are filled.
+    void GetKeyFrame(unsigned index, AnimationKeyFrame& dest) const;
+    /// Return keyframe time by index.
+    float GetKeyFrameTime(unsigned index) const { return IsCompressed() ? compressedTimes_[index] * timeScale_ : keyFrameTimes_[index]; }
+    /// Return number of keyframes.
+    unsigned GetNumKeyFrames() const { return IsCompressed() ? compressedTimes_.Size() : keyFrameTimes_.Size(); }
+    /// Return whether the keyframes are evenly spaced in time.
+    bool HasUniformKeyFrameTimes() const { return invKeyFrameInterval_ > 0.0f; }
+    /// Return whether the keyframes are stored in compressed form.
+    bool IsCompressed() const { return !compressedTimes_.Empty(); }
+    /// Return memory use of the keyframe data in bytes.
+    unsigned GetKeyFrameMemoryUse() const;
     
     /// Bone name.
     String name_;
@@ -55,8 +79,38 @@ struct AnimationTrack
     StringHash nameHash_;
     /// Bitmask of included data (position, rotation, scale.)
     unsigned char channelMask_;
-    /// Keyframes.
-    Vector<AnimationKeyFrame> keyFrames_;
+    /// Keyframe times.
+    PODVector<float> keyFrameTimes_;
+    /// Keyframe positions, empty if the position channel is not included.
+    PODVector<Vector3> keyFramePositions_;
+    /// Keyframe rotations, empty if the rotation channel is not included.
+    PODVector<Quaternion> keyFrameRotations_;
+    /// Keyframe scales, empty if the scale channel is not included.
+    PODVector<Vector3> keyFrameScales_;
+    /// Reciprocal of the time between keyframes if they are evenly spaced, otherwise zero.
+    float invKeyFrameInterval_;
+    /// Bitmask of channels stored as a single constant value in compressed form.
+    unsigned char constantMask_;
+    /// Compressed keyframe time scale.
+    float timeScale_;
+    /// Compressed position range minimum, or the constant position.
+    Vector3 positionMin_;
+    /// Compressed position scale.
+    Vector3 positionScale_;
+    /// Constant rotation in compressed form.
+    Quaternion constantRotation_;
+    /// Compressed scale range minimum, or the constant scale.
+    Vector3 scaleMin_;
+    /// Compressed scale scale.
+    Vector3 scaleScale_;
+    /// Compressed keyframe times.
+    PODVector<unsigned short> compressedTimes_;
+    /// Compressed positions, 3 values per keyframe.
+    PODVector<unsigned short> compressedPositions_;
+    /// Compressed rotations, 3 values per keyframe.
+    PODVector<unsigned short> compressedRotations_;
+    /// Compressed scales, 3 values per keyframe.
+    PODVector<unsigned short> compressedScales_;
 };
 
 /// %Animation trigger point.
@@ -74,6 +128,21 @@ struct AnimationTriggerPoint
     Variant data_;
 };
 
+/// Sampled transforms of all tracks of an animation, stored in separate arrays indexed by track.
+struct AnimationPose
+{
+    /// Track positions.
+    PODVector<Vector3> positions_;
+    /// Track rotations.
+    PODVector<Quaternion> rotations_;
+    /// Track scales.
+    PODVector<Vector3> scales_;
+    /// Channels sampled for each track, zero if the track has no keyframes.
+    PODVector<unsigned char> channelMasks_;
+    /// Keyframe index of each track from the previous sampling.
+    PODVector<unsigned> keyFrames_;
+};
+
 static const unsigned char CHANNEL_POSITION = 0x1;
 static const unsigned char CHANNEL_ROTATION = 0x2;
 static const unsigned char CHANNEL_SCALE = 0x4;
@@ -102,6 +171,8 @@ public:
     void SetLength(float length);
     /// Set all animation tracks.
     void SetTracks(const Vector<AnimationTrack>& tracks);
+    /// Compress all animation tracks. A compressed animation is saved in the compressed file format.
+    void Compress();
     /// Add a trigger point.
     void AddTrigger(float time, bool timeIsNormalized, const Variant& data);
     /// Remove a trigger point by index.
@@ -131,8 +202,17 @@ public:
     const Vector<AnimationTriggerPoint>& GetTriggers() const { return triggers_; }
     /// Return number of animation trigger points.
     unsigned GetNumTriggers() const {return triggers_.Size(); }
+    /// Return whether any of the tracks are compressed.
+    bool IsCompressed() const;
+    /// Sample all tracks at time into a pose in one pass. Time is wrapped if looped, otherwise clamped. Reuse the pose between calls to keep the previous keyframe indices for sequential playback.
+    void Sample(float time, bool looped, AnimationPose& pose) const;
     
 private:
+    /// Read a compressed track's keyframe data.
+    void ReadCompressedTrack(AnimationTrack& track, Deserializer& source);
+    /// Write a compressed track's keyframe data.
+    void WriteCompressedTrack(const AnimationTrack& track, Serializer& dest) const;
+    
     /// Animation name.
     String animationName_;
     /// Animation name hash.
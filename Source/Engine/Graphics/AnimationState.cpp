@@ -37,6 +37,7 @@ namespace Urho3D
 AnimationStateTrack::AnimationStateTrack() :
     track_(0),
     bone_(0),
+    boneIndex_(0),
     weight_(1.0f),
     keyFrame_(0)
 {
@@ -152,6 +153,7 @@ void AnimationState::SetStartBone(Bone* startBone)
         if (trackBone && trackBone->node_)
         {
             stateTrack.bone_ = trackBone;
+            stateTrack.boneIndex_ = trackBone - &skeleton.GetModifiableBones()[0];
             stateTrack.node_ = trackBone->node_;
             stateTracks_.Push(stateTrack);
         }
@@ -391,6 +393,8 @@ void AnimationState::Apply()
 
 void AnimationState::ApplyToModel()
 {
+    bool toPose = model_->GetNodeFreeAnimation();
+    
     for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
     {
         AnimationStateTrack& stateTrack = *i;
@@ -400,7 +404,9 @@ void AnimationState::ApplyToModel()
         if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_)
             continue;
         
-        if (Equals(finalWeight, 1.0f))
+        if (toPose)
+            ApplyTrackToPose(stateTrack, finalWeight);
+        else if (Equals(finalWeight, 1.0f))
             ApplyTrackFullWeight(stateTrack);
         else
             ApplyTrackBlended(stateTrack, finalWeight);
@@ -416,123 +422,76 @@ void AnimationState::ApplyToNodes()
 
 void AnimationState::ApplyTrackFullWeight(AnimationStateTrack& stateTrack)
 {
-    const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
-    
-    if (track->keyFrames_.Empty() || !node)
+    if (!node)
         return;
     
-    unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
-    
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    unsigned nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.Size())
-    {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
-    }
-    
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
-    unsigned char channelMask = track->channelMask_;
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+    unsigned char channelMask = SampleTrack(stateTrack, position, rotation, scale);
     
-    if (!interpolate)
-    {
-        // No interpolation, full weight
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(keyFrame->position_);
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(keyFrame->rotation_);
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScale(keyFrame->scale_);
-    }
-    else
-    {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
-        
-        // Interpolation, full weight
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(keyFrame->position_.Lerp(nextKeyFrame->position_, t));
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t));
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScale(keyFrame->scale_.Lerp(nextKeyFrame->scale_, t));
-    }
+    if (channelMask & CHANNEL_POSITION)
+        node->SetPosition(position);
+    if (channelMask & CHANNEL_ROTATION)
+        node->SetRotation(rotation);
+    if (channelMask & CHANNEL_SCALE)
+        node->SetScale(scale);
 }
 
 void AnimationState::ApplyTrackBlended(AnimationStateTrack& stateTrack, float weight)
 {
-    const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
-    
-    if (track->keyFrames_.Empty() || !node)
+    if (!node)
         return;
     
-    unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+    unsigned char channelMask = SampleTrack(stateTrack, position, rotation, scale);
     
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    unsigned nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.Size())
+    // Blend between old transform & animation
+    if (channelMask & CHANNEL_POSITION)
+        node->SetPosition(node->GetPosition().Lerp(position, weight));
+    if (channelMask & CHANNEL_ROTATION)
+        node->SetRotation(node->GetRotation().Slerp(rotation, weight));
+    if (channelMask & CHANNEL_SCALE)
+        node->SetScale(node->GetScale().Lerp(scale, weight));
+}
+
+void AnimationState::ApplyTrackToPose(AnimationStateTrack& stateTrack, float weight)
+{
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+    unsigned char channelMask = SampleTrack(stateTrack, position, rotation, scale);
+    if (!channelMask)
+        return;
+    
+    // Write into the model's local pose arrays, which were reset to the initial pose before applying the states
+    unsigned index = stateTrack.boneIndex_;
+    bool fullWeight = Equals(weight, 1.0f);
+    if (channelMask & CHANNEL_POSITION)
     {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
+        Vector3& dest = model_->bonePositions_[index];
+        dest = fullWeight ? position : dest.Lerp(position, weight);
     }
-    
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
-    unsigned char channelMask = track->channelMask_;
-    
-    if (!interpolate)
+    if (channelMask & CHANNEL_ROTATION)
     {
-        // No interpolation, blend between old transform & animation
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(node->GetPosition().Lerp(keyFrame->position_, weight));
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(node->GetRotation().Slerp(keyFrame->rotation_, weight));
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScale(node->GetScale().Lerp(keyFrame->scale_, weight));
+        Quaternion& dest = model_->boneRotations_[index];
+        dest = fullWeight ? rotation : dest.Slerp(rotation, weight);
     }
-    else
+    if (channelMask & CHANNEL_SCALE)
     {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
-        
-        // Interpolation, blend between old transform & animation
-        if (channelMask & CHANNEL_POSITION)
-        {
-            node->SetPosition(node->GetPosition().Lerp(
-                keyFrame->position_.Lerp(nextKeyFrame->position_, t), weight));
-        }
-        if (channelMask & CHANNEL_ROTATION)
-        {
-            node->SetRotation(node->GetRotation().Slerp(
-                keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t), weight));
-        }
-        if (channelMask & CHANNEL_SCALE)
-        {
-            node->SetScale(node->GetScale().Lerp(
-                keyFrame->scale_.Lerp(nextKeyFrame->scale_, t), weight));
-        }
+        Vector3& dest = model_->boneScales_[index];
+        dest = fullWeight ? scale : dest.Lerp(scale, weight);
     }
 }
 
+unsigned char AnimationState::SampleTrack(AnimationStateTrack& stateTrack, Vector3& position, Quaternion& rotation,
+    Vector3& scale)
+{
+    return stateTrack.track_->Sample(time_, animation_->GetLength(), looped_, stateTrack.keyFrame_, position, rotation, scale);
+}
+
 }
@@ -35,6 +35,8 @@ class Serializer;
 class Skeleton;
 struct AnimationTrack;
 struct Bone;
+class Quaternion;
+class Vector3;
 
 /// %Animation instance per-track data.
 struct AnimationStateTrack
@@ -48,6 +50,8 @@ struct AnimationStateTrack
     const AnimationTrack* track_;
     /// Bone pointer.
     Bone* bone_;
+    /// Bone index in the skeleton.
+    unsigned boneIndex_;
     /// Scene node pointer.
     WeakPtr<Node> node_;
     /// Blending weight.
@@ -133,6 +137,10 @@ private:
     void ApplyTrackFullWeight(AnimationStateTrack& stateTrack);
     /// Apply animation track to a scene node, blended with current node transform.
     void ApplyTrackBlended(AnimationStateTrack& stateTrack, float weight);
+    /// Apply animation track to the animated model's bone pose arrays (node-free animation mode.)
+    void ApplyTrackToPose(AnimationStateTrack& stateTrack, float weight);
+    /// Sample animation track at the current time position. Only the channels present in the track are written. Return the channel mask, or 0 if no keyframes.
+    unsigned char SampleTrack(AnimationStateTrack& stateTrack, Vector3& position, Quaternion& rotation, Vector3& scale);
     
     /// Animated model (model mode.)
     WeakPtr<AnimatedModel> model_;
@@ -43,28 +43,92 @@
 namespace Urho3D
 {
 
-inline bool CompareBatchesState(Batch* lhs, Batch* rhs)
+/// Radix sorting is not worth its fixed cost below this amount of batches.
+static const unsigned MIN_RADIX_SORT_BATCHES = 32;
+/// Bits of a remapped shader and light ID in a front-to-back sort key.
+static const unsigned REMAP_SHADER_BITS = 20;
+/// Bits of a remapped material ID in a front-to-back sort key.
+static const unsigned REMAP_MATERIAL_BITS = 20;
+/// Bits of a remapped geometry ID in a front-to-back sort key.
+static const unsigned REMAP_GEOMETRY_BITS = 22;
+
+inline bool CompareSortEntries(const BatchSortEntry& lhs, const BatchSortEntry& rhs)
 {
-    if (lhs->sortKey_ != rhs->sortKey_)
-        return lhs->sortKey_ < rhs->sortKey_;
-    else
-        return lhs->distance_ < rhs->distance_;
+    return lhs.key_ < rhs.key_;
 }
 
-inline bool CompareBatchesFrontToBack(Batch* lhs, Batch* rhs)
+/// Convert a float to an unsigned integer which sorts in the same order.
+inline unsigned FloatToSortKey(float value)
 {
-    if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ < rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    union
+    {
+        float floatValue_;
+        unsigned bits_;
+    } convert;
+    
+    convert.floatValue_ = value;
+    // Flip all bits of negative values, and only the sign bit of positive values
+    return (convert.bits_ & 0x80000000) ? ~convert.bits_ : convert.bits_ | 0x80000000;
 }
 
-inline bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
+/// Sort entries by key with a stable least significant digit radix sort, one byte per pass. Passes in which all keys have the same byte are skipped.
+static void RadixSort(PODVector<BatchSortEntry>& entries, PODVector<BatchSortEntry>& buffer)
 {
-    if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ > rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    unsigned count = entries.Size();
+    if (count < MIN_RADIX_SORT_BATCHES)
+    {
+        // Insertion sort is stable, which the 2-pass sort relies on
+        InsertionSort(entries.Begin(), entries.End(), CompareSortEntries);
+        return;
+    }
+    
+    // Count the occurrences of each byte value for all passes at once
+    unsigned histograms[8][256];
+    memset(histograms, 0, sizeof histograms);
+    for (PODVector<BatchSortEntry>::ConstIterator i = entries.Begin(); i != entries.End(); ++i)
+    {
+        unsigned long long key = i->key_;
+        for (unsigned j = 0; j < 8; ++j)
+            ++histograms[j][(key >> (j * 8)) & 0xff];
+    }
+    
+    buffer.Resize(count);
+    BatchSortEntry* src = &entries[0];
+    BatchSortEntry* dest = &buffer[0];
+    
+    for (unsigned j = 0; j < 8; ++j)
+    {
+        unsigned shift = j * 8;
+        unsigned* histogram = histograms[j];
+        if (histogram[(src[0].key_ >> shift) & 0xff] == count)
+            continue;
+        
+        // Convert the counts to start offsets, then scatter to the destination in the current order
+        unsigned offset = 0;
+        for (unsigned k = 0; k < 256; ++k)
+        {
+            unsigned numKeys = histogram[k];
+            histogram[k] = offset;
+            offset += numKeys;
+        }
+        for (unsigned k = 0; k < count; ++k)
+            dest[histogram[(src[k].key_ >> shift) & 0xff]++] = src[k];
+        
+        Swap(src, dest);
+    }
+    
+    // After an odd number of passes the result is in the buffer
+    if (src != &entries[0])
+        entries.Swap(buffer);
+}
+
+/// Sort entries by the masked batch sort key. A following radix sort by another key is stable, so this orders the entries with equal keys in that sort by state.
+static void RadixSortByBatchKeys(PODVector<BatchSortEntry>& entries, PODVector<BatchSortEntry>& buffer, unsigned long long mask)
+{
+    for (PODVector<BatchSortEntry>::Iterator i = entries.Begin(); i != entries.End(); ++i)
+        i->key_ = i->batch_->sortKey_ & mask;
+    
+    RadixSort(entries, buffer);
 }
 
 inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
@@ -763,9 +827,10 @@ unsigned BatchGroupKey::ToHash() const
         ((unsigned)(size_t)geometry_) / sizeof(Geometry);
 }
 
-void BatchQueue::Clear(int maxSortedInstances)
+void BatchQueue::Clear(int maxSortedInstances, ArenaAllocator* arena)
 {
-    batches_.Clear();
+    // The sorted lists are filled by the sorting work items in worker threads, so they stay in the heap and keep their capacity
+    batches_.ResetArena(arena);
     sortedBatches_.Clear();
     batchGroups_.Clear();
     maxSortedInstances_ = maxSortedInstances;
@@ -773,12 +838,20 @@ void BatchQueue::Clear(int maxSortedInstances)
 
 void BatchQueue::SortBackToFront()
 {
-    sortedBatches_.Resize(batches_.Size());
-    
+    // Sort by distance, farthest first, and use the shader and light as a secondary key
+    sortEntries_.Resize(batches_.Size());
     for (unsigned i = 0; i < batches_.Size(); ++i)
-        sortedBatches_[i] = &batches_[i];
+        sortEntries_[i].batch_ = &batches_[i];
+    
+    // The material and geometry do not fit in the key, so sort by them first
+    RadixSortByBatchKeys(sortEntries_, sortBuffer_, (unsigned long long)M_MAX_UNSIGNED);
+    for (PODVector<BatchSortEntry>::Iterator i = sortEntries_.Begin(); i != sortEntries_.End(); ++i)
+        i->key_ = (((unsigned long long)~FloatToSortKey(i->batch_->distance_)) << 32) | (i->batch_->sortKey_ >> 32);
+    RadixSort(sortEntries_, sortBuffer_);
     
-    Sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
+    sortedBatches_.Resize(batches_.Size());
+    for (unsigned i = 0; i < sortEntries_.Size(); ++i)
+        sortedBatches_[i] = sortEntries_[i].batch_;
     
     // Do not actually sort batch groups, just list them
     sortedBatchGroups_.Resize(batchGroups_.Size());
@@ -790,10 +863,10 @@ void BatchQueue::SortBackToFront()
 
 void BatchQueue::SortFrontToBack()
 {
-    sortedBatches_.Clear();
+    sortedBatches_.Resize(batches_.Size());
     
     for (unsigned i = 0; i < batches_.Size(); ++i)
-        sortedBatches_.Push(&batches_[i]);
+        sortedBatches_[i] = &batches_[i];
     
     SortFrontToBack2Pass(sortedBatches_);
     
@@ -826,62 +899,74 @@ void BatchQueue::SortFrontToBack()
 
 void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
 {
-    // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The 2-pass
-    // method is also time consuming, so just sort with state having priority
+    if (batches.Size() < 2)
+        return;
+    
+    // First sort by distance. The following state sort is stable, so batches with the same state remain front to back
+    sortEntries_.Resize(batches.Size());
+    for (unsigned i = 0; i < batches.Size(); ++i)
+        sortEntries_[i].batch_ = batches[i];
+    
+    // Order batches at the same distance by state, so that the state IDs are remapped in a deterministic order
+    RadixSortByBatchKeys(sortEntries_, sortBuffer_, ~(unsigned long long)0);
+    for (PODVector<BatchSortEntry>::Iterator i = sortEntries_.Begin(); i != sortEntries_.End(); ++i)
+        i->key_ = FloatToSortKey(i->batch_->distance_);
+    RadixSort(sortEntries_, sortBuffer_);
+    
+    // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The remapping is
+    // also time consuming, so just sort with state having priority
     #ifdef GL_ES_VERSION_2_0
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    for (PODVector<BatchSortEntry>::Iterator i = sortEntries_.Begin(); i != sortEntries_.End(); ++i)
+        i->key_ = i->batch_->sortKey_;
     #else
-    // For desktop, first sort by distance and remap shader/material/geometry IDs in the sort key
-    Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
-    
+    // For desktop, remap the shader/material/geometry IDs in distance order, so that the state groups containing the closest
+    // batches are drawn first. The remapped IDs are sequential, so they fit in less bits than the original IDs. The base and
+    // alpha mask flags stay in the highest bits
     unsigned freeShaderID = 0;
-    unsigned short freeMaterialID = 0;
-    unsigned short freeGeometryID = 0;
+    unsigned freeMaterialID = 0;
+    unsigned freeGeometryID = 0;
     
-    for (PODVector<Batch*>::Iterator i = batches.Begin(); i != batches.End(); ++i)
+    for (PODVector<BatchSortEntry>::Iterator i = sortEntries_.Begin(); i != sortEntries_.End(); ++i)
     {
-        Batch* batch = *i;
+        unsigned long long sortKey = i->batch_->sortKey_;
         
-        unsigned shaderID = (batch->sortKey_ >> 32);
-        HashMap<unsigned, unsigned>::ConstIterator j = shaderRemapping_.Find(shaderID);
+        unsigned shaderID = (unsigned)(sortKey >> 32);
+        FlatHashMap<unsigned, unsigned>::ConstIterator j = shaderRemapping_.Find(shaderID);
         if (j != shaderRemapping_.End())
             shaderID = j->second_;
         else
-        {
-            shaderID = shaderRemapping_[shaderID] = freeShaderID | (shaderID & 0xc0000000);
-            ++freeShaderID;
-        }
+            shaderID = shaderRemapping_[shaderID] = freeShaderID++;
         
-        unsigned short materialID = (unsigned short)(batch->sortKey_ & 0xffff0000);
-        HashMap<unsigned short, unsigned short>::ConstIterator k = materialRemapping_.Find(materialID);
+        unsigned materialID = (unsigned short)(sortKey >> 16);
+        FlatHashMap<unsigned short, unsigned>::ConstIterator k = materialRemapping_.Find(materialID);
         if (k != materialRemapping_.End())
             materialID = k->second_;
         else
-        {
-            materialID = materialRemapping_[materialID] = freeMaterialID;
-            ++freeMaterialID;
-        }
+            materialID = materialRemapping_[materialID] = freeMaterialID++;
         
-        unsigned short geometryID = (unsigned short)(batch->sortKey_ & 0xffff);
-        HashMap<unsigned short, unsigned short>::ConstIterator l = geometryRemapping_.Find(geometryID);
+        unsigned geometryID = (unsigned short)sortKey;
+        FlatHashMap<unsigned short, unsigned>::ConstIterator l = geometryRemapping_.Find(geometryID);
         if (l != geometryRemapping_.End())
             geometryID = l->second_;
         else
-        {
-            geometryID = geometryRemapping_[geometryID] = freeGeometryID;
-            ++freeGeometryID;
-        }
+            geometryID = geometryRemapping_[geometryID] = freeGeometryID++;
         
-        batch->sortKey_ = (((unsigned long long)shaderID) << 32) || (((unsigned long long)materialID) << 16) | geometryID;
+        i->key_ = ((sortKey >> 62) << 62) |
+            (((unsigned long long)(shaderID & ((1 << REMAP_SHADER_BITS) - 1))) << (REMAP_MATERIAL_BITS + REMAP_GEOMETRY_BITS)) |
+            (((unsigned long long)(materialID & ((1 << REMAP_MATERIAL_BITS) - 1))) << REMAP_GEOMETRY_BITS) |
+            (geometryID & ((1 << REMAP_GEOMETRY_BITS) - 1));
     }
     
     shaderRemapping_.Clear();
     materialRemapping_.Clear();
     geometryRemapping_.Clear();
-    
-    // Finally sort again with the rewritten ID's
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
     #endif
+    
+    // Finally sort with the state keys
+    RadixSort(sortEntries_, sortBuffer_);
+    
+    for (unsigned i = 0; i < sortEntries_.Size(); ++i)
+        batches[i] = sortEntries_[i].batch_;
 }
 
 void BatchQueue::SetTransforms(void* lockedData, unsigned& freeIndex)
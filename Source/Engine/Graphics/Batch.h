@@ -23,6 +23,7 @@
 #pragma once
 
 #include "Drawable.h"
+#include "FlatHashMap.h"
 #include "MathDefs.h"
 #include "Matrix3x4.h"
 #include "Ptr.h"
@@ -214,12 +215,21 @@ struct BatchGroupKey
     unsigned ToHash() const;
 };
 
+/// Packed sorting key and batch for radix sorting a batch queue.
+struct BatchSortEntry
+{
+    /// Sorting key.
+    unsigned long long key_;
+    /// Batch.
+    Batch* batch_;
+};
+
 /// Queue that contains both instanced and non-instanced draw calls.
 struct BatchQueue
 {
 public:
-    /// Clear for new frame by clearing all groups and batches.
-    void Clear(int maxSortedInstances);
+    /// Clear for new frame by clearing all groups and batches. Optionally allocate the non-instanced batches from an arena.
+    void Clear(int maxSortedInstances, ArenaAllocator* arena = 0);
     /// Sort non-instanced draw calls back to front.
     void SortBackToFront();
     /// Sort instanced and non-instanced draw calls front to back.
@@ -238,11 +248,15 @@ public:
     /// Instanced draw calls.
     HashMap<BatchGroupKey, BatchGroup> batchGroups_;
     /// Shader remapping table for 2-pass state and distance sort.
-    HashMap<unsigned, unsigned> shaderRemapping_;
+    FlatHashMap<unsigned, unsigned> shaderRemapping_;
     /// Material remapping table for 2-pass state and distance sort.
-    HashMap<unsigned short, unsigned short> materialRemapping_;
+    FlatHashMap<unsigned short, unsigned> materialRemapping_;
     /// Geometry remapping table for 2-pass state and distance sort.
-    HashMap<unsigned short, unsigned short> geometryRemapping_;
+    FlatHashMap<unsigned short, unsigned> geometryRemapping_;
+    /// Sorting keys and batches being sorted.
+    PODVector<BatchSortEntry> sortEntries_;
+    /// Temporary buffer for the radix sort passes.
+    PODVector<BatchSortEntry> sortBuffer_;
     
     /// Unsorted non-instanced draw calls.
     PODVector<Batch> batches_;
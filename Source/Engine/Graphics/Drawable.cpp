@@ -61,6 +61,7 @@ Drawable::Drawable(Context* context, unsigned char drawableFlags) :
     castShadows_(false),
     occluder_(false),
     occludee_(true),
+    static_(false),
     updateQueued_(false),
     viewMask_(DEFAULT_VIEWMASK),
     lightMask_(DEFAULT_LIGHTMASK),
@@ -78,6 +79,8 @@ Drawable::Drawable(Context* context, unsigned char drawableFlags) :
     basePassFlags_(0),
     maxLights_(0),
     octant_(0),
+    octantIndex_(0),
+    staticIndexed_(false),
     firstLight_(0),
     zone_(0),
     lastZone_(0),
@@ -233,6 +236,18 @@ void Drawable::SetOccludee(bool enable)
     }
 }
 
+void Drawable::SetStatic(bool enable)
+{
+    if (enable != static_)
+    {
+        static_ = enable;
+        // Reinsert to octree to move into or out of the static drawable index
+        if (octant_ && !updateQueued_)
+            octant_->GetRoot()->QueueUpdate(this);
+        MarkNetworkUpdate();
+    }
+}
+
 void Drawable::MarkForUpdate()
 {
     if (!updateQueued_ && octant_)
@@ -245,6 +260,9 @@ const BoundingBox& Drawable::GetWorldBoundingBox()
     {
         OnWorldBoundingBoxUpdate();
         worldBoundingBoxDirty_ = false;
+        // Store the new bounds to the octant for culling. The static drawable index updates its bounds on reinsertion
+        if (octant_ && !staticIndexed_)
+            octant_->SetDrawableBounds(octantIndex_, worldBoundingBox_);
     }
 
     return worldBoundingBox_;
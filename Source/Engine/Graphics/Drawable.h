@@ -104,7 +104,9 @@ class URHO3D_API Drawable : public Component
     
     friend class Octant;
     friend class Octree;
+    friend class StaticDrawableIndex;
     friend void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex);
+    friend void ReinsertDrawablesWork(const WorkItem* item, unsigned threadIndex);
     
 public:
     /// Construct.
@@ -157,6 +159,8 @@ public:
     void SetOccluder(bool enable);
     /// Set occludee flag.
     void SetOccludee(bool enable);
+    /// Set static flag. Static occludees are stored in the octree's static drawable index, which suits drawables that rarely move.
+    void SetStatic(bool enable);
     /// Mark for update and octree reinsertion. Update is automatically queued when the drawable's scene node moves or changes scale.
     void MarkForUpdate();
     
@@ -188,6 +192,8 @@ public:
     bool IsOccluder() const { return occluder_; }
     /// Return occludee flag.
     bool IsOccludee() const { return occludee_; }
+    /// Return static flag.
+    bool IsStatic() const { return static_; }
     /// Return whether is in view this frame from any viewport camera. Excludes shadow map cameras.
     bool IsInView() const;
     /// Return whether is in view of a specific camera this frame. Pass in a null camera to allow any camera, including shadow map cameras.
@@ -293,6 +299,8 @@ protected:
     bool occluder_;
     /// Occludee flag.
     bool occludee_;
+    /// Static flag.
+    bool static_;
     /// Octree update queued flag.
     bool updateQueued_;
     /// View mask.
@@ -327,6 +335,10 @@ protected:
     unsigned maxLights_;
     /// Octree octant.
     Octant* octant_;
+    /// Index in the octant's drawable list.
+    unsigned octantIndex_;
+    /// Stored in the octree's static drawable index flag.
+    bool staticIndexed_;
     /// First per-pixel light added this frame.
     Light* firstLight_;
     /// Per-pixel lights affecting this drawable.
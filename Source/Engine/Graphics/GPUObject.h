@@ -22,7 +22,9 @@
 
 #pragma once
 
-#ifdef USE_OPENGL
+#if defined(USE_NULL_GRAPHICS)
+#include "Null/NullGPUObject.h"
+#elif defined(USE_OPENGL)
 #include "OpenGL/OGLGPUObject.h"
 #else
 #include "Direct3D9/D3D9GPUObject.h"
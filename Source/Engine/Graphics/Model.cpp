@@ -90,6 +90,7 @@ bool Model::Load(Deserializer& source)
     morphs_.Clear();
     vertexBuffers_.Clear();
     indexBuffers_.Clear();
+    occluderGeometry_.Reset();
     
     unsigned memoryUse = sizeof(Model);
     
@@ -245,6 +246,61 @@ bool Model::Load(Deserializer& source)
         geometryCenters_.Push(Vector3::ZERO);
     memoryUse += sizeof(Vector3) * geometries_.Size();
     
+    // Read occluder geometry if included. Malformed occluder data only drops the occluder, not the whole model
+    if (!source.IsEof())
+    {
+        bool valid = false;
+        unsigned vertexCount = source.ReadUInt();
+        unsigned indexCount = 0;
+        unsigned indexSize = 0;
+        SharedArrayPtr<unsigned char> vertexData;
+        SharedArrayPtr<unsigned char> indexData;
+        
+        if (vertexCount && vertexCount <= (source.GetSize() - source.GetPosition()) / sizeof(Vector3))
+        {
+            vertexData = new unsigned char[vertexCount * sizeof(Vector3)];
+            if (source.Read(vertexData.Get(), vertexCount * sizeof(Vector3)) == vertexCount * sizeof(Vector3))
+            {
+                indexCount = source.ReadUInt();
+                indexSize = source.ReadUInt();
+                if ((indexSize == sizeof(unsigned short) || indexSize == sizeof(unsigned)) && indexCount && !(indexCount % 3) &&
+                    indexCount <= (source.GetSize() - source.GetPosition()) / indexSize)
+                {
+                    indexData = new unsigned char[indexCount * indexSize];
+                    if (source.Read(indexData.Get(), indexCount * indexSize) == indexCount * indexSize)
+                    {
+                        valid = true;
+                        if (indexSize == sizeof(unsigned short))
+                        {
+                            const unsigned short* indices = (const unsigned short*)indexData.Get();
+                            for (unsigned i = 0; i < indexCount && valid; ++i)
+                                valid = indices[i] < vertexCount;
+                        }
+                        else
+                        {
+                            const unsigned* indices = (const unsigned*)indexData.Get();
+                            for (unsigned i = 0; i < indexCount && valid; ++i)
+                                valid = indices[i] < vertexCount;
+                        }
+                    }
+                }
+            }
+        }
+        
+        if (valid)
+        {
+            SharedPtr<Geometry> geometry(new Geometry(context_));
+            geometry->SetRawVertexData(vertexData, sizeof(Vector3), MASK_POSITION);
+            geometry->SetRawIndexData(indexData, indexSize);
+            geometry->SetDrawRange(TRIANGLE_LIST, 0, indexCount, 0, vertexCount);
+            occluderGeometry_ = geometry;
+            
+            memoryUse += sizeof(Geometry) + vertexCount * sizeof(Vector3) + indexCount * indexSize;
+        }
+        else
+            LOGERROR("Malformed occluder geometry in " + source.GetName() + ", occluder dropped");
+    }
+    
     SetMemoryUse(memoryUse);
     return true;
 }
@@ -337,6 +393,28 @@ bool Model::Save(Serializer& dest) const
     for (unsigned i = 0; i < geometryCenters_.Size(); ++i)
         dest.WriteVector3(geometryCenters_[i]);
     
+    // Write occluder geometry if defined. Older versions of the engine stop reading before it
+    if (occluderGeometry_)
+    {
+        const unsigned char* vertexData;
+        unsigned vertexSize;
+        const unsigned char* indexData;
+        unsigned indexSize;
+        unsigned elementMask;
+        occluderGeometry_->GetRawData(vertexData, vertexSize, indexData, indexSize, elementMask);
+        
+        // Write only the positions, which are always first in the vertex
+        unsigned vertexCount = occluderGeometry_->GetVertexStart() + occluderGeometry_->GetVertexCount();
+        dest.WriteUInt(vertexCount);
+        for (unsigned i = 0; i < vertexCount; ++i)
+            dest.WriteVector3(*((const Vector3*)(vertexData + i * vertexSize)));
+        
+        unsigned indexCount = occluderGeometry_->GetIndexCount();
+        dest.WriteUInt(indexCount);
+        dest.WriteUInt(indexSize);
+        dest.Write(indexData + occluderGeometry_->GetIndexStart() * indexSize, indexCount * indexSize);
+    }
+    
     return true;
 }
 
@@ -463,6 +541,33 @@ void Model::SetMorphs(const Vector<ModelMorph>& morphs)
     morphs_ = morphs;
 }
 
+bool Model::SetOccluderGeometry(Geometry* geometry)
+{
+    if (geometry)
+    {
+        const unsigned char* vertexData;
+        unsigned vertexSize;
+        const unsigned char* indexData;
+        unsigned indexSize;
+        unsigned elementMask;
+        geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elementMask);
+        
+        if (!vertexData || !indexData || !(elementMask & MASK_POSITION))
+        {
+            LOGERROR("Occluder geometry must have CPU-side position and index data");
+            return false;
+        }
+        if (geometry->GetPrimitiveType() != TRIANGLE_LIST)
+        {
+            LOGERROR("Occluder geometry must be a triangle list");
+            return false;
+        }
+    }
+    
+    occluderGeometry_ = geometry;
+    return true;
+}
+
 unsigned Model::GetNumGeometryLodLevels(unsigned index) const
 {
     return index < geometries_.Size() ? geometries_[index].Size() : 0;
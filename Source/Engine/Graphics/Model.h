@@ -98,6 +98,8 @@ public:
     void SetGeometryBoneMappings(const Vector<PODVector<unsigned> >& mappings);
     /// Set vertex morphs.
     void SetMorphs(const Vector<ModelMorph>& morphs);
+    /// Set simplified occluder geometry, which is rasterized into the occlusion buffer instead of the LOD geometries. Requires CPU-side position and index data. Null to disable.
+    bool SetOccluderGeometry(Geometry* geometry);
     
     /// Return bounding box.
     const BoundingBox& GetBoundingBox() const { return boundingBox_; }
@@ -133,6 +135,8 @@ public:
     unsigned GetMorphRangeStart(unsigned bufferIndex) const;
     /// Return vertex buffer morph range vertex count.
     unsigned GetMorphRangeCount(unsigned bufferIndex) const;
+    /// Return simplified occluder geometry, or null if not defined.
+    Geometry* GetOccluderGeometry() const { return occluderGeometry_; }
     
 private:
     /// Bounding box.
@@ -155,6 +159,8 @@ private:
     PODVector<unsigned> morphRangeStarts_;
     /// Vertex buffer morph range vertex count.
     PODVector<unsigned> morphRangeCounts_;
+    /// Simplified occluder geometry.
+    SharedPtr<Geometry> occluderGeometry_;
 };
 
 }
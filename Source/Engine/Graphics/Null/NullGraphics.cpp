@@ -0,0 +1,1553 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "AnimatedModel.h"
+#include "Animation.h"
+#include "AnimationController.h"
+#include "Camera.h"
+#include "Context.h"
+#include "CustomGeometry.h"
+#include "DebugRenderer.h"
+#include "DecalSet.h"
+#include "File.h"
+#include "Graphics.h"
+#include "GraphicsEvents.h"
+#include "GraphicsImpl.h"
+#include "IndexBuffer.h"
+#include "Log.h"
+#include "Material.h"
+#include "Octree.h"
+#include "ParticleEmitter.h"
+#include "ProcessUtils.h"
+#include "Profiler.h"
+#include "ResourceCache.h"
+#include "Shader.h"
+#include "ShaderPrecache.h"
+#include "ShaderVariation.h"
+#include "Skybox.h"
+#include "StaticModelGroup.h"
+#include "Technique.h"
+#include "Terrain.h"
+#include "TerrainPatch.h"
+#include "Texture2D.h"
+#include "Texture3D.h"
+#include "TextureCube.h"
+#include "Timer.h"
+#include "VertexBuffer.h"
+#include "Zone.h"
+
+#include "DebugNew.h"
+
+#ifdef _MSC_VER
+#pragma warning(disable:4355)
+#endif
+
+namespace Urho3D
+{
+
+Graphics::Graphics(Context* context) :
+    Object(context),
+    impl_(new GraphicsImpl()),
+    windowIcon_(0),
+    externalWindow_(0),
+    width_(0),
+    height_(0),
+    multiSample_(1),
+    fullscreen_(false),
+    borderless_(false),
+    resizable_(false),
+    vsync_(false),
+    tripleBuffer_(false),
+    flushGPU_(false),
+    sRGB_(false),
+    deviceLost_(false),
+    recordCommands_(true),
+    lightPrepassSupport_(false),
+    deferredSupport_(false),
+    hardwareShadowSupport_(false),
+    streamOffsetSupport_(false),
+    sRGBSupport_(false),
+    sRGBWriteSupport_(false),
+    hasSM3_(false),
+    forceSM2_(false),
+    numPrimitives_(0),
+    numBatches_(0),
+    maxScratchBufferRequest_(0),
+    dummyColorFormat_(0),
+    shadowMapFormat_(0),
+    hiresShadowMapFormat_(0),
+    defaultTextureFilterMode_(FILTER_BILINEAR),
+    shaderPath_("Shaders/HLSL/"),
+    shaderExtension_(".hlsl")
+{
+    SetTextureUnitMappings();
+    ResetCachedState();
+    
+    // Register Graphics library object factories
+    RegisterGraphicsLibrary(context_);
+}
+
+Graphics::~Graphics()
+{
+    // Release all GPU objects that still exist
+    for (Vector<GPUObject*>::Iterator i = gpuObjects_.Begin(); i != gpuObjects_.End(); ++i)
+        (*i)->Release();
+    gpuObjects_.Clear();
+    
+    delete impl_;
+    impl_ = 0;
+}
+
+void Graphics::SetExternalWindow(void* window)
+{
+    if (!impl_->deviceCreated_)
+        externalWindow_ = window;
+    else
+        LOGERROR("Window already opened, can not set external window");
+}
+
+void Graphics::SetWindowTitle(const String& windowTitle)
+{
+    windowTitle_ = windowTitle;
+}
+
+void Graphics::SetWindowIcon(Image* windowIcon)
+{
+    windowIcon_ = windowIcon;
+}
+
+void Graphics::SetWindowPosition(const IntVector2& position)
+{
+}
+
+void Graphics::SetWindowPosition(int x, int y)
+{
+    SetWindowPosition(IntVector2(x, y));
+}
+
+bool Graphics::SetMode(int width, int height, bool fullscreen, bool borderless, bool resizable, bool vsync, bool tripleBuffer, int multiSample)
+{
+    PROFILE(SetScreenMode);
+    
+    // There is no desktop to query, so zero dimensions always mean the predefined default size
+    if (!width || !height)
+    {
+        width = 1024;
+        height = 768;
+    }
+    
+    // Fullscreen or Borderless can not be resizable
+    if (fullscreen || borderless)
+        resizable = false;
+    
+    // Borderless cannot be fullscreen, they are mutually exclusive
+    if (borderless)
+        fullscreen = false;
+    
+    multiSample = Clamp(multiSample, 1, 16);
+    
+    // If nothing changes, do not reset the device
+    if (width == width_ && height == height_ && fullscreen == fullscreen_ && borderless == borderless_ && resizable == resizable_ &&
+        vsync == vsync_ && tripleBuffer == tripleBuffer_ && multiSample == multiSample_)
+        return true;
+    
+    if (!impl_->deviceCreated_)
+    {
+        impl_->deviceCreated_ = true;
+        CheckFeatureSupport();
+    }
+    
+    width_ = width;
+    height_ = height;
+    fullscreen_ = fullscreen;
+    borderless_ = borderless;
+    resizable_ = resizable;
+    vsync_ = vsync;
+    tripleBuffer_ = tripleBuffer;
+    multiSample_ = multiSample;
+    
+    ResetCachedState();
+    
+    #ifdef ENABLE_LOGGING
+    String msg;
+    msg.AppendWithFormat("Set null device screen mode %dx%d %s", width_, height_, (fullscreen_ ? "fullscreen" : "windowed"));
+    if (borderless_)
+        msg.Append(" borderless");
+    if (resizable_)
+        msg.Append(" resizable");
+    if (multiSample > 1)
+        msg.AppendWithFormat(" multisample %d", multiSample);
+    LOGINFO(msg);
+    #endif
+    
+    using namespace ScreenMode;
+    
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_WIDTH] = width_;
+    eventData[P_HEIGHT] = height_;
+    eventData[P_FULLSCREEN] = fullscreen_;
+    eventData[P_RESIZABLE] = resizable_;
+    eventData[P_BORDERLESS] = borderless_;
+    SendEvent(E_SCREENMODE, eventData);
+    
+    return true;
+}
+
+bool Graphics::SetMode(int width, int height)
+{
+    return SetMode(width, height, fullscreen_, borderless_, resizable_, vsync_, tripleBuffer_, multiSample_);
+}
+
+void Graphics::SetSRGB(bool enable)
+{
+    sRGB_ = enable && sRGBWriteSupport_;
+}
+
+void Graphics::SetFlushGPU(bool enable)
+{
+    flushGPU_ = enable;
+}
+
+bool Graphics::ToggleFullscreen()
+{
+    return SetMode(width_, height_, !fullscreen_, borderless_, resizable_, vsync_, tripleBuffer_, multiSample_);
+}
+
+void Graphics::Close()
+{
+    impl_->deviceCreated_ = false;
+}
+
+bool Graphics::TakeScreenShot(Image& destImage)
+{
+    LOGERROR("Screenshots are not supported by the null graphics device");
+    return false;
+}
+
+bool Graphics::BeginFrame()
+{
+    if (!IsInitialized())
+        return false;
+    
+    commands_.Clear();
+    counters_.Reset();
+    
+    // Set default rendertarget and depth buffer
+    ResetRenderTargets();
+    
+    // Cleanup textures from previous frame
+    for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
+        SetTexture(i, 0);
+    
+    // Cleanup stream frequencies from previous frame
+    ResetStreamFrequencies();
+    
+    numPrimitives_ = 0;
+    numBatches_ = 0;
+    
+    SendEvent(E_BEGINRENDERING);
+    
+    return true;
+}
+
+void Graphics::EndFrame()
+{
+    if (!IsInitialized())
+        return;
+    
+    PROFILE(Present);
+    
+    SendEvent(E_ENDRENDERING);
+    
+    // Clean up too large scratch buffers
+    CleanupScratchBuffers();
+}
+
+void Graphics::Clear(unsigned flags, const Color& color, float depth, unsigned stencil)
+{
+    RecordCommand(GC_CLEAR, 0, flags);
+    ++counters_.numClears_;
+}
+
+bool Graphics::ResolveToTexture(Texture2D* destination, const IntRect& viewport)
+{
+    if (!destination || !destination->GetRenderSurface() || destination->GetWidth() != width_ ||
+        destination->GetHeight() != height_)
+        return false;
+    
+    // There is no backbuffer content to resolve; count it as a rendertarget operation only
+    RecordCommand(GC_SETRENDERTARGET, destination->GetRenderSurface(), 0);
+    ++counters_.numRenderTargetChanges_;
+    return true;
+}
+
+void Graphics::Draw(PrimitiveType type, unsigned vertexStart, unsigned vertexCount)
+{
+    if (!vertexCount)
+        return;
+    
+    ResetStreamFrequencies();
+    
+    unsigned primitiveCount = type == TRIANGLE_LIST ? vertexCount / 3 : vertexCount / 2;
+    RecordCommand(GC_DRAW, 0, type, vertexStart, vertexCount);
+    
+    numPrimitives_ += primitiveCount;
+    ++numBatches_;
+    counters_.numPrimitives_ += primitiveCount;
+    ++counters_.numDraws_;
+}
+
+void Graphics::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount)
+{
+    if (!indexCount)
+        return;
+    
+    ResetStreamFrequencies();
+    
+    unsigned primitiveCount = type == TRIANGLE_LIST ? indexCount / 3 : indexCount / 2;
+    RecordCommand(GC_DRAWINDEXED, indexBuffer_, type, indexStart, indexCount);
+    
+    numPrimitives_ += primitiveCount;
+    ++numBatches_;
+    counters_.numPrimitives_ += primitiveCount;
+    ++counters_.numDraws_;
+}
+
+void Graphics::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount,
+    unsigned instanceCount)
+{
+    if (!indexCount || !instanceCount)
+        return;
+    
+    for (unsigned i = 0; i < MAX_VERTEX_STREAMS; ++i)
+    {
+        VertexBuffer* buffer = vertexBuffers_[i];
+        if (buffer)
+            SetStreamFrequency(i, (buffer->GetElementMask() & MASK_INSTANCEMATRIX1) ? 1 : instanceCount);
+    }
+    
+    unsigned primitiveCount = type == TRIANGLE_LIST ? indexCount / 3 : indexCount / 2;
+    RecordCommand(GC_DRAWINSTANCED, indexBuffer_, type, indexStart, indexCount, instanceCount);
+    
+    numPrimitives_ += instanceCount * primitiveCount;
+    ++numBatches_;
+    counters_.numPrimitives_ += instanceCount * primitiveCount;
+    counters_.numInstances_ += instanceCount;
+    ++counters_.numDraws_;
+}
+
+void Graphics::SetVertexBuffer(VertexBuffer* buffer)
+{
+    // Note: this is not multi-instance safe
+    static PODVector<VertexBuffer*> vertexBuffers(1);
+    static PODVector<unsigned> elementMasks(1);
+    vertexBuffers[0] = buffer;
+    elementMasks[0] = MASK_DEFAULT;
+    SetVertexBuffers(vertexBuffers, elementMasks);
+}
+
+bool Graphics::SetVertexBuffers(const PODVector<VertexBuffer*>& buffers, const PODVector<unsigned>&
+    elementMasks, unsigned instanceOffset)
+{
+    if (buffers.Size() > MAX_VERTEX_STREAMS)
+    {
+        LOGERROR("Too many vertex buffers");
+        return false;
+    }
+    if (buffers.Size() != elementMasks.Size())
+    {
+        LOGERROR("Amount of element masks and vertex buffers does not match");
+        return false;
+    }
+    
+    for (unsigned i = 0; i < MAX_VERTEX_STREAMS; ++i)
+    {
+        VertexBuffer* buffer = 0;
+        unsigned offset = 0;
+        
+        if (i < buffers.Size())
+        {
+            buffer = buffers[i];
+            if (buffer && buffer->GetElementMask() & MASK_INSTANCEMATRIX1)
+                offset = instanceOffset * buffer->GetVertexSize();
+        }
+        
+        if (buffer != vertexBuffers_[i] || offset != streamOffsets_[i])
+        {
+            RecordCommand(GC_SETVERTEXBUFFER, buffer, i, offset);
+            ++counters_.numVertexBufferChanges_;
+            
+            vertexBuffers_[i] = buffer;
+            streamOffsets_[i] = offset;
+        }
+    }
+    
+    return true;
+}
+
+bool Graphics::SetVertexBuffers(const Vector<SharedPtr<VertexBuffer> >& buffers, const PODVector<unsigned>&
+    elementMasks, unsigned instanceOffset)
+{
+    if (buffers.Size() > MAX_VERTEX_STREAMS)
+    {
+        LOGERROR("Too many vertex buffers");
+        return false;
+    }
+    if (buffers.Size() != elementMasks.Size())
+    {
+        LOGERROR("Amount of element masks and vertex buffers does not match");
+        return false;
+    }
+    
+    for (unsigned i = 0; i < MAX_VERTEX_STREAMS; ++i)
+    {
+        VertexBuffer* buffer = 0;
+        unsigned offset = 0;
+        
+        if (i < buffers.Size())
+        {
+            buffer = buffers[i];
+            if (buffer && buffer->GetElementMask() & MASK_INSTANCEMATRIX1)
+                offset = instanceOffset * buffer->GetVertexSize();
+        }
+        
+        if (buffer != vertexBuffers_[i] || offset != streamOffsets_[i])
+        {
+            RecordCommand(GC_SETVERTEXBUFFER, buffer, i, offset);
+            ++counters_.numVertexBufferChanges_;
+            
+            vertexBuffers_[i] = buffer;
+            streamOffsets_[i] = offset;
+        }
+    }
+    
+    return true;
+}
+
+void Graphics::SetIndexBuffer(IndexBuffer* buffer)
+{
+    if (buffer != indexBuffer_)
+    {
+        RecordCommand(GC_SETINDEXBUFFER, buffer);
+        ++counters_.numIndexBufferChanges_;
+        indexBuffer_ = buffer;
+    }
+}
+
+void Graphics::SetShaders(ShaderVariation* vs, ShaderVariation* ps)
+{
+    if (vs == vertexShader_ && ps == pixelShader_)
+        return;
+    
+    ClearParameterSources();
+    
+    if (vs != vertexShader_)
+    {
+        // Create the shader now if not yet created. If already attempted, do not retry
+        if (vs && !vs->GetGPUObject())
+        {
+            if (vs->GetCompilerOutput().Empty())
+            {
+                PROFILE(CompileVertexShader);
+                
+                bool success = vs->Create();
+                if (!success)
+                {
+                    LOGERROR("Failed to compile vertex shader " + vs->GetFullName() + ":\n" + vs->GetCompilerOutput());
+                    vs = 0;
+                }
+            }
+            else
+                vs = 0;
+        }
+        
+        if (!vs || vs->GetShaderType() != VS)
+            vs = 0;
+        
+        RecordCommand(GC_SETVERTEXSHADER, vs);
+        ++counters_.numShaderChanges_;
+        vertexShader_ = vs;
+    }
+    
+    if (ps != pixelShader_)
+    {
+        if (ps && !ps->GetGPUObject())
+        {
+            if (ps->GetCompilerOutput().Empty())
+            {
+                PROFILE(CompilePixelShader);
+                
+                bool success = ps->Create();
+                if (!success)
+                {
+                    LOGERROR("Failed to compile pixel shader " + ps->GetFullName() + ":\n" + ps->GetCompilerOutput());
+                    ps = 0;
+                }
+            }
+            else
+                ps = 0;
+        }
+        
+        if (!ps || ps->GetShaderType() != PS)
+            ps = 0;
+        
+        RecordCommand(GC_SETPIXELSHADER, ps);
+        ++counters_.numShaderChanges_;
+        pixelShader_ = ps;
+    }
+    
+    // Store shader combination if shader dumping in progress
+    if (shaderPrecache_)
+        shaderPrecache_->StoreShaders(vertexShader_, pixelShader_);
+}
+
+void Graphics::SetShaderParameter(StringHash param, const float* data, unsigned count)
+{
+    RecordCommand(GC_SETSHADERPARAMETER, 0, param.Value(), 0, count);
+    ++counters_.numShaderParameters_;
+}
+
+void Graphics::SetShaderParameter(StringHash param, float value)
+{
+    SetShaderParameter(param, &value, 1);
+}
+
+void Graphics::SetShaderParameter(StringHash param, bool value)
+{
+    float data = value ? 1.0f : 0.0f;
+    SetShaderParameter(param, &data, 1);
+}
+
+void Graphics::SetShaderParameter(StringHash param, const Color& color)
+{
+    SetShaderParameter(param, color.Data(), 4);
+}
+
+void Graphics::SetShaderParameter(StringHash param, const Vector2& vector)
+{
+    SetShaderParameter(param, vector.Data(), 2);
+}
+
+void Graphics::SetShaderParameter(StringHash param, const Matrix3& matrix)
+{
+    SetShaderParameter(param, matrix.Data(), 9);
+}
+
+void Graphics::SetShaderParameter(StringHash param, const Vector3& vector)
+{
+    SetShaderParameter(param, vector.Data(), 3);
+}
+
+void Graphics::SetShaderParameter(StringHash param, const Matrix4& matrix)
+{
+    SetShaderParameter(param, matrix.Data(), 16);
+}
+
+void Graphics::SetShaderParameter(StringHash param, const Vector4& vector)
+{
+    SetShaderParameter(param, vector.Data(), 4);
+}
+
+void Graphics::SetShaderParameter(StringHash param, const Matrix3x4& matrix)
+{
+    SetShaderParameter(param, matrix.Data(), 12);
+}
+
+void Graphics::SetShaderParameter(StringHash param, const Variant& value)
+{
+    switch (value.GetType())
+    {
+    case VAR_BOOL:
+        SetShaderParameter(param, value.GetBool());
+        break;
+        
+    case VAR_FLOAT:
+        SetShaderParameter(param, value.GetFloat());
+        break;
+        
+    case VAR_VECTOR2:
+        SetShaderParameter(param, value.GetVector2());
+        break;
+        
+    case VAR_VECTOR3:
+        SetShaderParameter(param, value.GetVector3());
+        break;
+        
+    case VAR_VECTOR4:
+        SetShaderParameter(param, value.GetVector4());
+        break;
+        
+    default:
+        // Unsupported parameter type, do nothing
+        break;
+    }
+}
+
+void Graphics::RegisterShaderParameter(StringHash param, const ShaderParameter& definition)
+{
+    HashMap<StringHash, ShaderParameter>::Iterator i = shaderParameters_.Find(param);
+    
+    if (i == shaderParameters_.End())
+        shaderParameters_.Insert(MakePair(param, definition));
+    else if (i->second_.regCount_ < definition.regCount_)
+        i->second_.regCount_ = definition.regCount_;
+}
+
+bool Graphics::NeedParameterUpdate(ShaderParameterGroup group, const void* source)
+{
+    if ((unsigned)(size_t)shaderParameterSources_[group] == M_MAX_UNSIGNED || shaderParameterSources_[group] != source)
+    {
+        shaderParameterSources_[group] = source;
+        return true;
+    }
+    else
+        return false;
+}
+
+bool Graphics::HasShaderParameter(ShaderType type, StringHash param)
+{
+    // Null shaders have no reflection data. Report every parameter as used so that the renderer does its full CPU-side work
+    return type == VS ? vertexShader_ != 0 : pixelShader_ != 0;
+}
+
+bool Graphics::HasTextureUnit(TextureUnit unit)
+{
+    return pixelShader_ && pixelShader_->HasTextureUnit(unit);
+}
+
+void Graphics::ClearParameterSource(ShaderParameterGroup group)
+{
+    shaderParameterSources_[group] = (const void*)M_MAX_UNSIGNED;
+}
+
+void Graphics::ClearParameterSources()
+{
+    for (unsigned i = 0; i < MAX_SHADER_PARAMETER_GROUPS; ++i)
+        shaderParameterSources_[i] = (const void*)M_MAX_UNSIGNED;
+}
+
+void Graphics::ClearTransformSources()
+{
+    shaderParameterSources_[SP_CAMERA] = (const void*)M_MAX_UNSIGNED;
+    shaderParameterSources_[SP_OBJECTTRANSFORM] = (const void*)M_MAX_UNSIGNED;
+}
+
+void Graphics::SetTexture(unsigned index, Texture* texture)
+{
+    if (index >= MAX_TEXTURE_UNITS)
+        return;
+    
+    // Check if texture is currently bound as a rendertarget. In that case, use its backup texture, or blank if not defined
+    if (texture)
+    {
+        if (renderTargets_[0] && renderTargets_[0]->GetParentTexture() == texture)
+            texture = texture->GetBackupTexture();
+    }
+    
+    if (texture != textures_[index])
+    {
+        RecordCommand(GC_SETTEXTURE, texture, index);
+        ++counters_.numTextureChanges_;
+        textures_[index] = texture;
+    }
+    
+    if (texture)
+    {
+        TextureFilterMode filterMode = texture->GetFilterMode();
+        if (filterMode == FILTER_DEFAULT)
+            filterMode = defaultTextureFilterMode_;
+        
+        if (filterMode != impl_->filterModes_[index])
+        {
+            ++counters_.numStateChanges_;
+            impl_->filterModes_[index] = filterMode;
+        }
+        TextureAddressMode u = texture->GetAddressMode(COORD_U);
+        if (u != impl_->uAddressModes_[index])
+        {
+            ++counters_.numStateChanges_;
+            impl_->uAddressModes_[index] = u;
+        }
+        TextureAddressMode v = texture->GetAddressMode(COORD_V);
+        if (v != impl_->vAddressModes_[index])
+        {
+            ++counters_.numStateChanges_;
+            impl_->vAddressModes_[index] = v;
+        }
+        if (texture->GetType() == TextureCube::GetTypeStatic())
+        {
+            TextureAddressMode w = texture->GetAddressMode(COORD_W);
+            if (w != impl_->wAddressModes_[index])
+            {
+                ++counters_.numStateChanges_;
+                impl_->wAddressModes_[index] = w;
+            }
+        }
+    }
+}
+
+void Graphics::SetDefaultTextureFilterMode(TextureFilterMode mode)
+{
+    defaultTextureFilterMode_ = mode;
+}
+
+void Graphics::ResetRenderTargets()
+{
+    for (unsigned i = 0; i < MAX_RENDERTARGETS; ++i)
+        SetRenderTarget(i, (RenderSurface*)0);
+    SetDepthStencil((RenderSurface*)0);
+    SetViewport(IntRect(0, 0, width_, height_));
+}
+
+void Graphics::ResetRenderTarget(unsigned index)
+{
+    SetRenderTarget(index, (RenderSurface*)0);
+}
+
+void Graphics::ResetDepthStencil()
+{
+    SetDepthStencil((RenderSurface*)0);
+}
+
+void Graphics::SetRenderTarget(unsigned index, RenderSurface* renderTarget)
+{
+    if (index >= MAX_RENDERTARGETS)
+        return;
+    
+    if (renderTarget && renderTarget->GetUsage() != TEXTURE_RENDERTARGET)
+        return;
+    
+    if (renderTarget != renderTargets_[index])
+    {
+        renderTargets_[index] = renderTarget;
+        RecordCommand(GC_SETRENDERTARGET, renderTarget, index);
+        ++counters_.numRenderTargetChanges_;
+        
+        // Setting the first rendertarget causes viewport to be reset
+        if (!index)
+        {
+            IntVector2 rtSize = GetRenderTargetDimensions();
+            viewport_ = IntRect(0, 0, rtSize.x_, rtSize.y_);
+        }
+    }
+    
+    // If the rendertarget is also bound as a texture, replace with backup texture or null
+    if (renderTarget)
+    {
+        Texture* parentTexture = renderTarget->GetParentTexture();
+        
+        for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
+        {
+            if (textures_[i] == parentTexture)
+                SetTexture(i, textures_[i]->GetBackupTexture());
+        }
+    }
+}
+
+void Graphics::SetRenderTarget(unsigned index, Texture2D* texture)
+{
+    RenderSurface* renderTarget = 0;
+    if (texture)
+        renderTarget = texture->GetRenderSurface();
+    
+    SetRenderTarget(index, renderTarget);
+}
+
+void Graphics::SetDepthStencil(RenderSurface* depthStencil)
+{
+    if (depthStencil && depthStencil->GetUsage() != TEXTURE_DEPTHSTENCIL)
+        depthStencil = 0;
+    
+    if (depthStencil != depthStencil_)
+    {
+        RecordCommand(GC_SETDEPTHSTENCIL, depthStencil);
+        ++counters_.numRenderTargetChanges_;
+        depthStencil_ = depthStencil;
+    }
+}
+
+void Graphics::SetDepthStencil(Texture2D* texture)
+{
+    RenderSurface* depthStencil = 0;
+    if (texture)
+        depthStencil = texture->GetRenderSurface();
+    
+    SetDepthStencil(depthStencil);
+}
+
+void Graphics::SetViewport(const IntRect& rect)
+{
+    IntVector2 size = GetRenderTargetDimensions();
+    
+    IntRect rectCopy = rect;
+    
+    if (rectCopy.right_ <= rectCopy.left_)
+        rectCopy.right_ = rectCopy.left_ + 1;
+    if (rectCopy.bottom_ <= rectCopy.top_)
+        rectCopy.bottom_ = rectCopy.top_ + 1;
+    rectCopy.left_ = Clamp(rectCopy.left_, 0, size.x_);
+    rectCopy.top_ = Clamp(rectCopy.top_, 0, size.y_);
+    rectCopy.right_ = Clamp(rectCopy.right_, 0, size.x_);
+    rectCopy.bottom_ = Clamp(rectCopy.bottom_, 0, size.y_);
+    
+    RecordCommand(GC_SETVIEWPORT, 0, 0, (rectCopy.left_ << 16) | rectCopy.top_, (rectCopy.Width() << 16) | rectCopy.Height());
+    ++counters_.numStateChanges_;
+    viewport_ = rectCopy;
+    
+    // Disable scissor test, needs to be re-enabled by the user
+    SetScissorTest(false);
+}
+
+void Graphics::SetTextureAnisotropy(unsigned level)
+{
+    if (level < 1)
+        level = 1;
+    
+    if (level != textureAnisotropy_)
+    {
+        ++counters_.numStateChanges_;
+        textureAnisotropy_ = level;
+    }
+}
+
+void Graphics::SetBlendMode(BlendMode mode)
+{
+    if (mode != blendMode_)
+    {
+        RecordCommand(GC_SETBLENDMODE, 0, mode);
+        ++counters_.numStateChanges_;
+        blendMode_ = mode;
+    }
+}
+
+void Graphics::SetColorWrite(bool enable)
+{
+    if (enable != colorWrite_)
+    {
+        RecordCommand(GC_SETCOLORWRITE, 0, enable ? 1 : 0);
+        ++counters_.numStateChanges_;
+        colorWrite_ = enable;
+    }
+}
+
+void Graphics::SetCullMode(CullMode mode)
+{
+    if (mode != cullMode_)
+    {
+        RecordCommand(GC_SETCULLMODE, 0, mode);
+        ++counters_.numStateChanges_;
+        cullMode_ = mode;
+    }
+}
+
+void Graphics::SetDepthBias(float constantBias, float slopeScaledBias)
+{
+    if (constantBias != constantDepthBias_ || slopeScaledBias != slopeScaledDepthBias_)
+    {
+        RecordCommand(GC_SETDEPTHBIAS);
+        ++counters_.numStateChanges_;
+        constantDepthBias_ = constantBias;
+        slopeScaledDepthBias_ = slopeScaledBias;
+    }
+}
+
+void Graphics::SetDepthTest(CompareMode mode)
+{
+    if (mode != depthTestMode_)
+    {
+        RecordCommand(GC_SETDEPTHTEST, 0, mode);
+        ++counters_.numStateChanges_;
+        depthTestMode_ = mode;
+    }
+}
+
+void Graphics::SetDepthWrite(bool enable)
+{
+    if (enable != depthWrite_)
+    {
+        RecordCommand(GC_SETDEPTHWRITE, 0, enable ? 1 : 0);
+        ++counters_.numStateChanges_;
+        depthWrite_ = enable;
+    }
+}
+
+void Graphics::SetFillMode(FillMode mode)
+{
+    if (mode != fillMode_)
+    {
+        RecordCommand(GC_SETFILLMODE, 0, mode);
+        ++counters_.numStateChanges_;
+        fillMode_ = mode;
+    }
+}
+
+void Graphics::SetScissorTest(bool enable, const Rect& rect, bool borderInclusive)
+{
+    // During some light rendering loops, a full rect is toggled on/off repeatedly.
+    // Disable scissor in that case to reduce state changes
+    if (rect.min_.x_ <= 0.0f && rect.min_.y_ <= 0.0f && rect.max_.x_ >= 1.0f && rect.max_.y_ >= 1.0f)
+        enable = false;
+    
+    if (enable)
+    {
+        IntVector2 rtSize(GetRenderTargetDimensions());
+        IntVector2 viewSize(viewport_.Size());
+        IntVector2 viewPos(viewport_.left_, viewport_.top_);
+        IntRect intRect;
+        int expand = borderInclusive ? 1 : 0;
+        
+        intRect.left_ = Clamp((int)((rect.min_.x_ + 1.0f) * 0.5f * viewSize.x_) + viewPos.x_, 0, rtSize.x_ - 1);
+        intRect.top_ = Clamp((int)((-rect.max_.y_ + 1.0f) * 0.5f * viewSize.y_) + viewPos.y_, 0, rtSize.y_ - 1);
+        intRect.right_ = Clamp((int)((rect.max_.x_ + 1.0f) * 0.5f * viewSize.x_) + viewPos.x_ + expand, 0, rtSize.x_);
+        intRect.bottom_ = Clamp((int)((-rect.min_.y_ + 1.0f) * 0.5f * viewSize.y_) + viewPos.y_ + expand, 0, rtSize.y_);
+        
+        if (intRect.right_ == intRect.left_)
+            intRect.right_++;
+        if (intRect.bottom_ == intRect.top_)
+            intRect.bottom_++;
+        
+        if (intRect.right_ < intRect.left_ || intRect.bottom_ < intRect.top_)
+            enable = false;
+        
+        if (enable && scissorRect_ != intRect)
+        {
+            RecordCommand(GC_SETSCISSORTEST, 0, 1, (intRect.left_ << 16) | intRect.top_, (intRect.Width() << 16) | intRect.Height());
+            ++counters_.numStateChanges_;
+            scissorRect_ = intRect;
+        }
+    }
+    else
+        scissorRect_ = IntRect::ZERO;
+    
+    if (enable != scissorTest_)
+    {
+        if (!enable)
+            RecordCommand(GC_SETSCISSORTEST, 0, 0);
+        ++counters_.numStateChanges_;
+        scissorTest_ = enable;
+    }
+}
+
+void Graphics::SetScissorTest(bool enable, const IntRect& rect)
+{
+    IntVector2 rtSize(GetRenderTargetDimensions());
+    IntVector2 viewPos(viewport_.left_, viewport_.top_);
+    
+    if (enable)
+    {
+        IntRect intRect;
+        intRect.left_ = Clamp(rect.left_ + viewPos.x_, 0, rtSize.x_ - 1);
+        intRect.top_ = Clamp(rect.top_ + viewPos.y_, 0, rtSize.y_ - 1);
+        intRect.right_ = Clamp(rect.right_ + viewPos.x_, 0, rtSize.x_);
+        intRect.bottom_ = Clamp(rect.bottom_ + viewPos.y_, 0, rtSize.y_);
+        
+        if (intRect.right_ == intRect.left_)
+            intRect.right_++;
+        if (intRect.bottom_ == intRect.top_)
+            intRect.bottom_++;
+        
+        if (intRect.right_ < intRect.left_ || intRect.bottom_ < intRect.top_)
+            enable = false;
+        
+        if (enable && scissorRect_ != intRect)
+        {
+            RecordCommand(GC_SETSCISSORTEST, 0, 1, (intRect.left_ << 16) | intRect.top_, (intRect.Width() << 16) | intRect.Height());
+            ++counters_.numStateChanges_;
+            scissorRect_ = intRect;
+        }
+    }
+    else
+        scissorRect_ = IntRect::ZERO;
+    
+    if (enable != scissorTest_)
+    {
+        if (!enable)
+            RecordCommand(GC_SETSCISSORTEST, 0, 0);
+        ++counters_.numStateChanges_;
+        scissorTest_ = enable;
+    }
+}
+
+void Graphics::SetStencilTest(bool enable, CompareMode mode, StencilOp pass, StencilOp fail, StencilOp zFail, unsigned stencilRef, unsigned compareMask, unsigned writeMask)
+{
+    if (enable != stencilTest_ || (enable && (mode != stencilTestMode_ || pass != stencilPass_ || fail != stencilFail_ ||
+        zFail != stencilZFail_ || stencilRef != stencilRef_ || compareMask != stencilCompareMask_ || writeMask != stencilWriteMask_)))
+    {
+        RecordCommand(GC_SETSTENCILTEST, 0, enable ? 1 : 0, mode, stencilRef);
+        ++counters_.numStateChanges_;
+        stencilTest_ = enable;
+        
+        if (enable)
+        {
+            stencilTestMode_ = mode;
+            stencilPass_ = pass;
+            stencilFail_ = fail;
+            stencilZFail_ = zFail;
+            stencilRef_ = stencilRef;
+            stencilCompareMask_ = compareMask;
+            stencilWriteMask_ = writeMask;
+        }
+    }
+}
+
+void Graphics::SetClipPlane(bool enable, const Plane& clipPlane, const Matrix3x4& view, const Matrix4& projection)
+{
+    if (enable != useClipPlane_ || enable)
+    {
+        RecordCommand(GC_SETCLIPPLANE, 0, enable ? 1 : 0);
+        ++counters_.numStateChanges_;
+        useClipPlane_ = enable;
+    }
+}
+
+void Graphics::SetStreamFrequency(unsigned index, unsigned frequency)
+{
+    if (index < MAX_VERTEX_STREAMS && streamFrequencies_[index] != frequency)
+    {
+        RecordCommand(GC_SETSTREAMFREQUENCY, vertexBuffers_[index], index, 0, frequency);
+        streamFrequencies_[index] = frequency;
+    }
+}
+
+void Graphics::ResetStreamFrequencies()
+{
+    for (unsigned i = 0; i < MAX_VERTEX_STREAMS; ++i)
+    {
+        if (streamFrequencies_[i] != 1)
+        {
+            RecordCommand(GC_SETSTREAMFREQUENCY, vertexBuffers_[i], i, 0, 1);
+            streamFrequencies_[i] = 1;
+        }
+    }
+}
+
+void Graphics::SetForceSM2(bool enable)
+{
+    if (!IsInitialized())
+        forceSM2_ = enable;
+    else
+        LOGERROR("Force Shader Model 2 can not be changed after setting the initial screen mode");
+}
+
+void Graphics::BeginDumpShaders(const String& fileName)
+{
+    shaderPrecache_ = new ShaderPrecache(context_, fileName);
+}
+
+void Graphics::EndDumpShaders()
+{
+    shaderPrecache_.Reset();
+}
+
+void Graphics::PrecacheShaders(Deserializer& source)
+{
+    PROFILE(PrecacheShaders);
+    
+    ShaderPrecache::LoadShaders(this, source);
+}
+
+void Graphics::SetRecordCommands(bool enable)
+{
+    recordCommands_ = enable;
+    if (!enable)
+        commands_.Clear();
+}
+
+void Graphics::RecordCommand(GraphicsCommandType type, const void* object, unsigned index, unsigned start, unsigned count, unsigned instances)
+{
+    if (recordCommands_)
+        commands_.Push(GraphicsCommand(type, object, index, start, count, instances));
+}
+
+void Graphics::RecordBufferUpdate(const void* buffer, unsigned offset, unsigned size)
+{
+    RecordCommand(GC_UPDATEBUFFER, buffer, 0, offset, size);
+    ++counters_.numBufferUpdates_;
+    counters_.bufferUpdateBytes_ += size;
+}
+
+void Graphics::RecordTextureUpdate(const void* texture, unsigned level, unsigned size)
+{
+    RecordCommand(GC_UPDATETEXTURE, texture, level, 0, size);
+    ++counters_.numTextureUpdates_;
+    counters_.textureUpdateBytes_ += size;
+}
+
+bool Graphics::IsInitialized() const
+{
+    return impl_->deviceCreated_;
+}
+
+IntVector2 Graphics::GetWindowPosition() const
+{
+    return IntVector2::ZERO;
+}
+
+PODVector<IntVector2> Graphics::GetResolutions() const
+{
+    PODVector<IntVector2> ret;
+    ret.Push(GetDesktopResolution());
+    return ret;
+}
+
+PODVector<int> Graphics::GetMultiSampleLevels() const
+{
+    PODVector<int> ret;
+    for (int i = 1; i <= 16; i *= 2)
+        ret.Push(i);
+    return ret;
+}
+
+IntVector2 Graphics::GetDesktopResolution() const
+{
+    return IntVector2(1024, 768);
+}
+
+unsigned Graphics::GetFormat(CompressedFormat format) const
+{
+    switch (format)
+    {
+    case CF_DXT1:
+        return NULLFMT_DXT1;
+        
+    case CF_DXT3:
+        return NULLFMT_DXT3;
+        
+    case CF_DXT5:
+        return NULLFMT_DXT5;
+        
+    default:
+        return 0;
+    }
+}
+
+ShaderVariation* Graphics::GetShader(ShaderType type, const String& name, const String& defines) const
+{
+    return GetShader(type, name.CString(), defines.CString());
+}
+
+ShaderVariation* Graphics::GetShader(ShaderType type, const char* name, const char* defines) const
+{
+    if (lastShaderName_ != name || !lastShader_)
+    {
+        ResourceCache* cache = GetSubsystem<ResourceCache>();
+        
+        String fullShaderName = shaderPath_ + name + shaderExtension_;
+        // Try to reduce repeated error log prints because of missing shaders
+        if (lastShaderName_ == name && !cache->Exists(fullShaderName))
+            return 0;
+        
+        lastShader_ = cache->GetResource<Shader>(fullShaderName);
+        lastShaderName_ = name;
+    }
+    
+    return lastShader_ ? lastShader_->GetVariation(type, defines) : (ShaderVariation*)0;
+}
+
+VertexBuffer* Graphics::GetVertexBuffer(unsigned index) const
+{
+    return index < MAX_VERTEX_STREAMS ? vertexBuffers_[index] : 0;
+}
+
+TextureUnit Graphics::GetTextureUnit(const String& name)
+{
+    HashMap<String, TextureUnit>::Iterator i = textureUnits_.Find(name);
+    if (i != textureUnits_.End())
+        return i->second_;
+    else
+        return MAX_TEXTURE_UNITS;
+}
+
+const String& Graphics::GetTextureUnitName(TextureUnit unit)
+{
+    for (HashMap<String, TextureUnit>::Iterator i = textureUnits_.Begin(); i != textureUnits_.End(); ++i)
+    {
+        if (i->second_ == unit)
+            return i->first_;
+    }
+    return String::EMPTY;
+}
+
+Texture* Graphics::GetTexture(unsigned index) const
+{
+    return index < MAX_TEXTURE_UNITS ? textures_[index] : 0;
+}
+
+RenderSurface* Graphics::GetRenderTarget(unsigned index) const
+{
+    return index < MAX_RENDERTARGETS ? renderTargets_[index] : 0;
+}
+
+unsigned Graphics::GetStreamFrequency(unsigned index) const
+{
+    return index < MAX_VERTEX_STREAMS ? streamFrequencies_[index] : 0;
+}
+
+IntVector2 Graphics::GetRenderTargetDimensions() const
+{
+    int width, height;
+    
+    if (renderTargets_[0])
+    {
+        width = renderTargets_[0]->GetWidth();
+        height = renderTargets_[0]->GetHeight();
+    }
+    else
+    {
+        width = width_;
+        height = height_;
+    }
+    
+    return IntVector2(width, height);
+}
+
+void Graphics::WindowResized()
+{
+}
+
+void Graphics::Maximize()
+{
+}
+
+void Graphics::Minimize()
+{
+}
+
+void Graphics::AddGPUObject(GPUObject* object)
+{
+    gpuObjects_.Push(object);
+}
+
+void Graphics::RemoveGPUObject(GPUObject* object)
+{
+    gpuObjects_.Remove(object);
+}
+
+void* Graphics::ReserveScratchBuffer(unsigned size)
+{
+    if (!size)
+        return 0;
+    
+    if (size > maxScratchBufferRequest_)
+        maxScratchBufferRequest_ = size;
+    
+    // First check for a free buffer that is large enough
+    for (Vector<ScratchBuffer>::Iterator i = scratchBuffers_.Begin(); i != scratchBuffers_.End(); ++i)
+    {
+        if (!i->reserved_ && i->size_ >= size)
+        {
+            i->reserved_ = true;
+            return i->data_.Get();
+        }
+    }
+    
+    // Then check if a free buffer can be resized
+    for (Vector<ScratchBuffer>::Iterator i = scratchBuffers_.Begin(); i != scratchBuffers_.End(); ++i)
+    {
+        if (!i->reserved_)
+        {
+            i->data_ = new unsigned char[size];
+            i->size_ = size;
+            i->reserved_ = true;
+            
+            LOGDEBUG("Resized scratch buffer to size " + String(size));
+            
+            return i->data_.Get();
+        }
+    }
+    
+    // Finally allocate a new buffer
+    ScratchBuffer newBuffer;
+    newBuffer.data_ = new unsigned char[size];
+    newBuffer.size_ = size;
+    newBuffer.reserved_ = true;
+    scratchBuffers_.Push(newBuffer);
+    
+    LOGDEBUG("Allocated scratch buffer with size " + String(size));
+    
+    return newBuffer.data_.Get();
+}
+
+void Graphics::FreeScratchBuffer(void* buffer)
+{
+    if (!buffer)
+        return;
+    
+    for (Vector<ScratchBuffer>::Iterator i = scratchBuffers_.Begin(); i != scratchBuffers_.End(); ++i)
+    {
+        if (i->reserved_ && i->data_.Get() == buffer)
+        {
+            i->reserved_ = false;
+            return;
+        }
+    }
+    
+    LOGWARNING("Reserved scratch buffer " + ToStringHex((unsigned)(size_t)buffer) + " not found");
+}
+
+void Graphics::CleanupScratchBuffers()
+{
+    for (Vector<ScratchBuffer>::Iterator i = scratchBuffers_.Begin(); i != scratchBuffers_.End(); ++i)
+    {
+        if (!i->reserved_ && i->size_ > maxScratchBufferRequest_ * 2)
+        {
+            i->data_ = maxScratchBufferRequest_ > 0 ? new unsigned char[maxScratchBufferRequest_] : 0;
+            i->size_ = maxScratchBufferRequest_;
+            
+            LOGDEBUG("Resized scratch buffer to size " + String(maxScratchBufferRequest_));
+        }
+    }
+    
+    maxScratchBufferRequest_ = 0;
+}
+
+unsigned Graphics::GetAlphaFormat()
+{
+    return NULLFMT_A8;
+}
+
+unsigned Graphics::GetLuminanceFormat()
+{
+    return NULLFMT_L8;
+}
+
+unsigned Graphics::GetLuminanceAlphaFormat()
+{
+    return NULLFMT_L8A8;
+}
+
+unsigned Graphics::GetRGBFormat()
+{
+    return NULLFMT_RGB8;
+}
+
+unsigned Graphics::GetRGBAFormat()
+{
+    return NULLFMT_RGBA8;
+}
+
+unsigned Graphics::GetRGBA16Format()
+{
+    return NULLFMT_RGBA16;
+}
+
+unsigned Graphics::GetRGBAFloat16Format()
+{
+    return NULLFMT_RGBA16F;
+}
+
+unsigned Graphics::GetRGBAFloat32Format()
+{
+    return NULLFMT_RGBA32F;
+}
+
+unsigned Graphics::GetRG16Format()
+{
+    return NULLFMT_RG16;
+}
+
+unsigned Graphics::GetRGFloat16Format()
+{
+    return NULLFMT_RG16F;
+}
+
+unsigned Graphics::GetRGFloat32Format()
+{
+    return NULLFMT_RG32F;
+}
+
+unsigned Graphics::GetFloat16Format()
+{
+    return NULLFMT_R16F;
+}
+
+unsigned Graphics::GetFloat32Format()
+{
+    return NULLFMT_R32F;
+}
+
+unsigned Graphics::GetLinearDepthFormat()
+{
+    return NULLFMT_R32F;
+}
+
+unsigned Graphics::GetDepthStencilFormat()
+{
+    return NULLFMT_D24S8;
+}
+
+unsigned Graphics::GetFormat(const String& formatName)
+{
+    String nameLower = formatName.ToLower().Trimmed();
+    
+    if (nameLower == "a")
+        return GetAlphaFormat();
+    if (nameLower == "l")
+        return GetLuminanceFormat();
+    if (nameLower == "la")
+        return GetLuminanceAlphaFormat();
+    if (nameLower == "rgb")
+        return GetRGBFormat();
+    if (nameLower == "rgba")
+        return GetRGBAFormat();
+    if (nameLower == "rgba16")
+        return GetRGBA16Format();
+    if (nameLower == "rgba16f")
+        return GetRGBAFloat16Format();
+    if (nameLower == "rgba32f")
+        return GetRGBAFloat32Format();
+    if (nameLower == "rg16")
+        return GetRG16Format();
+    if (nameLower == "rg16f")
+        return GetRGFloat16Format();
+    if (nameLower == "rg32f")
+        return GetRGFloat32Format();
+    if (nameLower == "r16f")
+        return GetFloat16Format();
+    if (nameLower == "r32f" || nameLower == "float")
+        return GetFloat32Format();
+    if (nameLower == "lineardepth" || nameLower == "depth")
+        return GetLinearDepthFormat();
+    if (nameLower == "d24s8")
+        return GetDepthStencilFormat();
+    
+    return GetRGBFormat();
+}
+
+void Graphics::CheckFeatureSupport()
+{
+    // The null device supports every feature, so that all renderer code paths are exercised
+    lightPrepassSupport_ = true;
+    deferredSupport_ = true;
+    hardwareShadowSupport_ = true;
+    streamOffsetSupport_ = true;
+    sRGBSupport_ = true;
+    sRGBWriteSupport_ = true;
+    hasSM3_ = !forceSM2_;
+    
+    shadowMapFormat_ = NULLFMT_D16;
+    hiresShadowMapFormat_ = NULLFMT_D24S8;
+    dummyColorFormat_ = NULLFMT_RGBA8;
+    
+    SendEvent(E_GRAPHICSFEATURES);
+}
+
+void Graphics::ResetCachedState()
+{
+    for (unsigned i = 0; i < MAX_VERTEX_STREAMS; ++i)
+    {
+        vertexBuffers_[i] = 0;
+        streamOffsets_[i] = 0;
+        streamFrequencies_[i] = 1;
+    }
+    
+    for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
+    {
+        textures_[i] = 0;
+        impl_->filterModes_[i] = FILTER_NEAREST;
+        impl_->uAddressModes_[i] = ADDRESS_WRAP;
+        impl_->vAddressModes_[i] = ADDRESS_WRAP;
+        impl_->wAddressModes_[i] = ADDRESS_WRAP;
+    }
+    
+    for (unsigned i = 0; i < MAX_RENDERTARGETS; ++i)
+        renderTargets_[i] = 0;
+    
+    for (unsigned i = 0; i < MAX_SHADER_PARAMETER_GROUPS; ++i)
+        shaderParameterSources_[i] = (const void*)M_MAX_UNSIGNED;
+    
+    depthStencil_ = 0;
+    viewport_ = IntRect(0, 0, width_, height_);
+    indexBuffer_ = 0;
+    vertexShader_ = 0;
+    pixelShader_ = 0;
+    blendMode_ = BLEND_REPLACE;
+    textureAnisotropy_ = 1;
+    colorWrite_ = true;
+    cullMode_ = CULL_CCW;
+    constantDepthBias_ = 0.0f;
+    slopeScaledDepthBias_ = 0.0f;
+    depthTestMode_ = CMP_LESSEQUAL;
+    depthWrite_ = true;
+    fillMode_ = FILL_SOLID;
+    scissorTest_ = false;
+    scissorRect_ = IntRect::ZERO;
+    stencilTest_ = false;
+    stencilTestMode_ = CMP_ALWAYS;
+    stencilPass_ = OP_KEEP;
+    stencilFail_ = OP_KEEP;
+    stencilZFail_ = OP_KEEP;
+    stencilRef_ = 0;
+    stencilCompareMask_ = M_MAX_UNSIGNED;
+    stencilWriteMask_ = M_MAX_UNSIGNED;
+    useClipPlane_ = false;
+}
+
+void Graphics::SetTextureUnitMappings()
+{
+    textureUnits_["DiffMap"] = TU_DIFFUSE;
+    textureUnits_["DiffCubeMap"] = TU_DIFFUSE;
+    textureUnits_["NormalMap"] = TU_NORMAL;
+    textureUnits_["SpecMap"] = TU_SPECULAR;
+    textureUnits_["EmissiveMap"] = TU_EMISSIVE;
+    textureUnits_["EnvMap"] = TU_ENVIRONMENT;
+    textureUnits_["EnvCubeMap"] = TU_ENVIRONMENT;
+    textureUnits_["LightRampMap"] = TU_LIGHTRAMP;
+    textureUnits_["LightSpotMap"] = TU_LIGHTSHAPE;
+    textureUnits_["LightCubeMap"]  = TU_LIGHTSHAPE;
+    textureUnits_["ShadowMap"] = TU_SHADOWMAP;
+    textureUnits_["FaceSelectCubeMap"] = TU_FACESELECT;
+    textureUnits_["IndirectionCubeMap"] = TU_INDIRECTION;
+    textureUnits_["VolumeMap"] = TU_VOLUMEMAP;
+}
+
+void RegisterGraphicsLibrary(Context* context)
+{
+    Animation::RegisterObject(context);
+    Material::RegisterObject(context);
+    Model::RegisterObject(context);
+    Shader::RegisterObject(context);
+    Technique::RegisterObject(context);
+    Texture2D::RegisterObject(context);
+    Texture3D::RegisterObject(context);
+    TextureCube::RegisterObject(context);
+    Camera::RegisterObject(context);
+    Drawable::RegisterObject(context);
+    Light::RegisterObject(context);
+    StaticModel::RegisterObject(context);
+    StaticModelGroup::RegisterObject(context);
+    Skybox::RegisterObject(context);
+    AnimatedModel::RegisterObject(context);
+    AnimationController::RegisterObject(context);
+    BillboardSet::RegisterObject(context);
+    ParticleEmitter::RegisterObject(context);
+    CustomGeometry::RegisterObject(context);
+    DecalSet::RegisterObject(context);
+    Terrain::RegisterObject(context);
+    TerrainPatch::RegisterObject(context);
+    DebugRenderer::RegisterObject(context);
+    Octree::RegisterObject(context);
+    Zone::RegisterObject(context);
+}
+
+}
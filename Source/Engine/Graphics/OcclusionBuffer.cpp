@@ -22,11 +22,18 @@
 
 #include "Precompiled.h"
 #include "Camera.h"
+#include "Drawable.h"
 #include "Log.h"
 #include "OcclusionBuffer.h"
+#include "Profiler.h"
+#include "WorkQueue.h"
 
 #include <cstring>
 
+#ifdef URHO3D_SSE
+#include <xmmintrin.h>
+#endif
+
 #include "DebugNew.h"
 
 namespace Urho3D
@@ -39,6 +46,45 @@ static const unsigned CLIPMASK_Y_NEG = 0x8;
 static const unsigned CLIPMASK_Z_POS = 0x10;
 static const unsigned CLIPMASK_Z_NEG = 0x20;
 
+static inline int FloorToInt(float value)
+{
+    int result = (int)value;
+    return (float)result > value ? result - 1 : result;
+}
+
+static inline int CeilToInt(float value)
+{
+    int result = (int)value;
+    return (float)result < value ? result + 1 : result;
+}
+
+#ifdef URHO3D_SSE
+static inline float HorizontalMin(__m128 value)
+{
+    value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(value);
+}
+
+static inline float HorizontalMax(__m128 value)
+{
+    value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(value);
+}
+#endif
+
+void RasterizeOcclusionTilesWork(const WorkItem* item, unsigned threadIndex)
+{
+    OcclusionBuffer* buffer = reinterpret_cast<OcclusionBuffer*>(item->aux_);
+    OcclusionTile* start = reinterpret_cast<OcclusionTile*>(item->start_);
+    OcclusionTile* end = reinterpret_cast<OcclusionTile*>(item->end_);
+    PROFILE_OBJECT(buffer, RasterizeOcclusionTiles);
+    
+    while (start != end)
+        buffer->RasterizeTile(*start++);
+}
+
 OcclusionBuffer::OcclusionBuffer(Context* context) :
     Object(context),
     buffer_(0),
@@ -50,7 +96,9 @@ OcclusionBuffer::OcclusionBuffer(Context* context) :
     depthHierarchyDirty_(true),
     reverseCulling_(false),
     nearClip_(0.0f),
-    farClip_(0.0f)
+    farClip_(0.0f),
+    numReprojections_(0),
+    contentValid_(false)
 {
 }
 
@@ -63,6 +111,9 @@ bool OcclusionBuffer::SetSize(int width, int height)
     // Force the height to an even amount of pixels for better mip generation
     if (height & 1)
         ++height;
+    // The tiles are rasterized four pixels at a time, so enforce a minimum width
+    if (width > 0 && width < OCCLUSION_MIN_SIZE)
+        width = OCCLUSION_MIN_SIZE;
     
     if (width == width_ && height == height_)
         return true;
@@ -79,10 +130,24 @@ bool OcclusionBuffer::SetSize(int width, int height)
     width_ = width;
     height_ = height;
     
-    // Reserve extra memory in case 3D clipping is not exact
-    fullBuffer_ = new int[width * (height + 2) + 2];
-    buffer_ = fullBuffer_.Get() + width + 1;
+    fullBuffer_ = new float[width * height];
+    buffer_ = fullBuffer_.Get();
+    previousBuffer_.Reset();
     mipBuffers_.Clear();
+    triangles_.Clear();
+    drawnOccluders_.Clear();
+    contentValid_ = false;
+    
+    // Divide the buffer into tiles of full rows
+    tiles_.Resize((height_ + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT);
+    for (unsigned i = 0; i < tiles_.Size(); ++i)
+    {
+        OcclusionTile& tile = tiles_[i];
+        tile.top_ = i * OCCLUSION_TILE_HEIGHT;
+        tile.bottom_ = Min(tile.top_ + OCCLUSION_TILE_HEIGHT, height_);
+        tile.start_ = 0;
+        tile.count_ = 0;
+    }
     
     // Build buffers for mip levels
     for (;;)
@@ -108,6 +173,7 @@ void OcclusionBuffer::SetView(Camera* camera)
     if (!camera)
         return;
     
+    camera_ = camera;
     view_ = camera->GetView();
     projection_ = camera->GetProjection(false);
     viewProj_ = projection_ * view_;
@@ -144,15 +210,10 @@ void OcclusionBuffer::Clear()
     if (!buffer_)
         return;
     
-    Reset();
-    
-    int* dest = buffer_;
-    int count = width_ * height_;
-    
-    while (count--)
-        *dest++ = 0x7fffffff;
-    
-    depthHierarchyDirty_ = true;
+    ClearDepth();
+    drawnOccluders_.Clear();
+    numReprojections_ = 0;
+    contentValid_ = false;
 }
 
 bool OcclusionBuffer::Draw(const Matrix3x4& model, const void* vertexData, unsigned vertexSize, unsigned vertexStart, unsigned vertexCount)
@@ -252,6 +313,10 @@ void OcclusionBuffer::BuildDepthHierarchy()
     if (!buffer_)
         return;
     
+    RasterizeTriangles();
+    
+    PROFILE(BuildDepthHierarchy);
+    
     // Build the first mip level from the pixel-level data
     int width = (width_ + 1) / 2;
     int height = (height_ + 1) / 2;
@@ -259,20 +324,44 @@ void OcclusionBuffer::BuildDepthHierarchy()
     {
         for (int y = 0; y < height; ++y)
         {
-            int* src = buffer_ + (y * 2) * width_;
+            float* src = buffer_ + (y * 2) * width_;
             DepthValue* dest = mipBuffers_[0].Get() + y * width;
             DepthValue* end = dest + width;
             
             if (y * 2 + 1 < height_)
             {
-                int* src2 = src + width_;
+                float* src2 = src + width_;
+                #ifdef URHO3D_SSE
+                // Reduce 2 rows of 8 pixels into 4 depth ranges at a time
+                while (dest + 4 <= end)
+                {
+                    __m128 upper0 = _mm_loadu_ps(src);
+                    __m128 upper1 = _mm_loadu_ps(src + 4);
+                    __m128 lower0 = _mm_loadu_ps(src2);
+                    __m128 lower1 = _mm_loadu_ps(src2 + 4);
+                    __m128 min0 = _mm_min_ps(upper0, lower0);
+                    __m128 min1 = _mm_min_ps(upper1, lower1);
+                    __m128 max0 = _mm_max_ps(upper0, lower0);
+                    __m128 max1 = _mm_max_ps(upper1, lower1);
+                    __m128 mins = _mm_min_ps(_mm_shuffle_ps(min0, min1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(min0, min1,
+                        _MM_SHUFFLE(3, 1, 3, 1)));
+                    __m128 maxs = _mm_max_ps(_mm_shuffle_ps(max0, max1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(max0, max1,
+                        _MM_SHUFFLE(3, 1, 3, 1)));
+                    _mm_storeu_ps(&dest[0].min_, _mm_unpacklo_ps(mins, maxs));
+                    _mm_storeu_ps(&dest[2].min_, _mm_unpackhi_ps(mins, maxs));
+                    
+                    src += 8;
+                    src2 += 8;
+                    dest += 4;
+                }
+                #endif
                 while (dest < end)
                 {
-                    int minUpper = Min(src[0], src[1]);
-                    int minLower = Min(src2[0], src2[1]);
+                    float minUpper = Min(src[0], src[1]);
+                    float minLower = Min(src2[0], src2[1]);
                     dest->min_ = Min(minUpper, minLower);
-                    int maxUpper = Max(src[0], src[1]);
-                    int maxLower = Max(src2[0], src2[1]);
+                    float maxUpper = Max(src[0], src[1]);
+                    float maxLower = Max(src2[0], src2[1]);
                     dest->max_ = Max(maxUpper, maxLower);
                     
                     src += 2;
@@ -313,11 +402,11 @@ void OcclusionBuffer::BuildDepthHierarchy()
                 DepthValue* src2 = src + prevWidth;
                 while (dest < end)
                 {
-                    int minUpper = Min(src[0].min_, src[1].min_);
-                    int minLower = Min(src2[0].min_, src2[1].min_);
+                    float minUpper = Min(src[0].min_, src[1].min_);
+                    float minLower = Min(src2[0].min_, src2[1].min_);
                     dest->min_ = Min(minUpper, minLower);
-                    int maxUpper = Max(src[0].max_, src[1].max_);
-                    int maxLower = Max(src2[0].max_, src2[1].max_);
+                    float maxUpper = Max(src[0].max_, src[1].max_);
+                    float maxLower = Max(src2[0].max_, src2[1].max_);
                     dest->max_ = Max(maxUpper, maxLower);
                     
                     src += 2;
@@ -340,6 +429,167 @@ void OcclusionBuffer::BuildDepthHierarchy()
     }
     
     depthHierarchyDirty_ = false;
+    
+    // Remember the view for reprojecting the contents on the next frame
+    contentCamera_ = camera_;
+    contentView_ = view_;
+    contentViewProj_ = viewProj_;
+    contentValid_ = true;
+}
+
+bool OcclusionBuffer::Reproject(unsigned maxReprojections, float maxDistance, float maxAngle)
+{
+    if (!buffer_ || !contentValid_ || !camera_ || camera_ != contentCamera_ || numReprojections_ >= maxReprojections)
+        return false;
+    
+    // Check that the camera has not jumped
+    Matrix3x4 cameraTransform = view_.Inverse();
+    Matrix3x4 contentCameraTransform = contentView_.Inverse();
+    if ((cameraTransform.Translation() - contentCameraTransform.Translation()).Length() > maxDistance)
+        return false;
+    Vector3 direction = cameraTransform * Vector4(Vector3::FORWARD, 0.0f);
+    Vector3 contentDirection = contentCameraTransform * Vector4(Vector3::FORWARD, 0.0f);
+    if (direction.Angle(contentDirection) > maxAngle)
+        return false;
+    
+    // Check that the occluders in the contents still exist and have not moved
+    for (HashMap<Drawable*, DrawnOccluder>::ConstIterator i = drawnOccluders_.Begin(); i != drawnOccluders_.End(); ++i)
+    {
+        Drawable* occluder = i->second_.drawable_;
+        if (!occluder || !occluder->IsEnabledEffective() || !occluder->GetOctant() || occluder->GetWorldBoundingBox() !=
+            i->second_.worldBoundingBox_)
+            return false;
+    }
+    
+    PROFILE(ReprojectOcclusion);
+    
+    if (!previousBuffer_)
+        previousBuffer_ = new float[width_ * height_];
+    Swap(fullBuffer_, previousBuffer_);
+    buffer_ = fullBuffer_.Get();
+    ClearDepth();
+    
+    // Transform from the previous pixel coordinates and depth to the current clip space. The pixel at (x, y) is sampled
+    // at (x + 1, y + 1)
+    Matrix4 pixelToProjection(
+        1.0f / scaleX_, 0.0f, 0.0f, (1.0f - offsetX_) / scaleX_,
+        0.0f, 1.0f / scaleY_, 0.0f, (1.0f - offsetY_) / scaleY_,
+        0.0f, 0.0f, 1.0f / OCCLUSION_Z_SCALE, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    );
+    Matrix4 reprojection = viewProj_ * contentViewProj_.Inverse() * pixelToProjection;
+    
+    // Move each pixel to the farthest depth of the 2x2 pixel quad starting from it, so that depth discontinuities do not
+    // pull the result closer. Quads touching empty pixels are skipped
+    const Matrix4& m = reprojection;
+    const float* previous = previousBuffer_.Get();
+    #ifdef URHO3D_SSE
+    __m128 offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    __m128 infinity = _mm_set1_ps(M_INFINITY);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 maxX = _mm_set1_ps((float)width_ + 0.5f);
+    __m128 maxY = _mm_set1_ps((float)height_ + 0.5f);
+    #endif
+    
+    for (int y = 0; y < height_ - 1; ++y)
+    {
+        const float* row = previous + y * width_;
+        const float* nextRow = row + width_;
+        float fy = (float)y;
+        Vector4 rowBase(m.m01_ * fy + m.m03_, m.m11_ * fy + m.m13_, m.m21_ * fy + m.m23_, m.m31_ * fy + m.m33_);
+        int x = 0;
+        
+        #ifdef URHO3D_SSE
+        // Transform 4 pixels at a time, then write the results one by one
+        for (; x + 4 < width_; x += 4)
+        {
+            __m128 depth = _mm_max_ps(_mm_max_ps(_mm_loadu_ps(row + x), _mm_loadu_ps(row + x + 1)),
+                _mm_max_ps(_mm_loadu_ps(nextRow + x), _mm_loadu_ps(nextRow + x + 1)));
+            __m128 valid = _mm_cmplt_ps(depth, infinity);
+            if (!_mm_movemask_ps(valid))
+                continue;
+            
+            __m128 fx = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+            __m128 projX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m00_), fx), _mm_mul_ps(_mm_set1_ps(m.m02_), depth)),
+                _mm_set1_ps(rowBase.x_));
+            __m128 projY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m10_), fx), _mm_mul_ps(_mm_set1_ps(m.m12_), depth)),
+                _mm_set1_ps(rowBase.y_));
+            __m128 projZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m20_), fx), _mm_mul_ps(_mm_set1_ps(m.m22_), depth)),
+                _mm_set1_ps(rowBase.z_));
+            __m128 projW = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m30_), fx), _mm_mul_ps(_mm_set1_ps(m.m32_), depth)),
+                _mm_set1_ps(rowBase.w_));
+            __m128 invW = _mm_div_ps(one, projW);
+            __m128 screenX = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(projX, invW), _mm_set1_ps(scaleX_)), _mm_set1_ps(offsetX_));
+            __m128 screenY = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(projY, invW), _mm_set1_ps(scaleY_)), _mm_set1_ps(offsetY_));
+            __m128 screenZ = _mm_mul_ps(_mm_mul_ps(projZ, invW), _mm_set1_ps(OCCLUSION_Z_SCALE));
+            
+            // Discard points behind the near plane or outside the buffer
+            valid = _mm_and_ps(valid, _mm_cmpgt_ps(projZ, _mm_setzero_ps()));
+            valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(screenX, half), _mm_cmplt_ps(screenX, maxX)));
+            valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(screenY, half), _mm_cmplt_ps(screenY, maxY)));
+            int mask = _mm_movemask_ps(valid);
+            if (!mask)
+                continue;
+            
+            float destX[4], destY[4], destZ[4];
+            _mm_storeu_ps(destX, screenX);
+            _mm_storeu_ps(destY, screenY);
+            _mm_storeu_ps(destZ, screenZ);
+            for (unsigned i = 0; i < 4; ++i)
+            {
+                if (mask & (1 << i))
+                {
+                    float& dest = buffer_[((int)(destY[i] + 0.5f) - 1) * width_ + (int)(destX[i] + 0.5f) - 1];
+                    if (destZ[i] < dest)
+                        dest = destZ[i];
+                }
+            }
+        }
+        #endif
+        
+        for (; x < width_ - 1; ++x)
+        {
+            float depth = Max(Max(row[x], row[x + 1]), Max(nextRow[x], nextRow[x + 1]));
+            if (depth == M_INFINITY)
+                continue;
+            
+            float fx = (float)x;
+            Vector4 projected(
+                m.m00_ * fx + m.m02_ * depth + rowBase.x_,
+                m.m10_ * fx + m.m12_ * depth + rowBase.y_,
+                m.m20_ * fx + m.m22_ * depth + rowBase.z_,
+                m.m30_ * fx + m.m32_ * depth + rowBase.w_
+            );
+            if (projected.z_ <= 0.0f)
+                continue;
+            
+            Vector3 screen = ViewportTransform(projected);
+            if (screen.x_ < 0.5f || screen.y_ < 0.5f || screen.x_ >= (float)width_ + 0.5f || screen.y_ >= (float)height_ + 0.5f)
+                continue;
+            
+            float& dest = buffer_[((int)(screen.y_ + 0.5f) - 1) * width_ + (int)(screen.x_ + 0.5f) - 1];
+            if (screen.z_ < dest)
+                dest = screen.z_;
+        }
+    }
+    
+    FillReprojectionHoles();
+    
+    ++numReprojections_;
+    contentValid_ = false;
+    return true;
+}
+
+void OcclusionBuffer::AddDrawnOccluder(Drawable* occluder, bool complete)
+{
+    if (!occluder)
+        return;
+    
+    DrawnOccluder& drawn = drawnOccluders_[occluder];
+    drawn.drawable_ = occluder;
+    drawn.worldBoundingBox_ = occluder->GetWorldBoundingBox();
+    drawn.complete_ = complete;
 }
 
 void OcclusionBuffer::ResetUseTimer()
@@ -347,11 +597,74 @@ void OcclusionBuffer::ResetUseTimer()
     useTimer_.Reset();
 }
 
+bool OcclusionBuffer::IsOccluderDrawn(Drawable* occluder) const
+{
+    HashMap<Drawable*, DrawnOccluder>::ConstIterator i = drawnOccluders_.Find(occluder);
+    return i != drawnOccluders_.End() && i->second_.complete_;
+}
+
 bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
 {
     if (!buffer_)
         return true;
     
+    float minX, maxX, minY, maxY, minZ;
+    
+    #ifdef URHO3D_SSE
+    // Transform corners to projection space 4 at a time, first the corners at minimum Z, then at maximum Z
+    const Vector3& boxMin = worldSpaceBox.min_;
+    const Vector3& boxMax = worldSpaceBox.max_;
+    __m128 cornerX = _mm_setr_ps(boxMin.x_, boxMax.x_, boxMin.x_, boxMax.x_);
+    __m128 cornerY = _mm_setr_ps(boxMin.y_, boxMin.y_, boxMax.y_, boxMax.y_);
+    __m128 zero = _mm_setzero_ps();
+    __m128 minXVec, maxXVec, minYVec, maxYVec, minZVec;
+    const Matrix4& m = viewProj_;
+    
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        __m128 cornerZ = _mm_set1_ps(i ? boxMax.z_ : boxMin.z_);
+        __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m00_), cornerX), _mm_mul_ps(_mm_set1_ps(m.m01_), cornerY)),
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m02_), cornerZ), _mm_set1_ps(m.m03_)));
+        __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m10_), cornerX), _mm_mul_ps(_mm_set1_ps(m.m11_), cornerY)),
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m12_), cornerZ), _mm_set1_ps(m.m13_)));
+        __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m20_), cornerX), _mm_mul_ps(_mm_set1_ps(m.m21_), cornerY)),
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m22_), cornerZ), _mm_set1_ps(m.m23_)));
+        __m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m30_), cornerX), _mm_mul_ps(_mm_set1_ps(m.m31_), cornerY)),
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m32_), cornerZ), _mm_set1_ps(m.m33_)));
+        
+        // Apply a far clip relative bias. If any of the corners cross the near plane, assume visible
+        z = _mm_sub_ps(z, _mm_set1_ps(OCCLUSION_RELATIVE_BIAS));
+        if (_mm_movemask_ps(_mm_cmple_ps(z, zero)))
+            return true;
+        
+        // Transform to screen space
+        __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), w);
+        x = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(x, invW), _mm_set1_ps(scaleX_)), _mm_set1_ps(offsetX_));
+        y = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, invW), _mm_set1_ps(scaleY_)), _mm_set1_ps(offsetY_));
+        z = _mm_mul_ps(_mm_mul_ps(z, invW), _mm_set1_ps(OCCLUSION_Z_SCALE));
+        
+        if (!i)
+        {
+            minXVec = maxXVec = x;
+            minYVec = maxYVec = y;
+            minZVec = z;
+        }
+        else
+        {
+            minXVec = _mm_min_ps(minXVec, x);
+            maxXVec = _mm_max_ps(maxXVec, x);
+            minYVec = _mm_min_ps(minYVec, y);
+            maxYVec = _mm_max_ps(maxYVec, y);
+            minZVec = _mm_min_ps(minZVec, z);
+        }
+    }
+    
+    minX = HorizontalMin(minXVec);
+    maxX = HorizontalMax(maxXVec);
+    minY = HorizontalMin(minYVec);
+    maxY = HorizontalMax(maxYVec);
+    minZ = HorizontalMin(minZVec);
+    #else
     // Transform corners to projection space
     Vector4 vertices[8];
     vertices[0] = ModelTransform(viewProj_, worldSpaceBox.min_);
@@ -368,8 +681,6 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
         vertices[i].z_ -= OCCLUSION_RELATIVE_BIAS;
     
     // Transform to screen space. If any of the corners cross the near plane, assume visible
-    float minX, maxX, minY, maxY, minZ;
-    
     if (vertices[0].z_ <= 0.0f)
         return true;
     
@@ -392,6 +703,7 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
         if (projected.y_ > maxY) maxY = projected.y_;
         if (projected.z_ < minZ) minZ = projected.z_;
     }
+    #endif
     
     // Expand the bounding box 1 pixel in each direction to be conservative and correct rasterization offset
     IntRect rect(
@@ -415,8 +727,11 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
     if (rect.bottom_ >= height_)
         rect.bottom_ = height_ - 1;
     
-    // Convert depth to integer and apply final bias
-    int z = (int)(minZ + 0.5f) - OCCLUSION_FIXED_BIAS;
+    // Apply final bias
+    float z = minZ - (float)OCCLUSION_FIXED_BIAS;
+    #ifdef URHO3D_SSE
+    __m128 zVec = _mm_set1_ps(z);
+    #endif
     
     if (!depthHierarchyDirty_)
     {
@@ -437,6 +752,18 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
             {
                 DepthValue* src = row + left;
                 DepthValue* end = row + right;
+                #ifdef URHO3D_SSE
+                // Test 2 depth ranges at a time. The lanes are minimum, maximum, minimum, maximum
+                while (src < end)
+                {
+                    int mask = _mm_movemask_ps(_mm_cmple_ps(zVec, _mm_loadu_ps(&src->min_)));
+                    if (mask & 0x5)
+                        return true;
+                    if (mask & 0xa)
+                        allOccluded = false;
+                    src += 2;
+                }
+                #endif
                 while (src <= end)
                 {
                     if (z <= src->min_)
@@ -454,12 +781,20 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
     }
     
     // If no conclusive result, finally check the pixel-level data
-    int* row = buffer_ + rect.top_ * width_;
-    int* endRow = buffer_ + rect.bottom_ * width_;
+    float* row = buffer_ + rect.top_ * width_;
+    float* endRow = buffer_ + rect.bottom_ * width_;
     while (row <= endRow)
     {
-        int* src = row + rect.left_;
-        int* end = row + rect.right_;
+        float* src = row + rect.left_;
+        float* end = row + rect.right_;
+        #ifdef URHO3D_SSE
+        while (src + 3 <= end)
+        {
+            if (_mm_movemask_ps(_mm_cmple_ps(zVec, _mm_loadu_ps(src))))
+                return true;
+            src += 4;
+        }
+        #endif
         while (src <= end)
         {
             if (z <= *src)
@@ -577,7 +912,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices)
         
         if (CheckFacing(projected[0], projected[1], projected[2]))
         {
-            DrawTriangle2D(projected);
+            SetupTriangle(projected);
             drawOk = true;
         }
     }
@@ -614,7 +949,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices)
                 
                 if (CheckFacing(projected[0], projected[1], projected[2]))
                 {
-                    DrawTriangle2D(projected);
+                    SetupTriangle(projected);
                     drawOk = true;
                 }
             }
@@ -695,220 +1030,229 @@ void OcclusionBuffer::ClipVertices(const Vector4& plane, Vector4* vertices, bool
     }
 }
 
-// Code based on Chris Hecker's Perspective Texture Mapping series in the Game Developer magazine
-// Also available online at http://chrishecker.com/Miscellaneous_Technical_Articles
-
-/// %Gradients of a software rasterized triangle.
-struct Gradients
+void OcclusionBuffer::ClearDepth()
 {
-    /// Construct from vertices.
-    Gradients(const Vector3* vertices)
-    {
-        float invdX = 1.0f / (((vertices[1].x_ - vertices[2].x_) *
-            (vertices[0].y_ - vertices[2].y_)) -
-            ((vertices[0].x_ - vertices[2].x_) *
-            (vertices[1].y_ - vertices[2].y_)));
-        
-        float invdY = -invdX;
-        
-        dInvZdX_ = invdX * (((vertices[1].z_ - vertices[2].z_) * (vertices[0].y_ - vertices[2].y_)) -
-            ((vertices[0].z_ - vertices[2].z_) * (vertices[1].y_ - vertices[2].y_)));
-        
-        dInvZdY_ = invdY * (((vertices[1].z_ - vertices[2].z_) * (vertices[0].x_ - vertices[2].x_)) -
-            ((vertices[0].z_ - vertices[2].z_) * (vertices[1].x_ - vertices[2].x_)));
-        
-        dInvZdXInt_ = (int)dInvZdX_;
-    }
+    Reset();
+    triangles_.Clear();
+    
+    float* dest = buffer_;
+    int count = width_ * height_;
+    
+    while (count--)
+        *dest++ = M_INFINITY;
     
-    /// Integer horizontal gradient.
-    int dInvZdXInt_;
-    /// Horizontal gradient.
-    float dInvZdX_;
-    /// Vertical gradient.
-    float dInvZdY_;
-};
+    depthHierarchyDirty_ = true;
+}
 
-/// %Edge of a software rasterized triangle.
-struct Edge
+void OcclusionBuffer::FillReprojectionHoles()
 {
-    /// Construct from gradients and top & bottom vertices.
-    Edge(const Gradients& gradients, const Vector3& top, const Vector3& bottom, int topY)
+    // A pixel is filled if both of its horizontal or vertical neighbours are, using the farther depth of the neighbours.
+    // Write to the previous buffer so that filled pixels do not affect their neighbours, then swap back
+    float* dest = previousBuffer_.Get();
+    for (int y = 0; y < height_; ++y)
     {
-        float slope = (bottom.x_ - top.x_) / (bottom.y_ - top.y_);
-        float yPreStep = (float)(topY + 1) - top.y_;
-        float xPreStep = slope * yPreStep;
+        const float* row = buffer_ + y * width_;
+        float* destRow = dest + y * width_;
         
-        x_ = (int)((xPreStep + top.x_) * OCCLUSION_X_SCALE + 0.5f);
-        xStep_ = (int)(slope * OCCLUSION_X_SCALE + 0.5f);
-        invZ_ = (int)(top.z_ + xPreStep * gradients.dInvZdX_ + yPreStep * gradients.dInvZdY_ + 0.5f);
-        invZStep_ = (int)(slope * gradients.dInvZdX_ + gradients.dInvZdY_ + 0.5f);
+        for (int x = 0; x < width_; ++x)
+        {
+            float depth = row[x];
+            if (depth == M_INFINITY)
+            {
+                if (x > 0 && x < width_ - 1)
+                    depth = Max(row[x - 1], row[x + 1]);
+                if (depth == M_INFINITY && y > 0 && y < height_ - 1)
+                    depth = Max(row[x - width_], row[x + width_]);
+            }
+            destRow[x] = depth;
+        }
     }
     
-    /// X coordinate.
-    int x_;
-    /// X coordinate step.
-    int xStep_;
-    /// Inverse Z.
-    int invZ_;
-    /// Inverse Z step.
-    int invZStep_;
-};
+    Swap(fullBuffer_, previousBuffer_);
+    buffer_ = fullBuffer_.Get();
+}
 
-void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices)
+void OcclusionBuffer::SetupTriangle(const Vector3* vertices)
 {
-    int top, middle, bottom;
-    bool middleIsRight;
+    const Vector3& v0 = vertices[0];
+    const Vector3& v1 = vertices[1];
+    const Vector3& v2 = vertices[2];
+    
+    float area = (v1.x_ - v0.x_) * (v2.y_ - v0.y_) - (v2.x_ - v0.x_) * (v1.y_ - v0.y_);
+    if (area == 0.0f)
+        return;
+    
+    // The pixel at (x, y) is sampled at (x + 1, y + 1) due to the half pixel offset in the viewport transform
+    float minX = Min(Min(v0.x_, v1.x_), v2.x_);
+    float maxX = Max(Max(v0.x_, v1.x_), v2.x_);
+    int left = Max(CeilToInt(minX) - 1, 0);
+    int top = Max(CeilToInt(Min(Min(v0.y_, v1.y_), v2.y_)) - 1, 0);
+    int right = Min(FloorToInt(maxX) - 1, width_ - 1);
+    int bottom = Min(FloorToInt(Max(Max(v0.y_, v1.y_), v2.y_)) - 1, height_ - 1);
+    if (right < left || bottom < top)
+        return;
     
-    // Sort vertices in Y-direction
-    if (vertices[0].y_ < vertices[1].y_)
+    triangles_.Resize(triangles_.Size() + 1);
+    OcclusionTriangle& triangle = triangles_.Back();
+    triangle.minX_ = Max(minX, 1.0f);
+    triangle.maxX_ = Min(maxX, (float)width_);
+    triangle.top_ = top;
+    triangle.bottom_ = bottom;
+    
+    // Sort the non-horizontal edges to the left and right sides. Depending on the winding, the inside of the triangle is
+    // to the right of an edge going down and to the left of an edge going up, or vice versa. There is always at least
+    // one edge on both sides; if only one, duplicate it
+    unsigned numLeft = 0;
+    unsigned numRight = 0;
+    for (unsigned i = 0; i < 3; ++i)
     {
-        if (vertices[2].y_ < vertices[0].y_)
+        const Vector3& start = vertices[i];
+        const Vector3& end = vertices[i < 2 ? i + 1 : 0];
+        float dy = end.y_ - start.y_;
+        if (dy == 0.0f)
+            continue;
+        
+        float slope = (end.x_ - start.x_) / dy;
+        float x = start.x_ - slope * start.y_;
+        if ((dy < 0.0f) == (area > 0.0f))
         {
-            top = 2; middle = 0; bottom = 1;
-            middleIsRight = true;
+            triangle.leftSlope_[numLeft] = slope;
+            triangle.leftX_[numLeft++] = x;
         }
         else
         {
-            top = 0;
-            if (vertices[1].y_ < vertices[2].y_)
-            {
-                middle = 1; bottom = 2;
-                middleIsRight = true;
-            }
-            else
-            {
-                middle = 2; bottom = 1;
-                middleIsRight = false;
-            }
+            triangle.rightSlope_[numRight] = slope;
+            triangle.rightX_[numRight++] = x;
         }
     }
-    else
+    if (numLeft < 2)
     {
-        if (vertices[2].y_ < vertices[1].y_)
-        {
-            top = 2; middle = 1; bottom = 0;
-            middleIsRight = false;
-        }
-        else
-        {
-            top = 1;
-            if (vertices[0].y_ < vertices[2].y_)
-            {
-                middle = 0; bottom = 2;
-                middleIsRight = false;
-            }
-            else
-            {
-                middle = 2; bottom = 0;
-                middleIsRight = true;
-            }
-        }
+        triangle.leftSlope_[1] = triangle.leftSlope_[0];
+        triangle.leftX_[1] = triangle.leftX_[0];
+    }
+    if (numRight < 2)
+    {
+        triangle.rightSlope_[1] = triangle.rightSlope_[0];
+        triangle.rightX_[1] = triangle.rightX_[0];
     }
     
-    int topY = (int)vertices[top].y_;
-    int middleY = (int)vertices[middle].y_;
-    int bottomY = (int)vertices[bottom].y_;
-    
-    // Check for degenerate triangle
-    if (topY == bottomY)
+    float invArea = 1.0f / area;
+    triangle.depthX_ = ((v1.z_ - v0.z_) * (v2.y_ - v0.y_) - (v2.z_ - v0.z_) * (v1.y_ - v0.y_)) * invArea;
+    triangle.depthY_ = ((v2.z_ - v0.z_) * (v1.x_ - v0.x_) - (v1.z_ - v0.z_) * (v2.x_ - v0.x_)) * invArea;
+    triangle.depthConstant_ = v0.z_ - triangle.depthX_ * v0.x_ - triangle.depthY_ * v0.y_ + triangle.depthX_ + triangle.depthY_;
+}
+
+void OcclusionBuffer::RasterizeTriangles()
+{
+    if (!buffer_ || triangles_.Empty())
         return;
     
-    Gradients gradients(vertices);
-    Edge topToMiddle(gradients, vertices[top], vertices[middle], topY);
-    Edge topToBottom(gradients, vertices[top], vertices[bottom], topY);
-    Edge middleToBottom(gradients, vertices[middle], vertices[bottom], middleY);
+    PROFILE(RasterizeOcclusion);
     
-    // The triangle is clockwise, so if bottom > middle then middle is right
-    if (middleIsRight)
+    // Bin the triangles to the tiles they overlap. First count the triangles per tile, then fill the bins
+    for (PODVector<OcclusionTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+        i->count_ = 0;
+    for (PODVector<OcclusionTriangle>::ConstIterator i = triangles_.Begin(); i != triangles_.End(); ++i)
     {
-        // Top half
-        int* row = buffer_ + topY * width_;
-        int* endRow = buffer_ + middleY * width_;
-        while (row < endRow)
-        {
-            int invZ = topToBottom.invZ_;
-            int* dest = row + (topToBottom.x_ >> 16);
-            int* end = row + (topToMiddle.x_ >> 16);
-            while (dest < end)
-            {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
-            }
-            
-            topToBottom.x_ += topToBottom.xStep_;
-            topToBottom.invZ_ += topToBottom.invZStep_;
-            topToMiddle.x_ += topToMiddle.xStep_;
-            row += width_;
-        }
-        
-        // Bottom half
-        row = buffer_ + middleY * width_;
-        endRow = buffer_ + bottomY * width_;
-        while (row < endRow)
+        for (int j = i->top_ / OCCLUSION_TILE_HEIGHT; j <= i->bottom_ / OCCLUSION_TILE_HEIGHT; ++j)
+            ++tiles_[j].count_;
+    }
+    
+    unsigned numBinned = 0;
+    for (PODVector<OcclusionTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        i->start_ = numBinned;
+        numBinned += i->count_;
+        i->count_ = 0;
+    }
+    
+    binnedTriangles_.Resize(numBinned);
+    for (unsigned i = 0; i < triangles_.Size(); ++i)
+    {
+        const OcclusionTriangle& triangle = triangles_[i];
+        for (int j = triangle.top_ / OCCLUSION_TILE_HEIGHT; j <= triangle.bottom_ / OCCLUSION_TILE_HEIGHT; ++j)
         {
-            int invZ = topToBottom.invZ_;
-            int* dest = row + (topToBottom.x_ >> 16);
-            int* end = row + (middleToBottom.x_ >> 16);
-            while (dest < end)
-            {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
-            }
-            
-            topToBottom.x_ += topToBottom.xStep_;
-            topToBottom.invZ_ += topToBottom.invZStep_;
-            middleToBottom.x_ += middleToBottom.xStep_;
-            row += width_;
+            OcclusionTile& tile = tiles_[j];
+            binnedTriangles_[tile.start_ + tile.count_++] = i;
         }
     }
+    
+    // The tiles do not overlap, so they can be rasterized in parallel
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue && queue->GetNumThreads())
+    {
+        queue->ParallelFor(tiles_, 0, RasterizeOcclusionTilesWork, this);
+        queue->Complete(M_MAX_UNSIGNED);
+    }
     else
     {
-        // Top half
-        int* row = buffer_ + topY * width_;
-        int* endRow = buffer_ + middleY * width_;
-        while (row < endRow)
+        for (PODVector<OcclusionTile>::ConstIterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+            RasterizeTile(*i);
+    }
+    
+    triangles_.Clear();
+}
+
+void OcclusionBuffer::RasterizeTile(const OcclusionTile& tile)
+{
+    #ifdef URHO3D_SSE
+    __m128 offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    __m128 four = _mm_set1_ps(4.0f);
+    #endif
+    
+    for (unsigned i = tile.start_; i < tile.start_ + tile.count_; ++i)
+    {
+        const OcclusionTriangle& triangle = triangles_[binnedTriangles_[i]];
+        
+        // Clip the triangle to the tile
+        int top = Max(triangle.top_, tile.top_);
+        int bottom = Min(triangle.bottom_, tile.bottom_ - 1);
+        #ifdef URHO3D_SSE
+        __m128 depthX = _mm_set1_ps(triangle.depthX_);
+        __m128 depthStep = _mm_mul_ps(depthX, four);
+        #endif
+        
+        float* row = buffer_ + top * width_;
+        for (int y = top; y <= bottom; ++y, row += width_)
         {
-            int invZ = topToMiddle.invZ_;
-            int* dest = row + (topToMiddle.x_ >> 16);
-            int* end = row + (topToBottom.x_ >> 16);
-            while (dest < end)
+            // Get the covered span of the row from the side edges
+            float sampleY = (float)(y + 1);
+            float spanLeft = Max(Max(triangle.leftSlope_[0] * sampleY + triangle.leftX_[0], triangle.leftSlope_[1] * sampleY +
+                triangle.leftX_[1]), triangle.minX_);
+            float spanRight = Min(Min(triangle.rightSlope_[0] * sampleY + triangle.rightX_[0], triangle.rightSlope_[1] * sampleY +
+                triangle.rightX_[1]), triangle.maxX_);
+            if (spanLeft > spanRight)
+                continue;
+            int startX = CeilToInt(spanLeft) - 1;
+            int endX = FloorToInt(spanRight) - 1;
+            
+            #ifdef URHO3D_SSE
+            // Write 4 pixels at a time starting from a multiple of 4. Mask the pixels outside the span
+            int x = startX & ~3;
+            float depth = triangle.depthX_ * (float)x + triangle.depthY_ * (float)y + triangle.depthConstant_;
+            __m128 depthVec = _mm_add_ps(_mm_set1_ps(depth), _mm_mul_ps(depthX, offsets));
+            __m128 xVec = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+            __m128 startVec = _mm_set1_ps((float)startX);
+            __m128 endVec = _mm_set1_ps((float)endX);
+            for (; x <= endX; x += 4)
             {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
+                __m128 inside = _mm_and_ps(_mm_cmpge_ps(xVec, startVec), _mm_cmple_ps(xVec, endVec));
+                __m128 oldDepth = _mm_loadu_ps(row + x);
+                __m128 newDepth = _mm_min_ps(oldDepth, depthVec);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, newDepth), _mm_andnot_ps(inside, oldDepth)));
+                
+                depthVec = _mm_add_ps(depthVec, depthStep);
+                xVec = _mm_add_ps(xVec, four);
             }
-            
-            topToMiddle.x_ += topToMiddle.xStep_;
-            topToMiddle.invZ_ += topToMiddle.invZStep_;
-            topToBottom.x_ += topToBottom.xStep_;
-            row += width_;
-        }
-        
-        // Bottom half
-        row = buffer_ + middleY * width_;
-        endRow = buffer_ + bottomY * width_;
-        while (row < endRow)
-        {
-            int invZ = middleToBottom.invZ_;
-            int* dest = row + (middleToBottom.x_ >> 16);
-            int* end = row + (topToBottom.x_ >> 16);
-            while (dest < end)
+            #else
+            float depth = triangle.depthX_ * (float)startX + triangle.depthY_ * (float)y + triangle.depthConstant_;
+            for (int x = startX; x <= endX; ++x)
             {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
+                if (depth < row[x])
+                    row[x] = depth;
+                depth += triangle.depthX_;
             }
-            
-            middleToBottom.x_ += middleToBottom.xStep_;
-            middleToBottom.invZ_ += middleToBottom.invZStep_;
-            topToBottom.x_ += topToBottom.xStep_;
-            row += width_;
+            #endif
         }
     }
 }
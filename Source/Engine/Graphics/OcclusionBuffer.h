@@ -23,7 +23,9 @@
 #pragma once
 
 #include "ArrayPtr.h"
+#include "BoundingBox.h"
 #include "Frustum.h"
+#include "HashMap.h"
 #include "Object.h"
 #include "GraphicsDefs.h"
 #include "Timer.h"
@@ -31,42 +33,94 @@
 namespace Urho3D
 {
 
-class BoundingBox;
 class Camera;
+class Drawable;
 class IndexBuffer;
 class IntRect;
 class VertexBuffer;
-struct Edge;
-struct Gradients;
+struct WorkItem;
 
 /// Occlusion hierarchy depth range.
 struct DepthValue
 {
     /// Minimum value.
-    int min_;
+    float min_;
     /// Maximum value.
-    int max_;
+    float max_;
+};
+
+/// Occlusion triangle set up for rasterization. The depth plane is evaluated at integer pixel coordinates.
+struct OcclusionTriangle
+{
+    /// Slopes of the edges bounding the left side, as X per sample row.
+    float leftSlope_[2];
+    /// X of the left side edges at sample row zero.
+    float leftX_[2];
+    /// Slopes of the edges bounding the right side, as X per sample row.
+    float rightSlope_[2];
+    /// X of the right side edges at sample row zero.
+    float rightX_[2];
+    /// Minimum X of the vertices, clipped to the buffer.
+    float minX_;
+    /// Maximum X of the vertices, clipped to the buffer.
+    float maxX_;
+    /// Depth plane X coefficient.
+    float depthX_;
+    /// Depth plane Y coefficient.
+    float depthY_;
+    /// Depth plane constant.
+    float depthConstant_;
+    /// Top pixel row.
+    int top_;
+    /// Bottom pixel row, inclusive.
+    int bottom_;
+};
+
+/// Occlusion buffer screen tile spanning the full width, which is rasterized independently of the other tiles.
+struct OcclusionTile
+{
+    /// Top pixel row.
+    int top_;
+    /// Bottom pixel row, exclusive.
+    int bottom_;
+    /// Start index in the binned triangles.
+    unsigned start_;
+    /// Number of binned triangles.
+    unsigned count_;
+};
+
+/// Occluder drawn to the occlusion buffer, used to check whether the buffer contents can be reprojected.
+struct DrawnOccluder
+{
+    /// Occluder drawable.
+    WeakPtr<Drawable> drawable_;
+    /// World bounding box when drawn.
+    BoundingBox worldBoundingBox_;
+    /// Whether all triangles were drawn.
+    bool complete_;
 };
 
 static const int OCCLUSION_MIN_SIZE = 8;
 static const int OCCLUSION_DEFAULT_MAX_TRIANGLES = 5000;
 static const float OCCLUSION_RELATIVE_BIAS = 0.00001f;
 static const int OCCLUSION_FIXED_BIAS = 16;
-static const float OCCLUSION_X_SCALE = 65536.0f;
 static const float OCCLUSION_Z_SCALE = 16777216.0f;
+static const int OCCLUSION_TILE_HEIGHT = 16;
 
 /// Software renderer for occlusion.
 class URHO3D_API OcclusionBuffer : public Object
 {
     OBJECT(OcclusionBuffer);
     
+    friend void RasterizeOcclusionTilesWork(const WorkItem* item, unsigned threadIndex);
+    
 public:
     /// Construct.
     OcclusionBuffer(Context* context);
     /// Destruct.
     virtual ~OcclusionBuffer();
     
-    /// Set occlusion buffer size.
+    /// Set occlusion buffer size. The width must be a power of two and is at least OCCLUSION_MIN_SIZE.
     bool SetSize(int width, int height);
     /// Set camera view to render from.
     void SetView(Camera* camera);
@@ -78,17 +132,25 @@ public:
     void Reset();
     /// Clear the buffer.
     void Clear();
-    /// Draw a triangle mesh to the buffer using non-indexed geometry.
+    /// Draw a triangle mesh to the buffer using non-indexed geometry. The triangles are rasterized later.
     bool Draw(const Matrix3x4& model, const void* vertexData, unsigned vertexSize, unsigned vertexStart, unsigned vertexCount);
-    /// Draw a triangle mesh to the buffer using indexed geometry.
+    /// Draw a triangle mesh to the buffer using indexed geometry. The triangles are rasterized later.
     bool Draw(const Matrix3x4& model, const void* vertexData, unsigned vertexSize, const void* indexData, unsigned indexSize, unsigned indexStart, unsigned indexCount);
-    /// Build reduced size mip levels.
+    /// Rasterize the triangles drawn since the last rasterization. The tiles are rasterized in worker threads if available.
+    void RasterizeTriangles();
+    /// Rasterize any pending triangles and build reduced size mip levels.
     void BuildDepthHierarchy();
+    /// Reproject the previous contents to the current view instead of clearing. Fails if drawn from another camera, the camera moved or turned too much, the reprojection limit was reached or a drawn occluder has changed. Return true if successful.
+    bool Reproject(unsigned maxReprojections, float maxDistance, float maxAngle);
+    /// Record an occluder as drawn to the current contents.
+    void AddDrawnOccluder(Drawable* occluder, bool complete);
     /// Reset last used timer.
     void ResetUseTimer();
     
     /// Return highest level depth values.
-    int* GetBuffer() const { return buffer_; }
+    float* GetBuffer() const { return buffer_; }
+    /// Return camera the view was set from.
+    Camera* GetCamera() const { return camera_; }
     /// Return view transform matrix.
     const Matrix3x4& GetView() const { return view_; }
     /// Return projection matrix.
@@ -99,10 +161,16 @@ public:
     int GetHeight() const { return height_; }
     /// Return number of rendered triangles.
     unsigned GetNumTriangles() const { return numTriangles_; }
+    /// Return number of triangles waiting for rasterization.
+    unsigned GetNumPendingTriangles() const { return triangles_.Size(); }
     /// Return maximum number of triangles.
     unsigned GetMaxTriangles() const { return maxTriangles_; }
     /// Return culling mode.
     CullMode GetCullMode() const { return cullMode_; }
+    /// Return number of consecutive reprojections of the contents.
+    unsigned GetNumReprojections() const { return numReprojections_; }
+    /// Return whether an occluder has been completely drawn to the current contents.
+    bool IsOccluderDrawn(Drawable* occluder) const;
     /// Test a bounding box for visibility. For best performance, build depth hierarchy first.
     bool IsVisible(const BoundingBox& worldSpaceBox) const;
     /// Return time since last use in milliseconds.
@@ -123,11 +191,17 @@ private:
     void DrawTriangle(Vector4* vertices);
     /// Clip vertices against a plane.
     void ClipVertices(const Vector4& plane, Vector4* vertices, bool* triangles, unsigned& numTriangles);
-    /// Draw a clipped triangle.
-    void DrawTriangle2D(const Vector3* vertices);
+    /// Clear the depth values and pending triangles.
+    void ClearDepth();
+    /// Fill single pixel holes left by reprojection.
+    void FillReprojectionHoles();
+    /// Set up a clipped triangle for rasterization.
+    void SetupTriangle(const Vector3* vertices);
+    /// Rasterize the triangles binned to a tile.
+    void RasterizeTile(const OcclusionTile& tile);
     
     /// Highest level depth buffer.
-    int* buffer_;
+    float* buffer_;
     /// Buffer width.
     int width_;
     /// Buffer height.
@@ -166,10 +240,32 @@ private:
     float projOffsetScaleX_;
     /// Combined Y projection and viewport transform.
     float projOffsetScaleY_;
-    /// Highest level buffer with safety padding.
-    SharedArrayPtr<int> fullBuffer_;
+    /// Highest level buffer data.
+    SharedArrayPtr<float> fullBuffer_;
     /// Reduced size depth buffers.
     Vector<SharedArrayPtr<DepthValue> > mipBuffers_;
+    /// Triangles waiting for rasterization.
+    PODVector<OcclusionTriangle> triangles_;
+    /// Screen tiles.
+    PODVector<OcclusionTile> tiles_;
+    /// Triangle indices binned to the tiles.
+    PODVector<unsigned> binnedTriangles_;
+    /// Previous depth values during reprojection.
+    SharedArrayPtr<float> previousBuffer_;
+    /// Occluders drawn to the current contents.
+    HashMap<Drawable*, DrawnOccluder> drawnOccluders_;
+    /// Camera the view was set from.
+    WeakPtr<Camera> camera_;
+    /// Camera the current contents were drawn from.
+    WeakPtr<Camera> contentCamera_;
+    /// View transform the current contents were drawn with.
+    Matrix3x4 contentView_;
+    /// View-projection transform the current contents were drawn with.
+    Matrix4 contentViewProj_;
+    /// Number of consecutive reprojections of the current contents.
+    unsigned numReprojections_;
+    /// Current contents complete and usable for reprojection flag.
+    bool contentValid_;
 };
 
 }
@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "AnimatedModel.h"
 #include "Context.h"
 #include "DebugRenderer.h"
 #include "Log.h"
@@ -43,6 +44,7 @@ namespace Urho3D
 static const float DEFAULT_OCTREE_SIZE = 1000.0f;
 static const int DEFAULT_OCTREE_LEVELS = 8;
 static const int RAYCASTS_PER_WORK_ITEM = 4;
+static const unsigned ANIMATION_WORK_ITEMS_PER_THREAD = 4;
 
 extern const char* SUBSYSTEM_CATEGORY;
 
@@ -81,6 +83,60 @@ void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex)
     }
 }
 
+void UpdateAnimationsWork(const WorkItem* item, unsigned threadIndex)
+{
+    const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
+    AnimatedModel** start = reinterpret_cast<AnimatedModel**>(item->start_);
+    AnimatedModel** end = reinterpret_cast<AnimatedModel**>(item->end_);
+
+    while (start != end)
+    {
+        (*start)->UpdateAnimationAndSkinning(frame);
+        ++start;
+    }
+}
+
+void ReinsertDrawablesWork(const WorkItem* item, unsigned threadIndex)
+{
+    Octree* octree = reinterpret_cast<Octree*>(item->aux_);
+    OctreeReinsertion* start = reinterpret_cast<OctreeReinsertion*>(item->start_);
+    OctreeReinsertion* end = reinterpret_cast<OctreeReinsertion*>(item->end_);
+
+    while (start != end)
+    {
+        Drawable* drawable = start->drawable_;
+        Octant* octant = drawable ? drawable->octant_ : 0;
+        start->octant_ = 0;
+
+        // Skip if no octant or does not belong to this octree anymore
+        if (octant && octant->GetRoot() == octree)
+        {
+            const BoundingBox& box = drawable->GetWorldBoundingBox();
+
+            // Static drawables are reinserted in the main thread to update the static drawable index
+            if (drawable->static_ || drawable->staticIndexed_)
+                start->octant_ = octree;
+            // Skip if still fits the current octant. Otherwise find the new octant, but do not create child octants yet, as
+            // that would modify the octree
+            else if (!drawable->IsOccludee() || octant->GetCullingBox().IsInside(box) != INSIDE || !octant->CheckDrawableFit(box))
+                start->octant_ = octree->FindInsertOctant(drawable, box, false);
+        }
+
+        ++start;
+    }
+}
+
+inline bool CompareOctantsDeepestFirst(Octant* lhs, Octant* rhs)
+{
+    return lhs->GetLevel() != rhs->GetLevel() ? lhs->GetLevel() > rhs->GetLevel() : lhs < rhs;
+}
+
+/// Return an estimate of the cost of evaluating an animated model's animation.
+static inline unsigned GetAnimationCost(AnimatedModel* model)
+{
+    return Max((int)model->GetSkeleton().GetNumBones(), 1) * Max((int)model->GetNumAnimationStates(), 1);
+}
+
 inline bool CompareRayQueryResults(const RayQueryResult& lhs, const RayQueryResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
@@ -104,13 +160,13 @@ Octant::~Octant()
     if (root_)
     {
         // Remove the drawables (if any) from this octant to the root octant
-        for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
+        for (unsigned i = 0; i < drawables_.Size(); ++i)
         {
-            (*i)->SetOctant(root_);
-            root_->drawables_.Push(*i);
-            root_->QueueUpdate(*i);
+            root_->PushDrawable(drawables_[i], GetDrawableBounds(i));
+            root_->QueueUpdate(drawables_[i]);
         }
         drawables_.Clear();
+        drawableBounds_.Clear();
         numDrawables_ = 0;
     }
 
@@ -153,37 +209,46 @@ void Octant::DeleteChild(unsigned index)
     children_[index] = 0;
 }
 
-void Octant::InsertDrawable(Drawable* drawable)
+void Octant::AddDrawable(Drawable* drawable)
 {
-    const BoundingBox& box = drawable->GetWorldBoundingBox();
-
-    // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
-    // Also if drawable is outside the root octant bounds, insert to root
-    bool insertHere;
-    if (this == root_)
-        insertHere = !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
-    else
-        insertHere = CheckDrawableFit(box);
+    // Get the bounding box first, as updating it stores the bounds to the current octant
+    PushDrawable(drawable, drawable->GetWorldBoundingBox());
+    IncDrawableCount();
+}
 
-    if (insertHere)
+void Octant::RemoveDrawable(Drawable* drawable, bool resetOctant)
+{
+    // Static drawables are stored in the octree's static drawable index instead of the octants
+    if (drawable->staticIndexed_)
     {
-        Octant* oldOctant = drawable->octant_;
-        if (oldOctant != this)
-        {
-            // Add first, then remove, because drawable count going to zero deletes the octree branch in question
-            AddDrawable(drawable);
-            if (oldOctant)
-                oldOctant->RemoveDrawable(drawable, false);
-        }
+        if (root_)
+            root_->staticIndex_.RemoveDrawable(drawable);
+        return;
     }
-    else
+    
+    unsigned index = drawable->octantIndex_;
+    if (index >= drawables_.Size() || drawables_[index] != drawable)
     {
-        Vector3 boxCenter = box.Center();
-        unsigned x = boxCenter.x_ < center_.x_ ? 0 : 1;
-        unsigned y = boxCenter.y_ < center_.y_ ? 0 : 2;
-        unsigned z = boxCenter.z_ < center_.z_ ? 0 : 4;
+        PODVector<Drawable*>::Iterator i = drawables_.Find(drawable);
+        if (i == drawables_.End())
+            return;
+        index = i - drawables_.Begin();
+    }
+
+    RemoveDrawableAt(index, resetOctant);
+}
 
-        GetOrCreateChild(x + y + z)->InsertDrawable(drawable);
+void Octant::InsertDrawable(Drawable* drawable)
+{
+    Octant* octant = FindInsertOctant(drawable, drawable->GetWorldBoundingBox(), true);
+    Octant* oldOctant = drawable->octant_;
+    if (oldOctant != octant)
+    {
+        // Add first, then remove, because drawable count going to zero deletes the octree branch in question
+        unsigned oldIndex = drawable->octantIndex_;
+        octant->AddDrawable(drawable);
+        if (oldOctant)
+            oldOctant->RemoveDrawableAt(oldIndex, false);
     }
 }
 
@@ -248,6 +313,35 @@ void Octant::Initialize(const BoundingBox& box)
     cullingBox_ = BoundingBox(worldBoundingBox_.min_ - halfSize_, worldBoundingBox_.max_ + halfSize_);
 }
 
+Octant* Octant::FindInsertOctant(Drawable* drawable, const BoundingBox& box, bool createChildren)
+{
+    Octant* octant = this;
+
+    for (;;)
+    {
+        // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
+        // Also if drawable is outside the root octant bounds, insert to root
+        bool insertHere;
+        if (octant == root_)
+            insertHere = !drawable->IsOccludee() || octant->cullingBox_.IsInside(box) != INSIDE || octant->CheckDrawableFit(box);
+        else
+            insertHere = octant->CheckDrawableFit(box);
+
+        if (insertHere)
+            return octant;
+
+        Vector3 boxCenter = box.Center();
+        unsigned x = boxCenter.x_ < octant->center_.x_ ? 0 : 1;
+        unsigned y = boxCenter.y_ < octant->center_.y_ ? 0 : 2;
+        unsigned z = boxCenter.z_ < octant->center_.z_ ? 0 : 4;
+
+        unsigned index = x + y + z;
+        if (!octant->children_[index] && !createChildren)
+            return octant;
+        octant = octant->GetOrCreateChild(index);
+    }
+}
+
 void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
 {
     if (this != root_)
@@ -266,7 +360,11 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     {
         Drawable** start = const_cast<Drawable**>(&drawables_[0]);
         Drawable** end = start + drawables_.Size();
-        query.TestDrawables(start, end, inside);
+        // When the octant is fully inside, the drawables' bounding boxes need not be tested
+        if (inside)
+            query.TestDrawables(start, end, true);
+        else
+            query.TestDrawables(start, end, &drawableBounds_[0], false);
     }
 
     for (unsigned i = 0; i < NUM_OCTANTS; ++i)
@@ -330,9 +428,52 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*
     }
 }
 
+void Octant::PushDrawable(Drawable* drawable, const BoundingBox& box)
+{
+    unsigned index = drawables_.Size();
+    drawable->SetOctant(this);
+    drawable->octantIndex_ = index;
+    drawables_.Push(drawable);
+
+    // Start a new group of four bounding boxes if necessary. Zero the unused bounds
+    if (!(index & 3))
+    {
+        drawableBounds_.Resize(drawableBounds_.Size() + 24);
+        for (unsigned i = index * 6; i < drawableBounds_.Size(); ++i)
+            drawableBounds_[i] = 0.0f;
+    }
+    SetDrawableBounds(index, box);
+}
+
+void Octant::RemoveDrawableAt(unsigned index, bool resetOctant)
+{
+    Drawable* drawable = drawables_[index];
+    EraseDrawableAt(index);
+
+    if (resetOctant)
+        drawable->SetOctant(0);
+    DecDrawableCount();
+}
+
+void Octant::EraseDrawableAt(unsigned index)
+{
+    unsigned last = drawables_.Size() - 1;
+    if (index != last)
+    {
+        Drawable* moved = drawables_[last];
+        drawables_[index] = moved;
+        moved->octantIndex_ = index;
+        SetDrawableBounds(index, GetDrawableBounds(last));
+    }
+    drawables_.Pop();
+    if (!(last & 3))
+        drawableBounds_.Resize(last * 6);
+}
+
 Octree::Octree(Context* context) :
     Component(context),
     Octant(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, 0, this),
+    staticIndex_(this),
     numLevels_(DEFAULT_OCTREE_LEVELS)
 {
     // Resize threaded ray query intermediate result vector according to number of worker threads
@@ -345,6 +486,7 @@ Octree::~Octree()
     // Reset root pointer from all child octants now so that they do not move their drawables to root
     drawableUpdates_.Clear();
     drawableReinsertions_.Clear();
+    staticIndex_.Clear();
     ResetRoot();
 }
 
@@ -374,6 +516,7 @@ void Octree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
         PROFILE(OctreeDrawDebug);
 
         Octant::DrawDebugGeometry(debug, depthTest);
+        staticIndex_.DrawDebugGeometry(debug, depthTest);
     }
 }
 
@@ -392,7 +535,13 @@ void Octree::SetSize(const BoundingBox& box, unsigned numLevels)
 
 void Octree::Update(const FrameInfo& frame)
 {
-    // Let drawables update themselves before reinsertion. This can be used for animation
+    PROFILE(UpdateOctree);
+    
+    // Evaluate animations in their own stage, so that the work is divided by its cost rather than by the number of drawables
+    if (!drawableUpdates_.Empty())
+        UpdateAnimations(frame);
+    
+    // Let drawables update themselves before reinsertion
     if (!drawableUpdates_.Empty())
     {
         PROFILE(UpdateDrawables);
@@ -403,29 +552,7 @@ void Octree::Update(const FrameInfo& frame)
         WorkQueue* queue = GetSubsystem<WorkQueue>();
         scene->BeginThreadedUpdate();
         
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = drawableUpdates_.Size() / numWorkItems;
-        
-        PODVector<Drawable*>::Iterator start = drawableUpdates_.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
-
-            PODVector<Drawable*>::Iterator end = drawableUpdates_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
+        queue->ParallelFor(drawableUpdates_, 0, UpdateDrawablesWork, const_cast<FrameInfo*>(&frame));
         queue->Complete(M_MAX_UNSIGNED);
         scene->EndThreadedUpdate();
     }
@@ -448,25 +575,57 @@ void Octree::Update(const FrameInfo& frame)
     {
         PROFILE(ReinsertToOctree);
 
-        for (PODVector<Drawable*>::Iterator i = drawableUpdates_.Begin(); i != drawableUpdates_.End(); ++i)
+        // Find the new octants in worker threads without modifying the octree
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        drawableReinsertions_.Resize(drawableUpdates_.Size());
+        for (unsigned i = 0; i < drawableUpdates_.Size(); ++i)
+            drawableReinsertions_[i].drawable_ = drawableUpdates_[i];
+
+        queue->ParallelFor(drawableReinsertions_, 0, ReinsertDrawablesWork, this);
+        queue->Complete(M_MAX_UNSIGNED);
+
+        // Create the missing child octants and remove the moving drawables from their old octants. Defer the drawable count
+        // changes, so that no octant gets deleted while drawables are still being moved
+        reinsertionOctants_.Clear();
+        for (PODVector<OctreeReinsertion>::Iterator i = drawableReinsertions_.Begin(); i != drawableReinsertions_.End(); ++i)
         {
-            Drawable* drawable = *i;
-            drawable->updateQueued_ = false;
-            Octant* octant = drawable->GetOctant();
-            const BoundingBox& box = drawable->GetWorldBoundingBox();
+            Drawable* drawable = i->drawable_;
+            // If the update was queued more than once, reinsert only once
+            if (!drawable || !drawable->updateQueued_)
+            {
+                i->octant_ = 0;
+                continue;
+            }
 
-            // Skip if no octant or does not belong to this octree anymore
-            if (!octant || octant->GetRoot() != this)
+            drawable->updateQueued_ = false;
+            if (!i->octant_ || drawable->IsStatic() || drawable->staticIndexed_)
                 continue;
-            // Skip if still fits the current octant
-            if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+
+            Octant* oldOctant = drawable->octant_;
+            i->octant_ = i->octant_->FindInsertOctant(drawable, drawable->GetWorldBoundingBox(), true);
+            if (i->octant_ == oldOctant)
+                i->octant_ = 0;
+            else
+            {
+                oldOctant->EraseDrawableAt(drawable->octantIndex_);
+                reinsertionOctants_.Push(oldOctant);
+            }
+        }
+
+        unsigned numRemovals = reinsertionOctants_.Size();
+        for (PODVector<OctreeReinsertion>::Iterator i = drawableReinsertions_.Begin(); i != drawableReinsertions_.End(); ++i)
+        {
+            Drawable* drawable = i->drawable_;
+            Octant* octant = i->octant_;
+            if (!octant || drawable->IsStatic() || drawable->staticIndexed_)
                 continue;
 
-            InsertDrawable(drawable);
+            const BoundingBox& box = drawable->GetWorldBoundingBox();
+            octant->PushDrawable(drawable, box);
+            reinsertionOctants_.Push(octant);
 
             #ifdef _DEBUG
             // Verify that the drawable will be culled correctly
-            octant = drawable->GetOctant();
             if (octant != this && octant->GetCullingBox().IsInside(box) != INSIDE)
             {
                 LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
@@ -474,9 +633,71 @@ void Octree::Update(const FrameInfo& frame)
             }
             #endif
         }
+
+        // Apply the drawable count changes once per octant. Increase the counts first, then decrease them deepest octants first,
+        // so that an octant with pending changes is never deleted along with its emptied parent
+        Sort(reinsertionOctants_.Begin() + numRemovals, reinsertionOctants_.End(), CompareOctantsDeepestFirst);
+        for (unsigned i = numRemovals; i < reinsertionOctants_.Size();)
+        {
+            unsigned j = i + 1;
+            while (j < reinsertionOctants_.Size() && reinsertionOctants_[j] == reinsertionOctants_[i])
+                ++j;
+            reinsertionOctants_[i]->IncDrawableCount(j - i);
+            i = j;
+        }
+
+        Sort(reinsertionOctants_.Begin(), reinsertionOctants_.Begin() + numRemovals, CompareOctantsDeepestFirst);
+        for (unsigned i = 0; i < numRemovals;)
+        {
+            unsigned j = i + 1;
+            while (j < numRemovals && reinsertionOctants_[j] == reinsertionOctants_[i])
+                ++j;
+            reinsertionOctants_[i]->DecDrawableCount(j - i);
+            i = j;
+        }
+
+        // Finally move static drawables into or out of the static drawable index
+        for (PODVector<OctreeReinsertion>::Iterator i = drawableReinsertions_.Begin(); i != drawableReinsertions_.End(); ++i)
+        {
+            Drawable* drawable = i->drawable_;
+            if (i->octant_ && (drawable->IsStatic() || drawable->staticIndexed_))
+                InsertDrawable(drawable);
+        }
+
+        drawableReinsertions_.Clear();
     }
     
     drawableUpdates_.Clear();
+    
+    // Rebuild the static drawable index once enough static drawables have been added, moved or removed
+    if (staticIndex_.IsRebuildNeeded())
+    {
+        PROFILE(RebuildStaticIndex);
+        staticIndex_.Rebuild();
+    }
+}
+
+void Octree::InsertDrawable(Drawable* drawable)
+{
+    if (drawable->IsStatic() && drawable->IsOccludee())
+    {
+        if (!drawable->staticIndexed_)
+        {
+            Octant* oldOctant = drawable->octant_;
+            if (oldOctant)
+                oldOctant->RemoveDrawable(drawable);
+            staticIndex_.AddDrawable(drawable);
+        }
+        else
+            staticIndex_.UpdateDrawable(drawable);
+    }
+    else
+    {
+        // Static non-occludees go to the octants, so that the static drawable index node occlusion does not hide them
+        if (drawable->staticIndexed_)
+            staticIndex_.RemoveDrawable(drawable);
+        Octant::InsertDrawable(drawable);
+    }
 }
 
 void Octree::AddManualDrawable(Drawable* drawable)
@@ -501,6 +722,7 @@ void Octree::GetDrawables(OctreeQuery& query) const
 {
     query.result_.Clear();
     GetDrawablesInternal(query, false);
+    staticIndex_.GetDrawables(query);
 }
 
 void Octree::Raycast(RayOctreeQuery& query) const
@@ -513,13 +735,17 @@ void Octree::Raycast(RayOctreeQuery& query) const
 
     // If no worker threads or no triangle-level testing, do not create work items
     if (!queue->GetNumThreads() || query.level_ < RAY_TRIANGLE)
+    {
         GetDrawablesInternal(query);
+        staticIndex_.GetDrawables(query);
+    }
     else
     {
         // Threaded ray query: first get the drawables
         rayQuery_ = &query;
         rayQueryDrawables_.Clear();
         GetDrawablesOnlyInternal(query, rayQueryDrawables_);
+        staticIndex_.GetDrawablesOnly(query, rayQueryDrawables_);
 
         // Check that amount of drawables is large enough to justify threading
         if (rayQueryDrawables_.Size() >= RAYCASTS_PER_WORK_ITEM * 2)
@@ -527,24 +753,7 @@ void Octree::Raycast(RayOctreeQuery& query) const
             for (unsigned i = 0; i < rayQueryResults_.Size(); ++i)
                 rayQueryResults_[i].Clear();
 
-            PODVector<Drawable*>::Iterator start = rayQueryDrawables_.Begin();
-            while (start != rayQueryDrawables_.End())
-            {
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ = RaycastDrawablesWork;
-                item->aux_ = const_cast<Octree*>(this);
-
-                PODVector<Drawable*>::Iterator end = rayQueryDrawables_.End();
-                if (end - start > RAYCASTS_PER_WORK_ITEM)
-                    end = start + RAYCASTS_PER_WORK_ITEM;
-
-                item->start_ = &(*start);
-                item->end_ = &(*end);
-                queue->AddWorkItem(item);
-
-                start = end;
-            }
+            queue->ParallelFor(rayQueryDrawables_, RAYCASTS_PER_WORK_ITEM, RaycastDrawablesWork, const_cast<Octree*>(this));
 
             // Merge per-thread results
             queue->Complete(M_MAX_UNSIGNED);
@@ -568,6 +777,7 @@ void Octree::RaycastSingle(RayOctreeQuery& query) const
     query.result_.Clear();
     rayQueryDrawables_.Clear();
     GetDrawablesOnlyInternal(query, rayQueryDrawables_);
+    staticIndex_.GetDrawablesOnly(query, rayQueryDrawables_);
 
     // Sort by increasing hit distance to AABB
     for (PODVector<Drawable*>::Iterator i = rayQueryDrawables_.Begin(); i != rayQueryDrawables_.End(); ++i)
@@ -601,6 +811,71 @@ void Octree::RaycastSingle(RayOctreeQuery& query) const
     }
 }
 
+void Octree::UpdateAnimations(const FrameInfo& frame)
+{
+    // Gather the animated models with pending animation. Sort by address to remove duplicates, in case an update was queued
+    // from several threads at once
+    animationUpdates_.Clear();
+    for (PODVector<Drawable*>::ConstIterator i = drawableUpdates_.Begin(); i != drawableUpdates_.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        if (drawable && drawable->GetType() == AnimatedModel::GetTypeStatic())
+        {
+            AnimatedModel* model = static_cast<AnimatedModel*>(drawable);
+            if (model->IsMaster() && model->IsAnimationDirty())
+                animationUpdates_.Push(model);
+        }
+    }
+    
+    if (animationUpdates_.Empty())
+        return;
+    
+    PROFILE(UpdateAnimations);
+    
+    Sort(animationUpdates_.Begin(), animationUpdates_.End());
+    unsigned totalCost = 0;
+    unsigned numModels = 0;
+    for (unsigned i = 0; i < animationUpdates_.Size(); ++i)
+    {
+        if (i && animationUpdates_[i] == animationUpdates_[i - 1])
+            continue;
+        animationUpdates_[numModels++] = animationUpdates_[i];
+        totalCost += GetAnimationCost(animationUpdates_[i]);
+    }
+    animationUpdates_.Resize(numModels);
+    
+    // Split into work items of roughly equal cost, several per thread so that the threads finish close to each other. Node-free
+    // animation does not modify the bone nodes, but notify the scene of the threaded update for models that do
+    Scene* scene = GetScene();
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numWorkItems = (queue->GetNumThreads() + 1) * ANIMATION_WORK_ITEMS_PER_THREAD;
+    unsigned workItemCost = Max((int)((totalCost + numWorkItems - 1) / numWorkItems), 1);
+    scene->BeginThreadedUpdate();
+    
+    unsigned start = 0;
+    unsigned cost = 0;
+    for (unsigned i = 0; i < numModels; ++i)
+    {
+        cost += GetAnimationCost(animationUpdates_[i]);
+        if (cost >= workItemCost || i == numModels - 1)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = UpdateAnimationsWork;
+            item->aux_ = const_cast<FrameInfo*>(&frame);
+            item->start_ = &animationUpdates_[start];
+            item->end_ = &animationUpdates_[i] + 1;
+            queue->AddWorkItem(item);
+            
+            start = i + 1;
+            cost = 0;
+        }
+    }
+    
+    queue->Complete(M_MAX_UNSIGNED);
+    scene->EndThreadedUpdate();
+}
+
 void Octree::QueueUpdate(Drawable* drawable)
 {
     Scene* scene = GetScene();
@@ -26,18 +26,31 @@
 #include "List.h"
 #include "Mutex.h"
 #include "OctreeQuery.h"
+#include "StaticDrawableIndex.h"
 
 namespace Urho3D
 {
 
+class AnimatedModel;
 class Octree;
 
 static const int NUM_OCTANTS = 8;
 static const unsigned ROOT_INDEX = M_MAX_UNSIGNED;
 
+/// %Octree reinsertion of a drawable object. The target octant is found in a worker thread.
+struct OctreeReinsertion
+{
+    /// Drawable object.
+    Drawable* drawable_;
+    /// Octant to insert to, or the deepest existing octant on the way if child octants need to be created. Null if the drawable need not be reinserted.
+    Octant* octant_;
+};
+
 /// %Octree octant
 class URHO3D_API Octant
 {
+    friend class Octree;
+    
 public:
     /// Construct.
     Octant(const BoundingBox& box, unsigned level, Octant* parent, Octree* root, unsigned index = ROOT_INDEX);
@@ -54,22 +67,19 @@ public:
     bool CheckDrawableFit(const BoundingBox& box) const;
     
     /// Add a drawable object to this octant.
-    void AddDrawable(Drawable* drawable)
-    {
-        drawable->SetOctant(this);
-        drawables_.Push(drawable);
-        IncDrawableCount();
-    }
-    
+    void AddDrawable(Drawable* drawable);
     /// Remove a drawable object from this octant.
-    void RemoveDrawable(Drawable* drawable, bool resetOctant = true)
+    void RemoveDrawable(Drawable* drawable, bool resetOctant = true);
+    /// Store a drawable object's world bounding box to the structure-of-arrays bounds. Called internally when the bounding box is updated.
+    void SetDrawableBounds(unsigned index, const BoundingBox& box)
     {
-        if (drawables_.Remove(drawable))
-        {
-            if (resetOctant)
-                drawable->SetOctant(0);
-            DecDrawableCount();
-        }
+        float* bounds = &drawableBounds_[(index >> 2) * 24 + (index & 3)];
+        bounds[0] = box.min_.x_;
+        bounds[4] = box.min_.y_;
+        bounds[8] = box.min_.z_;
+        bounds[12] = box.max_.x_;
+        bounds[16] = box.max_.y_;
+        bounds[20] = box.max_.z_;
     }
     
     /// Return world-space bounding box.
@@ -95,27 +105,41 @@ public:
 protected:
     /// Initialize bounding box.
     void Initialize(const BoundingBox& box);
+    /// Return the octant a drawable object should be inserted to by checking for fit from this octant downward. If child octants are not created, return the deepest existing octant on the way instead.
+    Octant* FindInsertOctant(Drawable* drawable, const BoundingBox& box, bool createChildren);
     /// Return drawable objects by a query, called internally.
     void GetDrawablesInternal(OctreeQuery& query, bool inside) const;
     /// Return drawable objects by a ray query, called internally.
     void GetDrawablesInternal(RayOctreeQuery& query) const;
     /// Return drawable objects only for a threaded ray query, called internally.
     void GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*>& drawables) const;
+    /// Add a drawable object and its bounding box to the end of the drawable list without changing the drawable count.
+    void PushDrawable(Drawable* drawable, const BoundingBox& box);
+    /// Remove a drawable object by index. Move the last drawable object to its place.
+    void RemoveDrawableAt(unsigned index, bool resetOctant);
+    /// Remove a drawable object by index without changing the drawable count. Move the last drawable object to its place.
+    void EraseDrawableAt(unsigned index);
+    /// Return a drawable object's bounding box from the structure-of-arrays bounds.
+    BoundingBox GetDrawableBounds(unsigned index) const
+    {
+        const float* bounds = &drawableBounds_[(index >> 2) * 24 + (index & 3)];
+        return BoundingBox(Vector3(bounds[0], bounds[4], bounds[8]), Vector3(bounds[12], bounds[16], bounds[20]));
+    }
     
     /// Increase drawable object count recursively.
-    void IncDrawableCount()
+    void IncDrawableCount(unsigned count = 1)
     {
-        ++numDrawables_;
+        numDrawables_ += count;
         if (parent_)
-            parent_->IncDrawableCount();
+            parent_->IncDrawableCount(count);
     }
     
     /// Decrease drawable object count recursively and remove octant if it becomes empty.
-    void DecDrawableCount()
+    void DecDrawableCount(unsigned count = 1)
     {
         Octant* parent = parent_;
         
-        --numDrawables_;
+        numDrawables_ -= count;
         if (!numDrawables_)
         {
             if (parent)
@@ -123,7 +147,7 @@ protected:
         }
         
         if (parent)
-            parent->DecDrawableCount();
+            parent->DecDrawableCount(count);
     }
     
     /// World bounding box.
@@ -132,6 +156,8 @@ protected:
     BoundingBox cullingBox_;
     /// Drawable objects.
     PODVector<Drawable*> drawables_;
+    /// Drawable object world bounding boxes in groups of four: minimum x, y and z, then maximum x, y and z coordinates, four floats each. Allows testing four bounding boxes at once without accessing the drawable objects.
+    PODVector<float> drawableBounds_;
     /// Child octants.
     Octant* children_[NUM_OCTANTS];
     /// World bounding box center.
@@ -153,6 +179,8 @@ protected:
 /// %Octree component. Should be added only to the root scene node
 class URHO3D_API Octree : public Component, public Octant
 {
+    friend class Octant;
+    friend void ReinsertDrawablesWork(const WorkItem* item, unsigned threadIndex);
     friend void RaycastDrawablesWork(const WorkItem* item, unsigned threadIndex);
     
     OBJECT(Octree);
@@ -174,6 +202,8 @@ public:
     void SetSize(const BoundingBox& box, unsigned numLevels);
     /// Update and reinsert drawable objects.
     void Update(const FrameInfo& frame);
+    /// Insert a drawable object. Static occludees are stored in the static drawable index, others to the octants by checking for fit recursively.
+    void InsertDrawable(Drawable* drawable);
     /// Add a drawable manually.
     void AddManualDrawable(Drawable* drawable);
     /// Remove a manually added drawable.
@@ -187,6 +217,8 @@ public:
     void RaycastSingle(RayOctreeQuery& query) const;
     /// Return subdivision levels.
     unsigned GetNumLevels() const { return numLevels_; }
+    /// Return number of drawable objects in the static drawable index.
+    unsigned GetNumStaticDrawables() const { return staticIndex_.GetNumDrawables(); }
     
     /// Mark drawable object as requiring an update and a reinsertion.
     void QueueUpdate(Drawable* drawable);
@@ -196,10 +228,19 @@ public:
     void DrawDebugGeometry(bool depthTest);
     
 private:
+    /// Evaluate the pending animations of the drawable objects that require update in worker threads, balanced by bone count.
+    void UpdateAnimations(const FrameInfo& frame);
+    
     /// Drawable objects that require update.
     PODVector<Drawable*> drawableUpdates_;
-    /// Drawable objects that require reinsertion.
-    PODVector<Drawable*> drawableReinsertions_;
+    /// Animated models whose animation is evaluated in the current update.
+    PODVector<AnimatedModel*> animationUpdates_;
+    /// Drawable object reinsertions of the current update.
+    PODVector<OctreeReinsertion> drawableReinsertions_;
+    /// Octants that drawable objects were added to or removed from during the current update, for applying the drawable count changes.
+    PODVector<Octant*> reinsertionOctants_;
+    /// Bounding volume hierarchy of static drawable objects.
+    StaticDrawableIndex staticIndex_;
     /// Mutex for octree reinsertions.
     Mutex octreeMutex_;
     /// Current threaded ray query.
@@ -116,4 +116,34 @@ void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool in
     }
 }
 
+void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, const float* bounds, bool inside)
+{
+    if (inside)
+    {
+        TestDrawables(start, end, true);
+        return;
+    }
+    
+    // Pass each run of consecutive drawables inside the frustum to the drawable test. The drawables outside are not accessed
+    unsigned count = end - start;
+    unsigned runStart = 0;
+    for (unsigned i = 0; i < count; i += 4)
+    {
+        unsigned insideMask = frustum_.IsInsideFastSoA(bounds + i * 6);
+        unsigned groupEnd = Min((int)i + 4, (int)count);
+        for (unsigned j = i; j < groupEnd; ++j)
+        {
+            if (!(insideMask & (1 << (j - i))))
+            {
+                if (runStart < j)
+                    TestDrawables(start + runStart, start + j, true);
+                runStart = j + 1;
+            }
+        }
+    }
+    
+    if (runStart < count)
+        TestDrawables(start + runStart, end, true);
+}
+
 }
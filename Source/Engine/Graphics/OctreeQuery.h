@@ -55,6 +55,8 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside) = 0;
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside) = 0;
+    /// Intersection test for drawables with their world bounding boxes in the octant's structure-of-arrays layout. By default ignores the bounding boxes.
+    virtual void TestDrawables(Drawable** start, Drawable** end, const float* bounds, bool inside) { TestDrawables(start, end, inside); }
     
     /// Result vector reference.
     PODVector<Drawable*>& result_;
@@ -143,6 +145,8 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside);
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside);
+    /// Intersection test for drawables, four bounding boxes at a time. Calls the test without bounding boxes as inside for the drawables that pass, so subclasses only need to override that for additional checks.
+    virtual void TestDrawables(Drawable** start, Drawable** end, const float* bounds, bool inside);
     
     /// Frustum.
     Frustum frustum_;
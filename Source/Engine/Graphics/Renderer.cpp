@@ -275,6 +275,9 @@ Renderer::Renderer(Context* context) :
     maxOccluderTriangles_(5000),
     occlusionBufferSize_(256),
     occluderSizeThreshold_(0.025f),
+    occlusionReprojectionFrames_(0),
+    occlusionReprojectionDistance_(1.0f),
+    occlusionReprojectionAngle_(5.0f),
     numViews_(0), 
     numOcclusionBuffers_(0),
     numShadowCameras_(0),
@@ -484,6 +487,21 @@ void Renderer::SetOccluderSizeThreshold(float screenSize)
     occluderSizeThreshold_ = Max(screenSize, 0.0f);
 }
 
+void Renderer::SetOcclusionReprojectionFrames(int frames)
+{
+    occlusionReprojectionFrames_ = Max(frames, 0);
+}
+
+void Renderer::SetOcclusionReprojectionDistance(float distance)
+{
+    occlusionReprojectionDistance_ = Max(distance, 0.0f);
+}
+
+void Renderer::SetOcclusionReprojectionAngle(float angle)
+{
+    occlusionReprojectionAngle_ = Max(angle, 0.0f);
+}
+
 void Renderer::ReloadShaders()
 {
     shadersDirty_ = true;
@@ -551,6 +569,17 @@ unsigned Renderer::GetNumOccluders(bool allViews) const
     return numOccluders;
 }
 
+unsigned Renderer::GetNumZoneLookups(bool allViews) const
+{
+    unsigned numZoneLookups = 0;
+    unsigned lastView = allViews ? numViews_ : 1;
+    
+    for (unsigned i = 0; i < lastView; ++i)
+        numZoneLookups += views_[i]->GetNumZoneLookups();
+    
+    return numZoneLookups;
+}
+
 void Renderer::Update(float timeStep)
 {
     PROFILE(UpdateViews);
@@ -1012,6 +1041,16 @@ OcclusionBuffer* Renderer::GetOcclusionBuffer(Camera* camera)
         occlusionBuffers_.Push(newBuffer);
     }
     
+    // Prefer the buffer the camera used previously, so that its contents can be reprojected
+    for (unsigned i = numOcclusionBuffers_ + 1; i < occlusionBuffers_.Size(); ++i)
+    {
+        if (occlusionBuffers_[i]->GetCamera() == camera)
+        {
+            Swap(occlusionBuffers_[i], occlusionBuffers_[numOcclusionBuffers_]);
+            break;
+        }
+    }
+    
     int width = occlusionBufferSize_;
     int height = (int)((float)occlusionBufferSize_ / camera->GetAspectRatio() + 0.5f);
     
@@ -1042,6 +1081,12 @@ Camera* Renderer::GetShadowCamera()
     return camera;
 }
 
+bool Renderer::ArePassShadersLoaded(Pass* pass) const
+{
+    return pass->GetVertexShaders().Size() && pass->GetPixelShaders().Size() && pass->GetShadersLoadedFrameNumber() ==
+        shadersChangedFrameNumber_;
+}
+
 void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows)
 {
     // Check if shaders are unloaded or need reloading
@@ -1159,7 +1204,9 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows)
     // Log error if shaders could not be assigned, but only once per technique
     if (!batch.vertexShader_ || !batch.pixelShader_)
     {
-        if (!shaderErrorDisplayed_.Contains(tech))
+        MutexLock lock(rendererMutex_);
+        
+        if (tech && !shaderErrorDisplayed_.Contains(tech))
         {
             shaderErrorDisplayed_.Insert(tech);
             LOGERROR("Technique " + tech->GetName() + " has missing shaders");
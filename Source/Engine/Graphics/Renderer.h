@@ -209,6 +209,12 @@ public:
     void SetOcclusionBufferSize(int size);
     /// Set required screen size (1.0 = full screen) for occluders.
     void SetOccluderSizeThreshold(float screenSize);
+    /// Set maximum number of consecutive frames the occlusion buffer is reprojected from the previous frame instead of redrawn. 0 (default) disables reprojection.
+    void SetOcclusionReprojectionFrames(int frames);
+    /// Set maximum camera movement per frame for occlusion buffer reprojection.
+    void SetOcclusionReprojectionDistance(float distance);
+    /// Set maximum camera rotation in degrees per frame for occlusion buffer reprojection.
+    void SetOcclusionReprojectionAngle(float angle);
     /// Force reload of shaders.
     void ReloadShaders();
     
@@ -256,6 +262,12 @@ public:
     int GetOcclusionBufferSize() const { return occlusionBufferSize_; }
     /// Return occluder screen size threshold.
     float GetOccluderSizeThreshold() const { return occluderSizeThreshold_; }
+    /// Return maximum number of consecutive occlusion buffer reprojections.
+    int GetOcclusionReprojectionFrames() const { return occlusionReprojectionFrames_; }
+    /// Return maximum camera movement per frame for occlusion buffer reprojection.
+    float GetOcclusionReprojectionDistance() const { return occlusionReprojectionDistance_; }
+    /// Return maximum camera rotation per frame for occlusion buffer reprojection.
+    float GetOcclusionReprojectionAngle() const { return occlusionReprojectionAngle_; }
     /// Return number of views rendered.
     unsigned GetNumViews() const { return numViews_; }
     /// Return number of primitives rendered.
@@ -270,6 +282,8 @@ public:
     unsigned GetNumShadowMaps(bool allViews = false) const;
     /// Return number of occluders rendered.
     unsigned GetNumOccluders(bool allViews = false) const;
+    /// Return number of zone lookups for drawables, camera and far clip position.
+    unsigned GetNumZoneLookups(bool allViews = false) const;
     /// Return the default zone.
     Zone* GetDefaultZone() const { return defaultZone_; }
     /// Return the directional light for fullscreen quad rendering.
@@ -312,7 +326,9 @@ public:
     OcclusionBuffer* GetOcclusionBuffer(Camera* camera);
     /// Allocate a temporary shadow camera and a scene node for it. Is thread-safe.
     Camera* GetShadowCamera();
-    /// Choose shaders for a forward rendering batch.
+    /// Return whether the shaders of a pass are loaded and up to date, so that choosing shaders for it does not need to load them. Is thread-safe.
+    bool ArePassShadersLoaded(Pass* pass) const;
+    /// Choose shaders for a forward rendering batch. Is thread-safe if the pass shaders are loaded.
     void SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows = true);
     /// Choose shaders for a deferred light volume batch.
     void SetLightVolumeBatchShaders(Batch& batch, const String& vsName, const String& psName);
@@ -423,7 +439,7 @@ private:
     HashSet<Octree*> updatedOctrees_;
     /// Techniques for which missing shader error has been displayed.
     HashSet<Technique*> shaderErrorDisplayed_;
-    /// Mutex for shadow camera allocation.
+    /// Mutex for shadow camera allocation and shader error logging.
     Mutex rendererMutex_;
     /// Current variation names for deferred light volume shaders.
     Vector<String> deferredLightPSVariations_;
@@ -457,6 +473,12 @@ private:
     int occlusionBufferSize_;
     /// Occluder screen size threshold.
     float occluderSizeThreshold_;
+    /// Maximum consecutive occlusion buffer reprojections.
+    int occlusionReprojectionFrames_;
+    /// Maximum camera movement per frame for occlusion buffer reprojection.
+    float occlusionReprojectionDistance_;
+    /// Maximum camera rotation per frame for occlusion buffer reprojection.
+    float occlusionReprojectionAngle_;
     /// Number of views.
     unsigned numViews_;
     /// Number of occlusion buffers in use.
@@ -22,7 +22,9 @@
 
 #pragma once
 
-#ifdef USE_OPENGL
+#if defined(USE_NULL_GRAPHICS)
+#include "Null/NullShaderVariation.h"
+#elif defined(USE_OPENGL)
 #include "OpenGL/OGLShaderVariation.h"
 #else
 #include "Direct3D9/D3D9ShaderVariation.h"
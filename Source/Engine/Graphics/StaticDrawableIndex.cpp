@@ -0,0 +1,546 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "DebugRenderer.h"
+#include "Drawable.h"
+#include "OctreeQuery.h"
+#include "Sort.h"
+#include "StaticDrawableIndex.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned MAX_LEAF_DRAWABLES = 8;
+static const unsigned MAX_SAH_LEAF_DRAWABLES = 32;
+static const unsigned NUM_SAH_BINS = 16;
+static const unsigned MAX_TRAVERSAL_DEPTH = 64;
+static const unsigned MIN_REBUILD_CHANGES = 32;
+static const unsigned REBUILD_CHANGE_RATIO = 8;
+/// Relative cost of traversing a node compared to testing a drawable.
+static const float SAH_TRAVERSAL_COST = 1.0f;
+
+static inline void SetBounds(float* bounds, unsigned index, const BoundingBox& box)
+{
+    bounds += (index >> 2) * 24 + (index & 3);
+    bounds[0] = box.min_.x_;
+    bounds[4] = box.min_.y_;
+    bounds[8] = box.min_.z_;
+    bounds[12] = box.max_.x_;
+    bounds[16] = box.max_.y_;
+    bounds[20] = box.max_.z_;
+}
+
+static inline BoundingBox GetBounds(const float* bounds, unsigned index)
+{
+    bounds += (index >> 2) * 24 + (index & 3);
+    return BoundingBox(Vector3(bounds[0], bounds[4], bounds[8]), Vector3(bounds[12], bounds[16], bounds[20]));
+}
+
+static inline float GetHalfArea(const BoundingBox& box)
+{
+    if (!box.defined_)
+        return 0.0f;
+    
+    Vector3 size = box.Size();
+    return size.x_ * size.y_ + size.y_ * size.z_ + size.z_ * size.x_;
+}
+
+static inline bool CompareEntryX(const StaticDrawableIndexEntry& lhs, const StaticDrawableIndexEntry& rhs)
+{
+    return lhs.center_.x_ < rhs.center_.x_;
+}
+
+static inline bool CompareEntryY(const StaticDrawableIndexEntry& lhs, const StaticDrawableIndexEntry& rhs)
+{
+    return lhs.center_.y_ < rhs.center_.y_;
+}
+
+static inline bool CompareEntryZ(const StaticDrawableIndexEntry& lhs, const StaticDrawableIndexEntry& rhs)
+{
+    return lhs.center_.z_ < rhs.center_.z_;
+}
+
+StaticDrawableIndex::StaticDrawableIndex(Octant* root) :
+    root_(root),
+    numRemoved_(0)
+{
+}
+
+StaticDrawableIndex::~StaticDrawableIndex()
+{
+    Clear();
+}
+
+void StaticDrawableIndex::AddDrawable(Drawable* drawable)
+{
+    if (!drawable || drawable->staticIndexed_)
+        return;
+    
+    drawable->SetOctant(root_);
+    drawable->staticIndexed_ = true;
+    PushPendingDrawable(drawable, drawable->GetWorldBoundingBox());
+}
+
+void StaticDrawableIndex::UpdateDrawable(Drawable* drawable)
+{
+    if (!drawable || !drawable->staticIndexed_)
+        return;
+    
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+    unsigned index = drawable->octantIndex_;
+    if (index < drawables_.Size())
+    {
+        // If still inside the leaf, only the bounds need to be updated. Otherwise test the drawable linearly until next rebuild
+        const StaticDrawableIndexNode& leaf = nodes_[leafIndices_[index]];
+        if (leaf.box_.IsInside(box) == INSIDE)
+            SetBounds(&bounds_[leaf.boundsOffset_], index - leaf.start_, box);
+        else
+        {
+            RemoveTreeDrawableAt(index);
+            PushPendingDrawable(drawable, box);
+        }
+    }
+    else
+        SetBounds(&pendingBounds_[0], index - drawables_.Size(), box);
+}
+
+void StaticDrawableIndex::RemoveDrawable(Drawable* drawable)
+{
+    if (!drawable || !drawable->staticIndexed_)
+        return;
+    
+    unsigned index = drawable->octantIndex_;
+    if (index < drawables_.Size())
+        RemoveTreeDrawableAt(index);
+    else
+        RemovePendingDrawableAt(index - drawables_.Size());
+    
+    drawable->SetOctant(0);
+    drawable->staticIndexed_ = false;
+}
+
+void StaticDrawableIndex::Rebuild()
+{
+    entries_.Clear();
+    entries_.Reserve(GetNumDrawables());
+    
+    for (unsigned i = 0; i < drawables_.Size(); ++i)
+    {
+        Drawable* drawable = drawables_[i];
+        if (drawable)
+        {
+            StaticDrawableIndexEntry entry;
+            entry.box_ = drawable->GetWorldBoundingBox();
+            entry.center_ = entry.box_.Center();
+            entry.drawable_ = drawable;
+            entries_.Push(entry);
+        }
+    }
+    for (unsigned i = 0; i < pendingDrawables_.Size(); ++i)
+    {
+        StaticDrawableIndexEntry entry;
+        entry.box_ = pendingDrawables_[i]->GetWorldBoundingBox();
+        entry.center_ = entry.box_.Center();
+        entry.drawable_ = pendingDrawables_[i];
+        entries_.Push(entry);
+    }
+    
+    nodes_.Clear();
+    pendingDrawables_.Clear();
+    pendingBounds_.Clear();
+    numRemoved_ = 0;
+    if (entries_.Size())
+        BuildNode(0, entries_.Size(), 0);
+    
+    // Store the drawables and their bounds in leaf order. Each leaf starts a new group of four bounding boxes
+    unsigned boundsSize = 0;
+    for (unsigned i = 0; i < nodes_.Size(); ++i)
+    {
+        StaticDrawableIndexNode& node = nodes_[i];
+        if (!node.secondChild_)
+        {
+            node.boundsOffset_ = boundsSize;
+            boundsSize += ((node.count_ + 3) >> 2) * 24;
+        }
+    }
+    
+    drawables_.Resize(entries_.Size());
+    leafIndices_.Resize(entries_.Size());
+    bounds_.Resize(boundsSize);
+    for (unsigned i = 0; i < boundsSize; ++i)
+        bounds_[i] = 0.0f;
+    
+    for (unsigned i = 0; i < nodes_.Size(); ++i)
+    {
+        const StaticDrawableIndexNode& node = nodes_[i];
+        if (node.secondChild_)
+            continue;
+        
+        for (unsigned j = 0; j < node.count_; ++j)
+        {
+            unsigned index = node.start_ + j;
+            const StaticDrawableIndexEntry& entry = entries_[index];
+            drawables_[index] = entry.drawable_;
+            leafIndices_[index] = i;
+            entry.drawable_->octantIndex_ = index;
+            SetBounds(&bounds_[node.boundsOffset_], j, entry.box_);
+        }
+    }
+    
+    entries_.Clear();
+}
+
+void StaticDrawableIndex::Clear()
+{
+    for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        if (drawable)
+        {
+            drawable->SetOctant(0);
+            drawable->staticIndexed_ = false;
+        }
+    }
+    for (PODVector<Drawable*>::Iterator i = pendingDrawables_.Begin(); i != pendingDrawables_.End(); ++i)
+    {
+        (*i)->SetOctant(0);
+        (*i)->staticIndexed_ = false;
+    }
+    
+    nodes_.Clear();
+    drawables_.Clear();
+    leafIndices_.Clear();
+    bounds_.Clear();
+    pendingDrawables_.Clear();
+    pendingBounds_.Clear();
+    numRemoved_ = 0;
+}
+
+void StaticDrawableIndex::GetDrawables(OctreeQuery& query) const
+{
+    if (!nodes_.Empty())
+    {
+        // Store the inside flag in the lowest bit of the stack entries
+        unsigned stack[MAX_TRAVERSAL_DEPTH];
+        unsigned stackSize = 0;
+        stack[stackSize++] = 0;
+        
+        while (stackSize)
+        {
+            unsigned entry = stack[--stackSize];
+            unsigned nodeIndex = entry >> 1;
+            bool inside = (entry & 1) != 0;
+            const StaticDrawableIndexNode& node = nodes_[nodeIndex];
+            
+            Intersection res = query.TestOctant(node.box_, inside);
+            if (res == INSIDE)
+                inside = true;
+            else if (res == OUTSIDE)
+                continue;
+            
+            if (node.secondChild_)
+            {
+                stack[stackSize++] = (node.secondChild_ << 1) | (inside ? 1 : 0);
+                stack[stackSize++] = ((nodeIndex + 1) << 1) | (inside ? 1 : 0);
+            }
+            else if (node.count_)
+            {
+                Drawable** start = const_cast<Drawable**>(&drawables_[node.start_]);
+                Drawable** end = start + node.count_;
+                // When the node is fully inside, the drawables' bounding boxes need not be tested
+                if (inside)
+                    query.TestDrawables(start, end, true);
+                else
+                    query.TestDrawables(start, end, &bounds_[node.boundsOffset_], false);
+            }
+        }
+    }
+    
+    if (pendingDrawables_.Size())
+    {
+        Drawable** start = const_cast<Drawable**>(&pendingDrawables_[0]);
+        Drawable** end = start + pendingDrawables_.Size();
+        query.TestDrawables(start, end, &pendingBounds_[0], false);
+    }
+}
+
+void StaticDrawableIndex::GetDrawables(RayOctreeQuery& query) const
+{
+    unsigned stack[MAX_TRAVERSAL_DEPTH];
+    unsigned stackSize = 0;
+    if (!nodes_.Empty())
+        stack[stackSize++] = 0;
+    
+    while (stackSize)
+    {
+        unsigned nodeIndex = stack[--stackSize];
+        const StaticDrawableIndexNode& node = nodes_[nodeIndex];
+        if (query.ray_.HitDistance(node.box_) >= query.maxDistance_)
+            continue;
+        
+        if (node.secondChild_)
+        {
+            stack[stackSize++] = node.secondChild_;
+            stack[stackSize++] = nodeIndex + 1;
+        }
+        else
+        {
+            for (unsigned i = node.start_; i < node.start_ + node.count_; ++i)
+            {
+                Drawable* drawable = drawables_[i];
+                if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+                    drawable->ProcessRayQuery(query, query.result_);
+            }
+        }
+    }
+    
+    for (PODVector<Drawable*>::ConstIterator i = pendingDrawables_.Begin(); i != pendingDrawables_.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+            drawable->ProcessRayQuery(query, query.result_);
+    }
+}
+
+void StaticDrawableIndex::GetDrawablesOnly(RayOctreeQuery& query, PODVector<Drawable*>& drawables) const
+{
+    unsigned stack[MAX_TRAVERSAL_DEPTH];
+    unsigned stackSize = 0;
+    if (!nodes_.Empty())
+        stack[stackSize++] = 0;
+    
+    while (stackSize)
+    {
+        unsigned nodeIndex = stack[--stackSize];
+        const StaticDrawableIndexNode& node = nodes_[nodeIndex];
+        if (query.ray_.HitDistance(node.box_) >= query.maxDistance_)
+            continue;
+        
+        if (node.secondChild_)
+        {
+            stack[stackSize++] = node.secondChild_;
+            stack[stackSize++] = nodeIndex + 1;
+        }
+        else
+        {
+            for (unsigned i = node.start_; i < node.start_ + node.count_; ++i)
+            {
+                Drawable* drawable = drawables_[i];
+                if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+                    drawables.Push(drawable);
+            }
+        }
+    }
+    
+    for (PODVector<Drawable*>::ConstIterator i = pendingDrawables_.Begin(); i != pendingDrawables_.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+            drawables.Push(drawable);
+    }
+}
+
+void StaticDrawableIndex::DrawDebugGeometry(DebugRenderer* debug, bool depthTest) const
+{
+    if (!debug)
+        return;
+    
+    for (PODVector<StaticDrawableIndexNode>::ConstIterator i = nodes_.Begin(); i != nodes_.End(); ++i)
+    {
+        if (!i->secondChild_ && i->count_ && debug->IsInside(i->box_))
+            debug->AddBoundingBox(i->box_, Color(0.0f, 0.5f, 0.25f), depthTest);
+    }
+}
+
+bool StaticDrawableIndex::IsRebuildNeeded() const
+{
+    unsigned changes = pendingDrawables_.Size() + numRemoved_;
+    return changes > MIN_REBUILD_CHANGES && changes * REBUILD_CHANGE_RATIO > drawables_.Size();
+}
+
+void StaticDrawableIndex::BuildNode(unsigned start, unsigned end, unsigned depth)
+{
+    unsigned nodeIndex = nodes_.Size();
+    nodes_.Resize(nodeIndex + 1);
+    
+    BoundingBox box;
+    BoundingBox centerBox;
+    for (unsigned i = start; i < end; ++i)
+    {
+        box.Merge(entries_[i].box_);
+        centerBox.Merge(entries_[i].center_);
+    }
+    
+    StaticDrawableIndexNode& node = nodes_[nodeIndex];
+    node.box_ = box;
+    node.secondChild_ = 0;
+    node.start_ = start;
+    node.count_ = end - start;
+    node.boundsOffset_ = 0;
+    
+    // Leave room in the traversal stack for the two children of the deepest inner node
+    unsigned count = end - start;
+    Vector3 size = centerBox.Size();
+    if (count <= MAX_LEAF_DRAWABLES || depth + 2 >= MAX_TRAVERSAL_DEPTH || (size.x_ <= 0.0f && size.y_ <= 0.0f &&
+        size.z_ <= 0.0f))
+        return;
+    
+    unsigned axis = 0;
+    if (size.y_ > size.x_ && size.y_ >= size.z_)
+        axis = 1;
+    else if (size.z_ > size.x_ && size.z_ > size.y_)
+        axis = 2;
+    
+    // Bin the drawable centers along the longest axis and evaluate the surface area heuristic at each bin boundary
+    float axisMin = centerBox.min_.Data()[axis];
+    float axisSize = size.Data()[axis];
+    float binScale = (float)NUM_SAH_BINS / axisSize;
+    BoundingBox binBoxes[NUM_SAH_BINS];
+    unsigned binCounts[NUM_SAH_BINS];
+    for (unsigned i = 0; i < NUM_SAH_BINS; ++i)
+        binCounts[i] = 0;
+    
+    for (unsigned i = start; i < end; ++i)
+    {
+        const StaticDrawableIndexEntry& entry = entries_[i];
+        unsigned bin = Min((int)((entry.center_.Data()[axis] - axisMin) * binScale), (int)NUM_SAH_BINS - 1);
+        binBoxes[bin].Merge(entry.box_);
+        ++binCounts[bin];
+    }
+    
+    float rightAreas[NUM_SAH_BINS];
+    BoundingBox rightBox;
+    for (unsigned i = NUM_SAH_BINS - 1; i > 0; --i)
+    {
+        rightBox.Merge(binBoxes[i]);
+        rightAreas[i] = GetHalfArea(rightBox);
+    }
+    
+    BoundingBox leftBox;
+    unsigned leftCount = 0;
+    unsigned bestSplit = 0;
+    float bestCost = M_INFINITY;
+    for (unsigned i = 1; i < NUM_SAH_BINS; ++i)
+    {
+        leftBox.Merge(binBoxes[i - 1]);
+        leftCount += binCounts[i - 1];
+        if (!leftCount || leftCount == count)
+            continue;
+        
+        float cost = GetHalfArea(leftBox) * leftCount + rightAreas[i] * (count - leftCount);
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            bestSplit = i;
+        }
+    }
+    
+    unsigned middle;
+    if (bestSplit)
+    {
+        // Stop at a small leaf if testing its drawables is cheaper than the best split
+        float parentArea = GetHalfArea(box);
+        if (count <= MAX_SAH_LEAF_DRAWABLES && parentArea > 0.0f && (float)count <= SAH_TRAVERSAL_COST + bestCost /
+            parentArea)
+            return;
+        
+        // Partition the entries by the split bin
+        middle = start;
+        for (unsigned i = start; i < end; ++i)
+        {
+            if ((int)((entries_[i].center_.Data()[axis] - axisMin) * binScale) < (int)bestSplit)
+                Swap(entries_[i], entries_[middle++]);
+        }
+    }
+    else
+    {
+        // All centers fell into one bin, so split at the median instead
+        if (axis == 0)
+            Sort(entries_.Begin() + start, entries_.Begin() + end, CompareEntryX);
+        else if (axis == 1)
+            Sort(entries_.Begin() + start, entries_.Begin() + end, CompareEntryY);
+        else
+            Sort(entries_.Begin() + start, entries_.Begin() + end, CompareEntryZ);
+        middle = (start + end) / 2;
+    }
+    
+    nodes_[nodeIndex].count_ = 0;
+    BuildNode(start, middle, depth + 1);
+    // The node vector may have been reallocated, so do not use the node reference anymore
+    nodes_[nodeIndex].secondChild_ = nodes_.Size();
+    BuildNode(middle, end, depth + 1);
+}
+
+void StaticDrawableIndex::PushPendingDrawable(Drawable* drawable, const BoundingBox& box)
+{
+    unsigned index = pendingDrawables_.Size();
+    drawable->octantIndex_ = drawables_.Size() + index;
+    pendingDrawables_.Push(drawable);
+    
+    // Start a new group of four bounding boxes if necessary. Zero the unused bounds
+    if (!(index & 3))
+    {
+        pendingBounds_.Resize(pendingBounds_.Size() + 24);
+        for (unsigned i = index * 6; i < pendingBounds_.Size(); ++i)
+            pendingBounds_[i] = 0.0f;
+    }
+    SetBounds(&pendingBounds_[0], index, box);
+}
+
+void StaticDrawableIndex::RemoveTreeDrawableAt(unsigned index)
+{
+    StaticDrawableIndexNode& leaf = nodes_[leafIndices_[index]];
+    unsigned last = leaf.start_ + leaf.count_ - 1;
+    float* bounds = &bounds_[leaf.boundsOffset_];
+    if (index != last)
+    {
+        Drawable* moved = drawables_[last];
+        drawables_[index] = moved;
+        moved->octantIndex_ = index;
+        SetBounds(bounds, index - leaf.start_, GetBounds(bounds, last - leaf.start_));
+    }
+    // The leaf bounds are left as they are until the next rebuild, as they still enclose the remaining drawables
+    SetBounds(bounds, last - leaf.start_, BoundingBox(Vector3::ZERO, Vector3::ZERO));
+    drawables_[last] = 0;
+    --leaf.count_;
+    ++numRemoved_;
+}
+
+void StaticDrawableIndex::RemovePendingDrawableAt(unsigned index)
+{
+    unsigned last = pendingDrawables_.Size() - 1;
+    if (index != last)
+    {
+        Drawable* moved = pendingDrawables_[last];
+        pendingDrawables_[index] = moved;
+        moved->octantIndex_ = drawables_.Size() + index;
+        SetBounds(&pendingBounds_[0], index, GetBounds(&pendingBounds_[0], last));
+    }
+    pendingDrawables_.Pop();
+    if (!(last & 3))
+        pendingBounds_.Resize(last * 6);
+}
+
+}
@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "BoundingBox.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+class DebugRenderer;
+class Drawable;
+class Octant;
+class OctreeQuery;
+class RayOctreeQuery;
+
+/// %Drawable entry used while building the static drawable index.
+struct StaticDrawableIndexEntry
+{
+    /// World bounding box.
+    BoundingBox box_;
+    /// World bounding box center.
+    Vector3 center_;
+    /// Drawable.
+    Drawable* drawable_;
+};
+
+/// Static drawable index tree node.
+struct StaticDrawableIndexNode
+{
+    /// Bounding box of the drawables in the subtree.
+    BoundingBox box_;
+    /// Second child node index. The first child is the next node. Zero for leaf nodes.
+    unsigned secondChild_;
+    /// First drawable slot. Used only by leaf nodes.
+    unsigned start_;
+    /// Number of drawables. Used only by leaf nodes.
+    unsigned count_;
+    /// Offset of the leaf's drawable bounds. Used only by leaf nodes.
+    unsigned boundsOffset_;
+};
+
+/// Bounding volume hierarchy of static drawables, built with the surface area heuristic. Used by the octree alongside the octants.
+class URHO3D_API StaticDrawableIndex
+{
+public:
+    /// Construct with the octree root octant the indexed drawables report as their octant.
+    StaticDrawableIndex(Octant* root);
+    /// Destruct. Detach the indexed drawables.
+    ~StaticDrawableIndex();
+    
+    /// Add a drawable. It is tested linearly until the next rebuild.
+    void AddDrawable(Drawable* drawable);
+    /// Update a drawable's bounds after it has moved or resized.
+    void UpdateDrawable(Drawable* drawable);
+    /// Remove a drawable.
+    void RemoveDrawable(Drawable* drawable);
+    /// Rebuild the tree from all drawables.
+    void Rebuild();
+    /// Remove and detach all drawables.
+    void Clear();
+    
+    /// Return drawable objects by a query.
+    void GetDrawables(OctreeQuery& query) const;
+    /// Return drawable objects by a ray query.
+    void GetDrawables(RayOctreeQuery& query) const;
+    /// Return drawable objects only for a threaded ray query.
+    void GetDrawablesOnly(RayOctreeQuery& query, PODVector<Drawable*>& drawables) const;
+    /// Draw the leaf node bounds to the debug graphics.
+    void DrawDebugGeometry(DebugRenderer* debug, bool depthTest) const;
+    
+    /// Return number of drawables.
+    unsigned GetNumDrawables() const { return drawables_.Size() - numRemoved_ + pendingDrawables_.Size(); }
+    /// Return number of drawables added or moved since the last rebuild.
+    unsigned GetNumPendingDrawables() const { return pendingDrawables_.Size(); }
+    /// Return number of tree nodes.
+    unsigned GetNumNodes() const { return nodes_.Size(); }
+    /// Return whether enough drawables have been added, moved or removed since the last rebuild to warrant a new one.
+    bool IsRebuildNeeded() const;
+    
+private:
+    /// Build a subtree from a range of build entries.
+    void BuildNode(unsigned start, unsigned end, unsigned depth);
+    /// Add a drawable to the pending drawables.
+    void PushPendingDrawable(Drawable* drawable, const BoundingBox& box);
+    /// Remove a drawable from a tree slot. Move the last drawable of the leaf to its place.
+    void RemoveTreeDrawableAt(unsigned index);
+    /// Remove a pending drawable by index. Move the last pending drawable to its place.
+    void RemovePendingDrawableAt(unsigned index);
+    
+    /// Octree root octant.
+    Octant* root_;
+    /// Tree nodes. The first node is the root.
+    PODVector<StaticDrawableIndexNode> nodes_;
+    /// Drawable slots, ordered by the tree leaves. Slots freed by removal are null until the next rebuild.
+    PODVector<Drawable*> drawables_;
+    /// Leaf node index of each drawable slot.
+    PODVector<unsigned> leafIndices_;
+    /// Leaf drawable world bounding boxes in groups of four, in the same layout as octant drawable bounds. Each leaf starts a new group.
+    PODVector<float> bounds_;
+    /// Drawables added or moved out of their leaf since the last rebuild.
+    PODVector<Drawable*> pendingDrawables_;
+    /// Pending drawable world bounding boxes in groups of four.
+    PODVector<float> pendingBounds_;
+    /// Build entries. Used only during a rebuild.
+    PODVector<StaticDrawableIndexEntry> entries_;
+    /// Number of drawable slots freed by removal since the last rebuild.
+    unsigned numRemoved_;
+};
+
+}
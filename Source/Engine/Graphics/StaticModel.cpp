@@ -69,6 +69,8 @@ void StaticModel::RegisterObject(Context* context)
     ACCESSOR_ATTRIBUTE(StaticModel, VAR_FLOAT, "LOD Bias", GetLodBias, SetLodBias, float, 1.0f, AM_DEFAULT);
     COPY_BASE_ATTRIBUTES(StaticModel, Drawable);
     ATTRIBUTE(StaticModel, VAR_INT, "Occlusion LOD Level", occlusionLodLevel_, M_MAX_UNSIGNED, AM_DEFAULT);
+    // Not saved to file, as the positional binary format of existing scenes and derived components has no room for it
+    ACCESSOR_ATTRIBUTE(StaticModel, VAR_BOOL, "Is Static", IsStatic, SetStatic, bool, false, AM_NET | AM_NOEDIT);
 }
 
 void StaticModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results)
@@ -167,6 +169,10 @@ Geometry* StaticModel::GetLodGeometry(unsigned batchIndex, unsigned level)
 
 unsigned StaticModel::GetNumOccluderTriangles()
 {
+    Geometry* occluderGeometry = GetOccluderGeometry();
+    if (occluderGeometry)
+        return occluderGeometry->GetIndexCount() / 3;
+    
     unsigned triangles = 0;
     
     for (unsigned i = 0; i < batches_.Size(); ++i)
@@ -188,6 +194,22 @@ unsigned StaticModel::GetNumOccluderTriangles()
 
 bool StaticModel::DrawOcclusion(OcclusionBuffer* buffer)
 {
+    // The occluder geometry is a closed hull inside the model, so it can always be drawn with backface culling
+    Geometry* occluderGeometry = GetOccluderGeometry();
+    if (occluderGeometry)
+    {
+        const unsigned char* vertexData;
+        unsigned vertexSize;
+        const unsigned char* indexData;
+        unsigned indexSize;
+        unsigned elementMask;
+        
+        occluderGeometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elementMask);
+        buffer->SetCullMode(CULL_CCW);
+        return buffer->Draw(node_->GetWorldTransform(), vertexData, vertexSize, indexData, indexSize,
+            occluderGeometry->GetIndexStart(), occluderGeometry->GetIndexCount());
+    }
+    
     for (unsigned i = 0; i < batches_.Size(); ++i)
     {
         Geometry* geometry = GetLodGeometry(i, occlusionLodLevel_);
@@ -227,6 +249,27 @@ bool StaticModel::DrawOcclusion(OcclusionBuffer* buffer)
     return true;
 }
 
+Geometry* StaticModel::GetOccluderGeometry() const
+{
+    // An explicitly set occlusion LOD level overrides the occluder geometry
+    if (!model_ || occlusionLodLevel_ != M_MAX_UNSIGNED)
+        return 0;
+    
+    Geometry* occluderGeometry = model_->GetOccluderGeometry();
+    if (!occluderGeometry)
+        return 0;
+    
+    // The occluder geometry covers all batches, so if any of their materials disables occlusion, use the LOD geometries
+    for (unsigned i = 0; i < batches_.Size(); ++i)
+    {
+        Material* material = batches_[i].material_;
+        if (material && !material->GetOcclusion())
+            return 0;
+    }
+    
+    return occluderGeometry;
+}
+
 void StaticModel::SetModel(Model* model)
 {
     if (model == model_)
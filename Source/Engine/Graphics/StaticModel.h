@@ -68,7 +68,7 @@ public:
     void SetMaterial(Material* material);
     /// Set material on one geometry. Return true if successful.
     bool SetMaterial(unsigned index, Material* material);
-    /// Set occlusion LOD level. By default (M_MAX_UNSIGNED) same as visible.
+    /// Set occlusion LOD level. By default (M_MAX_UNSIGNED) the model's occluder geometry if it has one, otherwise same as visible.
     void SetOcclusionLodLevel(unsigned level);
     /// Apply default materials from a material list file. If filename is empty (default), the model's resource name with extension .txt will be used.
     void ApplyMaterialList(const String& fileName = String::EMPTY);
@@ -106,6 +106,8 @@ protected:
     void ResetLodLevels();
     /// Choose LOD levels based on distance.
     void CalculateLodLevels();
+    /// Return the model's occluder geometry if it should be drawn to the occlusion buffer instead of the LOD geometries.
+    Geometry* GetOccluderGeometry() const;
     
     /// Extra per-geometry data.
     PODVector<StaticModelGeometryData> geometryData_;
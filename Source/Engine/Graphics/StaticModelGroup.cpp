@@ -197,6 +197,10 @@ unsigned StaticModelGroup::GetNumOccluderTriangles()
     // Make sure instance transforms are up-to-date
     GetWorldBoundingBox();
     
+    Geometry* occluderGeometry = GetOccluderGeometry();
+    if (occluderGeometry)
+        return numWorldTransforms_ * occluderGeometry->GetIndexCount() / 3;
+    
     unsigned triangles = 0;
     
     for (unsigned i = 0; i < batches_.Size(); ++i)
@@ -221,6 +225,27 @@ bool StaticModelGroup::DrawOcclusion(OcclusionBuffer* buffer)
     // Make sure instance transforms are up-to-date
     GetWorldBoundingBox();
     
+    Geometry* occluderGeometry = GetOccluderGeometry();
+    if (occluderGeometry)
+    {
+        const unsigned char* vertexData;
+        unsigned vertexSize;
+        const unsigned char* indexData;
+        unsigned indexSize;
+        unsigned elementMask;
+        
+        occluderGeometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elementMask);
+        buffer->SetCullMode(CULL_CCW);
+        for (unsigned i = 0; i < numWorldTransforms_; ++i)
+        {
+            if (!buffer->Draw(worldTransforms_[i], vertexData, vertexSize, indexData, indexSize,
+                occluderGeometry->GetIndexStart(), occluderGeometry->GetIndexCount()))
+                return false;
+        }
+        
+        return true;
+    }
+    
     for (unsigned i = 0; i < numWorldTransforms_; ++i)
     {
         for (unsigned j = 0; j < batches_.Size(); ++j)
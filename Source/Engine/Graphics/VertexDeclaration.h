@@ -22,6 +22,6 @@
 
 #pragma once
 
-#ifndef USE_OPENGL
+#if !defined(USE_OPENGL) && !defined(USE_NULL_GRAPHICS)
 #include "Direct3D9/D3D9VertexDeclaration.h"
 #endif
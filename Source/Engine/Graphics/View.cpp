@@ -24,6 +24,7 @@
 #include "Camera.h"
 #include "DebugRenderer.h"
 #include "FileSystem.h"
+#include "FrameAllocator.h"
 #include "Geometry.h"
 #include "Graphics.h"
 #include "GraphicsImpl.h"
@@ -62,6 +63,7 @@ static const Vector3* directions[] =
 };
 
 static const float LIGHT_INTENSITY_THRESHOLD = 0.003f;
+static const unsigned MAX_VERTEXLIGHT_QUEUES = 1024;
 
 /// %Frustum octree query for shadowcasters.
 class ShadowCasterOctreeQuery : public FrustumOctreeQuery
@@ -204,7 +206,7 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
             {
                 Zone* drawableZone = drawable->GetZone();
                 if ((!drawableZone || (drawableZone->GetViewMask() & cameraViewMask) == 0) && !cameraZoneOverride)
-                    view->FindZone(drawable);
+                    view->FindZone(drawable, threadIndex);
                 
                 const BoundingBox& geomBox = drawable->GetWorldBoundingBox();
                 Vector3 center = geomBox.Center();
@@ -225,6 +227,8 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
                 }
                 
                 result.geometries_.Push(drawable);
+                if (drawable->GetUpdateGeometryType() == UPDATE_WORKER_THREAD)
+                    result.threadedGeometries_.Push(drawable);
             }
             else if (drawable->GetDrawableFlags() & DRAWABLE_LIGHT)
             {
@@ -240,9 +244,21 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
 void ProcessLightWork(const WorkItem* item, unsigned threadIndex)
 {
     View* view = reinterpret_cast<View*>(item->aux_);
-    LightQueryResult* query = reinterpret_cast<LightQueryResult*>(item->start_);
+    LightQueryResult* start = reinterpret_cast<LightQueryResult*>(item->start_);
+    LightQueryResult* end = reinterpret_cast<LightQueryResult*>(item->end_);
     
-    view->ProcessLight(*query, threadIndex);
+    while (start != end)
+        view->ProcessLight(*start++, threadIndex);
+}
+
+void UpdateVisibleGeometriesWork(const WorkItem* item, unsigned threadIndex)
+{
+    View* view = reinterpret_cast<View*>(item->aux_);
+    const PODVector<Drawable*>& geometries = reinterpret_cast<PerThreadSceneResult*>(item->start_)->threadedGeometries_;
+    PROFILE_OBJECT(view, UpdateGeometries);
+    
+    for (PODVector<Drawable*>::ConstIterator i = geometries.Begin(); i != geometries.End(); ++i)
+        (*i)->UpdateGeometry(view->frame_);
 }
 
 void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
@@ -250,6 +266,7 @@ void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
     const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
     Drawable** start = reinterpret_cast<Drawable**>(item->start_);
     Drawable** end = reinterpret_cast<Drawable**>(item->end_);
+    PROFILE_OBJECT(frame.camera_, UpdateGeometries);
     
     while (start != end)
     {
@@ -261,6 +278,7 @@ void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
 void SortBatchQueueFrontToBackWork(const WorkItem* item, unsigned threadIndex)
 {
     BatchQueue* queue = reinterpret_cast<BatchQueue*>(item->start_);
+    PROFILE_OBJECT(reinterpret_cast<View*>(item->aux_), SortBatches);
     
     queue->SortFrontToBack();
 }
@@ -268,6 +286,7 @@ void SortBatchQueueFrontToBackWork(const WorkItem* item, unsigned threadIndex)
 void SortBatchQueueBackToFrontWork(const WorkItem* item, unsigned threadIndex)
 {
     BatchQueue* queue = reinterpret_cast<BatchQueue*>(item->start_);
+    PROFILE_OBJECT(reinterpret_cast<View*>(item->aux_), SortBatches);
     
     queue->SortBackToFront();
 }
@@ -275,6 +294,7 @@ void SortBatchQueueBackToFrontWork(const WorkItem* item, unsigned threadIndex)
 void SortLightQueueWork(const WorkItem* item, unsigned threadIndex)
 {
     LightBatchQueue* start = reinterpret_cast<LightBatchQueue*>(item->start_);
+    PROFILE_OBJECT(reinterpret_cast<View*>(item->aux_), SortBatches);
     start->litBaseBatches_.SortFrontToBack();
     start->litBatches_.SortFrontToBack();
 }
@@ -282,26 +302,55 @@ void SortLightQueueWork(const WorkItem* item, unsigned threadIndex)
 void SortShadowQueueWork(const WorkItem* item, unsigned threadIndex)
 {
     LightBatchQueue* start = reinterpret_cast<LightBatchQueue*>(item->start_);
+    PROFILE_OBJECT(reinterpret_cast<View*>(item->aux_), SortBatches);
     for (unsigned i = 0; i < start->shadowSplits_.Size(); ++i)
         start->shadowSplits_[i].shadowBatches_.SortFrontToBack();
 }
 
+/// Return the technique of a material that a pass belongs to.
+static Technique* GetPassTechnique(Material* material, Pass* pass)
+{
+    const Vector<TechniqueEntry>& techniques = material->GetTechniques();
+    for (unsigned i = 0; i < techniques.Size(); ++i)
+    {
+        Technique* tech = techniques[i].technique_;
+        if (tech && tech->GetPass(pass->GetType()) == pass)
+            return tech;
+    }
+    
+    return 0;
+}
+
+void GetBaseBatchesWork(const WorkItem* item, unsigned threadIndex)
+{
+    View* view = reinterpret_cast<View*>(item->aux_);
+    Drawable** start = reinterpret_cast<Drawable**>(item->start_);
+    Drawable** end = reinterpret_cast<Drawable**>(item->end_);
+    PROFILE_OBJECT(view, BuildBaseBatches);
+    
+    while (start != end)
+        view->GetBaseBatches(*start++, threadIndex, true);
+}
+
 View::View(Context* context) :
     Object(context),
     graphics_(GetSubsystem<Graphics>()),
     renderer_(GetSubsystem<Renderer>()),
+    frameArena_(0),
     scene_(0),
     octree_(0),
     camera_(0),
     cameraZone_(0),
     farClipZone_(0),
     renderTarget_(0),
-    substituteRenderTarget_(0)
+    substituteRenderTarget_(0),
+    numZoneLookups_(0)
 {
     // Create octree query and scene results vector for each thread
     unsigned numThreads = GetSubsystem<WorkQueue>()->GetNumThreads() + 1; // Worker threads + main thread
     tempDrawables_.Resize(numThreads);
     sceneResults_.Resize(numThreads);
+    batchResults_.Resize(numThreads);
     frame_.camera_ = 0;
 }
 
@@ -474,6 +523,11 @@ void View::Update(const FrameInfo& frame)
     frame_.viewSize_ = viewSize_;
     
     int maxSortedInstances = renderer_->GetMaxSortedInstances();
+    FrameAllocator* frameAllocator = GetSubsystem<FrameAllocator>();
+    frameArena_ = frameAllocator ? frameAllocator->GetArena() : 0;
+    // Octree query results are allocated from the arena of the thread that makes the query
+    for (unsigned i = 0; i < tempDrawables_.Size(); ++i)
+        tempDrawables_[i].ResetArena(frameAllocator ? frameAllocator->GetArena(i) : 0);
     
     // Clear buffers, geometry, light, occluder & batch list
     renderTargets_.Clear();
@@ -482,9 +536,25 @@ void View::Update(const FrameInfo& frame)
     lights_.Clear();
     zones_.Clear();
     occluders_.Clear();
-    vertexLightQueues_.Clear();
     for (HashMap<StringHash, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
-        i->second_.Clear(maxSortedInstances);
+        i->second_.Clear(maxSortedInstances, frameArena_);
+    // The batches and batch groups' instances refer to last frame's arena memory, so clear also the light queues and light
+    // query results before they may be copied on resize
+    for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
+    {
+        i->litBaseBatches_.Clear(maxSortedInstances);
+        i->litBatches_.Clear(maxSortedInstances);
+        for (Vector<ShadowBatchQueue>::Iterator j = i->shadowSplits_.Begin(); j != i->shadowSplits_.End(); ++j)
+            j->shadowBatches_.Clear(maxSortedInstances);
+    }
+    for (Vector<LightQueryResult>::Iterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
+    {
+        i->litGeometries_.ResetArena(0);
+        i->shadowCasters_.ResetArena(0);
+    }
+    // Vertex light queues are fully defined by their key, so they are kept over frames to avoid reallocating them
+    if (vertexLightQueues_.Size() > MAX_VERTEXLIGHT_QUEUES)
+        vertexLightQueues_.Clear();
     
     // Set automatic aspect ratio if required
     if (camera_->GetAutoAspectRatio())
@@ -595,7 +665,6 @@ void View::GetDrawables()
     }
     
     highestZonePriority_ = M_MIN_INT;
-    int bestPriority = M_MIN_INT;
     Vector3 cameraPos = cameraNode_->GetWorldPosition();
     
     // Get default zone first in case we do not have zones defined
@@ -614,32 +683,27 @@ void View::GetDrawables()
             int priority = zone->GetPriority();
             if (priority > highestZonePriority_)
                 highestZonePriority_ = priority;
-            if (priority > bestPriority && zone->IsInside(cameraPos))
-            {
-                cameraZone_ = zone;
-                bestPriority = priority;
-            }
         }
         else
             occluders_.Push(drawable);
     }
     
+    // Index the zones for the camera and drawable zone lookups
+    zoneIndex_.Define(zones_);
+    numZoneLookups_ = 1;
+    Zone* zone = zoneIndex_.FindZone(cameraPos);
+    if (zone)
+        cameraZone_ = zone;
+    
     // Determine the zone at far clip distance. If not found, or camera zone has override mode, use camera zone
     cameraZoneOverride_ = cameraZone_->GetOverride();
     if (!cameraZoneOverride_)
     {
         Vector3 farClipPos = cameraPos + cameraNode_->GetWorldDirection() * Vector3(0.0f, 0.0f, camera_->GetFarClip());
-        bestPriority = M_MIN_INT;
-        
-        for (PODVector<Zone*>::Iterator i = zones_.Begin(); i != zones_.End(); ++i)
-        {
-            int priority = (*i)->GetPriority();
-            if (priority > bestPriority && (*i)->IsInside(farClipPos))
-            {
-                farClipZone_ = *i;
-                bestPriority = priority;
-            }
-        }
+        ++numZoneLookups_;
+        zone = zoneIndex_.FindZone(farClipPos);
+        if (zone)
+            farClipZone_ = zone;
     }
     if (farClipZone_ == defaultZone)
         farClipZone_ = cameraZone_;
@@ -679,35 +743,29 @@ void View::GetDrawables()
             PerThreadSceneResult& result = sceneResults_[i];
             
             result.geometries_.Clear();
+            result.threadedGeometries_.Clear();
             result.lights_.Clear();
             result.minZ_ = M_INFINITY;
             result.maxZ_ = 0.0f;
+            result.numZoneLookups_ = 0;
         }
         
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = tempDrawables.Size() / numWorkItems;
+        SharedPtr<WorkItem> visibilityItem = queue->ParallelFor(tempDrawables, 0, CheckVisibilityWork, this);
         
-        PODVector<Drawable*>::Iterator start = tempDrawables.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
+        // Chain the worker thread geometry updates of the visible geometries to start as soon as the visibility checks
+        // finish. They do not depend on lights or batches, so they proceed in the background until the end of GetBatches()
+        for (unsigned i = 0; i < sceneResults_.Size(); ++i)
         {
             SharedPtr<WorkItem> item = queue->GetFreeItem();
             item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckVisibilityWork;
+            item->workFunction_ = UpdateVisibleGeometriesWork;
+            item->start_ = &sceneResults_[i];
             item->aux_ = this;
-
-            PODVector<Drawable*>::Iterator end = tempDrawables.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-            
-            item->start_ = &(*start);
-            item->end_ = &(*end);
+            item->dependencies_.Push(visibilityItem);
             queue->AddWorkItem(item);
-            
-            start = end;
         }
         
-        queue->Complete(M_MAX_UNSIGNED);
+        queue->CompleteItem(visibilityItem);
     }
     
     // Combine lights, geometries & scene Z range from the threads
@@ -725,6 +783,7 @@ void View::GetDrawables()
             lights_.Push(result.lights_);
             minZ_ = Min(minZ_, result.minZ_);
             maxZ_ = Max(maxZ_, result.maxZ_);
+            numZoneLookups_ += result.numZoneLookups_;
         }
     }
     else
@@ -733,6 +792,7 @@ void View::GetDrawables()
         PerThreadSceneResult& result = sceneResults_[0];
         minZ_ = result.minZ_;
         maxZ_ = result.maxZ_;
+        numZoneLookups_ += result.numZoneLookups_;
         Swap(geometries_, result.geometries_);
         Swap(lights_, result.lights_);
     }
@@ -753,8 +813,9 @@ void View::GetDrawables()
 
 void View::GetBatches()
 {
+    PROFILE(GetBatches);
+    
     WorkQueue* queue = GetSubsystem<WorkQueue>();
-    PODVector<Light*> vertexLights;
     BatchQueue* alphaQueue = batchQueues_.Contains(alphaPassName_) ? &batchQueues_[alphaPassName_] : (BatchQueue*)0;
     
     // Process lit geometries and shadow casters for each light
@@ -762,23 +823,13 @@ void View::GetBatches()
         PROFILE(ProcessLights);
         
         lightQueryResults_.Resize(lights_.Size());
-        
         for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = ProcessLightWork;
-            item->aux_ = this;
-
-            LightQueryResult& query = lightQueryResults_[i];
-            query.light_ = lights_[i];
-            
-            item->start_ = &query;
-            queue->AddWorkItem(item);
-        }
+            lightQueryResults_[i].light_ = lights_[i];
         
-        // Ensure all lights have been processed before proceeding
-        queue->Complete(M_MAX_UNSIGNED);
+        // Ensure all lights have been processed before proceeding. The geometry updates may still continue
+        SharedPtr<WorkItem> lightsItem = queue->ParallelFor(lightQueryResults_.Begin().ptr_, lightQueryResults_.End().ptr_, 1,
+            ProcessLightWork, this);
+        queue->CompleteItem(lightsItem);
     }
     
     // Build light queues and lit batches
@@ -818,8 +869,8 @@ void View::GetBatches()
                 light->SetLightQueue(&lightQueue);
                 lightQueue.light_ = light;
                 lightQueue.shadowMap_ = 0;
-                lightQueue.litBaseBatches_.Clear(maxSortedInstances);
-                lightQueue.litBatches_.Clear(maxSortedInstances);
+                lightQueue.litBaseBatches_.Clear(maxSortedInstances, frameArena_);
+                lightQueue.litBatches_.Clear(maxSortedInstances, frameArena_);
                 lightQueue.volumeBatches_.Clear();
                 
                 // Allocate shadow map now
@@ -840,7 +891,7 @@ void View::GetBatches()
                     shadowQueue.shadowCamera_ = shadowCamera;
                     shadowQueue.nearSplit_ = query.shadowNearSplits_[j];
                     shadowQueue.farSplit_ = query.shadowFarSplits_[j];
-                    shadowQueue.shadowBatches_.Clear(maxSortedInstances);
+                    shadowQueue.shadowBatches_.Clear(maxSortedInstances, frameArena_);
                     
                     // Setup the shadow split viewport and finalize shadow camera parameters
                     shadowQueue.shadowViewport_ = GetShadowMapViewport(light, j, lightQueue.shadowMap_);
@@ -953,94 +1004,235 @@ void View::GetBatches()
         }
     }
     
+    // Start the worker thread geometry updates of the shadow casters outside the view. The list is not needed again until
+    // UpdateGeometries(), by which time the updates have finished
+    threadedGeometries_.Clear();
+    for (PODVector<Drawable*>::ConstIterator i = shadowGeometries_.Begin(); i != shadowGeometries_.End(); ++i)
+    {
+        if ((*i)->GetUpdateGeometryType() == UPDATE_WORKER_THREAD)
+            threadedGeometries_.Push(*i);
+    }
+    queue->ParallelFor(threadedGeometries_, 0, UpdateDrawableGeometriesWork, const_cast<FrameInfo*>(&frame_));
+    
     // Build base pass batches
     {
         PROFILE(GetBaseBatches);
         
-        for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
+        FrameAllocator* frameAllocator = GetSubsystem<FrameAllocator>();
+        for (unsigned i = 0; i < batchResults_.Size(); ++i)
+            batchResults_[i].instanceArena_ = frameAllocator ? frameAllocator->GetArena(i) : 0;
+        
+        if (queue->GetNumThreads())
         {
-            Drawable* drawable = *i;
-            Zone* zone = GetZone(drawable);
-            const Vector<SourceBatch>& batches = drawable->GetBatches();
+            for (unsigned i = 0; i < batchResults_.Size(); ++i)
+            {
+                PerThreadBatchResult& result = batchResults_[i];
+                if (i)
+                {
+                    result.batchQueues_.Resize(scenePasses_.Size());
+                    for (unsigned j = 0; j < result.batchQueues_.Size(); ++j)
+                        result.batchQueues_[j].Clear(0, result.instanceArena_);
+                }
+                result.deferredBatches_.Clear();
+                result.deferredDrawables_.Clear();
+                result.auxViewMaterials_.Clear();
+            }
             
-            const PODVector<Light*>& drawableVertexLights = drawable->GetVertexLights();
-            if (!drawableVertexLights.Empty())
-                drawable->LimitVertexLights();
+            queue->CompleteItem(queue->ParallelFor(geometries_, 0, GetBaseBatchesWork, this));
             
-            for (unsigned j = 0; j < batches.Size(); ++j)
+            // Finish the work that had to be left to the main thread
+            for (unsigned i = 0; i < batchResults_.Size(); ++i)
             {
-                const SourceBatch& srcBatch = batches[j];
-                
-                // Check here if the material refers to a rendertarget texture with camera(s) attached
-                // Only check this for backbuffer views (null rendertarget)
-                if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
-                    CheckMaterialForAuxView(srcBatch.material_);
-                
-                Technique* tech = GetTechnique(drawable, srcBatch.material_);
-                if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
-                    continue;
+                PerThreadBatchResult& result = batchResults_[i];
                 
-                Batch destBatch(srcBatch);
-                destBatch.camera_ = camera_;
-                destBatch.zone_ = zone;
-                destBatch.isBase_ = true;
-                destBatch.pass_ = 0;
-                destBatch.lightMask_ = GetLightMask(drawable);
+                for (PODVector<Material*>::ConstIterator j = result.auxViewMaterials_.Begin(); j !=
+                    result.auxViewMaterials_.End(); ++j)
+                {
+                    if ((*j)->GetAuxViewFrameNumber() != frame_.frameNumber_)
+                        CheckMaterialForAuxView(*j);
+                }
+                for (PODVector<Drawable*>::ConstIterator j = result.deferredDrawables_.Begin(); j !=
+                    result.deferredDrawables_.End(); ++j)
+                    GetBaseBatches(*j, 0, false);
+                for (PODVector<DeferredBaseBatch>::Iterator j = result.deferredBatches_.Begin(); j !=
+                    result.deferredBatches_.End(); ++j)
+                    AddBatchToQueue(*j->queue_, j->batch_, j->tech_, j->allowInstancing_);
+            }
+            
+            MergeBaseBatches();
+        }
+        else
+        {
+            for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
+                GetBaseBatches(*i, 0, false);
+        }
+    }
+    
+    // Finish the geometry updates left running in the background, as the next view may use the same drawables
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+void View::GetBaseBatches(Drawable* drawable, unsigned threadIndex, bool threaded)
+{
+    PerThreadBatchResult& result = batchResults_[threadIndex];
+    PODVector<Light*>& vertexLights = result.vertexLights_;
+    
+    const PODVector<Light*>& drawableVertexLights = drawable->GetVertexLights();
+    if (drawableVertexLights.Size() > (unsigned)MAX_VERTEX_LIGHTS)
+    {
+        // Limiting the vertex lights writes to the lights' sort values, so it is left to the main thread
+        if (threaded)
+        {
+            result.deferredDrawables_.Push(drawable);
+            return;
+        }
+        
+        drawable->LimitVertexLights();
+    }
+    
+    Zone* zone = GetZone(drawable);
+    const Vector<SourceBatch>& batches = drawable->GetBatches();
+    
+    for (unsigned j = 0; j < batches.Size(); ++j)
+    {
+        const SourceBatch& srcBatch = batches[j];
+        
+        // Check here if the material refers to a rendertarget texture with camera(s) attached
+        // Only check this for backbuffer views (null rendertarget)
+        if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
+        {
+            if (!threaded)
+                CheckMaterialForAuxView(srcBatch.material_);
+            else if (result.auxViewMaterials_.Empty() || result.auxViewMaterials_.Back() != srcBatch.material_)
+                result.auxViewMaterials_.Push(srcBatch.material_);
+        }
+        
+        Technique* tech = GetTechnique(drawable, srcBatch.material_);
+        if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
+            continue;
+        
+        Batch destBatch(srcBatch);
+        destBatch.camera_ = camera_;
+        destBatch.zone_ = zone;
+        destBatch.isBase_ = true;
+        destBatch.pass_ = 0;
+        destBatch.lightMask_ = GetLightMask(drawable);
+        
+        // Check each of the scene passes
+        for (unsigned k = 0; k < scenePasses_.Size(); ++k)
+        {
+            ScenePassInfo& info = scenePasses_[k];
+            destBatch.pass_ = tech->GetPass(info.pass_);
+            if (!destBatch.pass_)
+                continue;
+            
+            // Skip forward base pass if the corresponding litbase pass already exists
+            if (info.pass_ == basePassName_ && j < 32 && drawable->HasBasePass(j))
+                continue;
+            
+            if (info.vertexLights_ && !drawableVertexLights.Empty())
+            {
+                // For a deferred opaque batch, check if the vertex lights include converted per-pixel lights, and remove
+                // them to prevent double-lighting
+                if (deferred_ && destBatch.pass_->GetBlendMode() == BLEND_REPLACE)
+                {
+                    vertexLights.Clear();
+                    for (unsigned i = 0; i < drawableVertexLights.Size(); ++i)
+                    {
+                        if (drawableVertexLights[i]->GetPerVertex())
+                            vertexLights.Push(drawableVertexLights[i]);
+                    }
+                }
+                else
+                    vertexLights = drawableVertexLights;
                 
-                // Check each of the scene passes
-                for (unsigned k = 0; k < scenePasses_.Size(); ++k)
+                if (!vertexLights.Empty())
                 {
-                    ScenePassInfo& info = scenePasses_[k];
-                    destBatch.pass_ = tech->GetPass(info.pass_);
-                    if (!destBatch.pass_)
-                        continue;
-                    
-                    // Skip forward base pass if the corresponding litbase pass already exists
-                    if (info.pass_ == basePassName_ && j < 32 && drawable->HasBasePass(j))
-                        continue;
-                    
-                    if (info.vertexLights_ && !drawableVertexLights.Empty())
+                    // Find a vertex light queue. If not found, create new
+                    unsigned long long hash = GetVertexLightQueueHash(vertexLights);
+                    MutexLock lock(vertexLightQueueMutex_);
+                    HashMap<unsigned long long, LightBatchQueue>::Iterator i = vertexLightQueues_.Find(hash);
+                    if (i == vertexLightQueues_.End())
                     {
-                        // For a deferred opaque batch, check if the vertex lights include converted per-pixel lights, and remove
-                        // them to prevent double-lighting
-                        if (deferred_ && destBatch.pass_->GetBlendMode() == BLEND_REPLACE)
-                        {
-                            vertexLights.Clear();
-                            for (unsigned i = 0; i < drawableVertexLights.Size(); ++i)
-                            {
-                                if (drawableVertexLights[i]->GetPerVertex())
-                                    vertexLights.Push(drawableVertexLights[i]);
-                            }
-                        }
-                        else
-                            vertexLights = drawableVertexLights;
-                        
-                        if (!vertexLights.Empty())
-                        {
-                            // Find a vertex light queue. If not found, create new
-                            unsigned long long hash = GetVertexLightQueueHash(vertexLights);
-                            HashMap<unsigned long long, LightBatchQueue>::Iterator i = vertexLightQueues_.Find(hash);
-                            if (i == vertexLightQueues_.End())
-                            {
-                                i = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
-                                i->second_.light_ = 0;
-                                i->second_.shadowMap_ = 0;
-                                i->second_.vertexLights_ = vertexLights;
-                            }
-                            
-                            destBatch.lightQueue_ = &(i->second_);
-                        }
+                        i = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
+                        i->second_.light_ = 0;
+                        i->second_.shadowMap_ = 0;
+                        i->second_.vertexLights_ = vertexLights;
                     }
-                    else
-                        destBatch.lightQueue_ = 0;
-                    
-                    bool allowInstancing = info.allowInstancing_;
-                    if (allowInstancing && info.markToStencil_ && destBatch.lightMask_ != (zone->GetLightMask() & 0xff))
-                        allowInstancing = false;
                     
-                    AddBatchToQueue(*info.batchQueue_, destBatch, tech, allowInstancing);
+                    destBatch.lightQueue_ = &(i->second_);
+                }
+            }
+            else
+                destBatch.lightQueue_ = 0;
+            
+            bool allowInstancing = info.allowInstancing_;
+            if (allowInstancing && info.markToStencil_ && destBatch.lightMask_ != (zone->GetLightMask() & 0xff))
+                allowInstancing = false;
+            
+            if (!threaded)
+                AddBatchToQueue(*info.batchQueue_, destBatch, tech, allowInstancing);
+            else if (!renderer_->ArePassShadersLoaded(destBatch.pass_))
+            {
+                // Shaders can only be loaded in the main thread
+                DeferredBaseBatch deferredBatch;
+                deferredBatch.batch_ = destBatch;
+                deferredBatch.tech_ = tech;
+                deferredBatch.queue_ = info.batchQueue_;
+                deferredBatch.allowInstancing_ = allowInstancing;
+                result.deferredBatches_.Push(deferredBatch);
+            }
+            else
+            {
+                // The main thread adds directly to the view's batch queues, worker threads to their own
+                BatchQueue& queue = threadIndex ? result.batchQueues_[k] : *info.batchQueue_;
+                AddBatchToQueue(queue, destBatch, tech, allowInstancing, true, result.instanceArena_);
+            }
+        }
+    }
+}
+
+void View::MergeBaseBatches()
+{
+    PROFILE(MergeBaseBatches);
+    
+    for (unsigned i = 1; i < batchResults_.Size(); ++i)
+    {
+        PerThreadBatchResult& result = batchResults_[i];
+        
+        for (unsigned j = 0; j < result.batchQueues_.Size(); ++j)
+        {
+            BatchQueue& srcQueue = result.batchQueues_[j];
+            BatchQueue& destQueue = *scenePasses_[j].batchQueue_;
+            
+            destQueue.batches_.Push(srcQueue.batches_);
+            
+            for (HashMap<BatchGroupKey, BatchGroup>::Iterator k = srcQueue.batchGroups_.Begin(); k !=
+                srcQueue.batchGroups_.End(); ++k)
+            {
+                BatchGroup& srcGroup = k->second_;
+                HashMap<BatchGroupKey, BatchGroup>::Iterator l = destQueue.batchGroups_.Find(k->first_);
+                if (l == destQueue.batchGroups_.End())
+                {
+                    // Copy only the batch state, as the instances are in the worker thread's arena
+                    l = destQueue.batchGroups_.Insert(MakePair(k->first_, BatchGroup(static_cast<const Batch&>(srcGroup))));
+                    l->second_.instances_.SetArena(frameArena_);
+                }
+                
+                BatchGroup& destGroup = l->second_;
+                int oldSize = destGroup.instances_.Size();
+                destGroup.instances_.Push(srcGroup.instances_);
+                // Convert to using instancing shaders when the combined instances reach the instancing limit
+                if (oldSize < minInstances_ && (int)destGroup.instances_.Size() >= minInstances_)
+                {
+                    destGroup.geometryType_ = GEOM_INSTANCED;
+                    renderer_->SetBatchShaders(destGroup, GetPassTechnique(destGroup.material_, destGroup.pass_));
+                    destGroup.CalculateSortKey();
                 }
             }
+            
+            // The worker thread's arena is reset at frame end, so do not keep the instances referenced
+            srcQueue.Clear(0);
         }
     }
 }
@@ -1068,6 +1260,7 @@ void View::UpdateGeometries()
                 item->priority_ = M_MAX_UNSIGNED;
                 item->workFunction_ = command.sortMode_ == SORT_FRONTTOBACK ? SortBatchQueueFrontToBackWork : SortBatchQueueBackToFrontWork;
                 item->start_ = &batchQueues_[command.pass_];
+                item->aux_ = this;
                 queue->AddWorkItem(item);
             }
         }
@@ -1078,6 +1271,7 @@ void View::UpdateGeometries()
             lightItem->priority_ = M_MAX_UNSIGNED;
             lightItem->workFunction_ = SortLightQueueWork;
             lightItem->start_ = &(*i);
+            lightItem->aux_ = this;
             queue->AddWorkItem(lightItem);
 
             if (i->shadowSplits_.Size())
@@ -1086,6 +1280,7 @@ void View::UpdateGeometries()
                 shadowItem->priority_ = M_MAX_UNSIGNED;
                 shadowItem->workFunction_ = SortShadowQueueWork;
                 shadowItem->start_ = &(*i);
+                shadowItem->aux_ = this;
                 queue->AddWorkItem(shadowItem);
             }
         }
@@ -1113,31 +1308,10 @@ void View::UpdateGeometries()
                 threadedGeometries_.Push(*i);
         }
         
-        if (threadedGeometries_.Size())
-        {
-            int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-            int drawablesPerItem = threadedGeometries_.Size() / numWorkItems;
-            
-            PODVector<Drawable*>::Iterator start = threadedGeometries_.Begin();
-            for (int i = 0; i < numWorkItems; ++i)
-            {
-                PODVector<Drawable*>::Iterator end = threadedGeometries_.End();
-                if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                    end = start + drawablesPerItem;
-                
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ = UpdateDrawableGeometriesWork;
-                item->aux_ = const_cast<FrameInfo*>(&frame_);
-                item->start_ = &(*start);
-                item->end_ = &(*end);
-                queue->AddWorkItem(item);
-                
-                start = end;
-            }
-        }
+        queue->ParallelFor(threadedGeometries_, 0, UpdateDrawableGeometriesWork, const_cast<FrameInfo*>(&frame_));
         
         // While the work queue is processed, update non-threaded geometries
+        PROFILE(UpdateGeometries);
         for (PODVector<Drawable*>::ConstIterator i = nonThreadedGeometries_.Begin(); i != nonThreadedGeometries_.End(); ++i)
             (*i)->UpdateGeometry(frame_);
     }
@@ -1922,12 +2096,20 @@ void View::UpdateOccluders(PODVector<Drawable*>& occluders, Camera* camera)
 void View::DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& occluders)
 {
     buffer->SetMaxTriangles(maxOccluderTriangles_);
-    buffer->Clear();
+    
+    // If possible, reproject the previous frame's depth so that only the occluders not yet in it need to be drawn
+    unsigned reprojectionFrames = renderer_->GetOcclusionReprojectionFrames();
+    bool reprojected = reprojectionFrames && buffer->Reproject(reprojectionFrames, renderer_->GetOcclusionReprojectionDistance(),
+        renderer_->GetOcclusionReprojectionAngle());
+    if (!reprojected)
+        buffer->Clear();
     
     for (unsigned i = 0; i < occluders.Size(); ++i)
     {
         Drawable* occluder = occluders[i];
-        if (i > 0)
+        if (reprojected && buffer->IsOccluderDrawn(occluder))
+            continue;
+        if (i > 0 || reprojected)
         {
             // For subsequent occluders, do a test against the pixel-level occlusion buffer to see if rendering is necessary
             if (!buffer->IsVisible(occluder->GetWorldBoundingBox()))
@@ -1935,8 +2117,15 @@ void View::DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& oc
         }
         
         // Check for running out of triangles
-        if (!occluder->DrawOcclusion(buffer))
+        bool complete = occluder->DrawOcclusion(buffer);
+        if (reprojectionFrames)
+            buffer->AddDrawnOccluder(occluder, complete);
+        if (!complete)
             break;
+        
+        // Rasterize the pending triangles in a few batches so that the occluders drawn so far can occlude the rest
+        if (buffer->GetNumPendingTriangles() * 4 >= (unsigned)maxOccluderTriangles_)
+            buffer->RasterizeTriangles();
     }
     
     buffer->BuildDepthHierarchy();
@@ -1960,7 +2149,7 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
     #endif
     // Get lit geometries. They must match the light mask and be inside the main camera frustum to be considered
     PODVector<Drawable*>& tempDrawables = tempDrawables_[threadIndex];
-    query.litGeometries_.Clear();
+    query.litGeometries_.ResetArena(tempDrawables.GetArena());
     
     switch (type)
     {
@@ -2009,7 +2198,7 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
     SetupShadowCameras(query);
     
     // Process each split for shadow casters
-    query.shadowCasters_.Clear();
+    query.shadowCasters_.ResetArena(tempDrawables.GetArena());
     for (unsigned i = 0; i < query.numSplits_; ++i)
     {
         Camera* shadowCamera = query.shadowCameras_[i];
@@ -2448,10 +2637,9 @@ void View::QuantizeDirLightShadowCamera(Camera* shadowCamera, Light* light, cons
     }
 }
 
-void View::FindZone(Drawable* drawable)
+void View::FindZone(Drawable* drawable, unsigned threadIndex)
 {
     Vector3 center = drawable->GetWorldBoundingBox().Center();
-    int bestPriority = M_MIN_INT;
     Zone* newZone = 0;
     
     // If bounding box center is in view, the zone assignment is conclusive also for next frames. Otherwise it is temporary
@@ -2466,16 +2654,8 @@ void View::FindZone(Drawable* drawable)
         newZone = lastZone;
     else
     {
-        for (PODVector<Zone*>::Iterator i = zones_.Begin(); i != zones_.End(); ++i)
-        {
-            Zone* zone = *i;
-            int priority = zone->GetPriority();
-            if (priority > bestPriority && (drawable->GetZoneMask() & zone->GetZoneMask()) && zone->IsInside(center))
-            {
-                newZone = zone;
-                bestPriority = priority;
-            }
-        }
+        newZone = zoneIndex_.FindZone(center, drawable->GetZoneMask());
+        ++sceneResults_[threadIndex].numZoneLookups_;
     }
     
     drawable->SetZone(newZone, temporary);
@@ -2552,7 +2732,8 @@ void View::CheckMaterialForAuxView(Material* material)
     material->MarkForAuxView(frame_.frameNumber_);
 }
 
-void View::AddBatchToQueue(BatchQueue& batchQueue, Batch& batch, Technique* tech, bool allowInstancing, bool allowShadows)
+void View::AddBatchToQueue(BatchQueue& batchQueue, Batch& batch, Technique* tech, bool allowInstancing, bool allowShadows,
+    ArenaAllocator* instanceArena)
 {
     if (!batch.material_)
         batch.material_ = renderer_->GetDefaultMaterial();
@@ -2575,6 +2756,7 @@ void View::AddBatchToQueue(BatchQueue& batchQueue, Batch& batch, Technique* tech
             renderer_->SetBatchShaders(newGroup, tech, allowShadows);
             newGroup.CalculateSortKey();
             i = batchQueue.batchGroups_.Insert(MakePair(key, newGroup));
+            i->second_.instances_.SetArena(instanceArena ? instanceArena : frameArena_);
         }
 
         int oldSize = i->second_.instances_.Size();
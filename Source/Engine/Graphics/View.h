@@ -25,13 +25,16 @@
 #include "Batch.h"
 #include "HashSet.h"
 #include "List.h"
+#include "Mutex.h"
 #include "Object.h"
 #include "Polyhedron.h"
 #include "Zone.h"
+#include "ZoneIndex.h"
 
 namespace Urho3D
 {
 
+class ArenaAllocator;
 class Camera;
 class DebugRenderer;
 class Light;
@@ -94,12 +97,46 @@ struct PerThreadSceneResult
 {
     /// Geometry objects.
     PODVector<Drawable*> geometries_;
+    /// Geometry objects that need a geometry update in a worker thread.
+    PODVector<Drawable*> threadedGeometries_;
     /// Lights.
     PODVector<Light*> lights_;
     /// Scene minimum Z value.
     float minZ_;
     /// Scene maximum Z value.
     float maxZ_;
+    /// Number of zone index queries.
+    unsigned numZoneLookups_;
+};
+
+/// Base pass batch that a worker thread could not add to its queue, because the pass shaders need to be loaded first.
+struct DeferredBaseBatch
+{
+    /// Batch.
+    Batch batch_;
+    /// Technique of the batch's material.
+    Technique* tech_;
+    /// Destination batch queue.
+    BatchQueue* queue_;
+    /// Allow instancing flag.
+    bool allowInstancing_;
+};
+
+/// Per-thread base pass batch collection structure.
+struct PerThreadBatchResult
+{
+    /// Batch queues for each scene pass. Not used by the main thread, which adds directly to the view's batch queues.
+    Vector<BatchQueue> batchQueues_;
+    /// Batches that need to be added in the main thread.
+    PODVector<DeferredBaseBatch> deferredBatches_;
+    /// Drawables that need to be processed in the main thread.
+    PODVector<Drawable*> deferredDrawables_;
+    /// Materials that need to be checked for auxiliary views in the main thread.
+    PODVector<Material*> auxViewMaterials_;
+    /// Vertex light collection work vector.
+    PODVector<Light*> vertexLights_;
+    /// Arena for batch group instances.
+    ArenaAllocator* instanceArena_;
 };
 
 static const unsigned MAX_VIEWPORT_TEXTURES = 2;
@@ -109,6 +146,8 @@ class URHO3D_API View : public Object
 {
     friend void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex);
     friend void ProcessLightWork(const WorkItem* item, unsigned threadIndex);
+    friend void UpdateVisibleGeometriesWork(const WorkItem* item, unsigned threadIndex);
+    friend void GetBaseBatchesWork(const WorkItem* item, unsigned threadIndex);
     
     OBJECT(View);
     
@@ -145,6 +184,8 @@ public:
     const PODVector<Light*>& GetLights() const { return lights_; }
     /// Return light batch queues.
     const Vector<LightBatchQueue>& GetLightQueues() const { return lightQueues_; }
+    /// Return number of zone lookups on the last frame.
+    unsigned GetNumZoneLookups() const { return numZoneLookups_; }
     
 private:
     /// Query the octree for drawable objects.
@@ -198,13 +239,17 @@ private:
     /// Return the viewport for a shadow map split.
     IntRect GetShadowMapViewport(Light* light, unsigned splitIndex, Texture2D* shadowMap);
     /// Find and set a new zone for a drawable when it has moved.
-    void FindZone(Drawable* drawable);
+    void FindZone(Drawable* drawable, unsigned threadIndex);
     /// Return material technique, considering the drawable's LOD distance.
     Technique* GetTechnique(Drawable* drawable, Material* material);
     /// Check if material should render an auxiliary view (if it has a camera attached.)
     void CheckMaterialForAuxView(Material* material);
-    /// Choose shaders for a batch and add it to queue.
-    void AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing = true, bool allowShadows = true);
+    /// Get base pass batches of a drawable. When threaded, defer the work that must happen in the main thread.
+    void GetBaseBatches(Drawable* drawable, unsigned threadIndex, bool threaded);
+    /// Merge the worker threads' base pass batch queues into the view's batch queues.
+    void MergeBaseBatches();
+    /// Choose shaders for a batch and add it to queue. Batch group instances are allocated from the frame arena if no arena is specified.
+    void AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing = true, bool allowShadows = true, ArenaAllocator* instanceArena = 0);
     /// Prepare instancing buffer by filling it with all instance transforms.
     void PrepareInstancingBuffer();
     /// Set up a light volume rendering batch.
@@ -248,6 +293,8 @@ private:
     WeakPtr<Graphics> graphics_;
     /// Renderer subsystem.
     WeakPtr<Renderer> renderer_;
+    /// Main thread's frame arena for transient data, or null if not available.
+    ArenaAllocator* frameArena_;
     /// Scene to use.
     Scene* scene_;
     /// Octree to use.
@@ -292,6 +339,8 @@ private:
     int minInstances_;
     /// Highest zone priority currently visible.
     int highestZonePriority_;
+    /// Number of zone lookups on the last frame.
+    unsigned numZoneLookups_;
     /// Camera zone's override flag.
     bool cameraZoneOverride_;
     /// Draw shadows flag.
@@ -308,8 +357,12 @@ private:
     Vector<PODVector<Drawable*> > tempDrawables_;
     /// Per-thread geometries, lights and Z range collection results.
     Vector<PerThreadSceneResult> sceneResults_;
+    /// Per-thread base pass batch collection results.
+    Vector<PerThreadBatchResult> batchResults_;
     /// Visible zones.
     PODVector<Zone*> zones_;
+    /// Spatial index of the visible zones.
+    ZoneIndex zoneIndex_;
     /// Visible geometry objects.
     PODVector<Drawable*> geometries_;
     /// Geometry objects visible in shadow maps.
@@ -334,6 +387,8 @@ private:
     Vector<LightBatchQueue> lightQueues_;
     /// Per-vertex light queues.
     HashMap<unsigned long long, LightBatchQueue> vertexLightQueues_;
+    /// Mutex for creating vertex light queues from worker threads.
+    Mutex vertexLightQueueMutex_;
     /// Batch queues.
     HashMap<StringHash, BatchQueue> batchQueues_;
     /// Hash of the GBuffer pass, or null if none.
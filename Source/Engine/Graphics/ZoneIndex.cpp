@@ -0,0 +1,178 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Node.h"
+#include "Sort.h"
+#include "Zone.h"
+#include "ZoneIndex.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned MAX_LEAF_ZONES = 4;
+static const unsigned MAX_TRAVERSAL_DEPTH = 64;
+
+static inline bool CompareEntryX(const ZoneIndexEntry& lhs, const ZoneIndexEntry& rhs)
+{
+    return lhs.box_.min_.x_ + lhs.box_.max_.x_ < rhs.box_.min_.x_ + rhs.box_.max_.x_;
+}
+
+static inline bool CompareEntryY(const ZoneIndexEntry& lhs, const ZoneIndexEntry& rhs)
+{
+    return lhs.box_.min_.y_ + lhs.box_.max_.y_ < rhs.box_.min_.y_ + rhs.box_.max_.y_;
+}
+
+static inline bool CompareEntryZ(const ZoneIndexEntry& lhs, const ZoneIndexEntry& rhs)
+{
+    return lhs.box_.min_.z_ + lhs.box_.max_.z_ < rhs.box_.min_.z_ + rhs.box_.max_.z_;
+}
+
+static inline bool CompareEntryPriority(const ZoneIndexEntry& lhs, const ZoneIndexEntry& rhs)
+{
+    return lhs.priority_ != rhs.priority_ ? lhs.priority_ > rhs.priority_ : lhs.index_ < rhs.index_;
+}
+
+ZoneIndex::ZoneIndex()
+{
+}
+
+void ZoneIndex::Define(const PODVector<Zone*>& zones)
+{
+    Clear();
+    
+    entries_.Resize(zones.Size());
+    for (unsigned i = 0; i < zones.Size(); ++i)
+    {
+        Zone* zone = zones[i];
+        ZoneIndexEntry& entry = entries_[i];
+        entry.box_ = zone->GetWorldBoundingBox();
+        entry.zone_ = zone;
+        entry.priority_ = zone->GetPriority();
+        entry.zoneMask_ = zone->GetZoneMask();
+        entry.index_ = i;
+        // Update the inverse transform now, so that the point tests do not modify the zone during threaded queries
+        zone->GetInverseWorldTransform();
+    }
+    
+    if (entries_.Size())
+        BuildNode(0, entries_.Size());
+}
+
+void ZoneIndex::Clear()
+{
+    entries_.Clear();
+    nodes_.Clear();
+}
+
+Zone* ZoneIndex::Query(const Vector3& point, unsigned zoneMask, bool checkZoneMask) const
+{
+    if (nodes_.Empty())
+        return 0;
+    
+    const ZoneIndexEntry* best = 0;
+    unsigned stack[MAX_TRAVERSAL_DEPTH];
+    unsigned stackSize = 0;
+    stack[stackSize++] = 0;
+    
+    while (stackSize)
+    {
+        unsigned nodeIndex = stack[--stackSize];
+        const ZoneIndexNode& node = nodes_[nodeIndex];
+        // Skip subtrees that can not contain a better zone
+        if ((best && node.maxPriority_ < best->priority_) || node.box_.IsInside(point) == OUTSIDE)
+            continue;
+        
+        if (node.count_)
+        {
+            // The leaf entries are sorted by priority, so the first zone that contains the point is the best of the leaf
+            for (unsigned i = node.start_; i < node.start_ + node.count_; ++i)
+            {
+                const ZoneIndexEntry& entry = entries_[i];
+                if (best && !CompareEntryPriority(entry, *best))
+                    break;
+                if ((!checkZoneMask || (entry.zoneMask_ & zoneMask)) && entry.box_.IsInside(point) != OUTSIDE && entry.zone_->IsInside(point))
+                {
+                    best = &entry;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            stack[stackSize++] = node.secondChild_;
+            stack[stackSize++] = nodeIndex + 1;
+        }
+    }
+    
+    return best ? best->zone_ : 0;
+}
+
+void ZoneIndex::BuildNode(unsigned start, unsigned end)
+{
+    unsigned nodeIndex = nodes_.Size();
+    nodes_.Resize(nodeIndex + 1);
+    
+    BoundingBox box;
+    BoundingBox centerBox;
+    int maxPriority = M_MIN_INT;
+    for (unsigned i = start; i < end; ++i)
+    {
+        const ZoneIndexEntry& entry = entries_[i];
+        box.Merge(entry.box_);
+        centerBox.Merge(entry.box_.Center());
+        maxPriority = Max(maxPriority, entry.priority_);
+    }
+    
+    ZoneIndexNode& node = nodes_[nodeIndex];
+    node.box_ = box;
+    node.maxPriority_ = maxPriority;
+    node.secondChild_ = 0;
+    node.start_ = start;
+    
+    if (end - start <= MAX_LEAF_ZONES)
+    {
+        node.count_ = end - start;
+        Sort(entries_.Begin() + start, entries_.Begin() + end, CompareEntryPriority);
+        return;
+    }
+    
+    // Split at the median of the zone centers along the longest axis
+    node.count_ = 0;
+    Vector3 size = centerBox.Size();
+    if (size.x_ >= size.y_ && size.x_ >= size.z_)
+        Sort(entries_.Begin() + start, entries_.Begin() + end, CompareEntryX);
+    else if (size.y_ >= size.z_)
+        Sort(entries_.Begin() + start, entries_.Begin() + end, CompareEntryY);
+    else
+        Sort(entries_.Begin() + start, entries_.Begin() + end, CompareEntryZ);
+    
+    unsigned middle = (start + end) / 2;
+    BuildNode(start, middle);
+    // The node vector may have been reallocated, so do not use the node reference anymore
+    nodes_[nodeIndex].secondChild_ = nodes_.Size();
+    BuildNode(middle, end);
+}
+
+}
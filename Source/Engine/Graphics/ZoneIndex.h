@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "BoundingBox.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+class Zone;
+
+/// %Zone entry in the zone index.
+struct ZoneIndexEntry
+{
+    /// World bounding box.
+    BoundingBox box_;
+    /// Zone.
+    Zone* zone_;
+    /// Priority.
+    int priority_;
+    /// Zone mask.
+    unsigned zoneMask_;
+    /// Index in the original zone order.
+    unsigned index_;
+};
+
+/// %Zone index tree node.
+struct ZoneIndexNode
+{
+    /// Bounding box of the zones in the subtree.
+    BoundingBox box_;
+    /// Highest zone priority in the subtree.
+    int maxPriority_;
+    /// Second child node index. The first child is the next node. Used only by inner nodes.
+    unsigned secondChild_;
+    /// First zone entry index.
+    unsigned start_;
+    /// Number of zone entries. Zero for inner nodes.
+    unsigned count_;
+};
+
+/// Bounding volume hierarchy of zone bounding boxes for fast point queries.
+class URHO3D_API ZoneIndex
+{
+public:
+    /// Construct.
+    ZoneIndex();
+    
+    /// Build the index from zones. Should be called from the main thread, as the zones' bounding boxes and transforms are updated.
+    void Define(const PODVector<Zone*>& zones);
+    /// Remove all zones.
+    void Clear();
+    
+    /// Return the highest priority zone that contains a point, or null if none. Of equal priority zones, the one defined first is returned. Is thread-safe.
+    Zone* FindZone(const Vector3& point) const { return Query(point, 0, false); }
+    /// Return the highest priority zone that contains a point and has a matching zone mask, or null if none. Of equal priority zones, the one defined first is returned. Is thread-safe.
+    Zone* FindZone(const Vector3& point, unsigned zoneMask) const { return Query(point, zoneMask, true); }
+    /// Return number of zones.
+    unsigned GetNumZones() const { return entries_.Size(); }
+    
+private:
+    /// Build a subtree from a range of zone entries.
+    void BuildNode(unsigned start, unsigned end);
+    /// Find the highest priority zone that contains a point, optionally checking the zone mask.
+    Zone* Query(const Vector3& point, unsigned zoneMask, bool checkZoneMask) const;
+    
+    /// Zone entries, ordered by the tree leaves.
+    PODVector<ZoneIndexEntry> entries_;
+    /// Tree nodes. The first node is the root.
+    PODVector<ZoneIndexNode> nodes_;
+};
+
+}
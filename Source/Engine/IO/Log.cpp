@@ -21,16 +21,26 @@
 //
 
 #include "Precompiled.h"
+#include "Atomic.h"
 #include "Context.h"
+#include "CoreEvents.h"
 #include "File.h"
 #include "IOEvents.h"
 #include "Log.h"
-#include "Mutex.h"
 #include "ProcessUtils.h"
+#include "Thread.h"
 #include "Timer.h"
 
+#include <csignal>
 #include <cstdio>
 
+#ifdef WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
 #ifdef ANDROID
 #include <android/log.h>
 #endif
@@ -53,6 +63,157 @@ const char* logLevelPrefixes[] =
 };
 
 static Log* logInstance = 0;
+static bool crashHandlerInstalled = false;
+
+/// Formatted log message waiting to be printed.
+struct LogRecord
+{
+    /// Next older record.
+    LogRecord* next_;
+    /// Message.
+    String message_;
+    /// Message with the level prefix and timestamp.
+    String formattedMessage_;
+    /// Message level.
+    int level_;
+    /// Raw output flag.
+    bool raw_;
+    /// Error output flag.
+    bool error_;
+    /// Logged outside the main thread flag. The log event is sent later in the main thread.
+    bool threadMessage_;
+};
+
+/// Background thread for printing log messages and writing them to the log file.
+class LogWriter : public Thread
+{
+public:
+    /// Construct.
+    LogWriter(Log* log) :
+        log_(log)
+    {
+    }
+    
+    /// Write messages in batches until stopped, then write the remaining messages.
+    virtual void ThreadFunction()
+    {
+        while (shouldRun_)
+        {
+            if (!log_->WriteRecords())
+                Time::Sleep(1);
+        }
+        
+        log_->WriteRecords();
+    }
+    
+private:
+    /// Log subsystem.
+    Log* log_;
+};
+
+/// Write data to a file descriptor using only async-signal-safe calls.
+static void WriteOnCrash(int fd, const char* data, unsigned length)
+{
+    while (length)
+    {
+        #ifdef WIN32
+        int written = _write(fd, data, length);
+        #else
+        ssize_t written = write(fd, data, length);
+        if (written < 0 && errno == EINTR)
+            continue;
+        #endif
+        if (written <= 0)
+            return;
+        data += written;
+        length -= written;
+    }
+}
+
+#ifdef WIN32
+static LPTOP_LEVEL_EXCEPTION_FILTER previousExceptionFilter = 0;
+static void (*previousAbortHandler)(int) = SIG_DFL;
+
+static LONG WINAPI HandleCrashException(EXCEPTION_POINTERS* exceptionInfo)
+{
+    Log::FlushOnCrash();
+    return previousExceptionFilter ? previousExceptionFilter(exceptionInfo) : EXCEPTION_CONTINUE_SEARCH;
+}
+
+static void HandleCrashSignal(int signalNumber)
+{
+    Log::FlushOnCrash();
+    
+    // Chain to the previous handler, or let the default handler terminate the process
+    if (previousAbortHandler != SIG_DFL && previousAbortHandler != SIG_IGN && previousAbortHandler != SIG_ERR)
+        previousAbortHandler(signalNumber);
+    else
+    {
+        signal(signalNumber, SIG_DFL);
+        raise(signalNumber);
+    }
+}
+#else
+static const int crashSignals[] =
+{
+    SIGSEGV,
+    SIGBUS,
+    SIGILL,
+    SIGFPE,
+    SIGABRT
+};
+static const unsigned NUM_CRASH_SIGNALS = sizeof crashSignals / sizeof crashSignals[0];
+static struct sigaction previousCrashActions[NUM_CRASH_SIGNALS];
+
+static void HandleCrashSignal(int signalNumber, siginfo_t* info, void* context)
+{
+    Log::FlushOnCrash();
+    
+    for (unsigned i = 0; i < NUM_CRASH_SIGNALS; ++i)
+    {
+        if (crashSignals[i] != signalNumber)
+            continue;
+        
+        // Chain to the previous handler. If there was none, install the default action and raise again to terminate. An
+        // ignored fault signal is not restored, as the faulting instruction would then execute again in an endless loop
+        const struct sigaction& previous = previousCrashActions[i];
+        if (previous.sa_flags & SA_SIGINFO)
+            previous.sa_sigaction(signalNumber, info, context);
+        else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN)
+            previous.sa_handler(signalNumber);
+        else
+        {
+            struct sigaction defaultAction;
+            defaultAction.sa_handler = SIG_DFL;
+            sigemptyset(&defaultAction.sa_mask);
+            defaultAction.sa_flags = 0;
+            sigaction(signalNumber, &defaultAction, 0);
+            raise(signalNumber);
+        }
+        break;
+    }
+}
+#endif
+
+static void InstallCrashHandler()
+{
+    if (crashHandlerInstalled)
+        return;
+    
+    #ifdef WIN32
+    previousExceptionFilter = SetUnhandledExceptionFilter(HandleCrashException);
+    previousAbortHandler = signal(SIGABRT, HandleCrashSignal);
+    #else
+    struct sigaction action;
+    action.sa_sigaction = HandleCrashSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO;
+    for (unsigned i = 0; i < NUM_CRASH_SIGNALS; ++i)
+        sigaction(crashSignals[i], &action, &previousCrashActions[i]);
+    #endif
+    
+    crashHandlerInstalled = true;
+}
 
 Log::Log(Context* context) :
     Object(context),
@@ -63,13 +224,27 @@ Log::Log(Context* context) :
 #endif
     timeStamp_(true),
     inWrite_(false),
-    quiet_(false)
+    quiet_(false),
+    crashFileDescriptor_(-1),
+    writer_(0),
+    records_(0),
+    recordPool_(sizeof(LogRecord)),
+    recordAllocator_(&recordPool_)
 {
     logInstance = this;
+    
+    SubscribeToEvent(E_ENDFRAME, HANDLER(Log, HandleEndFrame));
 }
 
 Log::~Log()
 {
+    // Write the remaining messages, but do not send events for them anymore
+    SetAsync(false);
+    WriteRecords();
+    for (unsigned i = 0; i < eventRecords_.Size(); ++i)
+        recordAllocator_.Free(eventRecords_[i]);
+    eventRecords_.Clear();
+    
     logInstance = 0;
 }
 
@@ -86,22 +261,35 @@ void Log::Open(const String& fileName)
             Close();
     }
 
-    logFile_ = new File(context_);
-    if (logFile_->Open(fileName, FILE_WRITE))
+    SharedPtr<File> newLogFile(new File(context_));
+    if (newLogFile->Open(fileName, FILE_WRITE))
+    {
+        {
+            MutexLock lock(outputMutex_);
+            logFile_ = newLogFile;
+            #ifdef WIN32
+            crashFileDescriptor_ = _fileno((FILE*)logFile_->GetHandle());
+            #else
+            crashFileDescriptor_ = fileno((FILE*)logFile_->GetHandle());
+            #endif
+        }
         Write(LOG_INFO, "Opened log file " + fileName);
+    }
     else
-    {
-        logFile_.Reset();
         Write(LOG_ERROR, "Failed to create log file " + fileName);
-    }
     #endif
 }
 
 void Log::Close()
 {
     #if !defined(ANDROID) && !defined(IOS)
+    // Write the pending messages to the file before closing it
+    WriteRecords();
+    
+    MutexLock lock(outputMutex_);
     if (logFile_ && logFile_->IsOpen())
     {
+        crashFileDescriptor_ = -1;
         logFile_->Close();
         logFile_.Reset();
     }
@@ -125,93 +313,274 @@ void Log::SetQuiet(bool quiet)
     quiet_ = quiet;
 }
 
+void Log::SetAsync(bool enable)
+{
+    if (enable == (writer_ != 0))
+        return;
+    
+    if (enable)
+    {
+        InstallCrashHandler();
+        writer_ = new LogWriter(this);
+        if (!writer_->Run())
+        {
+            delete writer_;
+            writer_ = 0;
+            Write(LOG_ERROR, "Failed to start asynchronous log writer thread");
+        }
+    }
+    else
+    {
+        // Stopping the thread writes the remaining messages
+        writer_->Stop();
+        delete writer_;
+        writer_ = 0;
+    }
+}
+
 void Log::Write(int level, const String& message)
 {
     assert(level >= LOG_DEBUG && level < LOG_NONE);
 
     // Do not log if message level excluded or if currently sending a log event
-    if (!logInstance || logInstance->level_ > level || logInstance->inWrite_)
+    if (!logInstance || logInstance->level_ > level)
+        return;
+    bool mainThread = Thread::IsMainThread();
+    if (mainThread && logInstance->inWrite_)
         return;
 
     String formattedMessage = logLevelPrefixes[level];
     formattedMessage += ": " + message;
-    logInstance->lastMessage_ = message;
 
     if (logInstance->timeStamp_)
         formattedMessage = "[" + Time::GetTimeStamp() + "] " + formattedMessage;
 
-    #if defined(ANDROID)
-    int androidLevel = ANDROID_LOG_DEBUG + level;
-    __android_log_print(androidLevel, "Urho3D", "%s", message.CString());
-    #elif defined(IOS)
-    SDL_IOS_LogMessage(message.CString());
-    #else
-    if (logInstance->quiet_)
+    // Outside the main thread, or if asynchronous, leave the output to the writer thread or the end of frame
+    if (!mainThread || logInstance->writer_)
+        logInstance->PushRecord(level, message, formattedMessage, false, level == LOG_ERROR);
+    else
     {
-        // If in quiet mode, still print the error message to the standard error stream
-        if (level == LOG_ERROR)
-            PrintUnicodeLine(formattedMessage, true);
+        MutexLock lock(logInstance->outputMutex_);
+        logInstance->Output(level, message, formattedMessage, false, level == LOG_ERROR);
+        if (logInstance->logFile_)
+            logInstance->logFile_->Flush();
     }
-    else
-        PrintUnicodeLine(formattedMessage, level == LOG_ERROR);
-    #endif
 
-    if (logInstance->logFile_)
+    if (mainThread)
+        logInstance->SendLogEvent(level, message, formattedMessage, false);
+}
+
+void Log::WriteRaw(const String& message, bool error)
+{
+    // Prevent recursion during log event
+    if (!logInstance)
+        return;
+    bool mainThread = Thread::IsMainThread();
+    if (mainThread && logInstance->inWrite_)
+        return;
+
+    if (!mainThread || logInstance->writer_)
+        logInstance->PushRecord(LOG_INFO, message, message, true, error);
+    else
     {
-        logInstance->logFile_->WriteLine(formattedMessage);
-        logInstance->logFile_->Flush();
+        MutexLock lock(logInstance->outputMutex_);
+        logInstance->Output(LOG_INFO, message, message, true, error);
+        if (logInstance->logFile_)
+            logInstance->logFile_->Flush();
     }
 
-    logInstance->inWrite_ = true;
+    if (mainThread)
+        logInstance->SendLogEvent(LOG_INFO, message, message, true);
+}
 
-    using namespace LogMessage;
+void Log::Flush()
+{
+    if (logInstance)
+        logInstance->WriteRecords();
+}
 
-    VariantMap& eventData = logInstance->GetEventDataMap();
-    eventData[P_MESSAGE] = formattedMessage;
-    eventData[P_LEVEL] = level;
-    logInstance->SendEvent(E_LOGMESSAGE, eventData);
+void Log::FlushOnCrash()
+{
+    if (logInstance)
+        logInstance->WriteRecordsOnCrash();
+}
+
+void Log::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    // If not asynchronous, print the messages from other threads now
+    if (!writer_)
+        WriteRecords();
 
-    logInstance->inWrite_ = false;
+    PODVector<LogRecord*> records;
+    {
+        MutexLock lock(eventMutex_);
+        records.Swap(eventRecords_);
+    }
+
+    for (unsigned i = 0; i < records.Size(); ++i)
+    {
+        LogRecord* record = records[i];
+        SendLogEvent(record->level_, record->message_, record->formattedMessage_, record->raw_);
+        recordAllocator_.Free(record);
+    }
 }
 
-void Log::WriteRaw(const String& message, bool error)
+void Log::PushRecord(int level, const String& message, const String& formattedMessage, bool raw, bool error)
 {
-    // Prevent recursion during log event
-    if (!logInstance || logInstance->inWrite_)
-        return;
+    LogRecord* record = recordAllocator_.Reserve();
+    record->message_ = message;
+    record->formattedMessage_ = formattedMessage;
+    record->level_ = level;
+    record->raw_ = raw;
+    record->error_ = error;
+    record->threadMessage_ = !Thread::IsMainThread();
+
+    // Lock-free push to the front of the list
+    for (;;)
+    {
+        void* head = records_;
+        record->next_ = static_cast<LogRecord*>(head);
+        if (AtomicCompareAndSwapPointer(&records_, head, record))
+            break;
+    }
+}
+
+unsigned Log::WriteRecords()
+{
+    // Take all pending records at once and reverse them to the order they were logged in
+    LogRecord* newest = static_cast<LogRecord*>(AtomicExchangePointer(&records_, 0));
+    if (!newest)
+        return 0;
+
+    LogRecord* oldest = 0;
+    while (newest)
+    {
+        LogRecord* next = newest->next_;
+        newest->next_ = oldest;
+        oldest = newest;
+        newest = next;
+    }
+
+    unsigned numRecords = 0;
+    {
+        MutexLock lock(outputMutex_);
+        for (LogRecord* record = oldest; record; record = record->next_)
+        {
+            Output(record->level_, record->message_, record->formattedMessage_, record->raw_, record->error_);
+            ++numRecords;
+        }
+        if (logFile_)
+            logFile_->Flush();
+    }
+
+    // Records from other threads still need their log event sent in the main thread
+    MutexLock lock(eventMutex_);
+    while (oldest)
+    {
+        LogRecord* next = oldest->next_;
+        if (oldest->threadMessage_)
+            eventRecords_.Push(oldest);
+        else
+            recordAllocator_.Free(oldest);
+        oldest = next;
+    }
+
+    return numRecords;
+}
 
-    logInstance->lastMessage_ = message;
+void Log::WriteRecordsOnCrash()
+{
+    // The crashed thread may be holding the mutexes or be inside the heap, so only write the already formatted messages
+    // with system calls. The records are left allocated
+    LogRecord* newest = static_cast<LogRecord*>(AtomicExchangePointer(&records_, 0));
+    LogRecord* oldest = 0;
+    while (newest)
+    {
+        LogRecord* next = newest->next_;
+        newest->next_ = oldest;
+        oldest = newest;
+        newest = next;
+    }
+    
+    int fileDescriptor = crashFileDescriptor_;
+    for (LogRecord* record = oldest; record; record = record->next_)
+    {
+        const String& message = record->formattedMessage_;
+        int consoleDescriptor = record->error_ ? 2 : 1;
+        if (!quiet_ || record->error_)
+        {
+            WriteOnCrash(consoleDescriptor, message.CString(), message.Length());
+            if (!record->raw_)
+                WriteOnCrash(consoleDescriptor, "\n", 1);
+        }
+        if (fileDescriptor >= 0)
+        {
+            WriteOnCrash(fileDescriptor, message.CString(), message.Length());
+            if (!record->raw_)
+                WriteOnCrash(fileDescriptor, "\r\n", 2);
+        }
+    }
+}
 
+void Log::Output(int level, const String& message, const String& formattedMessage, bool raw, bool error)
+{
     #if defined(ANDROID)
-    __android_log_print(ANDROID_LOG_INFO, "Urho3D", message.CString());
+    if (raw)
+        __android_log_print(ANDROID_LOG_INFO, "Urho3D", message.CString());
+    else
+    {
+        int androidLevel = ANDROID_LOG_DEBUG + level;
+        __android_log_print(androidLevel, "Urho3D", "%s", message.CString());
+    }
     #elif defined(IOS)
     SDL_IOS_LogMessage(message.CString());
     #else
-    if (logInstance->quiet_)
+    if (quiet_)
     {
         // If in quiet mode, still print the error message to the standard error stream
         if (error)
-            PrintUnicode(message, true);
+        {
+            if (raw)
+                PrintUnicode(formattedMessage, true);
+            else
+                PrintUnicodeLine(formattedMessage, true);
+        }
     }
     else
-        PrintUnicode(message, error);
+    {
+        if (raw)
+            PrintUnicode(formattedMessage, error);
+        else
+            PrintUnicodeLine(formattedMessage, error);
+    }
     #endif
 
-    if (logInstance->logFile_)
+    if (logFile_)
     {
-        logInstance->logFile_->Write(message.CString(), message.Length());
-        logInstance->logFile_->Flush();
+        if (raw)
+            logFile_->Write(formattedMessage.CString(), formattedMessage.Length());
+        else
+            logFile_->WriteLine(formattedMessage);
     }
+}
 
-    logInstance->inWrite_ = true;
+void Log::SendLogEvent(int level, const String& message, const String& formattedMessage, bool raw)
+{
+    if (inWrite_)
+        return;
+
+    lastMessage_ = message;
+    inWrite_ = true;
 
     using namespace LogMessage;
 
-    VariantMap& eventData = logInstance->GetEventDataMap();
-    eventData[P_MESSAGE] = message;
-    logInstance->SendEvent(E_LOGMESSAGE, eventData);
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_MESSAGE] = formattedMessage;
+    if (!raw)
+        eventData[P_LEVEL] = level;
+    SendEvent(E_LOGMESSAGE, eventData);
 
-    logInstance->inWrite_ = false;
+    inWrite_ = false;
 }
 
 }
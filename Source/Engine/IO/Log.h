@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include "ConcurrentAllocator.h"
+#include "Mutex.h"
 #include "Object.h"
 #include "StringUtils.h"
 
@@ -40,11 +42,15 @@ static const int LOG_ERROR = 3;
 static const int LOG_NONE = 4;
 
 class File;
+class LogWriter;
+struct LogRecord;
 
 /// Logging subsystem.
 class URHO3D_API Log : public Object
 {
     OBJECT(Log);
+    
+    friend class LogWriter;
 
 public:
     /// Construct.
@@ -62,6 +68,8 @@ public:
     void SetTimeStamp(bool enable);
     /// Set quiet mode ie. only print error entries to standard error stream (which is normally redirected to console also). Output to log file is not affected by this mode.
     void SetQuiet(bool quiet);
+    /// Set whether to print and write the messages to the log file in a background thread. Also installs a crash handler to write pending messages.
+    void SetAsync(bool enable);
 
     /// Return logging level.
     int GetLevel() const { return level_; }
@@ -71,13 +79,32 @@ public:
     String GetLastMessage() const { return lastMessage_; }
     /// Return whether log is in quiet mode (only errors printed to standard error stream).
     bool IsQuiet() const { return quiet_; }
+    /// Return whether messages are printed and written in a background thread.
+    bool IsAsync() const { return writer_ != 0; }
 
     /// Write to the log. If logging level is higher than the level of the message, the message is ignored.
     static void Write(int level, const String& message);
     /// Write raw output to the log.
     static void WriteRaw(const String& message, bool error = false);
+    /// Print and write pending messages immediately in the calling thread.
+    static void Flush();
+    /// Print and write pending messages using only async-signal-safe system calls. Only to be called from a crash handler.
+    static void FlushOnCrash();
 
 private:
+    /// Handle end of frame. Print pending messages from other threads if not asynchronous, and send their log events.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    /// Push a formatted message to be printed by the background thread, or by the main thread if not asynchronous.
+    void PushRecord(int level, const String& message, const String& formattedMessage, bool raw, bool error);
+    /// Print and write pending messages. Return the number of messages written.
+    unsigned WriteRecords();
+    /// Write pending messages to the standard output streams and the log file descriptor without locking or allocating.
+    void WriteRecordsOnCrash();
+    /// Print and write one message to the log file. Does not flush the log file.
+    void Output(int level, const String& message, const String& formattedMessage, bool raw, bool error);
+    /// Send a log event. Only called in the main thread.
+    void SendLogEvent(int level, const String& message, const String& formattedMessage, bool raw);
+
     /// Log file.
     SharedPtr<File> logFile_;
     /// Last log message.
@@ -90,6 +117,22 @@ private:
     bool inWrite_;
     /// Quiet mode flag.
     bool quiet_;
+    /// Log file descriptor for writing in a crash handler, or -1 if no log file.
+    int crashFileDescriptor_;
+    /// Background writer thread, or null if not asynchronous.
+    LogWriter* writer_;
+    /// Pending message records from any thread, newest first.
+    void* volatile records_;
+    /// Message records from other threads that have been written and wait for their log event.
+    PODVector<LogRecord*> eventRecords_;
+    /// Thread-safe memory pool for the message records.
+    ConcurrentAllocator recordPool_;
+    /// Message record allocator.
+    Allocator<LogRecord> recordAllocator_;
+    /// Mutex for printing and the log file.
+    Mutex outputMutex_;
+    /// Mutex for the message records waiting for their log event.
+    Mutex eventMutex_;
 };
 
 #ifdef ENABLE_LOGGING
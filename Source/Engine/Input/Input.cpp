@@ -429,6 +429,9 @@ void Input::Initialize()
     Graphics* graphics = GetSubsystem<Graphics>();
     if (!graphics || !graphics->IsInitialized())
         return;
+    // Input is not available without a window, for example with the null graphics backend
+    if (!graphics->GetImpl()->GetWindow())
+        return;
 
     graphics_ = graphics;
 
@@ -967,6 +970,8 @@ void Input::HandleScreenMode(StringHash eventType, VariantMap& eventData)
         Initialize();
     else
         ResetState();
+    if (!initialized_)
+        return;
 
     // Re-enable cursor clipping, and re-center the cursor (if needed) to the new screen size, so that there is no erroneous
     // mouse move event. Also get new window ID if it changed
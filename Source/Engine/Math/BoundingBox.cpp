@@ -24,6 +24,10 @@
 #include "Frustum.h"
 #include "Polyhedron.h"
 
+#ifdef URHO3D_SSE
+#include <xmmintrin.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -127,6 +131,39 @@ BoundingBox BoundingBox::Transformed(const Matrix3& transform) const
 
 BoundingBox BoundingBox::Transformed(const Matrix3x4& transform) const
 {
+    #ifdef URHO3D_SSE
+    __m128 minPt = _mm_setr_ps(min_.x_, min_.y_, min_.z_, 0.0f);
+    __m128 maxPt = _mm_setr_ps(max_.x_, max_.y_, max_.z_, 0.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 oldCenter = _mm_mul_ps(_mm_add_ps(maxPt, minPt), half);
+    __m128 oldEdge = _mm_mul_ps(_mm_sub_ps(maxPt, minPt), half);
+    
+    // Transpose the matrix to get its columns, the last of which is the translation
+    __m128 c0 = _mm_loadu_ps(&transform.m00_);
+    __m128 c1 = _mm_loadu_ps(&transform.m10_);
+    __m128 c2 = _mm_loadu_ps(&transform.m20_);
+    __m128 c3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    
+    __m128 newCenter = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_shuffle_ps(oldCenter, oldCenter, _MM_SHUFFLE(0, 0, 0, 0))),
+        _mm_mul_ps(c1, _mm_shuffle_ps(oldCenter, oldCenter, _MM_SHUFFLE(1, 1, 1, 1)))),
+        _mm_add_ps(_mm_mul_ps(c2, _mm_shuffle_ps(oldCenter, oldCenter, _MM_SHUFFLE(2, 2, 2, 2))), c3));
+    
+    // Take the absolute values of the columns with max(x, -x), as a sign bit mask constant may not survive fast math
+    __m128 zero = _mm_setzero_ps();
+    c0 = _mm_max_ps(c0, _mm_sub_ps(zero, c0));
+    c1 = _mm_max_ps(c1, _mm_sub_ps(zero, c1));
+    c2 = _mm_max_ps(c2, _mm_sub_ps(zero, c2));
+    __m128 newEdge = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_shuffle_ps(oldEdge, oldEdge, _MM_SHUFFLE(0, 0, 0, 0))),
+        _mm_mul_ps(c1, _mm_shuffle_ps(oldEdge, oldEdge, _MM_SHUFFLE(1, 1, 1, 1)))),
+        _mm_mul_ps(c2, _mm_shuffle_ps(oldEdge, oldEdge, _MM_SHUFFLE(2, 2, 2, 2))));
+    
+    float newMin[4];
+    float newMax[4];
+    _mm_storeu_ps(newMin, _mm_sub_ps(newCenter, newEdge));
+    _mm_storeu_ps(newMax, _mm_add_ps(newCenter, newEdge));
+    return BoundingBox(Vector3(newMin), Vector3(newMax));
+    #else
     Vector3 newCenter = transform * Center();
     Vector3 oldEdge = Size() * 0.5f;
     Vector3 newEdge = Vector3(
@@ -136,6 +173,7 @@ BoundingBox BoundingBox::Transformed(const Matrix3x4& transform) const
     );
     
     return BoundingBox(newCenter - newEdge, newCenter + newEdge);
+    #endif
 }
 
 Rect BoundingBox::Projected(const Matrix4& projection) const
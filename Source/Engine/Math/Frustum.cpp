@@ -23,6 +23,8 @@
 #include "Precompiled.h"
 #include "Frustum.h"
 
+#include <cstring>
+
 namespace Urho3D
 {
 
@@ -56,6 +58,8 @@ void ProjectAndMergeEdge(Vector3 v0, Vector3 v1, Rect& rect, const Matrix4& proj
 
 Frustum::Frustum()
 {
+    // Zero the SIMD plane data, so that copying or testing an undefined frustum does not read uninitialized memory
+    memset(soaPlanes_, 0, sizeof soaPlanes_);
 }
 
 Frustum::Frustum(const Frustum& frustum)
@@ -69,6 +73,7 @@ Frustum& Frustum::operator = (const Frustum& rhs)
         planes_[i] = rhs.planes_[i];
     for (unsigned i = 0; i < NUM_FRUSTUM_VERTICES; ++i)
         vertices_[i] = rhs.vertices_[i];
+    memcpy(soaPlanes_, rhs.soaPlanes_, sizeof soaPlanes_);
     
     return *this;
 }
@@ -203,7 +208,27 @@ void Frustum::UpdatePlanes()
             planes_[i].d_ = -planes_[i].d_;
         }
     }
-
+    
+    for (unsigned i = 0; i < NUM_FRUSTUM_SOA_PLANES; ++i)
+    {
+        if (i < NUM_FRUSTUM_PLANES)
+        {
+            const Plane& plane = planes_[i];
+            soaPlanes_[0][i] = plane.normal_.x_;
+            soaPlanes_[1][i] = plane.normal_.y_;
+            soaPlanes_[2][i] = plane.normal_.z_;
+            soaPlanes_[3][i] = plane.absNormal_.x_;
+            soaPlanes_[4][i] = plane.absNormal_.y_;
+            soaPlanes_[5][i] = plane.absNormal_.z_;
+            soaPlanes_[6][i] = plane.d_;
+        }
+        else
+        {
+            for (unsigned j = 0; j < 6; ++j)
+                soaPlanes_[j][i] = 0.0f;
+            soaPlanes_[6][i] = M_LARGE_VALUE;
+        }
+    }
 }
 
 }
@@ -28,6 +28,10 @@
 #include "Rect.h"
 #include "Sphere.h"
 
+#ifdef URHO3D_SSE
+#include <xmmintrin.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -44,6 +48,7 @@ enum FrustumPlane
 
 static const unsigned NUM_FRUSTUM_PLANES = 6;
 static const unsigned NUM_FRUSTUM_VERTICES = 8;
+static const unsigned NUM_FRUSTUM_SOA_PLANES = 8;
 
 /// Convex constructed of 6 planes.
 class URHO3D_API Frustum
@@ -113,6 +118,12 @@ public:
     /// Test if a bounding box is inside, outside or intersects.
     Intersection IsInside(const BoundingBox& box) const
     {
+        #ifdef URHO3D_SSE
+        int intersects;
+        if (TestPlanesSSE(box, intersects))
+            return OUTSIDE;
+        return intersects ? INTERSECTS : INSIDE;
+        #else
         Vector3 center = box.Center();
         Vector3 edge = center - box.min_;
         bool allInside = true;
@@ -130,11 +141,16 @@ public:
         }
         
         return allInside ? INSIDE : INTERSECTS;
+        #endif
     }
     
     /// Test if a bounding box is (partially) inside or outside.
     Intersection IsInsideFast(const BoundingBox& box) const
     {
+        #ifdef URHO3D_SSE
+        int intersects;
+        return TestPlanesSSE(box, intersects) ? OUTSIDE : INSIDE;
+        #else
         Vector3 center = box.Center();
         Vector3 edge = center - box.min_;
         
@@ -149,6 +165,50 @@ public:
         }
         
         return INSIDE;
+        #endif
+    }
+    
+    /// Test four bounding boxes in structure-of-arrays layout, given as minimum x, y and z, then maximum x, y and z coordinates, four floats each. Return a bit mask of the boxes that are (partially) inside.
+    unsigned IsInsideFastSoA(const float* boxes) const
+    {
+        #ifdef URHO3D_SSE
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128 minX = _mm_loadu_ps(boxes);
+        __m128 minY = _mm_loadu_ps(boxes + 4);
+        __m128 minZ = _mm_loadu_ps(boxes + 8);
+        __m128 maxX = _mm_loadu_ps(boxes + 12);
+        __m128 maxY = _mm_loadu_ps(boxes + 16);
+        __m128 maxZ = _mm_loadu_ps(boxes + 20);
+        __m128 centerX = _mm_mul_ps(_mm_add_ps(maxX, minX), half);
+        __m128 centerY = _mm_mul_ps(_mm_add_ps(maxY, minY), half);
+        __m128 centerZ = _mm_mul_ps(_mm_add_ps(maxZ, minZ), half);
+        __m128 edgeX = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+        __m128 edgeY = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+        __m128 edgeZ = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+        __m128 zero = _mm_setzero_ps();
+        __m128 outside = zero;
+        
+        for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(soaPlanes_[0][i]), centerX),
+                _mm_mul_ps(_mm_set1_ps(soaPlanes_[1][i]), centerY)), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(soaPlanes_[2][i]), centerZ),
+                _mm_set1_ps(soaPlanes_[6][i])));
+            __m128 absDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(soaPlanes_[3][i]), edgeX),
+                _mm_mul_ps(_mm_set1_ps(soaPlanes_[4][i]), edgeY)), _mm_mul_ps(_mm_set1_ps(soaPlanes_[5][i]), edgeZ));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_sub_ps(zero, absDist)));
+        }
+        
+        return ~_mm_movemask_ps(outside) & 0xf;
+        #else
+        unsigned result = 0;
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            BoundingBox box(Vector3(boxes[i], boxes[4 + i], boxes[8 + i]), Vector3(boxes[12 + i], boxes[16 + i], boxes[20 + i]));
+            if (IsInsideFast(box) != OUTSIDE)
+                result |= 1 << i;
+        }
+        return result;
+        #endif
     }
     
     /// Return distance of a point to the frustum, or 0 if inside.
@@ -175,6 +235,43 @@ public:
     Plane planes_[NUM_FRUSTUM_PLANES];
     /// Frustum vertices.
     Vector3 vertices_[NUM_FRUSTUM_VERTICES];
+    /// Frustum planes in structure-of-arrays layout for testing four planes at once: normal x, y and z, absolute normal x, y and z, and the plane parameter. Padded with planes that never reject.
+    float soaPlanes_[7][NUM_FRUSTUM_SOA_PLANES];
+    
+private:
+    #ifdef URHO3D_SSE
+    /// Test a bounding box against four planes at a time. Return nonzero if outside any plane. Also return whether intersects any plane.
+    int TestPlanesSSE(const BoundingBox& box, int& intersects) const
+    {
+        __m128 minPt = _mm_setr_ps(box.min_.x_, box.min_.y_, box.min_.z_, 0.0f);
+        __m128 maxPt = _mm_setr_ps(box.max_.x_, box.max_.y_, box.max_.z_, 0.0f);
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128 center = _mm_mul_ps(_mm_add_ps(maxPt, minPt), half);
+        __m128 edge = _mm_mul_ps(_mm_sub_ps(maxPt, minPt), half);
+        __m128 centerX = _mm_shuffle_ps(center, center, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 centerY = _mm_shuffle_ps(center, center, _MM_SHUFFLE(1, 1, 1, 1));
+        __m128 centerZ = _mm_shuffle_ps(center, center, _MM_SHUFFLE(2, 2, 2, 2));
+        __m128 edgeX = _mm_shuffle_ps(edge, edge, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 edgeY = _mm_shuffle_ps(edge, edge, _MM_SHUFFLE(1, 1, 1, 1));
+        __m128 edgeZ = _mm_shuffle_ps(edge, edge, _MM_SHUFFLE(2, 2, 2, 2));
+        __m128 zero = _mm_setzero_ps();
+        
+        int outside = 0;
+        intersects = 0;
+        for (unsigned i = 0; i < NUM_FRUSTUM_SOA_PLANES; i += 4)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&soaPlanes_[0][i]), centerX),
+                _mm_mul_ps(_mm_loadu_ps(&soaPlanes_[1][i]), centerY)), _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&soaPlanes_[2][i]),
+                centerZ), _mm_loadu_ps(&soaPlanes_[6][i])));
+            __m128 absDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&soaPlanes_[3][i]), edgeX),
+                _mm_mul_ps(_mm_loadu_ps(&soaPlanes_[4][i]), edgeY)), _mm_mul_ps(_mm_loadu_ps(&soaPlanes_[5][i]), edgeZ));
+            outside |= _mm_movemask_ps(_mm_cmplt_ps(dist, _mm_sub_ps(zero, absDist)));
+            intersects |= _mm_movemask_ps(_mm_cmplt_ps(dist, absDist));
+        }
+        
+        return outside;
+    }
+    #endif
 };
 
 }
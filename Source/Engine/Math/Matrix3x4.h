@@ -24,6 +24,10 @@
 
 #include "Matrix4.h"
 
+#ifdef URHO3D_SSE
+#include <xmmintrin.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -280,6 +284,26 @@ public:
     /// Multiply a matrix.
     Matrix3x4 operator * (const Matrix3x4& rhs) const
     {
+        #ifdef URHO3D_SSE
+        Matrix3x4 ret;
+        __m128 r0 = _mm_loadu_ps(&rhs.m00_);
+        __m128 r1 = _mm_loadu_ps(&rhs.m10_);
+        __m128 r2 = _mm_loadu_ps(&rhs.m20_);
+        // Multiplying the row with this keeps only its translation, as the implicit fourth row of rhs is (0, 0, 0, 1)
+        __m128 r3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+        const float* src = &m00_;
+        float* dest = &ret.m00_;
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            __m128 row = _mm_loadu_ps(src + i * 4);
+            __m128 result = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), r0),
+                _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), r1));
+            result = _mm_add_ps(result, _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), r2),
+                _mm_mul_ps(row, r3)));
+            _mm_storeu_ps(dest + i * 4, result);
+        }
+        return ret;
+        #else
         return Matrix3x4(
             m00_ * rhs.m00_ + m01_ * rhs.m10_ + m02_ * rhs.m20_,
             m00_ * rhs.m01_ + m01_ * rhs.m11_ + m02_ * rhs.m21_,
@@ -294,6 +318,7 @@ public:
             m20_ * rhs.m02_ + m21_ * rhs.m12_ + m22_ * rhs.m22_,
             m20_ * rhs.m03_ + m21_ * rhs.m13_ + m22_ * rhs.m23_ + m23_
         );
+        #endif
     }
     
     /// Multiply a 4x4 matrix.
@@ -25,6 +25,10 @@
 #include "Quaternion.h"
 #include "Vector4.h"
 
+#ifdef URHO3D_SSE
+#include <xmmintrin.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -281,6 +285,25 @@ public:
     /// Multiply a matrix.
     Matrix4 operator * (const Matrix4& rhs) const
     {
+        #ifdef URHO3D_SSE
+        Matrix4 ret;
+        __m128 r0 = _mm_loadu_ps(&rhs.m00_);
+        __m128 r1 = _mm_loadu_ps(&rhs.m10_);
+        __m128 r2 = _mm_loadu_ps(&rhs.m20_);
+        __m128 r3 = _mm_loadu_ps(&rhs.m30_);
+        const float* src = &m00_;
+        float* dest = &ret.m00_;
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            __m128 row = _mm_loadu_ps(src + i * 4);
+            __m128 result = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), r0),
+                _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), r1));
+            result = _mm_add_ps(result, _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), r2),
+                _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), r3)));
+            _mm_storeu_ps(dest + i * 4, result);
+        }
+        return ret;
+        #else
         return Matrix4(
             m00_ * rhs.m00_ + m01_ * rhs.m10_ + m02_ * rhs.m20_ + m03_ * rhs.m30_,
             m00_ * rhs.m01_ + m01_ * rhs.m11_ + m02_ * rhs.m21_ + m03_ * rhs.m31_,
@@ -299,6 +322,7 @@ public:
             m30_ * rhs.m02_ + m31_ * rhs.m12_ + m32_ * rhs.m22_ + m33_ * rhs.m32_,
             m30_ * rhs.m03_ + m31_ * rhs.m13_ + m32_ * rhs.m23_ + m33_ * rhs.m33_
         );
+        #endif
     }
     
     /// Set translation elements.
@@ -24,6 +24,10 @@
 
 #include "Matrix3.h"
 
+#ifdef URHO3D_SSE
+#include <xmmintrin.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -143,12 +147,28 @@ public:
     /// Multiply a quaternion.
     Quaternion operator * (const Quaternion& rhs) const
     {
+        #ifdef URHO3D_SSE
+        // Multiply rhs with each component of this quaternion, shuffling rhs so that the products line up with the result components
+        __m128 q1 = _mm_loadu_ps(&w_);
+        __m128 q2 = _mm_loadu_ps(&rhs.w_);
+        __m128 result = _mm_mul_ps(_mm_shuffle_ps(q1, q1, _MM_SHUFFLE(0, 0, 0, 0)), q2);
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_mul_ps(_mm_shuffle_ps(q1, q1, _MM_SHUFFLE(1, 1, 1, 1)),
+            _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(2, 3, 0, 1))), _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f)));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_mul_ps(_mm_shuffle_ps(q1, q1, _MM_SHUFFLE(2, 2, 2, 2)),
+            _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(1, 0, 3, 2))), _mm_setr_ps(-1.0f, 1.0f, 1.0f, -1.0f)));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_mul_ps(_mm_shuffle_ps(q1, q1, _MM_SHUFFLE(3, 3, 3, 3)),
+            _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(0, 1, 2, 3))), _mm_setr_ps(-1.0f, -1.0f, 1.0f, 1.0f)));
+        Quaternion ret;
+        _mm_storeu_ps(&ret.w_, result);
+        return ret;
+        #else
         return Quaternion(
             w_ * rhs.w_ - x_ * rhs.x_ - y_ * rhs.y_ - z_ * rhs.z_,
             w_ * rhs.x_ + x_ * rhs.w_ + y_ * rhs.z_ - z_ * rhs.y_,
             w_ * rhs.y_ + y_ * rhs.w_ + z_ * rhs.x_ - x_ * rhs.z_,
             w_ * rhs.z_ + z_ * rhs.w_ + x_ * rhs.y_ - y_ * rhs.x_
         );
+        #endif
     }
     
     /// Multiply a Vector3.
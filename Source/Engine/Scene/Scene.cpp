@@ -80,9 +80,9 @@ Scene::~Scene()
     RemoveAllChildren();
     
     // Remove scene reference and owner from all nodes that still exist
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->ResetScene();
-    for (HashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
         i->second_->ResetScene();
 }
 
@@ -176,7 +176,7 @@ void Scene::AddReplicationState(NodeReplicationState* state)
     Node::AddReplicationState(state);
 
     // This is the first update for a new connection. Mark all replicated nodes dirty
-    for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         state->sceneState_->dirtyNodes_.Insert(i->first_);
 }
 
@@ -464,7 +464,7 @@ Node* Scene::GetNode(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End())
             return i->second_;
         else
@@ -472,7 +472,7 @@ Node* Scene::GetNode(unsigned id) const
     }
     else
     {
-        HashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
         if (i != localNodes_.End())
             return i->second_;
         else
@@ -484,7 +484,7 @@ Component* Scene::GetComponent(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End())
             return i->second_;
         else
@@ -492,7 +492,7 @@ Component* Scene::GetComponent(unsigned id) const
     }
     else
     {
-        HashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
         if (i != localComponents_.End())
             return i->second_;
         else
@@ -682,7 +682,7 @@ void Scene::NodeAdded(Node* node)
     // If node with same ID exists, remove the scene reference from it and overwrite with the new node
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End() && i->second_ != node)
         {
             LOGWARNING("Overwriting node with ID " + String(id));
@@ -696,7 +696,7 @@ void Scene::NodeAdded(Node* node)
     }
     else
     {
-        HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
         if (i != localNodes_.End() && i->second_ != node)
         {
             LOGWARNING("Overwriting node with ID " + String(id));
@@ -733,7 +733,7 @@ void Scene::ComponentAdded(Component* component)
     unsigned id = component->GetID();
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End() && i->second_ != component)
         {
             LOGWARNING("Overwriting component with ID " + String(id));
@@ -744,7 +744,7 @@ void Scene::ComponentAdded(Component* component)
     }
     else
     {
-        HashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
         if (i != localComponents_.End() && i->second_ != component)
         {
             LOGWARNING("Overwriting component with ID " + String(id));
@@ -817,10 +817,10 @@ void Scene::CleanupConnection(Connection* connection)
 {
     Node::CleanupConnection(connection);
 
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->CleanupConnection(connection);
 
-    for (HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+    for (FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
         i->second_->CleanupConnection(connection);
 }
 
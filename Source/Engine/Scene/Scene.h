@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "FlatHashMap.h"
 #include "HashSet.h"
 #include "Mutex.h"
 #include "Node.h"
@@ -195,13 +196,13 @@ private:
     void FinishSaving(Serializer* dest) const;
 
     /// Replicated scene nodes by ID.
-    HashMap<unsigned, Node*> replicatedNodes_;
+    FlatHashMap<unsigned, Node*> replicatedNodes_;
     /// Local scene nodes by ID.
-    HashMap<unsigned, Node*> localNodes_;
+    FlatHashMap<unsigned, Node*> localNodes_;
     /// Replicated components by ID.
-    HashMap<unsigned, Component*> replicatedComponents_;
+    FlatHashMap<unsigned, Component*> replicatedComponents_;
     /// Local components by ID.
-    HashMap<unsigned, Component*> localComponents_;
+    FlatHashMap<unsigned, Component*> localComponents_;
     /// Asynchronous loading progress.
     AsyncProgress asyncProgress_;
     /// Node and component ID resolver for asynchronous loading.
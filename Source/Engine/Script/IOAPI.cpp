@@ -148,6 +148,8 @@ static void RegisterLog(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Log", "String get_lastMessage()", asMETHOD(Log, GetLastMessage), asCALL_THISCALL);
     engine->RegisterObjectMethod("Log", "void set_quiet(bool)", asMETHOD(Log, SetQuiet), asCALL_THISCALL);
     engine->RegisterObjectMethod("Log", "bool get_quiet() const", asMETHOD(Log, IsQuiet), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Log", "void set_async(bool)", asMETHOD(Log, SetAsync), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Log", "bool get_async() const", asMETHOD(Log, IsAsync), asCALL_THISCALL);
     engine->RegisterGlobalFunction("Log@+ get_log()", asFUNCTION(GetLog), asCALL_CDECL);
 
     // Register also Print() functions for convenience
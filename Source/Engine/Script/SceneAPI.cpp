@@ -140,13 +140,13 @@ static CScriptArray* GetObjectsByCategory(const String& category)
     HashMap<String, Vector<ShortStringHash> >::ConstIterator i = categories.Find(category);
     if (i != categories.End())
     {
-        const HashMap<ShortStringHash, SharedPtr<ObjectFactory> >& factories = GetScriptContext()->GetObjectFactories();
+        const FlatHashMap<ShortStringHash, SharedPtr<ObjectFactory> >& factories = GetScriptContext()->GetObjectFactories();
         const Vector<ShortStringHash>& factoryHashes = i->second_;
         components.Reserve(factoryHashes.Size());
 
         for (unsigned j = 0; j < factoryHashes.Size(); ++j)
         {
-            HashMap<ShortStringHash, SharedPtr<ObjectFactory> >::ConstIterator k = factories.Find(factoryHashes[j]);
+            FlatHashMap<ShortStringHash, SharedPtr<ObjectFactory> >::ConstIterator k = factories.Find(factoryHashes[j]);
             if (k != factories.End())
                 components.Push(k->second_->GetTypeName());
         }
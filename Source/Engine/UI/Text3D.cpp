@@ -106,7 +106,9 @@ void Text3D::UpdateBatches(const FrameInfo& frame)
     if (faceCamera_)
     {
         customWorldTransform_ = Matrix3x4(node_->GetWorldPosition(), frame.camera_->GetNode()->GetWorldRotation(), node_->GetWorldScale());
+        // Update the bounding box now so that the octant's bounds used for culling follow the camera
         worldBoundingBoxDirty_ = true;
+        GetWorldBoundingBox();
     }
     
     for (unsigned i = 0; i < batches_.Size(); ++i)
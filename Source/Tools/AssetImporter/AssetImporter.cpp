@@ -94,6 +94,73 @@ struct OutScene
     PODVector<unsigned> nodeModelIndices_;
 };
 
+struct OccluderBox
+{
+    int min_[3];
+    int max_[3];
+    unsigned volume_;
+};
+
+enum OccluderVoxel
+{
+    VOXEL_INTERIOR = 0,
+    VOXEL_SURFACE,
+    VOXEL_EXTERIOR
+};
+
+enum LodVertexKind
+{
+    LOD_MANIFOLD = 0,
+    LOD_BORDER,
+    LOD_SEAM,
+    LOD_LOCKED
+};
+
+struct LodQuadric
+{
+    LodQuadric()
+    {
+        for (unsigned i = 0; i < 10; ++i)
+            q_[i] = 0.0;
+    }
+    
+    /// Symmetric 4x4 matrix: a00, a01, a02, a11, a12, a22, b0, b1, b2, c.
+    double q_[10];
+};
+
+struct LodPosition
+{
+    Vector3 position_;
+    unsigned index_;
+};
+
+struct LodEdgeCollapse
+{
+    unsigned source_;
+    unsigned target_;
+    unsigned siblingTarget_;
+    float cost_;
+};
+
+/// Voxel grid resolution along the longest axis of the model when generating the occluder geometry.
+static const int OCCLUDER_GRID_SIZE = 64;
+/// Weight of the quadrics that keep open borders and UV or normal seams in place, relative to the surface quadrics.
+static const float LOD_BOUNDARY_WEIGHT = 10.0f;
+/// Minimum cosine of the angle a triangle may rotate by in an edge collapse.
+static const float LOD_FLIP_THRESHOLD = 0.25f;
+/// LOD distance of the first generated LOD level if not specified. Each further level doubles the distance.
+static const float DEFAULT_LOD_DISTANCE = 20.0f;
+/// Occluder box triangle indices. The corners are numbered with bit 0 set for maximum X, bit 1 for maximum Y and bit 2 for maximum Z.
+static const unsigned short occluderBoxIndices[] =
+{
+    0, 2, 3, 0, 3, 1,
+    5, 7, 6, 5, 6, 4,
+    4, 6, 2, 4, 2, 0,
+    1, 3, 7, 1, 7, 5,
+    0, 1, 5, 0, 5, 4,
+    2, 6, 7, 2, 7, 3
+};
+
 SharedPtr<Context> context_(new Context());
 const aiScene* scene_ = 0;
 aiNode* rootNode_ = 0;
@@ -115,6 +182,11 @@ bool emissiveAO_ = false;
 bool noOverwriteMaterial_ = false;
 bool noOverwriteTexture_ = false;
 bool noOverwriteNewerTexture_ = false;
+unsigned occluderBoxes_ = 0;
+bool compressAnimations_ = false;
+float keyFrameTolerance_ = 0.0f;
+PODVector<float> lodRatios_;
+PODVector<float> lodDistances_;
 Vector<String> nonSkinningBoneIncludes_;
 Vector<String> nonSkinningBoneExcludes_;
 
@@ -135,6 +207,26 @@ void CollectAnimations(OutModel* model = 0);
 void BuildBoneCollisionInfo(OutModel& model);
 void BuildAndSaveModel(OutModel& model);
 void BuildAndSaveAnimations(OutModel* model = 0);
+void ReduceKeyFrames(Vector<AnimationKeyFrame>& keyFrames, unsigned char channelMask, float tolerance);
+bool CanInterpolateKeyFrames(const Vector<AnimationKeyFrame>& keyFrames, unsigned char channelMask, unsigned start, unsigned end,
+    float tolerance);
+void BuildOccluderGeometry(Model* outModel);
+bool TriangleIntersectsBox(const Vector3& center, const Vector3& halfSize, const Vector3& v0, const Vector3& v1, const Vector3& v2);
+unsigned GrowOccluderBox(const PODVector<unsigned char>& voxels, const int* dims, const int* seed, const int* axisOrder, OccluderBox& box);
+bool IsOccluderSlabInterior(const PODVector<unsigned char>& voxels, const int* dims, const OccluderBox& box, int axis, int layer);
+bool CompareOccluderBoxes(const OccluderBox& lhs, const OccluderBox& rhs);
+void GenerateLodLevels(Model* outModel, Vector<SharedPtr<IndexBuffer> >& ibVector);
+void SimplifyTriangles(const PODVector<Vector3>& positions, const PODVector<unsigned char>& bones, PODVector<unsigned>& indices,
+    unsigned targetIndices);
+void BuildLodAdjacency(const PODVector<unsigned>& indices, const PODVector<unsigned>& groups, PODVector<unsigned>& offsets,
+    PODVector<unsigned>& triangles);
+bool HasLodEdge(const PODVector<unsigned>& indices, const PODVector<unsigned>& offsets, const PODVector<unsigned>& triangles,
+    unsigned from, unsigned to);
+void AddPlaneQuadric(LodQuadric& quadric, const Vector3& normal, const Vector3& point, float weight);
+void AddQuadric(LodQuadric& quadric, const LodQuadric& other);
+float GetQuadricError(const LodQuadric& quadric, const Vector3& point);
+bool CompareLodPositions(const LodPosition& lhs, const LodPosition& rhs);
+bool CompareLodEdgeCollapses(const LodEdgeCollapse& lhs, const LodEdgeCollapse& rhs);
 
 void ExportScene(const String& outName, bool asPrefab);
 void CollectSceneModels(OutScene& scene, aiNode* node);
@@ -233,6 +325,16 @@ void Run(const Vector<String>& arguments)
             "-cm         Check and do not overwrite if material exists\n"
             "-ct         Check and do not overwrite if texture exists\n"
             "-ctn        Check and do not overwrite if texture has newer timestamp\n"
+            "-oc <boxes> Generate a simplified occluder geometry of at most the given amount\n"
+            "            of boxes inside the model. Not generated for skinned models\n"
+            "-ac         Save animations in compressed format\n"
+            "-ak <error> Remove animation keyframes that can be interpolated from their neighbours\n"
+            "            within the given error. Position and scale error is in model units,\n"
+            "            rotation error in radians\n"
+            "-lr <ratio> Generate LOD levels by simplifying each geometry to the given semicolon\n"
+            "            separated triangle ratios of the original, for example -lr \"0.5;0.25\"\n"
+            "-ld <dists> LOD distances of the generated LOD levels, for example -ld \"20;50\".\n"
+            "            Default is 20 for the first level, and double the previous for the rest\n"
         );
     }
     
@@ -359,6 +461,32 @@ void Run(const Vector<String>& arguments)
                 noOverwriteTexture_ = true;
             else if (argument == "ctn")
                 noOverwriteNewerTexture_ = true;
+            else if (argument == "oc" && !value.Empty())
+            {
+                occluderBoxes_ = ToUInt(value);
+                ++i;
+            }
+            else if (argument == "ac")
+                compressAnimations_ = true;
+            else if (argument == "ak" && !value.Empty())
+            {
+                keyFrameTolerance_ = Max(ToFloat(value), 0.0f);
+                ++i;
+            }
+            else if (argument == "lr" && !value.Empty())
+            {
+                Vector<String> ratios = value.Split(';');
+                for (unsigned j = 0; j < ratios.Size(); ++j)
+                    lodRatios_.Push(Clamp(ToFloat(ratios[j]), 0.0f, 1.0f));
+                ++i;
+            }
+            else if (argument == "ld" && !value.Empty())
+            {
+                Vector<String> distances = value.Split(';');
+                for (unsigned j = 0; j < distances.Size(); ++j)
+                    lodDistances_.Push(Max(ToFloat(distances[j]), 0.0f));
+                ++i;
+            }
         }
     }
     
@@ -891,6 +1019,10 @@ void BuildAndSaveModel(OutModel& model)
         ++destGeomIndex;
     }
     
+    // Generate simplified LOD levels if requested. This may replace the index buffers with larger ones
+    if (!lodRatios_.Empty())
+        GenerateLodLevels(outModel, ibVector);
+    
     // Define the model buffers and bounding box
     PODVector<unsigned> emptyMorphRange;
     outModel->SetVertexBuffers(vbVector, emptyMorphRange, emptyMorphRange);
@@ -948,6 +1080,9 @@ void BuildAndSaveModel(OutModel& model)
             outModel->SetGeometryBoneMappings(allBoneMappings);
     }
     
+    if (occluderBoxes_ && !model.bones_.Size())
+        BuildOccluderGeometry(outModel);
+    
     File outFile(context_);
     if (!outFile.Open(model.outName_, FILE_WRITE))
         ErrorExit("Could not open output file " + model.outName_);
@@ -968,6 +1103,811 @@ void BuildAndSaveModel(OutModel& model)
     }
 }
 
+void BuildOccluderGeometry(Model* outModel)
+{
+    // Collect the triangles of the most detailed LOD level of all geometries
+    PODVector<Vector3> triangles;
+    BoundingBox box;
+    for (unsigned i = 0; i < outModel->GetNumGeometries(); ++i)
+    {
+        Geometry* geometry = outModel->GetGeometry(i, 0);
+        if (!geometry || geometry->GetPrimitiveType() != TRIANGLE_LIST)
+            continue;
+        
+        const unsigned char* vertexData;
+        unsigned vertexSize;
+        const unsigned char* indexData;
+        unsigned indexSize;
+        unsigned elementMask;
+        geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elementMask);
+        if (!vertexData || !indexData)
+            continue;
+        
+        unsigned indexEnd = geometry->GetIndexStart() + geometry->GetIndexCount();
+        for (unsigned j = geometry->GetIndexStart(); j < indexEnd; ++j)
+        {
+            unsigned index = indexSize == sizeof(unsigned short) ? ((const unsigned short*)indexData)[j] :
+                ((const unsigned*)indexData)[j];
+            const Vector3& position = *((const Vector3*)(vertexData + index * vertexSize));
+            triangles.Push(position);
+            box.Merge(position);
+        }
+    }
+    
+    Vector3 size = box.Size();
+    float voxelSize = Max(Max(size.x_, size.y_), size.z_) / OCCLUDER_GRID_SIZE;
+    if (triangles.Empty() || voxelSize < M_EPSILON)
+    {
+        PrintLine("Warning: could not generate occluder geometry for an empty model");
+        return;
+    }
+    
+    // Voxelize the triangles into a grid padded by two voxels on each side, so that the exterior voxels are connected
+    int dims[3];
+    for (unsigned i = 0; i < 3; ++i)
+        dims[i] = Max((int)ceilf(size.Data()[i] / voxelSize), 1) + 4;
+    Vector3 origin = box.min_ - Vector3::ONE * 2.0f * voxelSize;
+    // Enlarge the voxels slightly for the intersection test so that triangles on voxel boundaries are not missed
+    Vector3 halfSize = Vector3::ONE * (0.5f + M_EPSILON) * voxelSize;
+    PODVector<unsigned char> voxels(dims[0] * dims[1] * dims[2]);
+    memset(&voxels[0], VOXEL_INTERIOR, voxels.Size());
+    
+    for (unsigned i = 0; i < triangles.Size(); i += 3)
+    {
+        const Vector3& v0 = triangles[i];
+        const Vector3& v1 = triangles[i + 1];
+        const Vector3& v2 = triangles[i + 2];
+        
+        int start[3];
+        int end[3];
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            float minValue = Min(Min(v0.Data()[j], v1.Data()[j]), v2.Data()[j]) - origin.Data()[j];
+            float maxValue = Max(Max(v0.Data()[j], v1.Data()[j]), v2.Data()[j]) - origin.Data()[j];
+            start[j] = Clamp((int)floorf(minValue / voxelSize - 0.5f), 0, dims[j] - 1);
+            end[j] = Clamp((int)floorf(maxValue / voxelSize + 0.5f), 0, dims[j] - 1);
+        }
+        
+        for (int z = start[2]; z <= end[2]; ++z)
+        {
+            for (int y = start[1]; y <= end[1]; ++y)
+            {
+                for (int x = start[0]; x <= end[0]; ++x)
+                {
+                    unsigned char& voxel = voxels[(z * dims[1] + y) * dims[0] + x];
+                    if (voxel == VOXEL_SURFACE)
+                        continue;
+                    Vector3 center = origin + Vector3(x + 0.5f, y + 0.5f, z + 0.5f) * voxelSize;
+                    if (TriangleIntersectsBox(center, halfSize, v0, v1, v2))
+                        voxel = VOXEL_SURFACE;
+                }
+            }
+        }
+    }
+    
+    // Flood fill the exterior from the grid corner. The voxels it does not reach are completely inside the model
+    PODVector<unsigned> stack;
+    voxels[0] = VOXEL_EXTERIOR;
+    stack.Push(0);
+    while (stack.Size())
+    {
+        unsigned index = stack.Back();
+        stack.Pop();
+        int x = index % dims[0];
+        int y = (index / dims[0]) % dims[1];
+        int z = index / (dims[0] * dims[1]);
+        
+        int neighbors[6];
+        unsigned numNeighbors = 0;
+        if (x > 0)
+            neighbors[numNeighbors++] = index - 1;
+        if (x < dims[0] - 1)
+            neighbors[numNeighbors++] = index + 1;
+        if (y > 0)
+            neighbors[numNeighbors++] = index - dims[0];
+        if (y < dims[1] - 1)
+            neighbors[numNeighbors++] = index + dims[0];
+        if (z > 0)
+            neighbors[numNeighbors++] = index - dims[0] * dims[1];
+        if (z < dims[2] - 1)
+            neighbors[numNeighbors++] = index + dims[0] * dims[1];
+        
+        for (unsigned i = 0; i < numNeighbors; ++i)
+        {
+            if (voxels[neighbors[i]] == VOXEL_INTERIOR)
+            {
+                voxels[neighbors[i]] = VOXEL_EXTERIOR;
+                stack.Push(neighbors[i]);
+            }
+        }
+    }
+    
+    // Cover the interior voxels greedily with boxes. Each box is grown from the first uncovered voxel, trying all axis
+    // orders, and may overlap the previous boxes
+    static const int axisOrders[6][3] = { {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0} };
+    PODVector<OccluderBox> boxes;
+    PODVector<bool> covered(voxels.Size());
+    for (unsigned i = 0; i < covered.Size(); ++i)
+        covered[i] = false;
+    
+    for (int z = 0; z < dims[2]; ++z)
+    {
+        for (int y = 0; y < dims[1]; ++y)
+        {
+            for (int x = 0; x < dims[0]; ++x)
+            {
+                unsigned index = (z * dims[1] + y) * dims[0] + x;
+                if (voxels[index] != VOXEL_INTERIOR || covered[index])
+                    continue;
+                
+                int seed[3] = { x, y, z };
+                OccluderBox bestBox;
+                bestBox.volume_ = 0;
+                for (unsigned i = 0; i < 6; ++i)
+                {
+                    OccluderBox newBox;
+                    if (GrowOccluderBox(voxels, dims, seed, axisOrders[i], newBox) > bestBox.volume_)
+                        bestBox = newBox;
+                }
+                
+                for (int bz = bestBox.min_[2]; bz <= bestBox.max_[2]; ++bz)
+                {
+                    for (int by = bestBox.min_[1]; by <= bestBox.max_[1]; ++by)
+                    {
+                        for (int bx = bestBox.min_[0]; bx <= bestBox.max_[0]; ++bx)
+                            covered[(bz * dims[1] + by) * dims[0] + bx] = true;
+                    }
+                }
+                boxes.Push(bestBox);
+            }
+        }
+    }
+    
+    if (boxes.Empty())
+    {
+        PrintLine("Warning: could not generate occluder geometry, the model is not closed or is too thin");
+        return;
+    }
+    
+    // Keep the largest boxes
+    Sort(boxes.Begin(), boxes.End(), CompareOccluderBoxes);
+    unsigned numBoxes = Min((int)boxes.Size(), (int)occluderBoxes_);
+    unsigned numVertices = numBoxes * 8;
+    unsigned numIndices = numBoxes * 36;
+    unsigned indexSize = numVertices > 65535 ? sizeof(unsigned) : sizeof(unsigned short);
+    
+    SharedArrayPtr<unsigned char> vertexData(new unsigned char[numVertices * sizeof(Vector3)]);
+    SharedArrayPtr<unsigned char> indexData(new unsigned char[numIndices * indexSize]);
+    Vector3* vertexDest = (Vector3*)vertexData.Get();
+    
+    for (unsigned i = 0; i < numBoxes; ++i)
+    {
+        const OccluderBox& occluderBox = boxes[i];
+        Vector3 boxMin = origin + Vector3((float)occluderBox.min_[0], (float)occluderBox.min_[1], (float)occluderBox.min_[2]) *
+            voxelSize;
+        Vector3 boxMax = origin + Vector3((float)occluderBox.max_[0] + 1.0f, (float)occluderBox.max_[1] + 1.0f,
+            (float)occluderBox.max_[2] + 1.0f) * voxelSize;
+        
+        for (unsigned j = 0; j < 8; ++j)
+        {
+            *vertexDest++ = Vector3(j & 1 ? boxMax.x_ : boxMin.x_, j & 2 ? boxMax.y_ : boxMin.y_, j & 4 ? boxMax.z_ :
+                boxMin.z_);
+        }
+        
+        for (unsigned j = 0; j < 36; ++j)
+        {
+            unsigned index = i * 8 + occluderBoxIndices[j];
+            if (indexSize == sizeof(unsigned short))
+                ((unsigned short*)indexData.Get())[i * 36 + j] = index;
+            else
+                ((unsigned*)indexData.Get())[i * 36 + j] = index;
+        }
+    }
+    
+    PrintLine("Writing occluder geometry with " + String(numBoxes) + " boxes out of " + String(boxes.Size()));
+    
+    SharedPtr<Geometry> geometry(new Geometry(context_));
+    geometry->SetRawVertexData(vertexData, sizeof(Vector3), MASK_POSITION);
+    geometry->SetRawIndexData(indexData, indexSize);
+    geometry->SetDrawRange(TRIANGLE_LIST, 0, numIndices, 0, numVertices);
+    outModel->SetOccluderGeometry(geometry);
+}
+
+bool TriangleIntersectsBox(const Vector3& center, const Vector3& halfSize, const Vector3& v0, const Vector3& v1, const Vector3& v2)
+{
+    // Separating axis test with the box axes, the triangle normal and the cross products of the box axes and the edges
+    Vector3 p0 = v0 - center;
+    Vector3 p1 = v1 - center;
+    Vector3 p2 = v2 - center;
+    
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        if (Min(Min(p0.Data()[i], p1.Data()[i]), p2.Data()[i]) > halfSize.Data()[i] ||
+            Max(Max(p0.Data()[i], p1.Data()[i]), p2.Data()[i]) < -halfSize.Data()[i])
+            return false;
+    }
+    
+    Vector3 edges[3] = { p1 - p0, p2 - p1, p0 - p2 };
+    Vector3 normal = edges[0].CrossProduct(edges[1]);
+    if (Abs(normal.DotProduct(p0)) > halfSize.DotProduct(normal.Abs()))
+        return false;
+    
+    const Vector3 boxAxes[3] = { Vector3::RIGHT, Vector3::UP, Vector3::FORWARD };
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            Vector3 axis = boxAxes[i].CrossProduct(edges[j]);
+            float d0 = axis.DotProduct(p0);
+            float d1 = axis.DotProduct(p1);
+            float d2 = axis.DotProduct(p2);
+            float radius = halfSize.DotProduct(axis.Abs());
+            if (Min(Min(d0, d1), d2) > radius || Max(Max(d0, d1), d2) < -radius)
+                return false;
+        }
+    }
+    
+    return true;
+}
+
+unsigned GrowOccluderBox(const PODVector<unsigned char>& voxels, const int* dims, const int* seed, const int* axisOrder, OccluderBox& box)
+{
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        box.min_[i] = seed[i];
+        box.max_[i] = seed[i];
+    }
+    
+    // Grow fully along each axis in turn, in both directions
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        int axis = axisOrder[i];
+        while (box.max_[axis] < dims[axis] - 1 && IsOccluderSlabInterior(voxels, dims, box, axis, box.max_[axis] + 1))
+            ++box.max_[axis];
+        while (box.min_[axis] > 0 && IsOccluderSlabInterior(voxels, dims, box, axis, box.min_[axis] - 1))
+            --box.min_[axis];
+    }
+    
+    box.volume_ = (box.max_[0] - box.min_[0] + 1) * (box.max_[1] - box.min_[1] + 1) * (box.max_[2] - box.min_[2] + 1);
+    return box.volume_;
+}
+
+bool IsOccluderSlabInterior(const PODVector<unsigned char>& voxels, const int* dims, const OccluderBox& box, int axis, int layer)
+{
+    int start[3];
+    int end[3];
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        start[i] = box.min_[i];
+        end[i] = box.max_[i];
+    }
+    start[axis] = layer;
+    end[axis] = layer;
+    
+    for (int z = start[2]; z <= end[2]; ++z)
+    {
+        for (int y = start[1]; y <= end[1]; ++y)
+        {
+            for (int x = start[0]; x <= end[0]; ++x)
+            {
+                if (voxels[(z * dims[1] + y) * dims[0] + x] != VOXEL_INTERIOR)
+                    return false;
+            }
+        }
+    }
+    
+    return true;
+}
+
+bool CompareOccluderBoxes(const OccluderBox& lhs, const OccluderBox& rhs)
+{
+    return lhs.volume_ > rhs.volume_;
+}
+
+void GenerateLodLevels(Model* outModel, Vector<SharedPtr<IndexBuffer> >& ibVector)
+{
+    const Vector<Vector<SharedPtr<Geometry> > >& geometries = outModel->GetGeometries();
+    
+    // Fill in the LOD distances that were not specified
+    PODVector<float> lodDistances;
+    for (unsigned i = 0; i < lodRatios_.Size(); ++i)
+    {
+        float distance = i < lodDistances_.Size() ? lodDistances_[i] : (i ? lodDistances[i - 1] * 2.0f : DEFAULT_LOD_DISTANCE);
+        lodDistances.Push(i ? Max(distance, lodDistances[i - 1]) : distance);
+    }
+    
+    for (unsigned i = 0; i < ibVector.Size(); ++i)
+    {
+        IndexBuffer* ib = ibVector[i];
+        bool largeIndices = ib->GetIndexSize() == sizeof(unsigned);
+        const unsigned char* indexData = ib->GetShadowData();
+        
+        // The LOD levels only need new indices, so they are appended to the index buffer of the original geometry
+        PODVector<unsigned> lodIndices;
+        PODVector<unsigned> lodIndexStarts;
+        PODVector<unsigned> lodIndexCounts;
+        Vector<SharedPtr<Geometry> > lodGeometries;
+        
+        for (unsigned j = 0; j < geometries.Size(); ++j)
+        {
+            Geometry* geometry = geometries[j][0];
+            if (geometry->GetIndexBuffer() != ib || geometry->GetPrimitiveType() != TRIANGLE_LIST)
+                continue;
+            
+            VertexBuffer* vb = geometry->GetVertexBuffer(0);
+            const unsigned char* vertexData = vb->GetShadowData();
+            unsigned vertexSize = vb->GetVertexSize();
+            unsigned elementMask = vb->GetElementMask();
+            unsigned vertexStart = geometry->GetVertexStart();
+            unsigned vertexCount = geometry->GetVertexCount();
+            unsigned indexStart = geometry->GetIndexStart();
+            unsigned indexCount = geometry->GetIndexCount();
+            
+            // Get the positions, and the most influential bone of each vertex to keep the skinning intact
+            PODVector<Vector3> positions(vertexCount);
+            PODVector<unsigned char> bones;
+            for (unsigned k = 0; k < vertexCount; ++k)
+                positions[k] = *((const Vector3*)(vertexData + (vertexStart + k) * vertexSize));
+            if ((elementMask & MASK_BLENDWEIGHTS) && (elementMask & MASK_BLENDINDICES))
+            {
+                unsigned weightOffset = vb->GetElementOffset(ELEMENT_BLENDWEIGHTS);
+                unsigned blendIndexOffset = vb->GetElementOffset(ELEMENT_BLENDINDICES);
+                bones.Resize(vertexCount);
+                for (unsigned k = 0; k < vertexCount; ++k)
+                {
+                    const unsigned char* vertex = vertexData + (vertexStart + k) * vertexSize;
+                    const float* weights = (const float*)(vertex + weightOffset);
+                    unsigned strongest = 0;
+                    for (unsigned l = 1; l < 4; ++l)
+                    {
+                        if (weights[l] > weights[strongest])
+                            strongest = l;
+                    }
+                    bones[k] = vertex[blendIndexOffset + strongest];
+                }
+            }
+            
+            PODVector<unsigned> indices(indexCount);
+            for (unsigned k = 0; k < indexCount; ++k)
+            {
+                unsigned index = largeIndices ? ((const unsigned*)indexData)[indexStart + k] :
+                    ((const unsigned short*)indexData)[indexStart + k];
+                indices[k] = index - vertexStart;
+            }
+            
+            // Simplify each LOD level further from the previous one
+            String triangleCounts(indexCount / 3);
+            unsigned numLodLevels = 1;
+            for (unsigned k = 0; k < lodRatios_.Size(); ++k)
+            {
+                unsigned lastIndexCount = indices.Size();
+                SimplifyTriangles(positions, bones, indices, (unsigned)(indexCount / 3 * lodRatios_[k]) * 3);
+                if (indices.Empty() || indices.Size() >= lastIndexCount)
+                    break;
+                
+                lodIndexStarts.Push(ib->GetIndexCount() + lodIndices.Size());
+                lodIndexCounts.Push(indices.Size());
+                for (unsigned l = 0; l < indices.Size(); ++l)
+                    lodIndices.Push(indices[l] + vertexStart);
+                
+                SharedPtr<Geometry> lodGeometry(new Geometry(context_));
+                lodGeometry->SetVertexBuffer(0, vb);
+                lodGeometry->SetLodDistance(lodDistances[k]);
+                outModel->SetNumGeometryLodLevels(j, numLodLevels + 1);
+                outModel->SetGeometry(j, numLodLevels, lodGeometry);
+                lodGeometries.Push(lodGeometry);
+                ++numLodLevels;
+                triangleCounts += " " + String(indices.Size() / 3);
+            }
+            
+            if (numLodLevels < lodRatios_.Size() + 1)
+            {
+                PrintLine("Warning: geometry " + String(j) + " could only be simplified to " + String(numLodLevels - 1) +
+                    " LOD levels");
+            }
+            PrintLine("Writing geometry " + String(j) + " LOD levels with triangle counts " + triangleCounts);
+        }
+        
+        if (lodIndices.Empty())
+            continue;
+        
+        SharedPtr<IndexBuffer> newIb(new IndexBuffer(context_));
+        newIb->SetSize(ib->GetIndexCount() + lodIndices.Size(), largeIndices);
+        unsigned char* newIndexData = newIb->GetShadowData();
+        memcpy(newIndexData, indexData, ib->GetIndexCount() * ib->GetIndexSize());
+        for (unsigned j = 0; j < lodIndices.Size(); ++j)
+        {
+            if (largeIndices)
+                ((unsigned*)newIndexData)[ib->GetIndexCount() + j] = lodIndices[j];
+            else
+                ((unsigned short*)newIndexData)[ib->GetIndexCount() + j] = lodIndices[j];
+        }
+        
+        for (unsigned j = 0; j < geometries.Size(); ++j)
+        {
+            if (geometries[j][0]->GetIndexBuffer() == ib)
+                geometries[j][0]->SetIndexBuffer(newIb);
+        }
+        for (unsigned j = 0; j < lodGeometries.Size(); ++j)
+        {
+            lodGeometries[j]->SetIndexBuffer(newIb);
+            lodGeometries[j]->SetDrawRange(TRIANGLE_LIST, lodIndexStarts[j], lodIndexCounts[j], true);
+        }
+        
+        ibVector[i] = newIb;
+    }
+}
+
+void SimplifyTriangles(const PODVector<Vector3>& positions, const PODVector<unsigned char>& bones, PODVector<unsigned>& indices,
+    unsigned targetIndices)
+{
+    unsigned numVertices = positions.Size();
+    
+    // Group the vertices that share a position. Vertices of the same group that differ by other attributes form seams
+    PODVector<LodPosition> sortedPositions(numVertices);
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        sortedPositions[i].position_ = positions[i];
+        sortedPositions[i].index_ = i;
+    }
+    Sort(sortedPositions.Begin(), sortedPositions.End(), CompareLodPositions);
+    
+    PODVector<unsigned> groups(numVertices);
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        unsigned index = sortedPositions[i].index_;
+        if (i && sortedPositions[i].position_ == sortedPositions[i - 1].position_)
+            groups[index] = groups[sortedPositions[i - 1].index_];
+        else
+            groups[index] = index;
+    }
+    
+    // Accumulate the area-weighted triangle plane quadrics to the position groups
+    Vector<LodQuadric> quadrics(numVertices);
+    for (unsigned i = 0; i < indices.Size(); i += 3)
+    {
+        const Vector3& v0 = positions[indices[i]];
+        Vector3 normal = (positions[indices[i + 1]] - v0).CrossProduct(positions[indices[i + 2]] - v0);
+        float doubleArea = normal.Length();
+        if (doubleArea < M_EPSILON)
+            continue;
+        
+        normal /= doubleArea;
+        for (unsigned j = 0; j < 3; ++j)
+            AddPlaneQuadric(quadrics[groups[indices[i + j]]], normal, v0, doubleArea * 0.5f);
+    }
+    
+    PODVector<unsigned> identity(numVertices);
+    for (unsigned i = 0; i < numVertices; ++i)
+        identity[i] = i;
+    
+    PODVector<unsigned> vertexOffsets;
+    PODVector<unsigned> vertexTriangles;
+    PODVector<unsigned> groupOffsets;
+    PODVector<unsigned> groupTriangles;
+    PODVector<unsigned> openIn(numVertices);
+    PODVector<unsigned> openOut(numVertices);
+    PODVector<unsigned> wedges(numVertices);
+    PODVector<unsigned char> kinds(numVertices);
+    PODVector<bool> locked(numVertices);
+    PODVector<unsigned> collapseRemap(numVertices);
+    PODVector<LodEdgeCollapse> collapses;
+    
+    for (unsigned pass = 0; indices.Size() > targetIndices; ++pass)
+    {
+        BuildLodAdjacency(indices, identity, vertexOffsets, vertexTriangles);
+        BuildLodAdjacency(indices, groups, groupOffsets, groupTriangles);
+        
+        // Find the open edges, which have no opposite edge using the same vertices. A vertex that has several open edges
+        // in the same direction is marked by referring to itself
+        for (unsigned i = 0; i < numVertices; ++i)
+        {
+            openIn[i] = M_MAX_UNSIGNED;
+            openOut[i] = M_MAX_UNSIGNED;
+        }
+        for (unsigned i = 0; i < indices.Size(); ++i)
+        {
+            unsigned from = indices[i];
+            unsigned to = indices[i % 3 == 2 ? i - 2 : i + 1];
+            if (HasLodEdge(indices, vertexOffsets, vertexTriangles, to, from))
+                continue;
+            
+            openOut[from] = openOut[from] == M_MAX_UNSIGNED ? to : from;
+            openIn[to] = openIn[to] == M_MAX_UNSIGNED ? from : to;
+            
+            // On the first pass, also add quadrics that keep the open borders and seams from moving sideways
+            if (!pass)
+            {
+                unsigned triangle = i - i % 3;
+                const Vector3& v0 = positions[indices[triangle]];
+                Vector3 normal = (positions[indices[triangle + 1]] - v0).CrossProduct(positions[indices[triangle + 2]] - v0);
+                Vector3 edge = positions[to] - positions[from];
+                Vector3 edgeNormal = edge.CrossProduct(normal).Normalized();
+                float weight = edge.LengthSquared() * LOD_BOUNDARY_WEIGHT;
+                AddPlaneQuadric(quadrics[groups[from]], edgeNormal, positions[from], weight);
+                AddPlaneQuadric(quadrics[groups[to]], edgeNormal, positions[from], weight);
+            }
+        }
+        
+        // Link the used vertices of each position group into a circular list
+        for (unsigned i = 0; i < numVertices;)
+        {
+            unsigned end = i + 1;
+            while (end < numVertices && sortedPositions[end].position_ == sortedPositions[i].position_)
+                ++end;
+            
+            unsigned first = M_MAX_UNSIGNED;
+            unsigned last = M_MAX_UNSIGNED;
+            for (unsigned j = i; j < end; ++j)
+            {
+                unsigned index = sortedPositions[j].index_;
+                wedges[index] = index;
+                if (vertexOffsets[index + 1] == vertexOffsets[index])
+                    continue;
+                
+                if (last != M_MAX_UNSIGNED)
+                    wedges[last] = index;
+                else
+                    first = index;
+                last = index;
+            }
+            if (last != M_MAX_UNSIGNED)
+                wedges[last] = first;
+            
+            i = end;
+        }
+        
+        // Classify the vertices. Border vertices may only move along their open edges, and seam vertices, which must have
+        // exactly two wedges whose open edges match, only along the seam together with their other wedge
+        for (unsigned i = 0; i < numVertices; ++i)
+        {
+            unsigned in = openIn[i];
+            unsigned out = openOut[i];
+            unsigned wedge = wedges[i];
+            
+            if (wedge == i)
+            {
+                if (in == M_MAX_UNSIGNED && out == M_MAX_UNSIGNED)
+                    kinds[i] = LOD_MANIFOLD;
+                else if (in != M_MAX_UNSIGNED && in != i && out != M_MAX_UNSIGNED && out != i)
+                    kinds[i] = LOD_BORDER;
+                else
+                    kinds[i] = LOD_LOCKED;
+            }
+            else if (wedges[wedge] == i)
+            {
+                unsigned wedgeIn = openIn[wedge];
+                unsigned wedgeOut = openOut[wedge];
+                if (in != M_MAX_UNSIGNED && in != i && out != M_MAX_UNSIGNED && out != i && wedgeIn != M_MAX_UNSIGNED &&
+                    wedgeIn != wedge && wedgeOut != M_MAX_UNSIGNED && wedgeOut != wedge && groups[in] == groups[wedgeOut] &&
+                    groups[out] == groups[wedgeIn] && groups[in] != groups[out])
+                    kinds[i] = LOD_SEAM;
+                else
+                    kinds[i] = LOD_LOCKED;
+            }
+            else
+                kinds[i] = LOD_LOCKED;
+        }
+        
+        // Collect the allowed collapses of each triangle edge in both directions
+        collapses.Clear();
+        for (unsigned i = 0; i < indices.Size(); ++i)
+        {
+            unsigned v0 = indices[i];
+            unsigned v1 = indices[i % 3 == 2 ? i - 2 : i + 1];
+            if (groups[v0] == groups[v1])
+                continue;
+            
+            for (unsigned j = 0; j < 2; ++j)
+            {
+                LodEdgeCollapse collapse;
+                collapse.source_ = j ? v1 : v0;
+                collapse.target_ = j ? v0 : v1;
+                collapse.siblingTarget_ = M_MAX_UNSIGNED;
+                
+                unsigned source = collapse.source_;
+                unsigned target = collapse.target_;
+                switch (kinds[source])
+                {
+                case LOD_MANIFOLD:
+                    break;
+                
+                case LOD_BORDER:
+                    if (target != openIn[source] && target != openOut[source])
+                        continue;
+                    break;
+                
+                case LOD_SEAM:
+                    if (target == openOut[source])
+                        collapse.siblingTarget_ = openIn[wedges[source]];
+                    else if (target == openIn[source])
+                        collapse.siblingTarget_ = openOut[wedges[source]];
+                    else
+                        continue;
+                    break;
+                
+                default:
+                    continue;
+                }
+                
+                if (!bones.Empty() && (bones[source] != bones[target] || (collapse.siblingTarget_ != M_MAX_UNSIGNED &&
+                    bones[wedges[source]] != bones[collapse.siblingTarget_])))
+                    continue;
+                
+                collapse.cost_ = GetQuadricError(quadrics[groups[source]], positions[target]);
+                collapses.Push(collapse);
+            }
+        }
+        
+        Sort(collapses.Begin(), collapses.End(), CompareLodEdgeCollapses);
+        
+        // Perform the cheapest collapses. Lock the neighbourhood of each collapsed vertex for the rest of the pass, so
+        // that the triangles it was checked against stay unchanged
+        for (unsigned i = 0; i < numVertices; ++i)
+        {
+            locked[i] = false;
+            collapseRemap[i] = i;
+        }
+        
+        unsigned removeGoal = (indices.Size() - targetIndices) / 3;
+        unsigned removed = 0;
+        for (unsigned i = 0; i < collapses.Size() && removed < removeGoal; ++i)
+        {
+            const LodEdgeCollapse& collapse = collapses[i];
+            unsigned sourceGroup = groups[collapse.source_];
+            unsigned targetGroup = groups[collapse.target_];
+            if (locked[sourceGroup] || locked[targetGroup])
+                continue;
+            
+            // Reject the collapse if a remaining triangle would flip or degenerate
+            const Vector3& targetPosition = positions[collapse.target_];
+            bool valid = true;
+            for (unsigned j = groupOffsets[sourceGroup]; j < groupOffsets[sourceGroup + 1] && valid; ++j)
+            {
+                unsigned triangle = groupTriangles[j] * 3;
+                Vector3 before[3];
+                Vector3 after[3];
+                bool removedTriangle = false;
+                for (unsigned k = 0; k < 3; ++k)
+                {
+                    unsigned group = groups[indices[triangle + k]];
+                    if (group == targetGroup)
+                        removedTriangle = true;
+                    before[k] = positions[indices[triangle + k]];
+                    after[k] = group == sourceGroup ? targetPosition : before[k];
+                }
+                if (removedTriangle)
+                    continue;
+                
+                Vector3 normalBefore = (before[1] - before[0]).CrossProduct(before[2] - before[0]);
+                Vector3 normalAfter = (after[1] - after[0]).CrossProduct(after[2] - after[0]);
+                if (normalBefore.DotProduct(normalAfter) <= LOD_FLIP_THRESHOLD * normalBefore.Length() * normalAfter.Length())
+                    valid = false;
+            }
+            if (!valid)
+                continue;
+            
+            for (unsigned j = groupOffsets[sourceGroup]; j < groupOffsets[sourceGroup + 1]; ++j)
+            {
+                unsigned triangle = groupTriangles[j] * 3;
+                for (unsigned k = 0; k < 3; ++k)
+                    locked[groups[indices[triangle + k]]] = true;
+            }
+            
+            collapseRemap[collapse.source_] = collapse.target_;
+            if (collapse.siblingTarget_ != M_MAX_UNSIGNED)
+                collapseRemap[wedges[collapse.source_]] = collapse.siblingTarget_;
+            AddQuadric(quadrics[targetGroup], quadrics[sourceGroup]);
+            removed += kinds[collapse.source_] == LOD_BORDER ? 1 : 2;
+        }
+        
+        if (!removed)
+            break;
+        
+        // Remap the indices and remove the triangles that collapsed
+        unsigned numIndices = 0;
+        for (unsigned i = 0; i < indices.Size(); i += 3)
+        {
+            unsigned v0 = collapseRemap[indices[i]];
+            unsigned v1 = collapseRemap[indices[i + 1]];
+            unsigned v2 = collapseRemap[indices[i + 2]];
+            if (groups[v0] == groups[v1] || groups[v1] == groups[v2] || groups[v2] == groups[v0])
+                continue;
+            
+            indices[numIndices++] = v0;
+            indices[numIndices++] = v1;
+            indices[numIndices++] = v2;
+        }
+        indices.Resize(numIndices);
+    }
+}
+
+void BuildLodAdjacency(const PODVector<unsigned>& indices, const PODVector<unsigned>& groups, PODVector<unsigned>& offsets,
+    PODVector<unsigned>& triangles)
+{
+    // List the triangles using each vertex or position group, grouped by the index of the vertex or the group
+    offsets.Resize(groups.Size() + 1);
+    for (unsigned i = 0; i < offsets.Size(); ++i)
+        offsets[i] = 0;
+    for (unsigned i = 0; i < indices.Size(); ++i)
+        ++offsets[groups[indices[i]] + 1];
+    for (unsigned i = 1; i < offsets.Size(); ++i)
+        offsets[i] += offsets[i - 1];
+    
+    PODVector<unsigned> fill(&offsets[0], offsets.Size() - 1);
+    triangles.Resize(indices.Size());
+    for (unsigned i = 0; i < indices.Size(); ++i)
+        triangles[fill[groups[indices[i]]]++] = i / 3;
+}
+
+bool HasLodEdge(const PODVector<unsigned>& indices, const PODVector<unsigned>& offsets, const PODVector<unsigned>& triangles,
+    unsigned from, unsigned to)
+{
+    for (unsigned i = offsets[from]; i < offsets[from + 1]; ++i)
+    {
+        unsigned triangle = triangles[i] * 3;
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            if (indices[triangle + j] == from && indices[triangle + (j + 1) % 3] == to)
+                return true;
+        }
+    }
+    
+    return false;
+}
+
+void AddPlaneQuadric(LodQuadric& quadric, const Vector3& normal, const Vector3& point, float weight)
+{
+    double a = normal.x_;
+    double b = normal.y_;
+    double c = normal.z_;
+    double d = -normal.DotProduct(point);
+    double* q = quadric.q_;
+    
+    q[0] += weight * a * a;
+    q[1] += weight * a * b;
+    q[2] += weight * a * c;
+    q[3] += weight * b * b;
+    q[4] += weight * b * c;
+    q[5] += weight * c * c;
+    q[6] += weight * a * d;
+    q[7] += weight * b * d;
+    q[8] += weight * c * d;
+    q[9] += weight * d * d;
+}
+
+void AddQuadric(LodQuadric& quadric, const LodQuadric& other)
+{
+    for (unsigned i = 0; i < 10; ++i)
+        quadric.q_[i] += other.q_[i];
+}
+
+float GetQuadricError(const LodQuadric& quadric, const Vector3& point)
+{
+    double x = point.x_;
+    double y = point.y_;
+    double z = point.z_;
+    const double* q = quadric.q_;
+    
+    double error = q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + q[3] * y * y + 2.0 * q[4] * y * z + q[5] * z * z +
+        2.0 * (q[6] * x + q[7] * y + q[8] * z) + q[9];
+    return Max((float)error, 0.0f);
+}
+
+bool CompareLodPositions(const LodPosition& lhs, const LodPosition& rhs)
+{
+    if (lhs.position_.x_ != rhs.position_.x_)
+        return lhs.position_.x_ < rhs.position_.x_;
+    if (lhs.position_.y_ != rhs.position_.y_)
+        return lhs.position_.y_ < rhs.position_.y_;
+    return lhs.position_.z_ < rhs.position_.z_;
+}
+
+bool CompareLodEdgeCollapses(const LodEdgeCollapse& lhs, const LodEdgeCollapse& rhs)
+{
+    return lhs.cost_ < rhs.cost_;
+}
+
 void BuildAndSaveAnimations(OutModel* model)
 {
     const PODVector<aiAnimation*>& animations = model ? model->animations_ : sceneAnimations_;
@@ -995,6 +1935,8 @@ void BuildAndSaveAnimations(OutModel* model)
         
         PrintLine("Writing animation " + animName + " length " + String(outAnim->GetLength()));
         Vector<AnimationTrack> tracks;
+        unsigned totalKeyFrames = 0;
+        unsigned keptKeyFrames = 0;
         for (unsigned j = 0; j < anim->mNumChannels; ++j)
         {
             aiNodeAnim* channel = anim->mChannels[j];
@@ -1067,6 +2009,7 @@ void BuildAndSaveAnimations(OutModel* model)
                 continue;
             }
             
+            Vector<AnimationKeyFrame> trackKeyFrames;
             unsigned keyFrames = channel->mNumPositionKeys;
             if (channel->mNumRotationKeys > keyFrames)
                 keyFrames = channel->mNumRotationKeys;
@@ -1121,13 +2064,33 @@ void BuildAndSaveAnimations(OutModel* model)
                 if (track.channelMask_ & CHANNEL_SCALE)
                     kf.scale_ = ToVector3(scale);
                 
-                track.keyFrames_.Push(kf);
+                trackKeyFrames.Push(kf);
             }
             
+            totalKeyFrames += trackKeyFrames.Size();
+            if (keyFrameTolerance_ > 0.0f)
+                ReduceKeyFrames(trackKeyFrames, track.channelMask_, keyFrameTolerance_);
+            keptKeyFrames += trackKeyFrames.Size();
+            
+            track.SetKeyFrames(trackKeyFrames);
             tracks.Push(track);
         }
         
         outAnim->SetTracks(tracks);
+        if (keyFrameTolerance_ > 0.0f)
+            PrintLine("Kept " + String(keptKeyFrames) + " of " + String(totalKeyFrames) + " keyframes");
+        if (compressAnimations_)
+        {
+            unsigned uncompressedSize = 0;
+            for (unsigned j = 0; j < tracks.Size(); ++j)
+                uncompressedSize += tracks[j].GetKeyFrameMemoryUse();
+            outAnim->Compress();
+            unsigned compressedSize = 0;
+            const Vector<AnimationTrack>& compressedTracks = outAnim->GetTracks();
+            for (unsigned j = 0; j < compressedTracks.Size(); ++j)
+                compressedSize += compressedTracks[j].GetKeyFrameMemoryUse();
+            PrintLine("Compressed keyframe data from " + String(uncompressedSize) + " to " + String(compressedSize) + " bytes");
+        }
         
         File outFile(context_);
         if (!outFile.Open(animOutName, FILE_WRITE))
@@ -1136,6 +2099,59 @@ void BuildAndSaveAnimations(OutModel* model)
     }
 }
 
+void ReduceKeyFrames(Vector<AnimationKeyFrame>& keyFrames, unsigned char channelMask, float tolerance)
+{
+    if (keyFrames.Size() < 3)
+        return;
+    
+    // Extend the span from the last kept keyframe for as long as the skipped keyframes can be interpolated within tolerance
+    Vector<AnimationKeyFrame> reduced;
+    reduced.Push(keyFrames[0]);
+    unsigned start = 0;
+    for (unsigned end = 2; end < keyFrames.Size(); ++end)
+    {
+        if (!CanInterpolateKeyFrames(keyFrames, channelMask, start, end, tolerance))
+        {
+            start = end - 1;
+            reduced.Push(keyFrames[start]);
+        }
+    }
+    reduced.Push(keyFrames.Back());
+    
+    keyFrames = reduced;
+}
+
+bool CanInterpolateKeyFrames(const Vector<AnimationKeyFrame>& keyFrames, unsigned char channelMask, unsigned start, unsigned end,
+    float tolerance)
+{
+    const AnimationKeyFrame& startKeyFrame = keyFrames[start];
+    const AnimationKeyFrame& endKeyFrame = keyFrames[end];
+    float timeInterval = endKeyFrame.time_ - startKeyFrame.time_;
+    if (timeInterval <= 0.0f)
+        return false;
+    
+    for (unsigned i = start + 1; i < end; ++i)
+    {
+        const AnimationKeyFrame& keyFrame = keyFrames[i];
+        float t = (keyFrame.time_ - startKeyFrame.time_) / timeInterval;
+        
+        if (channelMask & CHANNEL_POSITION && (startKeyFrame.position_.Lerp(endKeyFrame.position_, t) -
+            keyFrame.position_).Length() > tolerance)
+            return false;
+        if (channelMask & CHANNEL_ROTATION)
+        {
+            float dot = Abs(startKeyFrame.rotation_.Slerp(endKeyFrame.rotation_, t).DotProduct(keyFrame.rotation_));
+            if (2.0f * acosf(Min(dot, 1.0f)) > tolerance)
+                return false;
+        }
+        if (channelMask & CHANNEL_SCALE && (startKeyFrame.scale_.Lerp(endKeyFrame.scale_, t) -
+            keyFrame.scale_).Length() > tolerance)
+            return false;
+    }
+    
+    return true;
+}
+
 void ExportScene(const String& outName, bool asPrefab)
 {
     OutScene outScene;
@@ -1709,6 +2725,7 @@ void CombineLods(const PODVector<float>& lodDistances, const Vector<String>& mod
     outModel->SetSkeleton(srcModels[0]->GetSkeleton());
     outModel->SetGeometryBoneMappings(srcModels[0]->GetGeometryBoneMappings());
     outModel->SetBoundingBox(srcModels[0]->GetBoundingBox());
+    outModel->SetOccluderGeometry(srcModels[0]->GetOccluderGeometry());
     /// \todo Vertex morphs are ignored for now
     
     // Save the final model
@@ -0,0 +1,141 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Allocator.h"
+#include "Benchmarks.h"
+#include "ConcurrentAllocator.h"
+#include "Context.h"
+#include "Mutex.h"
+#include "ProcessUtils.h"
+#include "StringUtils.h"
+#include "Thread.h"
+#include "Timer.h"
+
+#include "DebugNew.h"
+
+static const unsigned NODE_SIZE = 32;
+static const unsigned NODES_PER_ROUND = 64;
+
+/// Benchmark thread that reserves and frees nodes either from a mutex-protected or a thread-safe allocator.
+class AllocatorBenchmarkThread : public RefCounted, public Thread
+{
+public:
+    /// Construct.
+    AllocatorBenchmarkThread(AllocatorBlock* allocator, Mutex* mutex, unsigned numRounds) :
+        allocator_(allocator),
+        mutex_(mutex),
+        numRounds_(numRounds)
+    {
+    }
+    
+    /// Reserve and free nodes in rounds, touching each node to simulate use.
+    virtual void ThreadFunction()
+    {
+        void* nodes[NODES_PER_ROUND];
+        
+        for (unsigned round = 0; round < numRounds_; ++round)
+        {
+            for (unsigned i = 0; i < NODES_PER_ROUND; ++i)
+            {
+                if (mutex_)
+                {
+                    MutexLock lock(*mutex_);
+                    nodes[i] = AllocatorReserve(allocator_);
+                }
+                else
+                    nodes[i] = AllocatorReserve(allocator_);
+                *static_cast<unsigned*>(nodes[i]) = i;
+            }
+            for (unsigned i = 0; i < NODES_PER_ROUND; ++i)
+            {
+                if (mutex_)
+                {
+                    MutexLock lock(*mutex_);
+                    AllocatorFree(allocator_, nodes[i]);
+                }
+                else
+                    AllocatorFree(allocator_, nodes[i]);
+            }
+        }
+    }
+    
+private:
+    /// Allocator.
+    AllocatorBlock* allocator_;
+    /// Mutex to lock around each operation, or null if not needed.
+    Mutex* mutex_;
+    /// Number of rounds to run.
+    unsigned numRounds_;
+};
+
+/// Run the benchmark threads to completion and return the elapsed time in milliseconds.
+static float RunAllocatorThreads(AllocatorBlock* allocator, Mutex* mutex, unsigned numThreads, unsigned numRounds)
+{
+    Vector<SharedPtr<AllocatorBenchmarkThread> > threads;
+    for (unsigned i = 0; i < numThreads; ++i)
+        threads.Push(SharedPtr<AllocatorBenchmarkThread>(new AllocatorBenchmarkThread(allocator, mutex, numRounds)));
+    
+    HiresTimer timer;
+    for (unsigned i = 0; i < numThreads; ++i)
+        threads[i]->Run();
+    for (unsigned i = 0; i < numThreads; ++i)
+        threads[i]->Stop();
+    
+    return (float)timer.GetUSec(false) / 1000.0f;
+}
+
+void RunAllocatorBenchmark(const Vector<String>& arguments)
+{
+    unsigned maxThreads = arguments.Size() > 0 ? ToUInt(arguments[0]) : GetNumPhysicalCPUs();
+    unsigned numOperations = arguments.Size() > 1 ? ToUInt(arguments[1]) : 1000000;
+    if (!maxThreads || !numOperations)
+        ErrorExit("Number of threads and operations must be positive");
+    
+    // Each thread runs the same amount of operations, so ideal scaling keeps the elapsed time constant
+    unsigned numRounds = numOperations / (NODES_PER_ROUND * 2);
+    if (!numRounds)
+        numRounds = 1;
+    
+    SharedPtr<Context> context = CreateBenchmarkContext(false);
+    
+    // Single-threaded baseline without locking
+    AllocatorBlock* single = AllocatorInitialize(NODE_SIZE, NODES_PER_ROUND);
+    float baseTime = RunAllocatorThreads(single, 0, 1, numRounds);
+    AllocatorUninitialize(single);
+    
+    PrintLine("Unlocked single-threaded allocator: " + String(baseTime) + " ms");
+    PrintLine("Threads\tMutex (ms)\tConcurrent (ms)\tSpeedup");
+    
+    for (unsigned numThreads = 1; numThreads <= maxThreads; ++numThreads)
+    {
+        Mutex mutex;
+        AllocatorBlock* locked = AllocatorInitialize(NODE_SIZE, NODES_PER_ROUND * numThreads);
+        float lockedTime = RunAllocatorThreads(locked, &mutex, numThreads, numRounds);
+        AllocatorUninitialize(locked);
+        
+        ConcurrentAllocator concurrent(NODE_SIZE);
+        float concurrentTime = RunAllocatorThreads(concurrent.GetAllocatorBlock(), 0, numThreads, numRounds);
+        
+        PrintLine(String(numThreads) + "\t" + String(lockedTime) + "\t" + String(concurrentTime) + "\t" +
+            String(lockedTime / concurrentTime));
+    }
+}
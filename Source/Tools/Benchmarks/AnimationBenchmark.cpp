@@ -0,0 +1,239 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "AnimatedModel.h"
+#include "Animation.h"
+#include "AnimationState.h"
+#include "Benchmarks.h"
+#include "Context.h"
+#include "Graphics.h"
+#include "Model.h"
+#include "ProcessUtils.h"
+#include "Scene.h"
+#include "StringUtils.h"
+#include "Timer.h"
+#include "VectorBuffer.h"
+
+#include "DebugNew.h"
+
+/// Find keyframe index by walking from the previous index, for comparison with the indexed lookup.
+static void GetKeyFrameIndexLinear(const AnimationTrack& track, float time, unsigned& index)
+{
+    unsigned numKeyFrames = track.GetNumKeyFrames();
+    if (index >= numKeyFrames)
+        index = numKeyFrames - 1;
+    
+    while (index && time < track.GetKeyFrameTime(index))
+        --index;
+    while (index < numKeyFrames - 1 && time >= track.GetKeyFrameTime(index + 1))
+        ++index;
+}
+
+/// Return time in milliseconds to find the keyframe indices of random times, either by walking linearly or indexed. Accumulate the indices into a checksum.
+static float MeasureKeyFrameLookup(const AnimationTrack& track, const PODVector<float>& times, bool linear, unsigned& checksum)
+{
+    HiresTimer timer;
+    unsigned index = 0;
+    for (unsigned i = 0; i < times.Size(); ++i)
+    {
+        if (linear)
+            GetKeyFrameIndexLinear(track, times[i], index);
+        else
+            track.GetKeyFrameIndex(times[i], index);
+        checksum += index;
+    }
+    
+    return (float)timer.GetUSec(false) / 1000.0f;
+}
+
+void RunAnimationBenchmark(const Vector<String>& arguments)
+{
+    unsigned numTracks = arguments.Size() > 0 ? ToUInt(arguments[0]) : 60;
+    unsigned numKeyFrames = arguments.Size() > 1 ? ToUInt(arguments[1]) : 300;
+    if (!numTracks || numKeyFrames < 2)
+        ErrorExit("Number of tracks must be positive and number of keyframes at least 2");
+    
+    SharedPtr<Context> context = CreateBenchmarkContext(false);
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+    
+    // Build a bone chain skeleton with one track per bone, sampled at 30 frames per second. Like exported animations, every
+    // track has all channels, but only rotation is animated in all of them, position in some and scale in none
+    const float frameRate = 30.0f;
+    float length = (numKeyFrames - 1) / frameRate;
+    Skeleton skeleton;
+    Vector<AnimationTrack> tracks;
+    Vector<Vector<AnimationKeyFrame> > sourceKeyFrames(numTracks);
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < numTracks; ++i)
+    {
+        Bone bone;
+        bone.name_ = "Bone" + String(i);
+        bone.nameHash_ = bone.name_;
+        bone.parentIndex_ = i ? i - 1 : 0;
+        bone.initialPosition_ = Vector3(0.0f, 0.1f, 0.0f);
+        skeleton.GetModifiableBones().Push(bone);
+        
+        AnimationTrack track;
+        track.name_ = bone.name_;
+        track.nameHash_ = bone.nameHash_;
+        track.channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION | CHANNEL_SCALE;
+        bool animatePosition = i % 4 == 0;
+        float phase = Random(M_PI);
+        for (unsigned j = 0; j < numKeyFrames; ++j)
+        {
+            AnimationKeyFrame keyFrame;
+            keyFrame.time_ = j / frameRate;
+            float angle = sinf(keyFrame.time_ * 2.0f + phase) * 45.0f;
+            keyFrame.position_ = animatePosition ? Vector3(0.0f, 0.1f, 0.0f) + Vector3(sinf(keyFrame.time_ + phase), 0.0f,
+                cosf(keyFrame.time_ + phase)) * 0.05f : bone.initialPosition_;
+            keyFrame.rotation_ = Quaternion(angle, angle * 0.5f, 0.0f);
+            keyFrame.scale_ = Vector3::ONE;
+            sourceKeyFrames[i].Push(keyFrame);
+        }
+        track.SetKeyFrames(sourceKeyFrames[i]);
+        tracks.Push(track);
+    }
+    
+    // The root bone index is only assigned when loading, so round-trip the skeleton through a buffer
+    VectorBuffer skeletonBuffer;
+    skeleton.Save(skeletonBuffer);
+    skeletonBuffer.Seek(0);
+    skeleton.Load(skeletonBuffer);
+    SharedPtr<Model> model(new Model(context));
+    model->SetSkeleton(skeleton);
+    
+    SharedPtr<Animation> animations[2];
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        animations[i] = new Animation(context);
+        animations[i]->SetLength(length);
+        animations[i]->SetTracks(tracks);
+    }
+    animations[1]->Compress();
+    
+    // Measure the decompression error against the source keyframes
+    float maxPositionError = 0.0f;
+    float maxRotationError = 0.0f;
+    for (unsigned i = 0; i < numTracks; ++i)
+    {
+        const AnimationTrack& track = animations[1]->GetTracks()[i];
+        for (unsigned j = 0; j < numKeyFrames; ++j)
+        {
+            AnimationKeyFrame keyFrame;
+            track.GetKeyFrame(j, keyFrame);
+            const AnimationKeyFrame& source = sourceKeyFrames[i][j];
+            maxPositionError = Max(maxPositionError, (keyFrame.position_ - source.position_).Length());
+            maxRotationError = Max(maxRotationError, 2.0f * acosf(Min(Abs(keyFrame.rotation_.DotProduct(source.rotation_)), 1.0f)));
+        }
+    }
+    
+    // Sample both animations by evaluating animated models in node-free mode, so that scene nodes do not affect the timing
+    SharedPtr<Scene> scene(new Scene(context));
+    const unsigned numModels = 100;
+    const unsigned numFrames = 100;
+    FrameInfo frame;
+    frame.frameNumber_ = 1;
+    frame.timeStep_ = 1.0f / 60.0f;
+    HiresTimer timer;
+    
+    PrintLine("Format\tKeyframe memory (bytes)\tSampling (ms)\tTracks sampled per second\tRandom seek sampling (ms)");
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        unsigned memory = 0;
+        const Vector<AnimationTrack>& animationTracks = animations[i]->GetTracks();
+        for (unsigned j = 0; j < animationTracks.Size(); ++j)
+            memory += animationTracks[j].GetKeyFrameMemoryUse();
+        
+        PODVector<AnimatedModel*> models;
+        SetRandomSeed(2);
+        for (unsigned j = 0; j < numModels; ++j)
+        {
+            AnimatedModel* animatedModel = scene->CreateChild()->CreateComponent<AnimatedModel>();
+            animatedModel->SetModel(model);
+            animatedModel->SetNodeFreeAnimation(true);
+            AnimationState* state = animatedModel->AddAnimationState(animations[i]);
+            state->SetWeight(1.0f);
+            state->SetLooped(true);
+            state->SetTime(Random(length));
+            models.Push(animatedModel);
+        }
+        
+        timer.Reset();
+        for (unsigned j = 0; j < numFrames; ++j)
+        {
+            for (unsigned k = 0; k < numModels; ++k)
+            {
+                models[k]->GetAnimationState(0u)->AddTime(frame.timeStep_);
+                models[k]->Update(frame);
+            }
+        }
+        long long usec = timer.GetUSec(false);
+        
+        // Sample all tracks into pose buffers at random times, as when seeking
+        Vector<AnimationPose> poses(numModels);
+        SetRandomSeed(3);
+        timer.Reset();
+        for (unsigned j = 0; j < numFrames; ++j)
+        {
+            for (unsigned k = 0; k < numModels; ++k)
+                animations[i]->Sample(Random(length), true, poses[k]);
+        }
+        long long seekUsec = timer.GetUSec(false);
+        
+        PrintLine(String(i == 0 ? "Uncompressed" : "Compressed") + "\t" + String(memory) + "\t" + String((float)usec / 1000.0f) +
+            "\t" + String((unsigned)((double)numTracks * numModels * numFrames * 1000000.0 / Max((int)usec, 1))) + "\t" +
+            String((float)seekUsec / 1000.0f));
+        
+        scene->RemoveAllChildren();
+    }
+    
+    // Compare random keyframe lookups against walking linearly from the previous index. Evenly spaced keyframes use the
+    // calculated index, unevenly spaced ones the binary search
+    const unsigned numLookups = 100000;
+    PODVector<float> lookupTimes(numLookups);
+    SetRandomSeed(4);
+    for (unsigned i = 0; i < numLookups; ++i)
+        lookupTimes[i] = Random(length);
+    
+    Vector<AnimationKeyFrame> unevenKeyFrames = sourceKeyFrames[0];
+    for (unsigned i = 1; i < numKeyFrames - 1; ++i)
+        unevenKeyFrames[i].time_ = (i + Random(0.5f)) / frameRate;
+    AnimationTrack unevenTrack = tracks[0];
+    unevenTrack.SetKeyFrames(unevenKeyFrames);
+    
+    PrintLine("Keyframe spacing\tLinear lookup (ms)\tIndexed lookup (ms)");
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        const AnimationTrack& track = i == 0 ? tracks[0] : unevenTrack;
+        unsigned linearChecksum = 0;
+        unsigned indexedChecksum = 0;
+        float linearTime = MeasureKeyFrameLookup(track, lookupTimes, true, linearChecksum);
+        float indexedTime = MeasureKeyFrameLookup(track, lookupTimes, false, indexedChecksum);
+        if (linearChecksum != indexedChecksum)
+            ErrorExit("Indexed keyframe lookup does not match linear lookup");
+        
+        PrintLine(String(i == 0 ? "Even" : "Uneven") + "\t" + String(linearTime) + "\t" + String(indexedTime));
+    }
+    
+    PrintLine("Maximum position error " + String(maxPositionError) + ", rotation error " + String(maxRotationError) +
+        " radians");
+}
@@ -0,0 +1,194 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Batch.h"
+#include "Benchmarks.h"
+#include "Context.h"
+#include "ProcessUtils.h"
+#include "Random.h"
+#include "Sort.h"
+#include "StringUtils.h"
+#include "Timer.h"
+
+#include "DebugNew.h"
+
+static const unsigned BATCHES_PER_DRAWABLE = 3;
+
+static bool CompareBatchesState(Batch* lhs, Batch* rhs)
+{
+    if (lhs->sortKey_ != rhs->sortKey_)
+        return lhs->sortKey_ < rhs->sortKey_;
+    else
+        return lhs->distance_ < rhs->distance_;
+}
+
+static bool CompareBatchesFrontToBack(Batch* lhs, Batch* rhs)
+{
+    if (lhs->distance_ != rhs->distance_)
+        return lhs->distance_ < rhs->distance_;
+    else
+        return lhs->sortKey_ < rhs->sortKey_;
+}
+
+static bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
+{
+    if (lhs->distance_ != rhs->distance_)
+        return lhs->distance_ > rhs->distance_;
+    else
+        return lhs->sortKey_ < rhs->sortKey_;
+}
+
+/// Sort batches back to front with a comparison sort, as batch queues did before radix sorting.
+static void ComparisonSortBackToFront(PODVector<Batch*>& batches)
+{
+    Sort(batches.Begin(), batches.End(), CompareBatchesBackToFront);
+}
+
+/// Sort batches front to back with state sorting using comparison sorts, as batch queues did before radix sorting. The sort keys are rewritten, so they need to be restored afterward.
+static void ComparisonSortFrontToBack(PODVector<Batch*>& batches)
+{
+    Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
+    
+    HashMap<unsigned, unsigned> shaderRemapping;
+    HashMap<unsigned short, unsigned> materialRemapping;
+    HashMap<unsigned short, unsigned> geometryRemapping;
+    
+    for (PODVector<Batch*>::Iterator i = batches.Begin(); i != batches.End(); ++i)
+    {
+        Batch* batch = *i;
+        unsigned shaderID = (unsigned)(batch->sortKey_ >> 32);
+        unsigned short materialID = (unsigned short)(batch->sortKey_ >> 16);
+        unsigned short geometryID = (unsigned short)batch->sortKey_;
+        
+        if (!shaderRemapping.Contains(shaderID))
+            shaderRemapping[shaderID] = shaderRemapping.Size();
+        if (!materialRemapping.Contains(materialID))
+            materialRemapping[materialID] = materialRemapping.Size();
+        if (!geometryRemapping.Contains(geometryID))
+            geometryRemapping[geometryID] = geometryRemapping.Size();
+        
+        batch->sortKey_ = ((batch->sortKey_ >> 62) << 62) | (((unsigned long long)shaderRemapping[shaderID]) << 42) |
+            (((unsigned long long)materialRemapping[materialID]) << 22) | geometryRemapping[geometryID];
+    }
+    
+    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+}
+
+/// Return the amount of positions where two batch orders differ. Batches with the same distance and original sort key are interchangeable, as the comparison sorts are not stable.
+static unsigned CountMismatches(const PODVector<Batch*>& lhs, const PODVector<Batch*>& rhs, const Batch* first,
+    const PODVector<unsigned long long>& sortKeys)
+{
+    unsigned mismatches = 0;
+    for (unsigned i = 0; i < lhs.Size(); ++i)
+    {
+        if (lhs[i] != rhs[i] && (lhs[i]->distance_ != rhs[i]->distance_ || sortKeys[lhs[i] - first] !=
+            sortKeys[rhs[i] - first]))
+            ++mismatches;
+    }
+    return mismatches;
+}
+
+void RunBatchSortBenchmark(const Vector<String>& arguments)
+{
+    unsigned numBatches = arguments.Size() > 0 ? ToUInt(arguments[0]) : 20000;
+    unsigned numIterations = arguments.Size() > 1 ? ToUInt(arguments[1]) : 20;
+    if (!numBatches || !numIterations)
+        ErrorExit("Number of batches and iterations must be positive");
+    
+    SharedPtr<Context> context = CreateBenchmarkContext(false);
+    
+    // Use a typical amount of distinct shaders, materials and geometries, and random distances with enough precision to
+    // make ties between drawables unlikely. Every few batches share a distance like the batches of one drawable, which tests
+    // the state ordering of equal distances. The sort key layout is the same as Batch::CalculateSortKey() produces: base and
+    // alpha mask flags, shaders, light queue, material and geometry
+    SetRandomSeed(1);
+    BatchQueue queue;
+    queue.Clear(0);
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        Batch batch;
+        unsigned long long shaderID = (Rand() & 0xc000) | (Rand() % 50);
+        unsigned long long lightQueueID = Rand() % 4;
+        unsigned long long materialID = Rand() % 200;
+        unsigned long long geometryID = Rand() % 500;
+        batch.sortKey_ = (shaderID << 48) | (lightQueueID << 32) | (materialID << 16) | geometryID;
+        batch.distance_ = i % BATCHES_PER_DRAWABLE ? queue.batches_.Back().distance_ : (float)((unsigned)Rand() << 15 |
+            (unsigned)Rand()) / 1000000.0f;
+        queue.batches_.Push(batch);
+    }
+    
+    PODVector<unsigned long long> sortKeys(numBatches);
+    PODVector<float> distances(numBatches);
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        sortKeys[i] = queue.batches_[i].sortKey_;
+        distances[i] = queue.batches_[i].distance_;
+    }
+    
+    PrintLine("Sort\tComparison sort (ms)\tRadix sort (ms)\tSpeedup\tMismatches");
+    PODVector<Batch*> reference(numBatches);
+    HiresTimer timer;
+    
+    // The last two passes put all batches at the same distance, like an orthographic sprite layer or a headless run
+    for (unsigned pass = 0; pass < 4; ++pass)
+    {
+        long long comparisonUSec = 0;
+        long long radixUSec = 0;
+        bool backToFront = (pass & 1) == 0;
+        
+        for (unsigned j = 0; j < numBatches; ++j)
+            queue.batches_[j].distance_ = pass < 2 ? distances[j] : 0.0f;
+        
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            for (unsigned j = 0; j < numBatches; ++j)
+                reference[j] = &queue.batches_[j];
+            
+            timer.Reset();
+            if (backToFront)
+                ComparisonSortBackToFront(reference);
+            else
+                ComparisonSortFrontToBack(reference);
+            comparisonUSec += timer.GetUSec(false);
+            
+            for (unsigned j = 0; j < numBatches; ++j)
+                queue.batches_[j].sortKey_ = sortKeys[j];
+            
+            timer.Reset();
+            if (backToFront)
+                queue.SortBackToFront();
+            else
+                queue.SortFrontToBack();
+            radixUSec += timer.GetUSec(false);
+        }
+        
+        float comparisonMs = (float)comparisonUSec / 1000.0f / numIterations;
+        float radixMs = (float)radixUSec / 1000.0f / numIterations;
+        unsigned mismatches = CountMismatches(reference, queue.sortedBatches_, &queue.batches_[0], sortKeys);
+        String name = String(backToFront ? "Back to front" : "Front to back") + (pass < 2 ? "" : ", equal distances");
+        PrintLine(name + "\t" + String(comparisonMs) + "\t" + String(radixMs) + "\t" + String(radixMs > 0.0f ? comparisonMs /
+            radixMs : 0.0f) + "\t" + String(mismatches));
+        
+        for (unsigned j = 0; j < numBatches; ++j)
+            queue.batches_[j].sortKey_ = sortKeys[j];
+    }
+}
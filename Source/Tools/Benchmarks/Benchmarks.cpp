@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Atomic.h"
+#include "Benchmarks.h"
+#include "Context.h"
+#include "ProcessUtils.h"
+#include "Timer.h"
+#include "WorkQueue.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+static volatile int numGlobalAllocations = 0;
+
+// Replace the global allocation functions to count every heap allocation. Defined before DebugNew.h, which may redefine new
+void* operator new(size_t size)
+{
+    AtomicIncrement(&numGlobalAllocations);
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    AtomicIncrement(&numGlobalAllocations);
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) throw()
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) throw()
+{
+    free(ptr);
+}
+
+#include "DebugNew.h"
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+unsigned GetNumGlobalAllocations()
+{
+    return (unsigned)numGlobalAllocations;
+}
+
+SharedPtr<Context> CreateBenchmarkContext(bool withWorkQueue)
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    if (withWorkQueue)
+        context->RegisterSubsystem(new WorkQueue(context));
+    return context;
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() < 1)
+    {
+        ErrorExit(
+            "Usage: Benchmarks <benchmark> [options]\n\n"
+            "Benchmarks:\n"
+            "allocator [max threads] [operations]  Node allocator contention from 1 to max threads\n"
+            "animation [tracks] [keyframes]        Animation memory use, compression error, sampling and seek speed\n"
+            "batchsort [batches] [iterations]      Batch queue sorting with comparison and radix sort\n"
+            "culling [drawables] [levels]          Octree frustum culling per drawable and batched\n"
+            "hashmap [elements] [iterations]       HashMap and FlatHashMap insert, find, iterate and erase\n"
+            "log [max threads] [messages]          Log throughput synchronously and asynchronously\n"
+            "math [operations] [iterations]        Math operations against scalar reference implementations\n"
+            "rendering [static models] [animated models] [lights] [particle emitters] [frames] [worker threads] [reprojection frames]\n"
+            "                                      Headless rendering stage timings as JSON\n"
+            "sceneload [nodes] [iterations]        Scene load and XML parsing time and heap allocations\n"
+            "staticindex [drawables] [levels]      Octree and static drawable index frustum and ray queries\n"
+            "workqueue [max threads] [items]       WorkQueue scaling from 0 to max worker threads\n"
+        );
+    }
+    
+    String benchmark = arguments[0].ToLower();
+    Vector<String> benchmarkArguments;
+    for (unsigned i = 1; i < arguments.Size(); ++i)
+        benchmarkArguments.Push(arguments[i]);
+    
+    if (benchmark == "allocator")
+        RunAllocatorBenchmark(benchmarkArguments);
+    else if (benchmark == "animation")
+        RunAnimationBenchmark(benchmarkArguments);
+    else if (benchmark == "batchsort")
+        RunBatchSortBenchmark(benchmarkArguments);
+    else if (benchmark == "culling")
+        RunCullingBenchmark(benchmarkArguments);
+    else if (benchmark == "hashmap")
+        RunHashMapBenchmark(benchmarkArguments);
+    else if (benchmark == "log")
+        RunLogBenchmark(benchmarkArguments);
+    else if (benchmark == "math")
+        RunMathBenchmark(benchmarkArguments);
+    else if (benchmark == "rendering")
+        RunRenderingBenchmark(benchmarkArguments);
+    else if (benchmark == "sceneload")
+        RunSceneLoadBenchmark(benchmarkArguments);
+    else if (benchmark == "staticindex")
+        RunStaticIndexBenchmark(benchmarkArguments);
+    else if (benchmark == "workqueue")
+        RunWorkQueueBenchmark(benchmarkArguments);
+    else
+        ErrorExit("Unrecognized benchmark " + benchmark);
+}
@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Ptr.h"
+#include "Str.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+class Context;
+
+}
+
+using namespace Urho3D;
+
+/// Create the execution context for a benchmark. Registers the Time subsystem, which initializes the high-resolution timer frequency, and optionally the WorkQueue subsystem.
+SharedPtr<Context> CreateBenchmarkContext(bool withWorkQueue);
+/// Return the number of global operator new calls made so far. Counts all heap allocations of the process, unlike GetNumHeapAllocations() which counts only the containers' own allocations. When the Urho3D library is a Windows DLL, its allocations are not included.
+unsigned GetNumGlobalAllocations();
+
+/// Run the thread-safe node allocator benchmark.
+void RunAllocatorBenchmark(const Vector<String>& arguments);
+/// Run the compressed and uncompressed animation memory use and sampling benchmark.
+void RunAnimationBenchmark(const Vector<String>& arguments);
+/// Run the batch queue sorting benchmark comparing comparison and radix sorting.
+void RunBatchSortBenchmark(const Vector<String>& arguments);
+/// Run the octree frustum culling benchmark.
+void RunCullingBenchmark(const Vector<String>& arguments);
+/// Run the HashMap and FlatHashMap comparison benchmark.
+void RunHashMapBenchmark(const Vector<String>& arguments);
+/// Run the synchronous and asynchronous logging benchmark.
+void RunLogBenchmark(const Vector<String>& arguments);
+/// Run the math operation benchmark comparing scalar and SSE implementations.
+void RunMathBenchmark(const Vector<String>& arguments);
+/// Run the headless rendering benchmark on a procedurally built scene and report per-stage timings as JSON.
+void RunRenderingBenchmark(const Vector<String>& arguments);
+/// Run the scene load and XML parsing heap allocation benchmark.
+void RunSceneLoadBenchmark(const Vector<String>& arguments);
+/// Run the octree and static drawable index frustum and ray query benchmark.
+void RunStaticIndexBenchmark(const Vector<String>& arguments);
+/// Run the WorkQueue thread scaling benchmark.
+void RunWorkQueueBenchmark(const Vector<String>& arguments);
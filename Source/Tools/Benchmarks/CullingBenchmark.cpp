@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Benchmarks.h"
+#include "Context.h"
+#include "Graphics.h"
+#include "Octree.h"
+#include "OctreeQuery.h"
+#include "ProcessUtils.h"
+#include "Scene.h"
+#include "StringUtils.h"
+#include "Timer.h"
+#include "Zone.h"
+
+#include "DebugNew.h"
+
+/// %Frustum octree query that tests each drawable's bounding box separately, as before the octants stored the bounding boxes.
+class PerDrawableFrustumOctreeQuery : public FrustumOctreeQuery
+{
+public:
+    /// Construct with frustum and query parameters.
+    PerDrawableFrustumOctreeQuery(PODVector<Drawable*>& result, const Frustum& frustum, unsigned char drawableFlags = DRAWABLE_ANY,
+        unsigned viewMask = DEFAULT_VIEWMASK) :
+        FrustumOctreeQuery(result, frustum, drawableFlags, viewMask)
+    {
+    }
+    
+    /// Intersection test for drawables. Ignore the octant's bounding boxes.
+    virtual void TestDrawables(Drawable** start, Drawable** end, const float* bounds, bool inside)
+    {
+        FrustumOctreeQuery::TestDrawables(start, end, inside);
+    }
+};
+
+void RunCullingBenchmark(const Vector<String>& arguments)
+{
+    unsigned numDrawables = arguments.Size() > 0 ? ToUInt(arguments[0]) : 100000;
+    unsigned numLevels = arguments.Size() > 1 ? ToUInt(arguments[1]) : 6;
+    if (!numDrawables || !numLevels)
+        ErrorExit("Number of drawables and octree levels must be positive");
+    
+    SharedPtr<Context> context = CreateBenchmarkContext(true);
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+    
+    // Scatter zones of varying size as drawables, as they need no resources to define their bounding boxes
+    SharedPtr<Scene> scene(new Scene(context));
+    Octree* octree = scene->CreateComponent<Octree>();
+    octree->SetSize(BoundingBox(-2000.0f, 2000.0f), numLevels);
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < numDrawables; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(Random(-2000.0f, 2000.0f), Random(-50.0f, 50.0f), Random(-2000.0f, 2000.0f)));
+        float size = Random(0.5f, 10.0f);
+        node->CreateComponent<Zone>()->SetBoundingBox(BoundingBox(-size, size));
+    }
+    
+    FrameInfo frame;
+    frame.frameNumber_ = 1;
+    frame.timeStep_ = 0.0f;
+    octree->Update(frame);
+    
+    PrintLine("Test\tTime (ms)\tVisible drawables");
+    const unsigned numIterations = 100;
+    PODVector<Drawable*> result;
+    HiresTimer timer;
+    
+    for (unsigned pass = 0; pass < 2; ++pass)
+    {
+        long long usec = 0;
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            // Rotate the camera around, so that all parts of the octree are visited
+            Frustum frustum;
+            frustum.Define(60.0f, 16.0f / 9.0f, 1.0f, 0.1f, 1000.0f, Matrix3x4(Vector3::ZERO, Quaternion(0.0f, 360.0f * i /
+                numIterations, 0.0f), 1.0f));
+            result.Clear();
+            
+            timer.Reset();
+            if (pass == 0)
+            {
+                PerDrawableFrustumOctreeQuery query(result, frustum, DRAWABLE_ZONE);
+                octree->GetDrawables(query);
+            }
+            else
+            {
+                FrustumOctreeQuery query(result, frustum, DRAWABLE_ZONE);
+                octree->GetDrawables(query);
+            }
+            usec += timer.GetUSec(false);
+        }
+        
+        PrintLine(String(pass == 0 ? "Per drawable" : "Batched") + "\t" + String((float)usec / 1000.0f / numIterations) + "\t" +
+            String(result.Size()));
+    }
+}
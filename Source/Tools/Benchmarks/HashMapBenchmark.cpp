@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Benchmarks.h"
+#include "Context.h"
+#include "FlatHashMap.h"
+#include "HashMap.h"
+#include "ProcessUtils.h"
+#include "Random.h"
+#include "StringUtils.h"
+#include "Timer.h"
+
+#include "DebugNew.h"
+
+/// Benchmarked hash map operations.
+enum HashMapOperation
+{
+    HMO_INSERT = 0,
+    HMO_FIND,
+    HMO_ITERATE,
+    HMO_ERASE,
+    MAX_HASHMAP_OPERATIONS
+};
+
+static const char* operationNames[] =
+{
+    "Insert",
+    "Find",
+    "Iterate",
+    "Erase"
+};
+
+/// Run all operations on a hash map type and accumulate the time taken by each. Return a checksum so that the lookups are not optimized away.
+template <class T, class U> unsigned BenchmarkHashMap(const Vector<U>& keys, const Vector<U>& lookupKeys, unsigned numIterations,
+    long long* usec)
+{
+    unsigned checksum = 0;
+    HiresTimer timer;
+    
+    for (unsigned i = 0; i < numIterations; ++i)
+    {
+        T map;
+        
+        timer.Reset();
+        for (unsigned j = 0; j < keys.Size(); ++j)
+            map[keys[j]] = j;
+        usec[HMO_INSERT] += timer.GetUSec(true);
+        
+        for (unsigned j = 0; j < lookupKeys.Size(); ++j)
+        {
+            typename T::ConstIterator k = map.Find(lookupKeys[j]);
+            if (k != map.End())
+                checksum += k->second_;
+        }
+        usec[HMO_FIND] += timer.GetUSec(true);
+        
+        for (typename T::ConstIterator j = map.Begin(); j != map.End(); ++j)
+            checksum ^= j->second_;
+        usec[HMO_ITERATE] += timer.GetUSec(true);
+        
+        for (unsigned j = 0; j < keys.Size(); ++j)
+            map.Erase(keys[j]);
+        usec[HMO_ERASE] += timer.GetUSec(true);
+    }
+    
+    return checksum;
+}
+
+/// Compare HashMap and FlatHashMap with a key type and print the average time of each operation.
+template <class T> unsigned CompareHashMaps(const String& keyName, const Vector<T>& keys, const Vector<T>& lookupKeys,
+    unsigned numIterations)
+{
+    long long hashMapUSec[MAX_HASHMAP_OPERATIONS];
+    long long flatHashMapUSec[MAX_HASHMAP_OPERATIONS];
+    for (unsigned i = 0; i < MAX_HASHMAP_OPERATIONS; ++i)
+        hashMapUSec[i] = flatHashMapUSec[i] = 0;
+    
+    unsigned checksum = BenchmarkHashMap<HashMap<T, unsigned> >(keys, lookupKeys, numIterations, hashMapUSec);
+    checksum += BenchmarkHashMap<FlatHashMap<T, unsigned> >(keys, lookupKeys, numIterations, flatHashMapUSec);
+    
+    for (unsigned i = 0; i < MAX_HASHMAP_OPERATIONS; ++i)
+    {
+        float hashMapMs = (float)hashMapUSec[i] / 1000.0f / numIterations;
+        float flatHashMapMs = (float)flatHashMapUSec[i] / 1000.0f / numIterations;
+        PrintLine(keyName + "\t" + operationNames[i] + "\t" + String(hashMapMs) + "\t" + String(flatHashMapMs) + "\t" +
+            String(flatHashMapMs > 0.0f ? hashMapMs / flatHashMapMs : 0.0f));
+    }
+    
+    return checksum;
+}
+
+void RunHashMapBenchmark(const Vector<String>& arguments)
+{
+    unsigned numElements = arguments.Size() > 0 ? ToUInt(arguments[0]) : 100000;
+    unsigned numIterations = arguments.Size() > 1 ? ToUInt(arguments[1]) : 10;
+    if (!numElements || !numIterations)
+        ErrorExit("Number of elements and iterations must be positive");
+    
+    SharedPtr<Context> context = CreateBenchmarkContext(false);
+    
+    // Use random integer keys, like object IDs and hashes, and string keys of typical resource name length. Half of the lookups miss
+    SetRandomSeed(1);
+    Vector<unsigned> intKeys;
+    Vector<unsigned> intLookupKeys;
+    Vector<String> stringKeys;
+    Vector<String> stringLookupKeys;
+    for (unsigned i = 0; i < numElements; ++i)
+    {
+        unsigned key = (unsigned)Rand() << 16 | (unsigned)Rand();
+        intKeys.Push(key);
+        stringKeys.Push("Models/Object" + String(key) + ".mdl");
+    }
+    for (unsigned i = 0; i < numElements; ++i)
+    {
+        if (i & 1)
+        {
+            intLookupKeys.Push(intKeys[Rand() % numElements]);
+            stringLookupKeys.Push(stringKeys[Rand() % numElements]);
+        }
+        else
+        {
+            unsigned key = (unsigned)Rand() << 16 | (unsigned)Rand();
+            intLookupKeys.Push(key);
+            stringLookupKeys.Push("Models/Missing" + String(key) + ".mdl");
+        }
+    }
+    
+    PrintLine("Key\tOperation\tHashMap (ms)\tFlatHashMap (ms)\tSpeedup");
+    unsigned checksum = CompareHashMaps("Int", intKeys, intLookupKeys, numIterations);
+    checksum += CompareHashMaps("String", stringKeys, stringLookupKeys, numIterations);
+    
+    // Use the result so that the lookups are not optimized away
+    if (!checksum)
+        PrintLine("Checksum was zero");
+}
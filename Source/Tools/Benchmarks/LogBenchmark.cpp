@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Benchmarks.h"
+#include "Context.h"
+#include "FileSystem.h"
+#include "Log.h"
+#include "ProcessUtils.h"
+#include "StringUtils.h"
+#include "Thread.h"
+#include "Timer.h"
+
+#include "DebugNew.h"
+
+static const String LOG_FILE_NAME("LogBenchmark.log");
+
+/// Benchmark thread that writes log messages.
+class LogBenchmarkThread : public RefCounted, public Thread
+{
+public:
+    /// Construct.
+    LogBenchmarkThread(unsigned numMessages) :
+        numMessages_(numMessages)
+    {
+    }
+    
+    /// Write the messages.
+    virtual void ThreadFunction()
+    {
+        for (unsigned i = 0; i < numMessages_; ++i)
+            Log::Write(LOG_INFO, "Log benchmark message " + String(i));
+    }
+    
+private:
+    /// Number of messages to write.
+    unsigned numMessages_;
+};
+
+/// Write the messages from the given amount of threads, or from the main thread if zero. Output the time spent writing, and the total time until the messages are in the log file, in milliseconds.
+static void RunLogThreads(Log* log, unsigned numThreads, unsigned numMessages, float& writeTime, float& totalTime)
+{
+    HiresTimer timer;
+    
+    if (!numThreads)
+    {
+        for (unsigned i = 0; i < numMessages; ++i)
+            Log::Write(LOG_INFO, "Log benchmark message " + String(i));
+    }
+    else
+    {
+        Vector<SharedPtr<LogBenchmarkThread> > threads;
+        for (unsigned i = 0; i < numThreads; ++i)
+            threads.Push(SharedPtr<LogBenchmarkThread>(new LogBenchmarkThread(numMessages / numThreads)));
+        for (unsigned i = 0; i < numThreads; ++i)
+            threads[i]->Run();
+        for (unsigned i = 0; i < numThreads; ++i)
+            threads[i]->Stop();
+    }
+    
+    writeTime = (float)timer.GetUSec(false) / 1000.0f;
+    Log::Flush();
+    totalTime = (float)timer.GetUSec(false) / 1000.0f;
+}
+
+void RunLogBenchmark(const Vector<String>& arguments)
+{
+    unsigned maxThreads = arguments.Size() > 0 ? ToUInt(arguments[0]) : GetNumPhysicalCPUs();
+    unsigned numMessages = arguments.Size() > 1 ? ToUInt(arguments[1]) : 100000;
+    if (!numMessages)
+        ErrorExit("Number of messages must be positive");
+    
+    SharedPtr<Context> context = CreateBenchmarkContext(false);
+    context->RegisterSubsystem(new FileSystem(context));
+    Log* log = new Log(context);
+    context->RegisterSubsystem(log);
+    
+    // Only the log file is written to, as printing to the console would dominate the results
+    log->SetQuiet(true);
+    log->Open(LOG_FILE_NAME);
+    
+    PrintLine("Mode\tThreads\tWrite (msg/s)\tTotal (msg/s)");
+    
+    for (unsigned async = 0; async < 2; ++async)
+    {
+        log->SetAsync(async != 0);
+        
+        // Outside the main thread messages are always queued, so they are only measured with the background writer
+        unsigned numThreads = async ? maxThreads : 0;
+        for (unsigned threads = 0; threads <= numThreads; ++threads)
+        {
+            float writeTime, totalTime;
+            RunLogThreads(log, threads, numMessages, writeTime, totalTime);
+            PrintLine(String(async ? "Async" : "Sync") + "\t" + String(threads) + "\t" + String(numMessages / writeTime *
+                1000.0f) + "\t" + String(numMessages / totalTime * 1000.0f));
+        }
+    }
+    
+    log->SetAsync(false);
+    log->Close();
+    context->GetSubsystem<FileSystem>()->Delete(LOG_FILE_NAME);
+}
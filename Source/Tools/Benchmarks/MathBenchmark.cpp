@@ -0,0 +1,290 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Benchmarks.h"
+#include "Context.h"
+#include "Frustum.h"
+#include "ProcessUtils.h"
+#include "StringUtils.h"
+#include "Timer.h"
+
+#include "DebugNew.h"
+
+/// Scalar reference of 3x4 matrix multiplication.
+static Matrix3x4 MultiplyScalar(const Matrix3x4& lhs, const Matrix3x4& rhs)
+{
+    return Matrix3x4(
+        lhs.m00_ * rhs.m00_ + lhs.m01_ * rhs.m10_ + lhs.m02_ * rhs.m20_,
+        lhs.m00_ * rhs.m01_ + lhs.m01_ * rhs.m11_ + lhs.m02_ * rhs.m21_,
+        lhs.m00_ * rhs.m02_ + lhs.m01_ * rhs.m12_ + lhs.m02_ * rhs.m22_,
+        lhs.m00_ * rhs.m03_ + lhs.m01_ * rhs.m13_ + lhs.m02_ * rhs.m23_ + lhs.m03_,
+        lhs.m10_ * rhs.m00_ + lhs.m11_ * rhs.m10_ + lhs.m12_ * rhs.m20_,
+        lhs.m10_ * rhs.m01_ + lhs.m11_ * rhs.m11_ + lhs.m12_ * rhs.m21_,
+        lhs.m10_ * rhs.m02_ + lhs.m11_ * rhs.m12_ + lhs.m12_ * rhs.m22_,
+        lhs.m10_ * rhs.m03_ + lhs.m11_ * rhs.m13_ + lhs.m12_ * rhs.m23_ + lhs.m13_,
+        lhs.m20_ * rhs.m00_ + lhs.m21_ * rhs.m10_ + lhs.m22_ * rhs.m20_,
+        lhs.m20_ * rhs.m01_ + lhs.m21_ * rhs.m11_ + lhs.m22_ * rhs.m21_,
+        lhs.m20_ * rhs.m02_ + lhs.m21_ * rhs.m12_ + lhs.m22_ * rhs.m22_,
+        lhs.m20_ * rhs.m03_ + lhs.m21_ * rhs.m13_ + lhs.m22_ * rhs.m23_ + lhs.m23_
+    );
+}
+
+/// Scalar reference of 4x4 matrix multiplication.
+static Matrix4 MultiplyScalar(const Matrix4& lhs, const Matrix4& rhs)
+{
+    const float* l = lhs.Data();
+    const float* r = rhs.Data();
+    float result[16];
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        for (unsigned j = 0; j < 4; ++j)
+            result[i * 4 + j] = l[i * 4] * r[j] + l[i * 4 + 1] * r[4 + j] + l[i * 4 + 2] * r[8 + j] + l[i * 4 + 3] * r[12 + j];
+    }
+    return Matrix4(result);
+}
+
+/// Scalar reference of quaternion multiplication.
+static Quaternion MultiplyScalar(const Quaternion& lhs, const Quaternion& rhs)
+{
+    return Quaternion(
+        lhs.w_ * rhs.w_ - lhs.x_ * rhs.x_ - lhs.y_ * rhs.y_ - lhs.z_ * rhs.z_,
+        lhs.w_ * rhs.x_ + lhs.x_ * rhs.w_ + lhs.y_ * rhs.z_ - lhs.z_ * rhs.y_,
+        lhs.w_ * rhs.y_ + lhs.y_ * rhs.w_ + lhs.z_ * rhs.x_ - lhs.x_ * rhs.z_,
+        lhs.w_ * rhs.z_ + lhs.z_ * rhs.w_ + lhs.x_ * rhs.y_ - lhs.y_ * rhs.x_
+    );
+}
+
+/// Scalar reference of bounding box transform.
+static BoundingBox TransformedScalar(const BoundingBox& box, const Matrix3x4& transform)
+{
+    Vector3 newCenter = transform * box.Center();
+    Vector3 oldEdge = box.Size() * 0.5f;
+    Vector3 newEdge = Vector3(
+        Abs(transform.m00_) * oldEdge.x_ + Abs(transform.m01_) * oldEdge.y_ + Abs(transform.m02_) * oldEdge.z_,
+        Abs(transform.m10_) * oldEdge.x_ + Abs(transform.m11_) * oldEdge.y_ + Abs(transform.m12_) * oldEdge.z_,
+        Abs(transform.m20_) * oldEdge.x_ + Abs(transform.m21_) * oldEdge.y_ + Abs(transform.m22_) * oldEdge.z_
+    );
+    
+    return BoundingBox(newCenter - newEdge, newCenter + newEdge);
+}
+
+/// Scalar reference of frustum bounding box test.
+static Intersection IsInsideScalar(const Frustum& frustum, const BoundingBox& box)
+{
+    Vector3 center = box.Center();
+    Vector3 edge = center - box.min_;
+    bool allInside = true;
+    
+    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    {
+        const Plane& plane = frustum.planes_[i];
+        float dist = plane.normal_.DotProduct(center) + plane.d_;
+        float absDist = plane.absNormal_.DotProduct(edge);
+        
+        if (dist < -absDist)
+            return OUTSIDE;
+        else if (dist < absDist)
+            allInside = false;
+    }
+    
+    return allInside ? INSIDE : INTERSECTS;
+}
+
+/// Return the largest difference between two float arrays, relative to the magnitude of the values if larger than one.
+static float MaxDifference(const float* lhs, const float* rhs, unsigned count)
+{
+    float maxDifference = 0.0f;
+    for (unsigned i = 0; i < count; ++i)
+        maxDifference = Max(maxDifference, Abs(lhs[i] - rhs[i]) / Max(Abs(lhs[i]), 1.0f));
+    return maxDifference;
+}
+
+/// Print the average time of the scalar reference and the engine implementation of an operation, and the largest error between them.
+static void PrintMathOperation(const String& name, long long scalarUSec, long long engineUSec, unsigned numIterations, float maxError)
+{
+    float scalarMs = (float)scalarUSec / 1000.0f / numIterations;
+    float engineMs = (float)engineUSec / 1000.0f / numIterations;
+    PrintLine(name + "\t" + String(scalarMs) + "\t" + String(engineMs) + "\t" + String(engineMs > 0.0f ? scalarMs / engineMs : 0.0f) +
+        "\t" + String(maxError) + (maxError > M_LARGE_EPSILON ? "\tMISMATCH" : ""));
+}
+
+void RunMathBenchmark(const Vector<String>& arguments)
+{
+    unsigned numOperations = arguments.Size() > 0 ? ToUInt(arguments[0]) : 100000;
+    unsigned numIterations = arguments.Size() > 1 ? ToUInt(arguments[1]) : 10;
+    if (!numOperations || !numIterations)
+        ErrorExit("Number of operations and iterations must be positive");
+    
+    SharedPtr<Context> context = CreateBenchmarkContext(false);
+    
+    #ifdef URHO3D_SSE
+    PrintLine("Comparing scalar reference to SSE implementation");
+    #else
+    PrintLine("SSE is disabled, comparing scalar reference to scalar implementation");
+    #endif
+    
+    // Create random node-like transforms, general 4x4 matrices, rotations and bounding boxes scattered around a camera frustum
+    SetRandomSeed(1);
+    PODVector<Matrix3x4> transforms(numOperations);
+    PODVector<Matrix4> matrices(numOperations);
+    PODVector<Quaternion> rotations(numOperations);
+    PODVector<BoundingBox> boxes(numOperations);
+    for (unsigned i = 0; i < numOperations; ++i)
+    {
+        transforms[i] = Matrix3x4(Vector3(Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(-100.0f, 100.0f)),
+            Quaternion(Random(360.0f), Random(360.0f), Random(360.0f)), Vector3(Random(0.5f, 2.0f), Random(0.5f, 2.0f),
+            Random(0.5f, 2.0f)));
+        float data[16];
+        for (unsigned j = 0; j < 16; ++j)
+            data[j] = Random(-10.0f, 10.0f);
+        matrices[i] = Matrix4(data);
+        rotations[i] = Quaternion(Random(360.0f), Random(360.0f), Random(360.0f));
+        Vector3 center(Random(-500.0f, 500.0f), Random(-500.0f, 500.0f), Random(-500.0f, 500.0f));
+        Vector3 halfSize(Random(0.1f, 20.0f), Random(0.1f, 20.0f), Random(0.1f, 20.0f));
+        boxes[i] = BoundingBox(center - halfSize, center + halfSize);
+    }
+    Frustum frustum;
+    frustum.Define(60.0f, 1.6f, 1.0f, 0.1f, 500.0f, Matrix3x4(Vector3::ZERO, Quaternion(10.0f, 30.0f, 0.0f), 1.0f));
+    
+    PrintLine("Operation\tScalar (ms)\tEngine (ms)\tSpeedup\tMax error");
+    HiresTimer timer;
+    long long scalarUSec;
+    long long engineUSec;
+    float maxError;
+    
+    {
+        PODVector<Matrix3x4> scalarResults(numOperations);
+        PODVector<Matrix3x4> engineResults(numOperations);
+        timer.Reset();
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            for (unsigned j = 0; j < numOperations; ++j)
+                scalarResults[j] = MultiplyScalar(transforms[j], transforms[numOperations - 1 - j]);
+        }
+        scalarUSec = timer.GetUSec(true);
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            for (unsigned j = 0; j < numOperations; ++j)
+                engineResults[j] = transforms[j] * transforms[numOperations - 1 - j];
+        }
+        engineUSec = timer.GetUSec(true);
+        maxError = 0.0f;
+        for (unsigned j = 0; j < numOperations; ++j)
+            maxError = Max(maxError, MaxDifference(scalarResults[j].Data(), engineResults[j].Data(), 12));
+        PrintMathOperation("Matrix3x4 multiply", scalarUSec, engineUSec, numIterations, maxError);
+    }
+    
+    {
+        PODVector<Matrix4> scalarResults(numOperations);
+        PODVector<Matrix4> engineResults(numOperations);
+        timer.Reset();
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            for (unsigned j = 0; j < numOperations; ++j)
+                scalarResults[j] = MultiplyScalar(matrices[j], matrices[numOperations - 1 - j]);
+        }
+        scalarUSec = timer.GetUSec(true);
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            for (unsigned j = 0; j < numOperations; ++j)
+                engineResults[j] = matrices[j] * matrices[numOperations - 1 - j];
+        }
+        engineUSec = timer.GetUSec(true);
+        maxError = 0.0f;
+        for (unsigned j = 0; j < numOperations; ++j)
+            maxError = Max(maxError, MaxDifference(scalarResults[j].Data(), engineResults[j].Data(), 16));
+        PrintMathOperation("Matrix4 multiply", scalarUSec, engineUSec, numIterations, maxError);
+    }
+    
+    {
+        PODVector<Quaternion> scalarResults(numOperations);
+        PODVector<Quaternion> engineResults(numOperations);
+        timer.Reset();
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            for (unsigned j = 0; j < numOperations; ++j)
+                scalarResults[j] = MultiplyScalar(rotations[j], rotations[numOperations - 1 - j]);
+        }
+        scalarUSec = timer.GetUSec(true);
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            for (unsigned j = 0; j < numOperations; ++j)
+                engineResults[j] = rotations[j] * rotations[numOperations - 1 - j];
+        }
+        engineUSec = timer.GetUSec(true);
+        maxError = 0.0f;
+        for (unsigned j = 0; j < numOperations; ++j)
+            maxError = Max(maxError, MaxDifference(scalarResults[j].Data(), engineResults[j].Data(), 4));
+        PrintMathOperation("Quaternion multiply", scalarUSec, engineUSec, numIterations, maxError);
+    }
+    
+    {
+        PODVector<BoundingBox> scalarResults(numOperations);
+        PODVector<BoundingBox> engineResults(numOperations);
+        timer.Reset();
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            for (unsigned j = 0; j < numOperations; ++j)
+                scalarResults[j] = TransformedScalar(boxes[j], transforms[j]);
+        }
+        scalarUSec = timer.GetUSec(true);
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            for (unsigned j = 0; j < numOperations; ++j)
+                engineResults[j] = boxes[j].Transformed(transforms[j]);
+        }
+        engineUSec = timer.GetUSec(true);
+        maxError = 0.0f;
+        for (unsigned j = 0; j < numOperations; ++j)
+        {
+            maxError = Max(maxError, MaxDifference(scalarResults[j].min_.Data(), engineResults[j].min_.Data(), 3));
+            maxError = Max(maxError, MaxDifference(scalarResults[j].max_.Data(), engineResults[j].max_.Data(), 3));
+        }
+        PrintMathOperation("BoundingBox transform", scalarUSec, engineUSec, numIterations, maxError);
+    }
+    
+    {
+        PODVector<Intersection> scalarResults(numOperations);
+        PODVector<Intersection> engineResults(numOperations);
+        timer.Reset();
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            for (unsigned j = 0; j < numOperations; ++j)
+                scalarResults[j] = IsInsideScalar(frustum, boxes[j]);
+        }
+        scalarUSec = timer.GetUSec(true);
+        for (unsigned i = 0; i < numIterations; ++i)
+        {
+            for (unsigned j = 0; j < numOperations; ++j)
+                engineResults[j] = frustum.IsInside(boxes[j]);
+        }
+        engineUSec = timer.GetUSec(true);
+        // The error of the frustum test is the fraction of differing results
+        unsigned mismatches = 0;
+        for (unsigned j = 0; j < numOperations; ++j)
+        {
+            if (scalarResults[j] != engineResults[j])
+                ++mismatches;
+        }
+        PrintMathOperation("Frustum box test", scalarUSec, engineUSec, numIterations, (float)mismatches / numOperations);
+    }
+}
@@ -0,0 +1,338 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "AnimatedModel.h"
+#include "AnimationController.h"
+#include "Benchmarks.h"
+#include "Camera.h"
+#include "Context.h"
+#include "CoreEvents.h"
+#include "Engine.h"
+#include "Graphics.h"
+#include "Image.h"
+#include "Light.h"
+#include "Material.h"
+#include "Model.h"
+#include "Octree.h"
+#include "ParticleEmitter.h"
+#include "ProcessUtils.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "ResourceCache.h"
+#include "Scene.h"
+#include "Sort.h"
+#include "StaticModel.h"
+#include "StringUtils.h"
+#include "Terrain.h"
+#include "Timer.h"
+#include "Viewport.h"
+#include "XMLFile.h"
+#include "Zone.h"
+
+#include "DebugNew.h"
+
+/// Profiling blocks of the rendering stages to report.
+static const char* stageNames[] =
+{
+    "UpdateOctree",
+    "UpdateAnimations",
+    "GetDrawables",
+    "GetBatches",
+    "SortBatches",
+    "UpdateGeometries"
+};
+
+static const unsigned NUM_STAGES = sizeof(stageNames) / sizeof(stageNames[0]);
+/// Frames to run before measuring, so that resource loading and shader creation are not included.
+static const unsigned NUM_WARMUP_FRAMES = 10;
+/// Half size of the area the scene content is scattered on.
+static const float SCENE_EXTENT = 150.0f;
+
+/// Return the last frame's time of all profiling blocks with the specified name in a profiling tree, in microseconds.
+static long long GetStageTime(const ProfilerBlock* block, const char* name)
+{
+    long long time = 0;
+    
+    for (PODVector<ProfilerBlock*>::ConstIterator i = block->children_.Begin(); i != block->children_.End(); ++i)
+    {
+        if (!String::Compare((*i)->name_, name, true))
+            time += (*i)->frameTime_;
+        else
+            time += GetStageTime(*i, name);
+    }
+    
+    return time;
+}
+
+/// Build the benchmark scene procedurally.
+static void CreateScene(Scene* scene, unsigned numStaticModels, unsigned numAnimatedModels, unsigned numLights,
+    unsigned numEmitters)
+{
+    ResourceCache* cache = scene->GetSubsystem<ResourceCache>();
+    
+    scene->CreateComponent<Octree>();
+    
+    Zone* zone = scene->CreateChild("Zone")->CreateComponent<Zone>();
+    zone->SetBoundingBox(BoundingBox(-1000.0f, 1000.0f));
+    zone->SetAmbientColor(Color(0.15f, 0.15f, 0.15f));
+    zone->SetFogColor(Color(0.5f, 0.5f, 0.7f));
+    zone->SetFogStart(200.0f);
+    zone->SetFogEnd(300.0f);
+    
+    Node* terrainNode = scene->CreateChild("Terrain");
+    Terrain* terrain = terrainNode->CreateComponent<Terrain>();
+    terrain->SetPatchSize(64);
+    terrain->SetSpacing(Vector3(0.4f, 0.05f, 0.4f));
+    terrain->SetHeightMap(cache->GetResource<Image>("Textures/HeightMap.png"));
+    terrain->SetMaterial(cache->GetResource<Material>("Materials/Terrain.xml"));
+    terrain->SetOccluder(true);
+    
+    SetRandomSeed(1);
+    
+    // The first light is a directional light with cascaded shadows, the rest are shadowed spot lights scattered around
+    for (unsigned i = 0; i < numLights; ++i)
+    {
+        Node* lightNode = scene->CreateChild("Light");
+        Light* light = lightNode->CreateComponent<Light>();
+        light->SetCastShadows(true);
+        if (!i)
+        {
+            lightNode->SetDirection(Vector3(0.6f, -1.0f, 0.8f));
+            light->SetLightType(LIGHT_DIRECTIONAL);
+            light->SetShadowCascade(CascadeParameters(10.0f, 50.0f, 200.0f, 0.0f, 0.8f));
+        }
+        else
+        {
+            float x = Random(-SCENE_EXTENT, SCENE_EXTENT);
+            float z = Random(-SCENE_EXTENT, SCENE_EXTENT);
+            lightNode->SetPosition(Vector3(x, terrain->GetHeight(Vector3(x, 0.0f, z)) + 15.0f, z));
+            lightNode->SetDirection(Vector3(Random(-0.5f, 0.5f), -1.0f, Random(-0.5f, 0.5f)));
+            light->SetLightType(LIGHT_SPOT);
+            light->SetRange(40.0f);
+            light->SetFov(60.0f);
+            light->SetColor(Color(Random(0.5f, 1.0f), Random(0.5f, 1.0f), Random(0.5f, 1.0f)));
+        }
+    }
+    
+    Model* boxModel = cache->GetResource<Model>("Models/Box.mdl");
+    Model* mushroomModel = cache->GetResource<Model>("Models/Mushroom.mdl");
+    Material* stoneMaterial = cache->GetResource<Material>("Materials/Stone.xml");
+    Material* mushroomMaterial = cache->GetResource<Material>("Materials/Mushroom.xml");
+    
+    for (unsigned i = 0; i < numStaticModels; ++i)
+    {
+        Node* modelNode = scene->CreateChild("StaticModel");
+        float x = Random(-SCENE_EXTENT, SCENE_EXTENT);
+        float z = Random(-SCENE_EXTENT, SCENE_EXTENT);
+        modelNode->SetPosition(Vector3(x, terrain->GetHeight(Vector3(x, 0.0f, z)), z));
+        modelNode->SetRotation(Quaternion(0.0f, Random(360.0f), 0.0f));
+        modelNode->SetScale(Random(0.5f, 2.0f));
+        StaticModel* model = modelNode->CreateComponent<StaticModel>();
+        if (i & 1)
+        {
+            model->SetModel(boxModel);
+            model->SetMaterial(stoneMaterial);
+        }
+        else
+        {
+            model->SetModel(mushroomModel);
+            model->SetMaterial(mushroomMaterial);
+        }
+        model->SetCastShadows(true);
+    }
+    
+    Model* jackModel = cache->GetResource<Model>("Models/Jack.mdl");
+    Material* jackMaterial = cache->GetResource<Material>("Materials/Jack.xml");
+    
+    for (unsigned i = 0; i < numAnimatedModels; ++i)
+    {
+        Node* modelNode = scene->CreateChild("AnimatedModel");
+        float x = Random(-SCENE_EXTENT, SCENE_EXTENT);
+        float z = Random(-SCENE_EXTENT, SCENE_EXTENT);
+        modelNode->SetPosition(Vector3(x, terrain->GetHeight(Vector3(x, 0.0f, z)), z));
+        modelNode->SetRotation(Quaternion(0.0f, Random(360.0f), 0.0f));
+        AnimatedModel* model = modelNode->CreateComponent<AnimatedModel>();
+        model->SetModel(jackModel);
+        model->SetMaterial(jackMaterial);
+        model->SetCastShadows(true);
+        AnimationController* controller = modelNode->CreateComponent<AnimationController>();
+        controller->PlayExclusive("Models/Jack_Walk.ani", 0, true);
+        controller->SetTime("Models/Jack_Walk.ani", Random(1.0f));
+    }
+    
+    XMLFile* smokeEffect = cache->GetResource<XMLFile>("Particle/Smoke.xml");
+    
+    for (unsigned i = 0; i < numEmitters; ++i)
+    {
+        Node* emitterNode = scene->CreateChild("ParticleEmitter");
+        float x = Random(-SCENE_EXTENT, SCENE_EXTENT);
+        float z = Random(-SCENE_EXTENT, SCENE_EXTENT);
+        emitterNode->SetPosition(Vector3(x, terrain->GetHeight(Vector3(x, 0.0f, z)), z));
+        emitterNode->CreateComponent<ParticleEmitter>()->Load(smokeEffect);
+    }
+}
+
+/// Return average, median, minimum and maximum of per-frame times as a JSON object.
+static String GetTimeStatistics(const String& name, PODVector<float>& times)
+{
+    Sort(times.Begin(), times.End());
+    
+    float total = 0.0f;
+    for (unsigned i = 0; i < times.Size(); ++i)
+        total += times[i];
+    
+    return "{\"name\": \"" + name + "\", \"avg\": " + String(total / times.Size()) + ", \"median\": " +
+        String(times[times.Size() / 2]) + ", \"min\": " + String(times.Front()) + ", \"max\": " + String(times.Back()) + "}";
+}
+
+void RunRenderingBenchmark(const Vector<String>& arguments)
+{
+    unsigned numStaticModels = arguments.Size() > 0 ? ToUInt(arguments[0]) : 2000;
+    unsigned numAnimatedModels = arguments.Size() > 1 ? ToUInt(arguments[1]) : 100;
+    unsigned numLights = arguments.Size() > 2 ? ToUInt(arguments[2]) : 4;
+    unsigned numEmitters = arguments.Size() > 3 ? ToUInt(arguments[3]) : 50;
+    unsigned numFrames = arguments.Size() > 4 ? ToUInt(arguments[4]) : 300;
+    bool workerThreads = arguments.Size() > 5 ? ToBool(arguments[5]) : false;
+    unsigned reprojectionFrames = arguments.Size() > 6 ? ToUInt(arguments[6]) : 0;
+    if (!numFrames)
+        ErrorExit("Number of frames must be positive");
+    
+    #ifndef ENABLE_PROFILING
+    ErrorExit("The rendering benchmark requires profiling to be enabled");
+    #endif
+    
+    // Run the engine headless. With the null graphics backend the renderer still runs all its CPU work. Worker threads
+    // are disabled by default for stable timings
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine(new Engine(context));
+    VariantMap engineParameters;
+    engineParameters["Headless"] = true;
+    engineParameters["LogQuiet"] = true;
+    engineParameters["LogName"] = "Benchmarks.log";
+    engineParameters["WindowWidth"] = 1280;
+    engineParameters["WindowHeight"] = 720;
+    engineParameters["WorkerThreads"] = workerThreads;
+    if (!engine->Initialize(engineParameters))
+        ErrorExit("Failed to initialize the engine");
+    engine->SetMaxFps(0);
+    engine->SetMaxInactiveFps(0);
+    
+    Renderer* renderer = context->GetSubsystem<Renderer>();
+    Profiler* profiler = context->GetSubsystem<Profiler>();
+    if (!renderer)
+        ErrorExit("The rendering benchmark requires the null graphics backend to run headless (USE_NULL_GRAPHICS)");
+    
+    SharedPtr<Scene> scene(new Scene(context));
+    CreateScene(scene, numStaticModels, numAnimatedModels, numLights, numEmitters);
+    
+    Node* cameraNode = scene->CreateChild("Camera");
+    Camera* camera = cameraNode->CreateComponent<Camera>();
+    camera->SetFarClip(300.0f);
+    renderer->SetViewport(0, new Viewport(context, scene, camera));
+    
+    // If occlusion reprojection is enabled, allow the camera movement and rotation of one benchmark frame
+    if (reprojectionFrames)
+    {
+        float frameAngle = 360.0f / (NUM_WARMUP_FRAMES + numFrames);
+        renderer->SetOcclusionReprojectionFrames(reprojectionFrames);
+        renderer->SetOcclusionReprojectionDistance(1.01f * SCENE_EXTENT * frameAngle * M_DEGTORAD);
+        renderer->SetOcclusionReprojectionAngle(1.01f * frameAngle);
+    }
+    
+    PODVector<float> frameTimes;
+    Vector<PODVector<float> > stageTimes(NUM_STAGES);
+    HiresTimer timer;
+    unsigned globalAllocations = 0;
+    unsigned containerAllocations = 0;
+    
+    for (unsigned i = 0; i < NUM_WARMUP_FRAMES + numFrames; ++i)
+    {
+        // Circle the camera around the scene center with a fixed time step, so that every run renders the same frames
+        float angle = 360.0f * i / (NUM_WARMUP_FRAMES + numFrames);
+        Vector3 position = Quaternion(0.0f, angle, 0.0f) * Vector3(0.0f, 0.0f, -SCENE_EXTENT);
+        cameraNode->SetPosition(position + Vector3(0.0f, 30.0f, 0.0f));
+        cameraNode->LookAt(Vector3(0.0f, 5.0f, 0.0f));
+        
+        if (i == NUM_WARMUP_FRAMES)
+        {
+            globalAllocations = GetNumGlobalAllocations();
+            containerAllocations = GetNumHeapAllocations();
+        }
+        
+        timer.Reset();
+        engine->SetNextTimeStep(1.0f / 60.0f);
+        engine->RunFrame();
+        long long frameUSec = timer.GetUSec(false);
+        
+        if (i < NUM_WARMUP_FRAMES)
+            continue;
+        
+        // The worker threads' profiling data is collected at the end of the frame, so sum the stages over all threads
+        frameTimes.Push(frameUSec / 1000.0f);
+        for (unsigned j = 0; j < NUM_STAGES; ++j)
+        {
+            long long stageUSec = 0;
+            for (unsigned k = 0; k < profiler->GetNumThreads(); ++k)
+                stageUSec += GetStageTime(profiler->GetThreadRootBlock(k), stageNames[j]);
+            stageTimes[j].Push(stageUSec / 1000.0f);
+        }
+    }
+    
+    PrintLine("{");
+    PrintLine("  \"staticModels\": " + String(numStaticModels) + ",");
+    PrintLine("  \"animatedModels\": " + String(numAnimatedModels) + ",");
+    PrintLine("  \"lights\": " + String(numLights) + ",");
+    PrintLine("  \"particleEmitters\": " + String(numEmitters) + ",");
+    PrintLine("  \"frames\": " + String(numFrames) + ",");
+    PrintLine("  \"workerThreads\": " + String(profiler->GetNumThreads() - 1) + ",");
+    PrintLine("  \"occlusionReprojectionFrames\": " + String(reprojectionFrames) + ",");
+    PrintLine("  \"timeUnit\": \"ms\",");
+    PrintLine("  \"stages\": [");
+    PrintLine("    " + GetTimeStatistics("Frame", frameTimes) + ",");
+    for (unsigned i = 0; i < NUM_STAGES; ++i)
+        PrintLine("    " + GetTimeStatistics(stageNames[i], stageTimes[i]) + (i < NUM_STAGES - 1 ? "," : ""));
+    PrintLine("  ],");
+    
+    // Report the average heap allocations per frame, both all allocations and the ones made by containers
+    globalAllocations = GetNumGlobalAllocations() - globalAllocations;
+    containerAllocations = GetNumHeapAllocations() - containerAllocations;
+    PrintLine("  \"heapAllocationsPerFrame\": {\"all\": " + String((float)globalAllocations / numFrames) + ", \"containers\": " +
+        String((float)containerAllocations / numFrames) + "},");
+    
+    // Report the renderer statistics and recorded graphics commands of the last frame
+    String rendererStats = "  \"renderer\": {\"geometries\": " + String(renderer->GetNumGeometries()) + ", \"lights\": " +
+        String(renderer->GetNumLights()) + ", \"shadowMaps\": " + String(renderer->GetNumShadowMaps()) + ", \"occluders\": " +
+        String(renderer->GetNumOccluders()) + ", \"zoneLookups\": " + String(renderer->GetNumZoneLookups()) + ", \"batches\": " +
+        String(renderer->GetNumBatches()) + ", \"primitives\": " + String(renderer->GetNumPrimitives()) + "}";
+    #ifdef USE_NULL_GRAPHICS
+    PrintLine(rendererStats + ",");
+    const GraphicsCounters& counters = context->GetSubsystem<Graphics>()->GetCounters();
+    PrintLine("  \"graphics\": {\"draws\": " + String(counters.numDraws_) + ", \"primitives\": " +
+        String(counters.numPrimitives_) + ", \"shaderChanges\": " + String(counters.numShaderChanges_) +
+        ", \"shaderParameters\": " + String(counters.numShaderParameters_) + ", \"textureChanges\": " +
+        String(counters.numTextureChanges_) + ", \"stateChanges\": " + String(counters.numStateChanges_) +
+        ", \"bufferUpdateBytes\": " + String(counters.bufferUpdateBytes_) + "}");
+    #else
+    PrintLine(rendererStats);
+    #endif
+    PrintLine("}");
+}
@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Allocator.h"
+#include "Benchmarks.h"
+#include "Context.h"
+#include "ProcessUtils.h"
+#include "Scene.h"
+#include "SmoothedTransform.h"
+#include "StringUtils.h"
+#include "Timer.h"
+#include "VectorBuffer.h"
+#include "XMLFile.h"
+
+#include "DebugNew.h"
+
+/// Read the name and all attributes of an element and its children recursively, as scene loading would.
+static unsigned ReadXMLElement(const XMLElement& element)
+{
+    unsigned length = element.GetName().Length();
+    
+    Vector<String> attributeNames = element.GetAttributeNames();
+    for (unsigned i = 0; i < attributeNames.Size(); ++i)
+        length += element.GetAttribute(attributeNames[i]).Length();
+    
+    for (XMLElement child = element.GetChild(); child; child = child.GetNext())
+        length += ReadXMLElement(child);
+    
+    return length;
+}
+
+/// Print the average time and heap allocations of a benchmark stage.
+static void PrintSceneLoadStage(const String& name, long long usec, unsigned allocations, unsigned numIterations, unsigned numNodes)
+{
+    PrintLine(name + "\t" + String((float)usec / 1000.0f / numIterations) + "\t" + String(allocations / numIterations) + "\t" +
+        String((float)allocations / numIterations / numNodes));
+}
+
+void RunSceneLoadBenchmark(const Vector<String>& arguments)
+{
+    unsigned numNodes = arguments.Size() > 0 ? ToUInt(arguments[0]) : 1000;
+    unsigned numIterations = arguments.Size() > 1 ? ToUInt(arguments[1]) : 10;
+    if (!numNodes || !numIterations)
+        ErrorExit("Number of nodes and iterations must be positive");
+    
+    SharedPtr<Context> context = CreateBenchmarkContext(false);
+    RegisterSceneLibrary(context);
+    
+    // Create a scene with short node names and variables, as is typical in game content
+    SharedPtr<Scene> sourceScene(new Scene(context));
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* node = sourceScene->CreateChild("Node" + String(i));
+        node->SetPosition(Vector3((float)i, 0.0f, (float)(i % 100)));
+        node->SetVar("Health", (int)i);
+        node->SetVar("Faction", "Enemy");
+        node->CreateComponent<SmoothedTransform>();
+    }
+    
+    VectorBuffer xmlData;
+    sourceScene->SaveXML(xmlData);
+    VectorBuffer binaryData;
+    sourceScene->Save(binaryData);
+    sourceScene.Reset();
+    
+    PrintLine("String size " + String((unsigned)sizeof(String)) + " bytes, inline capacity " + String(String::INLINE_CAPACITY) +
+        " bytes");
+    PrintLine("Stage\tTime (ms)\tHeap allocations\tPer node");
+    
+    unsigned allocations = GetNumHeapAllocations();
+    HiresTimer timer;
+    unsigned length = 0;
+    for (unsigned i = 0; i < numIterations; ++i)
+    {
+        xmlData.Seek(0);
+        SharedPtr<XMLFile> xmlFile(new XMLFile(context));
+        xmlFile->Load(xmlData);
+        length += ReadXMLElement(xmlFile->GetRoot());
+    }
+    PrintSceneLoadStage("XML parse", timer.GetUSec(true), GetNumHeapAllocations() - allocations, numIterations, numNodes);
+    
+    allocations = GetNumHeapAllocations();
+    for (unsigned i = 0; i < numIterations; ++i)
+    {
+        xmlData.Seek(0);
+        SharedPtr<Scene> scene(new Scene(context));
+        scene->LoadXML(xmlData);
+    }
+    PrintSceneLoadStage("XML load", timer.GetUSec(true), GetNumHeapAllocations() - allocations, numIterations, numNodes);
+    
+    allocations = GetNumHeapAllocations();
+    for (unsigned i = 0; i < numIterations; ++i)
+    {
+        binaryData.Seek(0);
+        SharedPtr<Scene> scene(new Scene(context));
+        scene->Load(binaryData);
+    }
+    PrintSceneLoadStage("Binary load", timer.GetUSec(true), GetNumHeapAllocations() - allocations, numIterations, numNodes);
+    
+    // Use the result so that the XML reading is not optimized away
+    if (!length)
+        PrintLine("XML file was empty");
+}
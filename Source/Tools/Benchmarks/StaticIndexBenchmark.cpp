@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Benchmarks.h"
+#include "Context.h"
+#include "Graphics.h"
+#include "Octree.h"
+#include "OctreeQuery.h"
+#include "ProcessUtils.h"
+#include "Scene.h"
+#include "StringUtils.h"
+#include "Timer.h"
+#include "Zone.h"
+
+#include "DebugNew.h"
+
+void RunStaticIndexBenchmark(const Vector<String>& arguments)
+{
+    unsigned numDrawables = arguments.Size() > 0 ? ToUInt(arguments[0]) : 100000;
+    unsigned numLevels = arguments.Size() > 1 ? ToUInt(arguments[1]) : 6;
+    if (!numDrawables || !numLevels)
+        ErrorExit("Number of drawables and octree levels must be positive");
+    
+    SharedPtr<Context> context = CreateBenchmarkContext(true);
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+    
+    // Gather most of the zones into dense clusters and scatter the rest, so that the octants hold very uneven counts
+    SharedPtr<Scene> scene(new Scene(context));
+    Octree* octree = scene->CreateComponent<Octree>();
+    octree->SetSize(BoundingBox(-2000.0f, 2000.0f), numLevels);
+    SetRandomSeed(1);
+    const unsigned numClusters = 16;
+    Vector3 clusterCenters[numClusters];
+    for (unsigned i = 0; i < numClusters; ++i)
+        clusterCenters[i] = Vector3(Random(-1800.0f, 1800.0f), 0.0f, Random(-1800.0f, 1800.0f));
+    
+    PODVector<Drawable*> drawables;
+    for (unsigned i = 0; i < numDrawables; ++i)
+    {
+        Node* node = scene->CreateChild();
+        Vector3 position;
+        if (i % 10)
+        {
+            const Vector3& center = clusterCenters[Rand() % numClusters];
+            position = center + Vector3(Random(-100.0f, 100.0f), Random(-20.0f, 20.0f), Random(-100.0f, 100.0f));
+        }
+        else
+            position = Vector3(Random(-2000.0f, 2000.0f), Random(-50.0f, 50.0f), Random(-2000.0f, 2000.0f));
+        node->SetPosition(position);
+        float size = Random(0.25f, 4.0f);
+        Zone* zone = node->CreateComponent<Zone>();
+        zone->SetBoundingBox(BoundingBox(-size, size));
+        drawables.Push(zone);
+    }
+    
+    FrameInfo frame;
+    frame.frameNumber_ = 1;
+    frame.timeStep_ = 0.0f;
+    octree->Update(frame);
+    
+    PrintLine("Test\tUpdate (ms)\tFrustum query (ms)\tRay query (ms)\tVisible drawables\tRay hits");
+    const unsigned numFrustumQueries = 100;
+    const unsigned numRayQueries = 1000;
+    PODVector<Drawable*> frustumResult;
+    PODVector<RayQueryResult> rayResult;
+    HiresTimer timer;
+    
+    for (unsigned pass = 0; pass < 2; ++pass)
+    {
+        // On the second pass move the zones into the static drawable index. The octree update rebuilds the index
+        long long updateUsec = 0;
+        if (pass == 1)
+        {
+            for (unsigned i = 0; i < drawables.Size(); ++i)
+                drawables[i]->SetStatic(true);
+            ++frame.frameNumber_;
+            timer.Reset();
+            octree->Update(frame);
+            updateUsec = timer.GetUSec(false);
+        }
+        
+        long long frustumUsec = 0;
+        unsigned numVisible = 0;
+        for (unsigned i = 0; i < numFrustumQueries; ++i)
+        {
+            // Rotate the camera around the cluster centers, so that both dense and sparse areas are visited
+            const Vector3& center = clusterCenters[i % numClusters];
+            Frustum frustum;
+            frustum.Define(60.0f, 16.0f / 9.0f, 1.0f, 0.1f, 1000.0f, Matrix3x4(center + Vector3(0.0f, 30.0f, 0.0f),
+                Quaternion(10.0f, 360.0f * i / numFrustumQueries, 0.0f), 1.0f));
+            FrustumOctreeQuery query(frustumResult, frustum, DRAWABLE_ZONE);
+            
+            timer.Reset();
+            octree->GetDrawables(query);
+            frustumUsec += timer.GetUSec(false);
+            numVisible += frustumResult.Size();
+        }
+        
+        long long rayUsec = 0;
+        unsigned numHits = 0;
+        SetRandomSeed(2);
+        for (unsigned i = 0; i < numRayQueries; ++i)
+        {
+            // Cast mostly horizontal picking rays from the clusters
+            const Vector3& center = clusterCenters[i % numClusters];
+            Ray ray(center + Vector3(Random(-100.0f, 100.0f), Random(-20.0f, 20.0f), Random(-100.0f, 100.0f)),
+                Vector3(Random(-1.0f, 1.0f), Random(-0.1f, 0.1f), Random(-1.0f, 1.0f)));
+            RayOctreeQuery query(rayResult, ray, RAY_AABB, 500.0f, DRAWABLE_ZONE);
+            
+            timer.Reset();
+            octree->Raycast(query);
+            rayUsec += timer.GetUSec(false);
+            numHits += rayResult.Size();
+        }
+        
+        PrintLine(String(pass == 0 ? "Octree" : "Static index") + "\t" + String((float)updateUsec / 1000.0f) + "\t" +
+            String((float)frustumUsec / 1000.0f / numFrustumQueries) + "\t" + String((float)rayUsec / 1000.0f / numRayQueries) +
+            "\t" + String(numVisible / numFrustumQueries) + "\t" + String(numHits));
+    }
+}
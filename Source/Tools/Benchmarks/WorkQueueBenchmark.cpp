@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2008-2014 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Benchmarks.h"
+#include "Context.h"
+#include "MathDefs.h"
+#include "ProcessUtils.h"
+#include "StringUtils.h"
+#include "Timer.h"
+#include "WorkQueue.h"
+
+#include "DebugNew.h"
+
+static const unsigned NUM_FRAMES = 100;
+
+/// Benchmark work item payload.
+struct BenchmarkTask
+{
+    /// Number of iterations to run. Varies per task to simulate unevenly costed work.
+    unsigned iterations_;
+    /// Result, to prevent the work from being optimized away.
+    float result_;
+};
+
+static void BenchmarkWork(const WorkItem* item, unsigned threadIndex)
+{
+    BenchmarkTask* start = reinterpret_cast<BenchmarkTask*>(item->start_);
+    BenchmarkTask* end = reinterpret_cast<BenchmarkTask*>(item->end_);
+    
+    for (BenchmarkTask* task = start; task < end; ++task)
+    {
+        float value = 0.0f;
+        for (unsigned i = 0; i < task->iterations_; ++i)
+            value += sqrtf((float)i) * 0.5f;
+        task->result_ = value;
+    }
+}
+
+void RunWorkQueueBenchmark(const Vector<String>& arguments)
+{
+    unsigned maxThreads = arguments.Size() > 0 ? ToUInt(arguments[0]) : GetNumPhysicalCPUs() - 1;
+    unsigned numItems = arguments.Size() > 1 ? ToUInt(arguments[1]) : 1024;
+    if (!numItems)
+        ErrorExit("Number of items must be positive");
+    
+    // Costs vary by a factor of 16 between items, and the expensive items are clustered to defeat equal slicing
+    PODVector<BenchmarkTask> tasks(numItems);
+    for (unsigned i = 0; i < numItems; ++i)
+    {
+        tasks[i].iterations_ = 256 * (1 + (i * 16 / numItems));
+        tasks[i].result_ = 0.0f;
+    }
+    
+    SharedPtr<Context> context = CreateBenchmarkContext(false);
+    
+    PrintLine("Threads\tFrame time (ms)\tSpeedup");
+    
+    float baseTime = 0.0f;
+    for (unsigned numThreads = 0; numThreads <= maxThreads; ++numThreads)
+    {
+        SharedPtr<WorkQueue> queue(new WorkQueue(context));
+        queue->CreateThreads(numThreads);
+        
+        HiresTimer timer;
+        for (unsigned frame = 0; frame < NUM_FRAMES; ++frame)
+        {
+            for (unsigned i = 0; i < numItems; ++i)
+            {
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = BenchmarkWork;
+                item->start_ = &tasks[i];
+                item->end_ = &tasks[i] + 1;
+                queue->AddWorkItem(item);
+            }
+            queue->Complete(M_MAX_UNSIGNED);
+        }
+        
+        float frameTime = (float)timer.GetUSec(false) / 1000.0f / NUM_FRAMES;
+        if (!numThreads)
+            baseTime = frameTime;
+        
+        PrintLine(String(numThreads) + "\t" + String(frameTime) + "\t" + String(baseTime / frameTime));
+    }
+}
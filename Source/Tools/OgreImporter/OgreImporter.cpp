@@ -970,6 +970,7 @@ void WriteOutput(const String& outputFileName, bool exportAnimations, bool rotat
                     else
                         newAnimationTrack.channelMask_ = CHANNEL_ROTATION;
                     
+                    Vector<AnimationKeyFrame> keyFrames;
                     XMLElement keyFramesRoot = track.GetChild("keyframes");
                     XMLElement keyFrame = keyFramesRoot.GetChild("keyframe");
                     while (keyFrame)
@@ -1000,16 +1001,19 @@ void WriteOutput(const String& outputFileName, bool exportAnimations, bool rotat
                         newKeyFrame.position_ = pos;
                         newKeyFrame.rotation_ = rot;
                         
-                        newAnimationTrack.keyFrames_.Push(newKeyFrame);
+                        keyFrames.Push(newKeyFrame);
                         keyFrame = keyFrame.GetNext("keyframe");
                     }
                     
                     // Make sure keyframes are sorted from beginning to end
-                    Sort(newAnimationTrack.keyFrames_.Begin(), newAnimationTrack.keyFrames_.End(), CompareKeyFrames);
+                    Sort(keyFrames.Begin(), keyFrames.End(), CompareKeyFrames);
                     
                     // Do not add tracks with no keyframes
-                    if (newAnimationTrack.keyFrames_.Size())
+                    if (keyFrames.Size())
+                    {
+                        newAnimationTrack.SetKeyFrames(keyFrames);
                         newAnimation.tracks_.Push(newAnimationTrack);
+                    }
                     
                     track = track.GetNext("track");
                 }
@@ -1031,17 +1035,16 @@ void WriteOutput(const String& outputFileName, bool exportAnimations, bool rotat
                     AnimationTrack& track = newAnimation.tracks_[i];
                     dest.WriteString(track.name_);
                     dest.WriteUByte(track.channelMask_);
-                    dest.WriteUInt(track.keyFrames_.Size());
-                    for (unsigned j = 0; j < track.keyFrames_.Size(); ++j)
+                    dest.WriteUInt(track.keyFrameTimes_.Size());
+                    for (unsigned j = 0; j < track.keyFrameTimes_.Size(); ++j)
                     {
-                        AnimationKeyFrame& keyFrame = track.keyFrames_[j];
-                        dest.WriteFloat(keyFrame.time_);
+                        dest.WriteFloat(track.keyFrameTimes_[j]);
                         if (track.channelMask_ & CHANNEL_POSITION)
-                            dest.WriteVector3(keyFrame.position_);
+                            dest.WriteVector3(track.keyFramePositions_[j]);
                         if (track.channelMask_ & CHANNEL_ROTATION)
-                            dest.WriteQuaternion(keyFrame.rotation_);
+                            dest.WriteQuaternion(track.keyFrameRotations_[j]);
                         if (track.channelMask_ & CHANNEL_SCALE)
-                            dest.WriteVector3(keyFrame.scale_);
+                            dest.WriteVector3(track.keyFrameScales_[j]);
                     }
                 }
                 